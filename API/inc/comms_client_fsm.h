@@ -51,10 +51,74 @@
 
 #include "comms_network.h"
 #include "comms_protocol.h"
+#include "comms_fragment.h"
+#include "comms_qos.h"
 
 
+/* Client context uses natural alignment, it embeds the trace ring */
+#pragma pack(push)
+#pragma pack()
 
-#define JOINREQ_ONCE 1
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Client state machine values persistent across transmit timer interrupts */
+typedef struct _comms_client_fsm
+{
+    uint8_t  fsm_state;                                    /*!< Current state machine state          */
+    uint8_t  debug_print_count;                            /*!< Print once counter for debug output  */
+    uint8_t  keep_alive_frames;                            /*!< SYNC messages since the last STATUS  */
+    uint8_t  contrl_record;                                /*!< Next record of held CONTRL frame     */
+    uint8_t  fragment_message_id;                          /*!< Message id of the fragmented message */
+    uint8_t  fragment_index;                               /*!< Next fragment to send                */
+    uint16_t fragment_offset;                              /*!< Application message bytes sent       */
+    uint8_t  payload_codecs;                               /*!< STATUS payload codecs, COMMS_CODEC_MASK */
+    uint8_t  sync_frame;                                   /*!< Frame number of the last SYNC        */
+    uint8_t  sync_received;                                /*!< SYNC received since the join         */
+    uint8_t  sync_behind;                                  /*!< SYNC frame behind the last one       */
+    uint32_t frames_sent;                                  /*!< Sent frames at the last SYNC message */
+    uint8_t  join_attempts;                                /*!< JOINREQ messages sent for this join  */
+    uint16_t join_backoff;                                 /*!< SYNC messages to skip before JOINREQ */
+    uint32_t join_random;                                  /*!< Backoff random state, MAC seeded     */
+    uint8_t  slot_period;                                  /*!< Requested period, slot every 2^n frames */
+    uint8_t  sleep_mode;                                   /*!< Radio sleeps between the slots it needs */
+    uint8_t  bitmap_client;                                /*!< Client id in the SYNC ack and mail bitmaps */
+    uint8_t  sleep_phase;                                  /*!< Low power timer phase                */
+    uint8_t  sleep_quiet;                                  /*!< Listen windows without server frames */
+    uint8_t  sleep_mail;                                   /*!< Mail bit of the last SYNC message    */
+    uint8_t  sleep_window;                                 /*!< Slots of the current listen window   */
+    uint8_t  frame_slots;                                  /*!< Frame length of the last SYNC        */
+    uint32_t sleep_frames;                                 /*!< Server frames at the window start    */
+    uint8_t  qos;                                          /*!< QoS 1, STATUS messages acknowledged  */
+    uint8_t  qos_sequence;                                 /*!< Sequence number of the next STATUS   */
+    uint8_t  qos_sent;                                     /*!< STATUS frame sent in the last frame  */
+    uint8_t  qos_sent_sequence;                            /*!< Sequence number of that STATUS frame */
+
+    net_retransmit_t retransmit[COMMS_QOS_QUEUE_SIZE];      /*!< STATUS frames without acknowledgement */
+
+    net_reassembly_t reassembly[COMMS_REASSEMBLY_BUFFERS];  /*!< Received fragmented messages         */
+
+}comms_client_fsm_t;
+
+
+
+/* Client instance context, all state of one client in caller owned storage */
+typedef struct _comms_client_context
+{
+    access_control_t       network;   /*!< Network access handle           */
+    device_config_t        device;    /*!< Client device configuration     */
+    comms_network_buffer_t buffers;   /*!< Network buffers                 */
+    uint8_t                rx_index;  /*!< Receive interrupt buffer index  */
+    comms_client_fsm_t     fsm;       /*!< State machine values            */
+    comms_trace_t          trace;     /*!< Deferred debug trace            */
+
+}comms_client_context_t;
 
 
 /******************************************************************************/
@@ -64,8 +128,92 @@
 /******************************************************************************/
 
 
+/**************************************************************************
+ * @brief  Client instance constructor, initializes caller owned context
+ *         and attaches the context trace, comms_network_trace_flush
+ *         prints the recorded debug output from the main loop
+ * @param  *client           : reference to client context
+ * @param  *network_ops      : reference to network operations handle
+ * @param  *mac_address      : mac_address of the client device
+ * @param  requested_slots   : number of slots requested
+ * @param  *user_name        : network user name
+ * @param  *password         : network password
+ * @retval int8_t            : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_init(comms_client_context_t *client, network_operations_t *network_ops, char *mac_address,
+                         uint8_t requested_slots, char *user_name, uint8_t *password);
+
+
+/**************************************************************************
+ * @brief  Client state machine step for a client context, call from the
+ *         transmit timer interrupt of the instance
+ * @param  *client        : reference to client context
+ * @param  destination_id : device id of the destination
+ * @retval int8_t         : error = 0
+ **************************************************************************/
+int8_t comms_client_run(comms_client_context_t *client, uint8_t destination_id);
+
+
+/**************************************************************************
+ * @brief  Client receive interrupt handler for a client context
+ * @param  *client : reference to client context
+ * @param  data    : received byte
+ * @retval int8_t  : error: -2, success: length of message
+ **************************************************************************/
+int8_t comms_client_recv(comms_client_context_t *client, char data);
+
+
+/**************************************************************************
+ * @brief  Select STATUS payload codecs, application messages are sent
+ *         encoded when smaller, set before joining, the server relays
+ *         encoded CONTRL messages only to clients that joined with codecs
+ * @param  *client  : reference to client context
+ * @param  codecs   : COMMS_CODEC_MASK bits, 0 sends raw payloads
+ * @retval int8_t   : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_codec(comms_client_context_t *client, uint8_t codecs);
+
+
+/**************************************************************************
+ * @brief  Select the low power mode of the client, the radio sleeps
+ *         outside the listen window at each server frame grid point and
+ *         the client slot of frames the client sends in, needs the
+ *         radio_sleep and radio_wake network operations
+ * @param  *client : reference to client context
+ * @param  enable  : 1 radio sleeps between the slots it needs, 0 always on
+ * @retval int8_t  : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_sleep(comms_client_context_t *client, uint8_t enable);
+
+
+/**************************************************************************
+ * @brief  Select the quality of service of the STATUS messages, set before
+ *         joining, QoS 1 messages carry a sequence number and are sent
+ *         again in later owned slots until the server acknowledges them
+ *         in the SYNC ack bitmap, at most COMMS_QOS_QUEUE_SIZE at a time
+ * @param  *client : reference to client context
+ * @param  qos     : 0 at most once, 1 at least once
+ * @retval int8_t  : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_qos(comms_client_context_t *client, uint8_t qos);
+
+
+/**************************************************************************
+ * @brief  Select the reporting period of the client, set before joining,
+ *         the server schedules the slot of a client with a period of
+ *         2^n frames once every 2^n frames in a shared superframe slot
+ * @param  *client       : reference to client context
+ * @param  period_frames : frames between STATUS messages, rounded down to
+ *                         a power of 2, 0 or 1 sends in every frame
+ * @retval int8_t        : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_period(comms_client_context_t *client, uint16_t period_frames);
+
+
 /**************************************************************************
  * @brief  Client State Machine Start Function
+ *         (single instance, state machine values kept in static storage),
+ *         debug prints go to a static trace, comms_start_client_flush
  * @param  *wireless_network : reference to network access handle
  * @param  *server_device    : reference to device configuration structure
  * @param  *network_buffers  : reference to network buffers structure
@@ -75,6 +223,17 @@
 int8_t comms_start_client(access_control_t *wireless_network, device_config_t *client_device, comms_network_buffer_t *network_buffers, uint8_t destination_id);
 
 
+/**************************************************************************
+ * @brief  Print the deferred debug trace of the single instance client
+ *         state machine, call from the main loop
+ * @param  *wireless_network : reference to network access handle
+ * @retval int16_t           : error: -1, success: records printed
+ **************************************************************************/
+int16_t comms_start_client_flush(access_control_t *wireless_network);
+
+
+
+#pragma pack(pop)
 
 
 #endif /* COMMS_CLIENT_FSM_H_ */
@@ -0,0 +1,170 @@
+/**
+ ******************************************************************************
+ * @file    comms_codec.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network payload codec header file
+ *
+ *  Info
+ *          Payload codecs for repetitive telemetry, zigzag delta varints for
+ *          separated decimal integer records and a static dictionary for
+ *          sensor text. The codec of a frame is carried in the message status
+ *          field, the encoder keeps the raw payload when no codec is smaller.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+#ifndef COMMS_CODEC_H_
+#define COMMS_CODEC_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Payload codecs */
+typedef enum _comms_codec
+{
+    COMMS_CODEC_NONE   = 0,  /*!< Raw payload                                        */
+    COMMS_CODEC_VARINT = 1,  /*!< Decimal integer records as zigzag delta varints    */
+    COMMS_CODEC_DICT   = 2   /*!< Text with static dictionary substitution           */
+
+}comms_codec_t;
+
+
+/* Codec mask bits, codecs tried by the encoder */
+#define COMMS_CODEC_MASK(codec)  (1U << ((codec) - 1))
+#define COMMS_CODEC_ALL          (COMMS_CODEC_MASK(COMMS_CODEC_VARINT) | COMMS_CODEC_MASK(COMMS_CODEC_DICT))
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to encode decimal integer records,
+ *         numbers split by one non digit separator are
+ *         sent as zigzag varint deltas of the previous
+ *         number, the separators are kept
+ * @param  *payload        : payload
+ * @param  payload_length  : payload length
+ * @param  *encoded        : encoded payload buffer
+ * @param  encoded_size    : encoded payload buffer size
+ * @retval int16_t         : not numeric or no space: -1,
+ *                           success: encoded length
+ *********************************************************/
+int16_t comms_codec_varint_encode(const char *payload, uint16_t payload_length, char *encoded, uint16_t encoded_size);
+
+
+/*********************************************************
+ * @brief  Function to decode decimal integer records
+ * @param  *encoded        : encoded payload
+ * @param  encoded_length  : encoded payload length
+ * @param  *payload        : payload buffer
+ * @param  payload_size    : payload buffer size
+ * @retval int16_t         : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_codec_varint_decode(const char *encoded, uint16_t encoded_length, char *payload, uint16_t payload_size);
+
+
+/*********************************************************
+ * @brief  Function to encode text with the static
+ *         dictionary, dictionary words are sent as one
+ *         byte, bytes above 0x7F are escaped
+ * @param  *payload        : payload
+ * @param  payload_length  : payload length
+ * @param  *encoded        : encoded payload buffer
+ * @param  encoded_size    : encoded payload buffer size
+ * @retval int16_t         : no space: -1, success: encoded length
+ *********************************************************/
+int16_t comms_codec_dict_encode(const char *payload, uint16_t payload_length, char *encoded, uint16_t encoded_size);
+
+
+/*********************************************************
+ * @brief  Function to decode static dictionary text
+ * @param  *encoded        : encoded payload
+ * @param  encoded_length  : encoded payload length
+ * @param  *payload        : payload buffer
+ * @param  payload_size    : payload buffer size
+ * @retval int16_t         : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_codec_dict_decode(const char *encoded, uint16_t encoded_length, char *payload, uint16_t payload_size);
+
+
+/*********************************************************
+ * @brief  Function to encode a payload with the smallest
+ *         of the codecs in the codec mask
+ * @param  *payload         : payload
+ * @param  payload_length   : payload length
+ * @param  *encoded         : encoded payload buffer
+ * @param  encoded_size     : encoded payload buffer size
+ * @param  codecs           : COMMS_CODEC_MASK bits
+ * @param  *encoded_length  : encoded payload length
+ * @retval uint8_t          : raw payload smaller: COMMS_CODEC_NONE,
+ *                            success: comms_codec_t
+ *********************************************************/
+uint8_t comms_codec_encode(const char *payload, uint16_t payload_length, char *encoded, uint16_t encoded_size,
+                           uint8_t codecs, uint16_t *encoded_length);
+
+
+/*********************************************************
+ * @brief  Function to decode a payload
+ * @param  codec           : comms_codec_t
+ * @param  *encoded        : encoded payload
+ * @param  encoded_length  : encoded payload length
+ * @param  *payload        : payload buffer
+ * @param  payload_size    : payload buffer size
+ * @retval int16_t         : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_codec_decode(uint8_t codec, const char *encoded, uint16_t encoded_length, char *payload,
+                           uint16_t payload_size);
+
+
+
+#endif /* COMMS_CODEC_H_ */
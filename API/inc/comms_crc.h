@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * @file    comms_crc.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network frame integrity CRC header file
+ *
+ *  Info
+ *          CRC-16/CCITT-FALSE and CRC-32 (IEEE 802.3) with lookup tables
+ *          generated by the preprocessor, per byte update for the receive
+ *          interrupt.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef COMMS_CRC_H_
+#define COMMS_CRC_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                            Macro Defines                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define COMMS_CRC16_INIT  0xFFFF
+#define COMMS_CRC32_INIT  0xFFFFFFFFUL
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Update CRC-16/CCITT-FALSE with one byte
+ * @param  crc      : running crc, start with COMMS_CRC16_INIT
+ * @param  data     : next byte
+ * @retval uint16_t : updated crc
+ *********************************************************/
+uint16_t comms_crc16_update(uint16_t crc, uint8_t data);
+
+
+/*********************************************************
+ * @brief  Calculate CRC-16/CCITT-FALSE of a buffer
+ * @param  *data    : buffer
+ * @param  length   : buffer length
+ * @retval uint16_t : crc
+ *********************************************************/
+uint16_t comms_crc16(const char *data, uint16_t length);
+
+
+/*********************************************************
+ * @brief  Update CRC-32 with one byte
+ * @param  crc      : running crc, start with COMMS_CRC32_INIT
+ * @param  data     : next byte
+ * @retval uint32_t : updated crc, final value is crc ^ COMMS_CRC32_INIT
+ *********************************************************/
+uint32_t comms_crc32_update(uint32_t crc, uint8_t data);
+
+
+/*********************************************************
+ * @brief  Calculate CRC-32 of a buffer
+ * @param  *data    : buffer
+ * @param  length   : buffer length
+ * @retval uint32_t : crc
+ *********************************************************/
+uint32_t comms_crc32(const char *data, uint32_t length);
+
+
+
+#endif /* COMMS_CRC_H_ */
@@ -0,0 +1,185 @@
+/**
+ ******************************************************************************
+ * @file    comms_fragment.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network message fragmentation header file
+ *
+ *  Info
+ *          Application messages longer than one frame are sent as fragments,
+ *          the fragment header holds a message id, the fragment index and a
+ *          last fragment flag. Fragments are reassembled in order into a
+ *          bounded set of caller owned buffers that time out in frames.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef COMMS_FRAGMENT_H_
+#define COMMS_FRAGMENT_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+#include "comms_network.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Last fragment flag in the fragment index byte, index in the lower 7 bits */
+#define COMMS_FRAGMENT_LAST   0x80
+#define COMMS_FRAGMENT_INDEX  0x7F
+
+
+/* Reassembly buffer states */
+typedef enum _net_reassembly_state
+{
+    NET_REASSEMBLY_FREE      = 0,  /*!< Buffer unused                        */
+    NET_REASSEMBLY_RECEIVING = 1,  /*!< Fragments received, more expected    */
+    NET_REASSEMBLY_COMPLETE  = 2   /*!< Message delivered, held for the app  */
+
+}net_reassembly_state_t;
+
+
+/* Reassembly buffer of one fragmented message */
+typedef struct _net_reassembly
+{
+    uint8_t  state;                           /*!< net_reassembly_state_t               */
+    uint8_t  source_id;                       /*!< Source client id                     */
+    uint8_t  message_id;                      /*!< Message id of the source             */
+    uint8_t  next_fragment;                   /*!< Expected fragment index              */
+    uint8_t  age;                             /*!< Frames since the last fragment       */
+    uint16_t length;                          /*!< Reassembled length                   */
+    char     data[COMMS_MAX_MESSAGE_LENGTH];  /*!< Reassembled message                  */
+
+}net_reassembly_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to get the fragment payload size, a
+ *         fragment fits the relayed CONTRL message
+ * @param  *network : reference to network handle structure
+ * @retval uint8_t  : payload bytes per fragment
+ *********************************************************/
+uint8_t comms_fragment_size(access_control_t *network);
+
+
+/*********************************************************
+ * @brief  Function to configure a fragment header
+ * @param  *header        : COMMS_FRAGMENT_HEADER_SIZE bytes
+ * @param  message_id     : message id of the sender
+ * @param  fragment_index : fragment index, 0 to 127
+ * @param  last           : last fragment of the message
+ * @retval uint8_t        : length of fragment header
+ *********************************************************/
+uint8_t comms_fragment_header(char *header, uint8_t message_id, uint8_t fragment_index, uint8_t last);
+
+
+/*********************************************************
+ * @brief  Function to get the fragment header values
+ * @param  *fragment        : fragment, header and payload
+ * @param  length           : fragment length
+ * @param  *message_id      : message id of the sender
+ * @param  *fragment_index  : fragment index
+ * @param  *last            : last fragment of the message
+ * @retval int16_t          : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_fragment_parse(const char *fragment, uint16_t length, uint8_t *message_id, uint8_t *fragment_index,
+                             uint8_t *last);
+
+
+/*********************************************************
+ * @brief  Function to initialize reassembly buffers
+ * @param  *buffers : reference to reassembly buffers
+ * @param  count    : number of buffers
+ *********************************************************/
+void init_reassembly(net_reassembly_t *buffers, uint8_t count);
+
+
+/*********************************************************
+ * @brief  Function to add a received fragment, fragments
+ *         of a message are accepted in order only, a
+ *         missing fragment drops the message
+ * @param  *buffers   : reference to reassembly buffers
+ * @param  count      : number of buffers
+ * @param  source_id  : source client id of the fragment
+ * @param  *fragment  : fragment, header and payload
+ * @param  length     : fragment length
+ * @param  **message  : reassembled message when complete
+ * @retval int16_t    : error: -1 invalid, -2 out of order,
+ *                      -3 no buffer, -4 too long,
+ *                      incomplete: 0, complete: length
+ *********************************************************/
+int16_t comms_reassembly_add(net_reassembly_t *buffers, uint8_t count, uint8_t source_id, const char *fragment,
+                             uint16_t length, const char **message);
+
+
+/*********************************************************
+ * @brief  Function to age reassembly buffers by one frame,
+ *         messages without fragment for
+ *         COMMS_REASSEMBLY_TIMEOUT frames are dropped
+ * @param  *buffers : reference to reassembly buffers
+ * @param  count    : number of buffers
+ * @retval uint8_t  : number of dropped messages
+ *********************************************************/
+uint8_t comms_reassembly_age(net_reassembly_t *buffers, uint8_t count);
+
+
+/*********************************************************
+ * @brief  Function to free the buffers of messages read
+ *         by the application
+ * @param  *buffers : reference to reassembly buffers
+ * @param  count    : number of buffers
+ *********************************************************/
+void comms_reassembly_release(net_reassembly_t *buffers, uint8_t count);
+
+
+
+#endif /* COMMS_FRAGMENT_H_ */
@@ -0,0 +1,365 @@
+/**
+ ******************************************************************************
+ * @file    comms_frame.h
+ * @author  Aditya Mall,
+ * @brief   (6314)comms frame layout descriptors header file.
+ *
+ *  Info
+ *          One descriptor table per message generates the field offsets, inline
+ *          byte/shift field accessors, field struct encoders and decoders and
+ *          compile time header size checks.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+
+#ifndef COMMS_FRAME_H_
+#define COMMS_FRAME_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "network_protocol_configs.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                            Macro Defines                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Field structs below use natural alignment */
+#pragma pack(push)
+#pragma pack()
+
+
+/* First byte after the preamble and the fixed header */
+#define COMMS_FRAME_FIELDS_START (NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH)
+
+/* Fixed header bytes */
+#define COMMS_FRAME_TYPE_BYTE      (NET_PREAMBLE_LENTH + 0)   /*!< (LSB) message status : 4, (MSB) message type : 4   */
+#define COMMS_FRAME_LENGTH_BYTE    (NET_PREAMBLE_LENTH + 1)   /*!< Message length                                     */
+#define COMMS_FRAME_CHECKSUM_BYTE  (NET_PREAMBLE_LENTH + 2)   /*!< Message checksum                                   */
+
+/* Second preamble byte, baseline preambles leave the integrity bits clear */
+#define COMMS_FRAME_INTEGRITY_BYTE 1                          /*!< (LSB) preamble id : 6, (MSB) integrity mode : 2    */
+#define COMMS_PREAMBLE_ID_MASK     0x3F                       /*!< Preamble id bits of COMMS_FRAME_INTEGRITY_BYTE     */
+
+
+/* Compile time check, fails with a negative array size */
+#define COMMS_FRAME_CHECK(condition, name) typedef char comms_frame_check_##name[(condition) ? 1 : -1]
+
+
+/*
+ * Message descriptors, FIELD(message, field, kind) in wire order after the fixed header,
+ * kind U8: one byte, U16: little endian 16 bit, MAC: NET_MAC_SIZE bytes
+ */
+
+#define COMMS_SYNC_FIELDS(FIELD)               \
+    FIELD(sync, network_id,            U16)    \
+    FIELD(sync, message_slot_number,   U8)     \
+    FIELD(sync, slot_time,             U16)    \
+    FIELD(sync, access_slot,           U8)     \
+    FIELD(sync, access_slots,          U8)     \
+    FIELD(sync, frame_number,          U8)     \
+    FIELD(sync, join_load,             U8)     \
+    FIELD(sync, frame_slots,           U8)
+
+#define COMMS_JOINREQ_FIELDS(FIELD)            \
+    FIELD(joinreq, source_mac,          MAC)   \
+    FIELD(joinreq, destination_mac,     MAC)   \
+    FIELD(joinreq, network_id,          U16)   \
+    FIELD(joinreq, message_slot_number, U8)    \
+    FIELD(joinreq, join_options,        U8)
+
+#define COMMS_JOINRESP_FIELDS(FIELD)           \
+    FIELD(joinresp, source_mac,          MAC)  \
+    FIELD(joinresp, destination_mac,     MAC)  \
+    FIELD(joinresp, network_id,          U16)  \
+    FIELD(joinresp, message_slot_number, U8)
+
+#define COMMS_STATUS_FIELDS(FIELD)               \
+    FIELD(status, network_id,            U16)    \
+    FIELD(status, message_slot_number,   U8)     \
+    FIELD(status, destination_client_id, U8)
+
+#define COMMS_CONTRL_FIELDS(FIELD)               \
+    FIELD(contrl, network_id,            U16)    \
+    FIELD(contrl, message_slot_number,   U8)     \
+    FIELD(contrl, source_client_id,      U8)     \
+    FIELD(contrl, destination_client_id, U8)
+
+#define COMMS_STATUSACK_FIELDS(FIELD)               \
+    FIELD(statusack, network_id,            U16)    \
+    FIELD(statusack, message_slot_number,   U8)     \
+    FIELD(statusack, destination_client_id, U8)
+
+
+/* All messages, MESSAGE(message, FIELDS) */
+#define COMMS_FRAME_MESSAGES(MESSAGE)            \
+    MESSAGE(sync,      COMMS_SYNC_FIELDS)        \
+    MESSAGE(joinreq,   COMMS_JOINREQ_FIELDS)     \
+    MESSAGE(joinresp,  COMMS_JOINRESP_FIELDS)    \
+    MESSAGE(status,    COMMS_STATUS_FIELDS)      \
+    MESSAGE(contrl,    COMMS_CONTRL_FIELDS)      \
+    MESSAGE(statusack, COMMS_STATUSACK_FIELDS)
+
+
+/* Field kinds, size, C type and array dimension */
+#define COMMS_FIELD_SIZE_U8   1
+#define COMMS_FIELD_SIZE_U16  2
+#define COMMS_FIELD_SIZE_MAC  NET_MAC_SIZE
+
+#define COMMS_FIELD_TYPE_U8   uint8_t
+#define COMMS_FIELD_TYPE_U16  uint16_t
+#define COMMS_FIELD_TYPE_MAC  char
+
+#define COMMS_FIELD_DIM_U8
+#define COMMS_FIELD_DIM_U16
+#define COMMS_FIELD_DIM_MAC   [NET_MAC_SIZE]
+
+
+/* Generated names */
+#define COMMS_FIELD_OFFSET(message, field)  message##_##field##_offset
+#define COMMS_PAYLOAD_OFFSET(message)       message##_payload_offset
+
+/* Message header size, bytes between the fixed header and the payload */
+#define COMMS_FRAME_HEADER_SIZE(message)    (COMMS_PAYLOAD_OFFSET(message) - COMMS_FRAME_FIELDS_START)
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                        Descriptor Generators                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Field offsets, every field ends one enumerator before the next field starts */
+#define COMMS_FRAME_ENUM_FIELD(message, field, kind)                                   \
+    COMMS_FIELD_OFFSET(message, field),                                                \
+    message##_##field##_last = COMMS_FIELD_OFFSET(message, field) + COMMS_FIELD_SIZE_##kind - 1,
+
+#define COMMS_FRAME_ENUM(message, FIELDS)                                              \
+    enum message##_frame_offsets                                                       \
+    {                                                                                  \
+        message##_fields_base = COMMS_FRAME_FIELDS_START - 1,                          \
+        FIELDS(COMMS_FRAME_ENUM_FIELD)                                                 \
+        COMMS_PAYLOAD_OFFSET(message)                                                  \
+    };
+
+
+/* Unpacked field struct */
+#define COMMS_FRAME_MEMBER(message, field, kind) COMMS_FIELD_TYPE_##kind field COMMS_FIELD_DIM_##kind;
+
+#define COMMS_FRAME_STRUCT(message, FIELDS)                                            \
+    typedef struct message##_fields                                                    \
+    {                                                                                  \
+        FIELDS(COMMS_FRAME_MEMBER)                                                     \
+    }message##_fields_t;
+
+
+/* Field accessors, byte loads and shifts, no alignment or host byte order assumptions */
+#define COMMS_FRAME_ACCESSORS_U8(message, field)                                                 \
+    static inline uint8_t comms_##message##_get_##field(const char *frame)                       \
+    {                                                                                            \
+        return (uint8_t)frame[COMMS_FIELD_OFFSET(message, field)];                               \
+    }                                                                                            \
+    static inline void comms_##message##_set_##field(char *frame, uint8_t value)                 \
+    {                                                                                            \
+        frame[COMMS_FIELD_OFFSET(message, field)] = (char)value;                                 \
+    }
+
+#define COMMS_FRAME_ACCESSORS_U16(message, field)                                                \
+    static inline uint16_t comms_##message##_get_##field(const char *frame)                      \
+    {                                                                                            \
+        return (uint16_t)((uint8_t)frame[COMMS_FIELD_OFFSET(message, field)] |                   \
+                          ((uint16_t)(uint8_t)frame[COMMS_FIELD_OFFSET(message, field) + 1] << 8)); \
+    }                                                                                            \
+    static inline void comms_##message##_set_##field(char *frame, uint16_t value)                \
+    {                                                                                            \
+        frame[COMMS_FIELD_OFFSET(message, field)]     = (char)(value & 0xFF);                    \
+        frame[COMMS_FIELD_OFFSET(message, field) + 1] = (char)(value >> 8);                      \
+    }
+
+#define COMMS_FRAME_ACCESSORS_MAC(message, field)                                                \
+    static inline void comms_##message##_get_##field(const char *frame, char *value)             \
+    {                                                                                            \
+        memcpy(value, frame + COMMS_FIELD_OFFSET(message, field), NET_MAC_SIZE);                 \
+    }                                                                                            \
+    static inline void comms_##message##_set_##field(char *frame, const char *value)             \
+    {                                                                                            \
+        memcpy(frame + COMMS_FIELD_OFFSET(message, field), value, NET_MAC_SIZE);                 \
+    }
+
+#define COMMS_FRAME_ACCESSORS(message, field, kind) COMMS_FRAME_ACCESSORS_##kind(message, field)
+
+
+/* Field struct encoder and decoder, one inline accessor per field */
+#define COMMS_FRAME_ENCODE_FIELD(message, field, kind) comms_##message##_set_##field(frame, fields->field);
+
+#define COMMS_FRAME_DECODE_U8(message, field)   fields->field = comms_##message##_get_##field(frame);
+#define COMMS_FRAME_DECODE_U16(message, field)  fields->field = comms_##message##_get_##field(frame);
+#define COMMS_FRAME_DECODE_MAC(message, field)  comms_##message##_get_##field(frame, fields->field);
+#define COMMS_FRAME_DECODE_FIELD(message, field, kind) COMMS_FRAME_DECODE_##kind(message, field)
+
+#define COMMS_FRAME_CODEC(message, FIELDS)                                                       \
+    static inline void comms_##message##_encode(char *frame, const message##_fields_t *fields)   \
+    {                                                                                            \
+        FIELDS(COMMS_FRAME_ENCODE_FIELD)                                                         \
+    }                                                                                            \
+    static inline void comms_##message##_decode(const char *frame, message##_fields_t *fields)   \
+    {                                                                                            \
+        FIELDS(COMMS_FRAME_DECODE_FIELD)                                                         \
+    }
+
+
+/* Message layout check against a packed message structure, struct type passed in by the caller */
+#define COMMS_FRAME_CHECK_FIELD(type, message, field)                                            \
+    COMMS_FRAME_CHECK(offsetof(type, field) == COMMS_FIELD_OFFSET(message, field), message##_##field##_offset)
+
+#define COMMS_FRAME_CHECK_PAYLOAD(type, message)                                                 \
+    COMMS_FRAME_CHECK(offsetof(type, payload) == COMMS_PAYLOAD_OFFSET(message), message##_payload_offset)
+
+
+#define COMMS_FRAME_GENERATE(message, FIELDS)                                          \
+    COMMS_FRAME_ENUM(message, FIELDS)                                                  \
+    COMMS_FRAME_STRUCT(message, FIELDS)                                                \
+    FIELDS(COMMS_FRAME_ACCESSORS)                                                      \
+    COMMS_FRAME_CODEC(message, FIELDS)
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Generated Offsets, Accessors and Codecs                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+COMMS_FRAME_MESSAGES(COMMS_FRAME_GENERATE)
+
+
+/* Hand maintained header lengths in network_protocol_configs.h */
+COMMS_FRAME_CHECK(JOINREQ_HEADER_SIZE   == COMMS_FRAME_HEADER_SIZE(joinreq),   joinreq_header_size);
+COMMS_FRAME_CHECK(JOINRESP_HEADER_SIZE  == COMMS_FRAME_HEADER_SIZE(joinresp),  joinresp_header_size);
+COMMS_FRAME_CHECK(STATUS_HEADER_SIZE    == COMMS_FRAME_HEADER_SIZE(status),    status_header_size);
+COMMS_FRAME_CHECK(CONTRL_HEADER_SIZE    == COMMS_FRAME_HEADER_SIZE(contrl),    contrl_header_size);
+COMMS_FRAME_CHECK(STATUSACK_HEADER_SIZE == COMMS_FRAME_HEADER_SIZE(statusack), statusack_header_size);
+
+/* Frames with the largest header still carry a payload */
+COMMS_FRAME_CHECK(COMMS_PAYLOAD_OFFSET(joinreq) + COMMS_TERMINATOR_LENGTH < NET_DATA_LENGTH, joinreq_frame_size);
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Fixed Header Accessors                            */
+/*                                                                            */
+/******************************************************************************/
+
+
+static inline uint8_t comms_frame_get_status(const char *frame)
+{
+    return (uint8_t)frame[COMMS_FRAME_TYPE_BYTE] & 0x0F;
+}
+
+static inline uint8_t comms_frame_get_type(const char *frame)
+{
+    return (uint8_t)frame[COMMS_FRAME_TYPE_BYTE] >> 4;
+}
+
+static inline uint8_t comms_frame_get_length(const char *frame)
+{
+    return (uint8_t)frame[COMMS_FRAME_LENGTH_BYTE];
+}
+
+/* Integrity mode in the upper two bits of the second preamble byte, 0 (sum8) on baseline frames */
+static inline uint8_t comms_frame_get_integrity(const char *frame)
+{
+    return (uint8_t)frame[COMMS_FRAME_INTEGRITY_BYTE] >> 6;
+}
+
+static inline uint8_t comms_frame_get_checksum(const char *frame)
+{
+    return (uint8_t)frame[COMMS_FRAME_CHECKSUM_BYTE];
+}
+
+static inline void comms_frame_set_status(char *frame, uint8_t status)
+{
+    frame[COMMS_FRAME_TYPE_BYTE] = (char)(((uint8_t)frame[COMMS_FRAME_TYPE_BYTE] & 0xF0) | (status & 0x0F));
+}
+
+static inline void comms_frame_set_type(char *frame, uint8_t type)
+{
+    frame[COMMS_FRAME_TYPE_BYTE] = (char)(((uint8_t)frame[COMMS_FRAME_TYPE_BYTE] & 0x0F) | (uint8_t)(type << 4));
+}
+
+static inline void comms_frame_set_length(char *frame, uint8_t length)
+{
+    frame[COMMS_FRAME_LENGTH_BYTE] = (char)length;
+}
+
+static inline void comms_frame_set_integrity(char *frame, uint8_t integrity)
+{
+    frame[COMMS_FRAME_INTEGRITY_BYTE] = (char)(((uint8_t)frame[COMMS_FRAME_INTEGRITY_BYTE] & COMMS_PREAMBLE_ID_MASK) |
+                                               (uint8_t)(integrity << 6));
+}
+
+static inline void comms_frame_set_checksum(char *frame, uint8_t checksum)
+{
+    frame[COMMS_FRAME_CHECKSUM_BYTE] = (char)checksum;
+}
+
+/* Preamble, big endian */
+static inline void comms_frame_set_preamble(char *frame, uint16_t preamble)
+{
+    frame[0] = (char)(preamble >> 8);
+    frame[1] = (char)(preamble & 0xFF);
+}
+
+
+#pragma pack(pop)
+
+
+#endif /* COMMS_FRAME_H_ */
@@ -0,0 +1,173 @@
+/**
+ ******************************************************************************
+ * @file    comms_mailbox.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network server downlink mailbox header file
+ *
+ *  Info
+ *          CONTRL messages for low power clients wait in a bounded mailbox
+ *          of the server. Each SYNC message announces the oldest messages
+ *          in its mail bitmap and the server sends them in the broadcast
+ *          slot of the next frame, the only frame a sleeping client listens
+ *          past the SYNC slot.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef COMMS_MAILBOX_H_
+#define COMMS_MAILBOX_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+#include "comms_network.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* One CONTRL message held for a low power client */
+typedef struct _net_mail
+{
+    uint8_t destination_id;            /*!< Destination client id              */
+    uint8_t source_id;                 /*!< Source client id                   */
+    uint8_t codec;                     /*!< Payload codec, COMMS_CODEC_NONE    */
+    uint8_t fragment;                  /*!< Payload is a message fragment      */
+    uint8_t announced;                 /*!< Announced in the last SYNC message */
+    uint8_t length;                    /*!< Payload length                     */
+    char    payload[NET_DATA_LENGTH];  /*!< CONTRL message payload             */
+
+}net_mail_t;
+
+
+/* Server mailbox, messages in arrival order */
+typedef struct _comms_mailbox
+{
+    uint8_t    count;                          /*!< Held messages                */
+    net_mail_t messages[COMMS_MAILBOX_SIZE];   /*!< Messages, oldest first       */
+
+}comms_mailbox_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to initialize a mailbox
+ * @param  *mailbox : reference to server mailbox
+ *********************************************************/
+void init_mailbox(comms_mailbox_t *mailbox);
+
+
+/*********************************************************
+ * @brief  Function to get the number of messages held
+ *         for a client
+ * @param  *mailbox       : reference to server mailbox
+ * @param  destination_id : destination client id
+ * @retval uint8_t        : number of held messages
+ *********************************************************/
+uint8_t comms_mailbox_count(const comms_mailbox_t *mailbox, uint8_t destination_id);
+
+
+/*********************************************************
+ * @brief  Function to hold a CONTRL message for a client,
+ *         at most COMMS_MAILBOX_DEPTH per client, client
+ *         ids beyond the SYNC mail bitmap are never announced
+ * @param  *mailbox       : reference to server mailbox
+ * @param  destination_id : destination client id
+ * @param  source_id      : source client id
+ * @param  codec          : payload codec
+ * @param  fragment       : payload is a message fragment
+ * @param  *payload       : CONTRL message payload
+ * @param  length         : payload length
+ * @retval int8_t         : error (mailbox full, id not
+ *                          announced): -1, success: 0
+ *********************************************************/
+int8_t comms_mailbox_add(comms_mailbox_t *mailbox, uint8_t destination_id, uint8_t source_id, uint8_t codec,
+                         uint8_t fragment, const char *payload, uint8_t length);
+
+
+/*********************************************************
+ * @brief  Function to announce the oldest messages, sets
+ *         the bit of each destination client id
+ * @param  *mailbox     : reference to server mailbox
+ * @param  *bitmap      : mail bitmap, one bit per client id
+ * @param  bitmap_size  : bitmap size in bytes
+ * @param  limit        : messages sent in one broadcast slot
+ * @retval uint8_t      : number of announced messages
+ *********************************************************/
+uint8_t comms_mailbox_announce(comms_mailbox_t *mailbox, uint8_t *bitmap, uint8_t bitmap_size, uint8_t limit);
+
+
+/*********************************************************
+ * @brief  Function to get the oldest announced message
+ * @param  *mailbox    : reference to server mailbox
+ * @retval net_mail_t  : none announced: NULL, success: message
+ *********************************************************/
+net_mail_t* comms_mailbox_peek(comms_mailbox_t *mailbox);
+
+
+/*********************************************************
+ * @brief  Function to remove the oldest message
+ * @param  *mailbox : reference to server mailbox
+ *********************************************************/
+void comms_mailbox_pop(comms_mailbox_t *mailbox);
+
+
+/*********************************************************
+ * @brief  Function to drop the messages of a client that
+ *         left the network
+ * @param  *mailbox       : reference to server mailbox
+ * @param  destination_id : destination client id
+ * @retval uint8_t        : number of dropped messages
+ *********************************************************/
+uint8_t comms_mailbox_release(comms_mailbox_t *mailbox, uint8_t destination_id);
+
+
+
+#endif /* COMMS_MAILBOX_H_ */
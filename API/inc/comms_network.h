@@ -50,6 +50,8 @@
  */
 #include <stdint.h>
 #include "network_protocol_configs.h"
+#include "comms_crc.h"
+#include "comms_trace.h"
 
 
 /******************************************************************************/
@@ -58,7 +60,9 @@
 /*                                                                            */
 /******************************************************************************/
 
-#pragma pack(1)
+/* Structures use natural alignment, only the wire messages are packed */
+#pragma pack(push)
+#pragma pack()
 
 
 #define COMMS_NET_PREAMBLE_LENGTH      2
@@ -81,6 +85,9 @@ typedef struct _device_config
     uint16_t  device_network_id;         /*!< Device Network ID, user defined                                      */
     uint8_t   network_access_slot;       /*!< Device Access Slot number, configs header file defined               */
     uint8_t   device_slot_number;        /*!< Device Slot Number, user defined                                     */
+    uint8_t   device_frame_slot;         /*!< Superframe slot number, 0: slot number is the device slot number     */
+    uint8_t   device_slot_period;        /*!< Superframe period, slot every 2^n frames, set by the server on join  */
+    uint8_t   device_slot_offset;        /*!< Superframe frame offset, frame number mod 2^n                        */
     uint16_t  device_slot_time;          /*!< Time of each slot interval, user defined                             */
     uint8_t   total_slots;               /*!< Total number of slots, user defined, changes in server on runtime    */
     uint8_t   network_joined;            /*!< Network Joined State, changed by client on runtime                   */
@@ -99,13 +106,27 @@ typedef enum _network_slot
     NET_ACCESS_SLOT        = COMMS_ACCESS_SLOTNUM,    /*!< Server Access Slot number    */
     NET_BROADCAST_SLOT     = COMMS_BROADCAST_SLOTNUM, /*!< Server Broadcast Slot number */
     NET_CLIENT_ACCESS_SLOT,
-    NET_CLIENT_SLOT
+    NET_CLIENT_SLOT,
+    NET_FRAME_SLOT,                                   /*!< Server frame of the last SYNC message          */
+    NET_FRAME_REST_SLOT,                              /*!< Rest of the server frame after broadcast slot  */
+    NET_CLIENT_WAKE_SLOT                              /*!< Low power client radio wake, wake_slots        */
 
 }network_slot_t;
 
 
 
-/* Network buffer message flags */
+/* Frame integrity modes, carried in the fixed header */
+typedef enum _net_integrity
+{
+    NET_INTEGRITY_SUM8  = 0,  /*!< 8 bit additive checksum in the fixed header */
+    NET_INTEGRITY_CRC16 = 1,  /*!< CRC-16/CCITT-FALSE trailer, little endian   */
+    NET_INTEGRITY_CRC32 = 2   /*!< CRC-32 trailer, little endian               */
+
+}net_integrity_t;
+
+
+
+/* Network buffer message flags, received event types */
 typedef enum _message_flags
 {
     CLEAR_FLAG        = 0,  /*!< clear message flag              */
@@ -128,16 +149,62 @@ typedef struct _application_flags
     uint8_t application_message_ready : 1;  /*!< App message ready flag, user enabled                  */
     uint8_t network_message_ready     : 1;  /*!< Network message ready flag, client/ server controlled */
     uint8_t gateway_connected         : 1;  /*!< Connection state of gateway to the server             */
-    uint8_t reserved                  : 2;
+    uint8_t network_unjoin_request    : 1;  /*!< Leave the network and release slots, user enabled     */
+    uint8_t network_hibernate_request : 1;  /*!< Hibernate and release slots, user enabled             */
 
 }app_flags_t;
 
 
-typedef struct network_queue
+/* Received frame event, message type and frame buffer */
+typedef struct _net_event
+{
+    uint8_t type;                   /*!< Message type, message_flags_t value */
+    uint8_t length;                 /*!< Frame length                        */
+    uint8_t acked;                  /*!< STATUS ack bit set, consumer only   */
+    char    data[NET_DATA_LENGTH];  /*!< Frame                               */
+
+}net_event_t;
+
+
+/* Compile time check, ring index wraps with a mask and the uint8_t head - tail full test holds the ring size */
+typedef char net_event_queue_size_check[((NET_EVENT_QUEUE_SIZE & (NET_EVENT_QUEUE_SIZE - 1)) == 0 &&
+                                         NET_EVENT_QUEUE_SIZE <= 128) ? 1 : -1];
+
+
+/* Single producer (receive interrupt), single consumer (state machine) event ring */
+typedef struct _net_event_queue
+{
+    net_event_t      events[NET_EVENT_QUEUE_SIZE];  /*!< Event storage                              */
+    volatile uint8_t head;                          /*!< Next write, written by the producer only   */
+    volatile uint8_t tail;                          /*!< Next read, written by the consumer only    */
+
+}net_event_queue_t;
+
+
+/* Receive frame parser states, one byte is consumed per state transition */
+typedef enum _net_rx_state
+{
+    NET_RX_PREAMBLE_MSB = 0,  /*!< Hunting first preamble byte      */
+    NET_RX_PREAMBLE_LSB = 1,  /*!< Second preamble byte             */
+    NET_RX_HEADER       = 2,  /*!< Message type and status          */
+    NET_RX_LENGTH       = 3,  /*!< Remaining length after checksum  */
+    NET_RX_CHECKSUM     = 4,  /*!< Message checksum                 */
+    NET_RX_BODY         = 5   /*!< Body bytes until length is met   */
+
+}net_rx_state_t;
+
+
+/* Receive frame parser, driven by the receive interrupt one byte at a time */
+typedef struct _net_rx_parser
 {
-    char data[NET_DATA_LENGTH];
+    uint8_t  state;           /*!< Current net_rx_state_t                      */
+    uint8_t  frame_length;    /*!< Expected frame length from the fixed header */
+    uint8_t  integrity_mode;  /*!< Integrity mode of the current frame         */
+    uint8_t  trailer_length;  /*!< CRC trailer length of the current frame     */
+    uint8_t  checksum;        /*!< Running checksum of the body bytes          */
+    uint32_t crc;             /*!< Running CRC of the current frame            */
 
-}net_queue_t;
+}net_rx_parser_t;
 
 
 /* Network buffer structure for message passing between network and user applications */
@@ -149,17 +216,66 @@ typedef struct _comms_network_buffer
     char            network_message[NET_DATA_LENGTH];      /*!< Network message buffer, filled by network                 */
     uint16_t        app_message_length;                    /*!< Application message length                                */
     uint16_t        net_message_length;                    /*!< Network message length                                    */
-    message_flags_t flag_state;                            /*!< Network message flag states                               */
+    const char     *app_message_data;                      /*!< Application message, application_message or user buffer   */
+    const char     *network_message_data;                  /*!< Network message, network_message or reassembly buffer     */
     uint8_t         source_id;                             /*!< Network message source ID                                 */
     uint8_t         destination_id;                        /*!< Network Message destination ID                            */
 
-    net_queue_t     network_queue[4];
-    uint16_t        queue_pos;
+    net_event_queue_t rx_events;                           /*!< Received frame events for the state machine               */
+    net_rx_parser_t   rx_parser;                           /*!< Receive interrupt frame parser state                      */
 
 }comms_network_buffer_t;
 
 
 
+/* Node metrics, counters and histograms updated on the hot paths, counters wrap around.
+ * Join and CLIENT_NOT_FOUND counters are replies sent by a server and received by a client,
+ * every field has a single writer, the receive interrupt or the state machine */
+typedef struct _comms_metrics
+{
+    uint32_t frames_rx[16];                    /*!< Valid frames received by message type                  */
+    uint32_t frames_tx[16];                    /*!< Frames sent by message type                            */
+    uint32_t frames_received;                  /*!< Valid frames received                                  */
+    uint32_t frames_sent;                      /*!< Frames sent                                            */
+    uint32_t sync_frames;                      /*!< Frames, SYNC messages of the server or a joined client */
+    uint16_t checksum_errors;                  /*!< Frames dropped on checksum or CRC mismatch             */
+    uint16_t length_errors;                    /*!< Frames dropped on invalid length                       */
+    uint16_t resync_bytes;                     /*!< Bytes skipped while hunting a preamble                 */
+    uint16_t rx_dropped[16];                   /*!< Frames dropped on full receive ring by message type    */
+    uint16_t join_accepted;                    /*!< JOINRESP_ACK                                           */
+    uint16_t join_rejected;                    /*!< JOINRESP_NACK, client table full                       */
+    uint16_t join_duplicates;                  /*!< JOINREQ_DUP, client already in the table               */
+    uint16_t client_not_found;                 /*!< CLIENT_NOT_FOUND replies                               */
+    uint16_t sync_missed;                      /*!< SYNC messages missed by a joined client, frame numbers */
+    uint16_t qos_retransmits;                  /*!< QoS 1 STATUS messages sent again, not acknowledged    */
+    uint16_t qos_dropped;                      /*!< QoS 1 STATUS messages dropped after the last retry    */
+    uint16_t qos_duplicates;                   /*!< Retransmitted STATUS messages received again, dropped */
+    uint16_t mailbox_held;                     /*!< CONTRL messages held for low power clients            */
+    uint16_t mailbox_dropped;                  /*!< CONTRL messages dropped on a full mailbox             */
+    uint16_t clients_expired;                  /*!< Keep alive clients released, silent for a period      */
+    uint16_t slot_usage[COMMS_METRICS_BINS];   /*!< Frames by used client slots, server: received frames,
+                                                    client: sent frames in the last frame                  */
+    uint16_t queue_depth[COMMS_METRICS_BINS];  /*!< State machine steps by receive ring depth              */
+    uint8_t  snapshot_frames;                  /*!< Frames since the last metrics_snapshot call            */
+
+}comms_metrics_t;
+
+
+
+/* Frame segment for gather send, frames are sent as a header followed by segments */
+typedef struct _net_segment
+{
+    const char *data;    /*!< Segment bytes   */
+    uint16_t    length;  /*!< Segment length  */
+
+}net_segment_t;
+
+
+/* Segments of one gather send, header and CRC trailer included */
+#define NET_MAX_SEGMENTS 6
+
+
+
 /* Network operations callback structure */
 typedef struct _network_operations
 {
@@ -167,6 +283,9 @@ typedef struct _network_operations
     int8_t (*send_message)(char *message_buffer, uint16_t message_length);          /*!< Send function               */
     int8_t (*recv_message)(char *message_buffer, uint16_t message_length);          /*!< Receive function            */
 
+    /* Optional gather send, comms_send_v assembles a frame for send_message when NULL */
+    int8_t (*send_message_v)(const net_segment_t *segments, uint8_t segment_count); /*!< Gather send function        */
+
     /* Transmit timer and receive interrupt operations */
     int8_t (*set_tx_timer)(uint16_t device_slot_time, uint8_t device_slot_number);  /*!< Set transmit timer function */
     int8_t (*reset_tx_timer)(void);                                                 /*!< Reset transmit timer        */
@@ -176,6 +295,16 @@ typedef struct _network_operations
     int8_t (*request_timeout)(uint8_t timeout_seconds);                             /*!< Request timeout             */
     int8_t (*response_timeout)(uint8_t timeout_seconds);                            /*!< Response timeout            */
 
+    /* Optional metrics copy, called from the state machine every COMMS_METRICS_FRAMES frames */
+    int8_t (*metrics_snapshot)(const comms_metrics_t *metrics);                     /*!< Metrics snapshot function   */
+
+    /* Optional trace record timestamp, called from interrupt context */
+    uint32_t (*trace_timestamp)(void);                                              /*!< Trace timestamp function    */
+
+    /* Optional radio power operations, low power clients sleep between the slots they need */
+    int8_t (*radio_sleep)(void);                                                    /*!< Radio sleep, after the frame being received */
+    int8_t (*radio_wake)(void);                                                     /*!< Radio wake function         */
+
 #if ACTIVITY_OPERATIONS
     /* Network activity status operations */
     int8_t (*sync_activity_status)(void);                                           /*!< Sync status                 */
@@ -194,6 +323,8 @@ typedef struct _network_operations
 }network_operations_t;
 
 
+#pragma pack(1)
+
 /* Network header */
 typedef struct _wi_network_header
 {
@@ -213,6 +344,8 @@ struct _network_message
 
 };
 
+#pragma pack()
+
 /* Network Header structure declaration */
 typedef struct _network_message network_message_t;
 
@@ -227,6 +360,19 @@ typedef struct _access_control
     network_message_t    *packet_type;       /*!< Network message packet structure */
     sync_packet_t        *sync_message;      /*!< Sync message packet structure    */
     network_operations_t *network_commands;  /*!< Network operations structure     */
+    comms_metrics_t       metrics;           /*!< Node metrics                     */
+    comms_trace_t        *trace;             /*!< Deferred debug trace, optional   */
+    uint16_t              network_id;        /*!< Network id of the server         */
+    uint8_t               integrity_mode;    /*!< Integrity mode of sent frames    */
+    uint8_t               frame_number;      /*!< Frame number of the next SYNC    */
+    uint8_t               join_load;         /*!< Join load hint of the next SYNC  */
+    uint8_t               access_slot;       /*!< First access slot of the frame   */
+    uint8_t               access_slots;      /*!< Access slots of the frame        */
+    uint8_t               frame_slots;       /*!< Frame length of the next SYNC    */
+    uint8_t               wake_slots;        /*!< Slots to the next radio wake     */
+    uint8_t               radio_sleeping;    /*!< Radio put to sleep               */
+    uint8_t               status_acks[COMMS_SYNC_BITMAP_SIZE]; /*!< STATUS source ids of the frame */
+    uint8_t               clients_heard[COMMS_SYNC_BITMAP_SIZE]; /*!< Client frame source ids, keep alive */
 
 }access_control_t;
 
@@ -248,6 +394,15 @@ typedef struct _access_control
 access_control_t* create_network_handle(network_operations_t *network_ops);
 
 
+/**************************************************************************************
+ * @brief  Initialize caller owned network access handle object
+ * @param  *network              : reference to network access handle storage
+ * @param  *network_operations_t : reference to network operations handle
+ * @retval access_control_t      : error: NULL, success: address of the network handle
+ **************************************************************************************/
+access_control_t* init_network_handle(access_control_t *network, network_operations_t *network_ops);
+
+
 /**************************************************************************************
  * @brief  Constructor function to create server device configure object
  * @param  *mac_address          : mac_address of the server device
@@ -262,6 +417,19 @@ device_config_t* create_server_device(char *mac_address, uint16_t network_id, ui
                                       char *user_name, uint8_t *password);
 
 
+/**************************************************************************************
+ * @brief  Initialize caller owned server device configure object
+ * @param  *server_device        : reference to device configuration storage
+ * @param  *mac_address          : mac_address of the server device
+ * @param  network_id            : network id of the server
+ * @param  device_slot_time      : slot time interval
+ * @param  total_slots           : no of existing slots at start
+ * @retval device_config_t       : error: NULL, success: address of the device object
+ **************************************************************************************/
+device_config_t* init_server_device(device_config_t *server_device, char *mac_address, uint16_t network_id,
+                                    uint16_t device_slot_time, uint8_t total_slots, char *user_name, uint8_t *password);
+
+
 /**************************************************************************************
  * @brief  Constructor function to create client device configure object
  * @param  *mac_address          : mac_address of the server device
@@ -274,6 +442,17 @@ device_config_t* create_client_device(char *mac_address, uint8_t requested_total
                                       uint8_t *password);
 
 
+/**************************************************************************************
+ * @brief  Initialize caller owned client device configure object
+ * @param  *client_device        : reference to device configuration storage
+ * @param  *mac_address          : mac_address of the client device
+ * @param  requested_total_slots : number of slots requested
+ * @retval device_config_t       : error: NULL, success: address of the device object
+ **************************************************************************************/
+device_config_t* init_client_device(device_config_t *client_device, char *mac_address, uint8_t requested_total_slots,
+                                    char *user_name, uint8_t *password);
+
+
 /*******************************************************************
  * @brief  Function to send sync message through network hardware
  * @param  *network         : reference to network handle structure
@@ -284,6 +463,21 @@ device_config_t* create_client_device(char *mac_address, uint8_t requested_total
 int8_t comms_send(access_control_t *network, char *message_buffer, uint16_t message_length);
 
 
+/*******************************************************************
+ * @brief  Function to send a frame of a header and payload segments,
+ *         sets length, integrity mode and checksum in the header and
+ *         sends through send_message_v, or send_message if not set
+ * @param  *network       : reference to network handle structure
+ * @param  *header        : preamble, fixed header and message header
+ * @param  header_length  : header length, at least 5
+ * @param  *segments      : payload segments, terminator included
+ * @param  segment_count  : number of payload segments
+ * @retval int16_t        : error: -1, success: length of message
+ *******************************************************************/
+int16_t comms_send_v(access_control_t *network, char *header, uint8_t header_length, const net_segment_t *segments,
+                     uint8_t segment_count);
+
+
 /************************************************************************
  * @brief  Function to receive message through network hardware interrupt
  * @param  *network         : reference to network handle structure
@@ -305,11 +499,37 @@ int8_t comms_client_recv_it(access_control_t *network, comms_network_buffer_t *r
 
 
 /*******************************************************************
- * @brief  Function to send application message.
+ * @brief  Function to get the oldest received frame event
+ * @param  *recv_buffer : reference to network buffer structure
+ * @retval net_event_t  : empty: NULL, success: oldest event
+ *******************************************************************/
+net_event_t* comms_event_peek(comms_network_buffer_t *recv_buffer);
+
+
+/*******************************************************************
+ * @brief  Function to get a queued received frame event
+ * @param  *recv_buffer : reference to network buffer structure
+ * @param  position     : events before it, 0 is the oldest event
+ * @retval net_event_t  : not queued: NULL, success: event
+ *******************************************************************/
+net_event_t* comms_event_peek_at(comms_network_buffer_t *recv_buffer, uint8_t position);
+
+
+/*******************************************************************
+ * @brief  Function to release the oldest received frame event
+ * @param  *recv_buffer : reference to network buffer structure
+ *******************************************************************/
+void comms_event_pop(comms_network_buffer_t *recv_buffer);
+
+
+/*******************************************************************
+ * @brief  Function to send application message, messages longer
+ *         than a frame are sent as fragments from the user buffer,
+ *         which must be kept until application_message_ready clears
  * @param  *network         : reference to network buffer structure
  * @param  *message_buffer  : user message
- * @param  message_length   : message length
- * @retval int8_t           : error: -2, success: length of message
+ * @param  message_length   : message length, COMMS_MAX_MESSAGE_LENGTH
+ * @retval int8_t           : error: -1, success: 1
  *******************************************************************/
 int8_t send_application_message(comms_network_buffer_t *network_buffer, char *user_message, uint16_t message_length);
 
@@ -334,6 +554,67 @@ int8_t comms_network_set_timer(access_control_t *network, device_config_t *devic
 int8_t comms_network_checksum(char *data, uint8_t offset, uint8_t size);
 
 
+/*********************************************************
+ * @brief  Function to select integrity mode of sent frames,
+ *         frames of every mode are accepted on receive
+ * @param  *network : reference to network handle structure
+ * @param  mode     : frame integrity mode
+ * @retval int8_t   : error: -1, success: 0
+ *********************************************************/
+int8_t comms_network_set_integrity(access_control_t *network, net_integrity_t mode);
+
+
+/*********************************************************
+ * @brief  Function to get the largest frame to build for
+ *         the integrity mode of sent frames, receivers hold
+ *         NET_DATA_LENGTH bytes including the CRC trailer
+ * @param  *network : reference to network handle structure
+ * @retval uint8_t  : frame length without CRC trailer
+ *********************************************************/
+uint8_t comms_network_frame_limit(access_control_t *network);
+
+
+/*********************************************************
+ * @brief  Function to count a state machine step in the
+ *         node metrics, bins the receive ring depth
+ * @param  *network     : reference to network handle structure
+ * @param  *recv_buffer : reference to network buffer structure
+ *********************************************************/
+void comms_metrics_step(access_control_t *network, comms_network_buffer_t *recv_buffer);
+
+
+/*********************************************************
+ * @brief  Function to count a frame (SYNC message) in the
+ *         node metrics, bins the used client slots and
+ *         calls metrics_snapshot every COMMS_METRICS_FRAMES
+ * @param  *network    : reference to network handle structure
+ * @param  slot_frames : frames in client slots of the frame
+ * @retval int8_t      : error: -18, success: 0
+ *********************************************************/
+int8_t comms_metrics_frame(access_control_t *network, uint32_t slot_frames);
+
+
+/*********************************************************
+ * @brief  Function to copy the node metrics, the state
+ *         machine and receive interrupt keep running
+ * @param  *network  : reference to network handle structure
+ * @param  *metrics  : reference to metrics copy
+ * @retval int8_t    : error: -18, success: 0
+ *********************************************************/
+int8_t comms_metrics_snapshot(access_control_t *network, comms_metrics_t *metrics);
+
+
+/*********************************************************
+ * @brief  Portable long to string conversion, replaces the
+ *         non standard ltoa of the TI compiler runtime
+ * @param  N      : value to convert
+ * @param  *str   : output string buffer
+ * @param  base   : number base (2 - 36, default 10)
+ * @retval char*  : output string buffer
+ *********************************************************/
+char *api_ltoa(long N, char *str, int base);
+
+
 
 /******************************************************************************/
 /*                                                                            */
@@ -382,6 +663,24 @@ int8_t comms_clear_activity(access_control_t *network);
 int8_t comms_net_connected_status(access_control_t *network);
 
 
+/************************************************************
+ * @brief  Function to put the radio to sleep, optional
+ *         radio_sleep operation of low power clients
+ * @param  *network  : reference to network handle structure
+ * @retval int8_t    : error = -19, success = 0
+ ************************************************************/
+int8_t comms_radio_sleep(access_control_t *network);
+
+
+/************************************************************
+ * @brief  Function to wake the radio, optional radio_wake
+ *         operation of low power clients
+ * @param  *network  : reference to network handle structure
+ * @retval int8_t    : error = -19, success = 0
+ ************************************************************/
+int8_t comms_radio_wake(access_control_t *network);
+
+
 
 
 /******************************************************************************/
@@ -393,7 +692,8 @@ int8_t comms_net_connected_status(access_control_t *network);
 
 
 /**********************************************************************
- * @brief  Function to print joinreq debug message
+ * @brief  Function to print joinreq debug message, recorded
+ *         in the trace ring when a trace is attached
  *         Prints: " JOINREQ (SL:x) "
  * @param  *network             : reference to network handle structure
  * @param  debug_message        : debug message
@@ -405,7 +705,8 @@ int8_t comms_joinreq_debug_print(access_control_t *network, char *debug_message,
 
 
 /************************************************************************
- * @brief  Function to print joinresp debug message
+ * @brief  Function to print joinresp debug message, recorded
+ *         in the trace ring when a trace is attached
  *         Prints: " JOINRESP (ID:x) "
  * @param  *network              : reference to network handle structure
  * @param  debug_message         : debug message
@@ -417,7 +718,8 @@ int8_t comms_joinresp_debug_print(access_control_t *network, char *debug_message
 
 
 /***********************************************************************
- * @brief  Function to print status message debug
+ * @brief  Function to print status message debug, recorded
+ *         in the trace ring when a trace is attached
  *         Prints: " STATUS (DID:x LEN:x) DATA: 'message' "
  * @param  *network             : reference to network handle structure
  * @param  debug_message        : debug message
@@ -430,7 +732,8 @@ int8_t comms_status_debug_print(access_control_t *network, char *debug_message,
 
 
 /*******************************************************************
- * @brief  Function to print status message debug
+ * @brief  Function to print status message debug, recorded
+ *         in the trace ring when a trace is attached
  *         Prints: " CONTRL (SID:x LEN:x) DATA: 'message' "
  * @param  *network        : reference to network handle structure
  * @param  debug_message   : debug message
@@ -442,6 +745,26 @@ int8_t comms_contrl_debug_print(access_control_t *network, char *debug_message,
                                 char *payload_data);
 
 
+/*******************************************************************
+ * @brief  Function to attach a trace ring, debug prints of the
+ *         state machine are recorded and printed by
+ *         comms_network_trace_flush, NULL prints directly
+ * @param  *network : reference to network handle structure
+ * @param  *trace   : reference to trace ring, or NULL
+ * @retval int8_t   : error: -1, success: 0
+ *******************************************************************/
+int8_t comms_network_set_trace(access_control_t *network, comms_trace_t *trace);
+
+
+/*******************************************************************
+ * @brief  Function to print the recorded trace, main loop side,
+ *         one net_debug_print call per record
+ * @param  *network : reference to network handle structure
+ * @retval int16_t  : error: -1, success: records printed
+ *******************************************************************/
+int16_t comms_network_trace_flush(access_control_t *network);
+
+
 
 /******************************************************************************/
 /*                                                                            */
@@ -461,6 +784,65 @@ int8_t comms_contrl_debug_print(access_control_t *network, char *debug_message,
 int8_t get_sync_data(device_config_t *client_device, char *message_payload ,access_control_t network);
 
 
+/*************************************************************************
+ * @brief  Function to get the frame number of a sync message, clients
+ *         count missed sync messages from gaps in the frame number
+ * @param  *sync_frame : received sync message
+ * @retval uint8_t     : frame number
+ *************************************************************************/
+uint8_t comms_get_sync_frame(const char *sync_frame);
+
+
+/*************************************************************************
+ * @brief  Function to get the join load hint of a sync message, the
+ *         estimated number of clients contending for the access slot
+ * @param  *sync_frame : received sync message
+ * @retval uint8_t     : join load hint, 0 no contention
+ *************************************************************************/
+uint8_t comms_get_sync_join_load(const char *sync_frame);
+
+
+/*************************************************************************
+ * @brief  Function to get the access slots of a sync message, clients
+ *         send JOINREQ in one of the access slots from the first slot
+ * @param  *sync_frame : received sync message
+ * @param  *first_slot : first access slot number
+ * @retval uint8_t     : number of access slots, at least 1
+ *************************************************************************/
+uint8_t comms_get_sync_access_slots(const char *sync_frame, uint8_t *first_slot);
+
+
+/*************************************************************************
+ * @brief  Function to get the frame length of a sync message, the server
+ *         sends only in the sync and broadcast slots of each frame
+ * @param  *sync_frame : received sync message
+ * @retval uint8_t     : slots from SYNC to SYNC, 0 unknown
+ *************************************************************************/
+uint8_t comms_get_sync_frame_slots(const char *sync_frame);
+
+
+/*************************************************************************
+ * @brief  Function to read the ack bitmap of a sync message, the server
+ *         sets the bit of each client id with a STATUS message received
+ *         in the frame before the sync message
+ * @param  *sync_frame : received sync message
+ * @param  client_id   : client id of the STATUS message
+ * @retval uint8_t     : STATUS message received = 1, else 0
+ *************************************************************************/
+uint8_t comms_get_sync_ack(const char *sync_frame, uint8_t client_id);
+
+
+/*************************************************************************
+ * @brief  Function to read the mail bitmap of a sync message, the server
+ *         sends CONTRL messages held for the clients with the bit set in
+ *         the broadcast slot of the next frame
+ * @param  *sync_frame : received sync message
+ * @param  client_id   : client id
+ * @retval uint8_t     : mail announced = 1, else 0
+ *************************************************************************/
+uint8_t comms_get_sync_mail(const char *sync_frame, uint8_t client_id);
+
+
 
 
 
@@ -484,10 +866,25 @@ uint8_t comms_network_sync_message(access_control_t *server_device, uint16_t net
                                    char *payload, uint16_t payload_size);
 
 
+/***********************************************************************
+ * @brief  Function to build the sync message payload, the ack bitmap
+ *         of the QoS 1 client ids with a STATUS message accepted since
+ *         the last sync message and the mail bitmap, each behind its length
+ *         byte, clears the ack bitmap
+ * @param  *network     : reference to server network handle
+ * @param  *mail_bitmap : mail bitmap of COMMS_SYNC_BITMAP_SIZE, or NULL
+ * @param  *payload     : payload buffer of COMMS_SYNC_PAYLOAD_SIZE
+ * @retval uint8_t      : payload length
+ ***********************************************************************/
+uint8_t comms_network_sync_payload(access_control_t *network, const uint8_t *mail_bitmap, char *payload);
+
+
+
 
 
 
 
+#pragma pack(pop)
 
 
 #endif /* COMMS_NETWORK_H_ */
@@ -55,6 +55,7 @@
 #include <stdint.h>
 
 #include "comms_network.h"
+#include "comms_codec.h"
 
 
 /******************************************************************************/
@@ -64,13 +65,26 @@
 /******************************************************************************/
 
 
-#pragma pack(1)
+/* Structures use natural alignment, only the wire messages are packed */
+#pragma pack(push)
+#pragma pack()
 
 
 #define PREAMBLE_LENGTH 2
 #define PAYLOAD_LENGTH  20
 
 
+/* STATUS and CONTRL frame bytes before the payload */
+#define STATUS_FRAME_HEADER_LENGTH (NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH + STATUS_HEADER_SIZE)
+#define CONTRL_FRAME_HEADER_LENGTH (NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH + CONTRL_HEADER_SIZE)
+
+/* Message status of a payload codec, comms_codec_t */
+#define COMMS_CODEC_STATUS(codec) (CODEC_VARINT + (codec) - COMMS_CODEC_VARINT)
+
+/* Payload segments of a gather CONTRL message, prefix, payload and terminator */
+#define CONTRL_MAX_SEGMENTS 3
+
+
 
 /******************************************************************************/
 /*                                                                            */
@@ -90,6 +104,10 @@ typedef enum comms_message_status_codes
     CLIENT_NOT_FOUND  = 4,  /*!< */
     MESSSAGE_OK       = 5,  /*!< */
     JOINRESP_FALSE    = 6,  /*!< */
+    CONTRL_AGGREGATE  = 7,  /*!< CONTRL message of (source, destination, length, payload) records */
+    MESSAGE_FRAGMENT  = 8,  /*!< STATUS or CONTRL message payload is a message fragment            */
+    CODEC_VARINT      = 9,  /*!< STATUS or CONTRL message payload in COMMS_CODEC_VARINT            */
+    CODEC_DICT        = 10, /*!< STATUS or CONTRL message payload in COMMS_CODEC_DICT              */
 
 }comms_message_status;
 
@@ -98,6 +116,8 @@ typedef enum comms_message_status_codes
 /* Wireless Network Protocol Messages*/
 
 
+#pragma pack(1)
+
 /* Network Header */
 typedef struct comms_header
 {
@@ -108,6 +128,8 @@ typedef struct comms_header
 
 }comms_header_t;
 
+#pragma pack()
+
 
 typedef struct _joinreq joinreq_t;    /*!< JOINREQ message structure  */
 
@@ -154,6 +176,43 @@ int8_t comms_joinreq_options(protocol_handle_t *device, uint8_t qos, uint8_t kee
 
 
 
+/********************************************************
+ * @brief  Function to configure JOINREQ codec support,
+ *         the server relays encoded payloads to clients
+ *         with codec support
+ * @param  *device        : pointer to comms protocol handle
+ * @param  codec_support  : payload codecs supported set/reset
+ * @retval int8_t         : error -3, success: 1
+ ********************************************************/
+int8_t comms_joinreq_codec(protocol_handle_t *device, uint8_t codec_support);
+
+
+/********************************************************
+ * @brief  Function to configure the JOINREQ reporting
+ *         period, the server schedules the client slot
+ *         every 2^period frames in a shared superframe
+ *         slot
+ * @param  *client  : pointer to comms protocol handle
+ * @param  period   : period 2^n frames, 0 every frame
+ * @retval int8_t   : error -3, success: 1
+ ********************************************************/
+int8_t comms_joinreq_period(protocol_handle_t *client, uint8_t period);
+
+
+/********************************************************
+ * @brief  Function to configure the JOINREQ low power
+ *         flag, the server holds the CONTRL messages of a
+ *         sleeping client in a mailbox and announces them
+ *         in the mail bitmap of the SYNC message
+ * @param  *client     : pointer to comms protocol handle
+ * @param  low_power   : radio sleeps between slots set/reset
+ * @retval int8_t      : error -3, success: 1
+ ********************************************************/
+int8_t comms_joinreq_sleep(protocol_handle_t *client, uint8_t low_power);
+
+
+
+
 /****************************************************************
  * @brief  Function to configure JOINREQ message
  * @param  *client         : pointer to comms protocol handle
@@ -192,18 +251,85 @@ uint8_t comms_status_message(protocol_handle_t *client, device_config_t device,
 
 
 
-/*****************************************************
- * @brief  Function to configure STATUS message
- * @param  client : Protocol handle structure
- * @retval int8_t : error -6, success: message status
- *****************************************************/
-int8_t comms_get_statusack(protocol_handle_t client, uint16_t network_id, uint8_t device_id);
+/************************************************************************************
+ * @brief  Function to configure a STATUS frame without payload for the server,
+ *         UNJOIN, HIBERNATE or KEEPALIVE message
+ * @param  *client       : pointer to the protocol handle
+ * @param  device        : client device structure
+ * @param  message_type  : COMMS_UNJOIN_MESSAGE, COMMS_HIBERNATE_MESSAGE or
+ *                         COMMS_KEEPALIVE_MESSAGE
+ * @retval uint8_t       : error 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_notify_message(protocol_handle_t *client, device_config_t device, uint8_t message_type);
+
+
+
+
+/************************************************************************************
+ * @brief  Function to configure a STATUS message fragment
+ * @param  *client         : pointer to the protocol handle
+ * @param  device          : client device structure
+ * @param  destination_id  : destination id of device to send the fragment to
+ * @param  message_id      : message id of the fragmented message
+ * @param  fragment_index  : fragment index
+ * @param  last            : last fragment of the message
+ * @param  *payload        : fragment payload, up to comms_fragment_size() bytes
+ * @param  payload_length  : fragment payload length
+ * @retval uint8_t         : error 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_fragment_message(protocol_handle_t *client, device_config_t device, uint8_t destination_id,
+                                      uint8_t message_id, uint8_t fragment_index, uint8_t last,
+                                      const char *payload, uint16_t payload_length);
+
+
+
+
+/************************************************************************************
+ * @brief  Function to configure a STATUS message with an encoded payload
+ * @param  *client         : pointer to the protocol handle
+ * @param  device          : client device structure
+ * @param  destination_id  : destination id of device to send the status message to
+ * @param  codec           : payload codec, comms_codec_t
+ * @param  *payload        : encoded payload
+ * @param  payload_length  : encoded payload length
+ * @retval uint8_t         : error 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_codec_message(protocol_handle_t *client, device_config_t device, uint8_t destination_id,
+                                   uint8_t codec, const char *payload, uint16_t payload_length);
+
+
+
+
+/************************************************************************************
+ * @brief  Function to add the QoS 1 sequence number in front of the payload of a
+ *         configured STATUS message, plain, fragment or encoded
+ * @param  *client       : pointer to the protocol handle
+ * @param  sequence      : STATUS sequence number
+ * @param  frame_limit   : largest frame, comms_network_frame_limit()
+ * @retval uint8_t       : error (frame full) 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_sequence(protocol_handle_t *client, uint8_t sequence, uint8_t frame_limit);
+
+
+
+
+/*****************************************************************************
+ * @brief  Function to get the next acknowledged sequence number of a device
+ *         from the records of a STATUSACK message
+ * @param  client      : Protocol handle structure
+ * @param  network_id  : network id
+ * @param  device_id   : device slot number / device id
+ * @param  *record     : offset of the next record, 0 for the first call
+ * @retval int16_t     : error or no more records -6, success: sequence number
+ *****************************************************************************/
+int16_t comms_get_statusack(protocol_handle_t client, uint16_t network_id, uint8_t device_id, uint8_t *record);
 
 
 
 
 /*************************************************************************
- * @brief  Function to get CONTRL message
+ * @brief  Function to get CONTRL message, first record for the device
+ *         of an aggregated CONTRL message
  * @param  message_buffer    : message data from CONTRL message
  * @param  *source_client_id : pointer to client/device id of source device
  * @param  client            : Protocol handle structure
@@ -216,6 +342,62 @@ int8_t comms_get_contrl_data(char *message_buffer, uint8_t *source_client_id, pr
 
 
 
+/*************************************************************************
+ * @brief  Function to get a CONTRL message record, aggregated CONTRL
+ *         messages carry records for several devices, only records for
+ *         device_id are read
+ * @param  message_buffer    : message data from CONTRL message record
+ * @param  *source_client_id : pointer to client/device id of source device
+ * @param  client            : Protocol handle structure
+ * @param  network_id        : network id
+ * @param  device_id         : device slot number / device id
+ * @param  *record_offset    : record to read, 0 for the first one, set to
+ *                             the next record for device_id, 0 when none
+ * @retval int8_t            : error -7, success: message length of payload
+ **************************************************************************/
+int8_t comms_get_contrl_record(char *message_buffer, uint8_t *source_client_id, protocol_handle_t device,
+                               uint16_t network_id, uint8_t device_id, uint8_t *record_offset);
+
+
+
+
+/*************************************************************************
+ * @brief  Function to get a CONTRL message fragment
+ * @param  fragment_buffer   : fragment header and payload
+ * @param  *source_client_id : pointer to client/device id of source device
+ * @param  client            : Protocol handle structure
+ * @param  network_id        : network id
+ * @param  device_id         : device slot number / device id
+ * @retval int8_t            : error -7, not a fragment for the device: 0,
+ *                             success: length of fragment
+ **************************************************************************/
+int8_t comms_get_contrl_fragment(char *fragment_buffer, uint8_t *source_client_id, protocol_handle_t device,
+                                 uint16_t network_id, uint8_t device_id);
+
+
+
+
+/*****************************************************
+ * @brief  Function to get the payload codec of a
+ *         CONTRL message
+ * @param  client  : Protocol handle structure
+ * @retval uint8_t : raw payload: COMMS_CODEC_NONE,
+ *                   encoded: comms_codec_t
+ *****************************************************/
+uint8_t comms_get_contrl_codec(protocol_handle_t device);
+
+
+/*****************************************************
+ * @brief  Function to get the message status of a
+ *         CONTRL message
+ * @param  client  : Protocol handle structure
+ * @retval uint8_t : comms_message_status value
+ *****************************************************/
+uint8_t comms_get_contrl_status(protocol_handle_t device);
+
+
+
+
 /******************************************************************************/
 /*                                                                            */
 /*                    API Function Prototypes (Server)                        */
@@ -246,6 +428,22 @@ int8_t comms_set_joinresp_message_status(protocol_handle_t *server, int8_t statu
 uint8_t comms_joinresp_message(protocol_handle_t *server, device_config_t device_server, char *destination_mac, int8_t client_id);
 
 
+/***********************************************************************************
+ * @brief  Function to configure JOINRESP message of a superframe client, the
+ *         payload carries ":slot:period:offset" after the client id
+ * @param  *server         : reference to the protocol handle
+ * @param  device_server   : server protocol handle structure
+ * @param  destination_mac : destination mac address
+ * @param  client_id       : destination client id, new id given to the client
+ * @param  frame_slot      : superframe slot number
+ * @param  period          : superframe period, slot every 2^period frames
+ * @param  offset          : frame offset, frame number mod 2^period
+ * @retval uint8_t         : error 0, success: length of message
+ ***********************************************************************************/
+uint8_t comms_joinresp_superframe_message(protocol_handle_t *server, device_config_t device_server, char *destination_mac,
+                                          int8_t client_id, uint8_t frame_slot, uint8_t period, uint8_t offset);
+
+
 
 
 /******************************************************************************************
@@ -263,6 +461,22 @@ int16_t comms_get_status_message(protocol_handle_t server, device_config_t serve
 
 
 
+/******************************************************************************************
+ * @brief  Function to get STATUS Message payload in place, without copy
+ * @param  server                 : reference to the server protocol handle structure
+ * @param  server_device          : reference to the server device configuration structure
+ * @param  **client_payload       : reference to payload pointer, points into the frame
+ * @param  *source_client_id      : pointer to client/device id of source device
+ * @param  *destination_client_id : pointer to client/device id of destination device
+ * @retval int16_t                : error: -9, success: length of status message payload,
+ *                                  0 for notifications without payload
+ ******************************************************************************************/
+int16_t comms_get_status_payload(protocol_handle_t server, device_config_t server_device, const char **client_payload,
+                                 uint8_t *source_client_id, uint8_t *destination_client_id);
+
+
+
+
 /****************************************************************************************
  * @brief  Function to configure CONTRL message
  * @param  *server                : reference to the server protocol handle
@@ -279,6 +493,112 @@ uint8_t comms_control_message(protocol_handle_t *server, device_config_t device,
 
 
 
+/****************************************************************************************
+ * @brief  Function to configure CONTRL message header and payload segments for
+ *         comms_send_v, the payload is not copied
+ * @param  *server                : reference to the server protocol handle, contrl_msg
+ *                                  holds CONTRL_FRAME_HEADER_LENGTH bytes
+ * @param  device                 : reference to the server device structure
+ * @param  source_id              : client/device id of source device
+ * @param  destination_id         : client/device id of destination device
+ * @param  *payload               : CONTRL message payload
+ * @param  payload_length         : CONTRL message payload length
+ * @param  *segments              : CONTRL_MAX_SEGMENTS payload segments
+ * @retval uint8_t                : error: 0, success: number of payload segments
+ ****************************************************************************************/
+uint8_t comms_control_message_v(protocol_handle_t *server, device_config_t device, uint8_t source_id,
+                                uint8_t destination_id, const char *payload, uint16_t payload_length,
+                                net_segment_t *segments);
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to configure CONTRL message header and payload segments of a STATUS
+ *         message fragment, the fragment header goes out with the payload, client not
+ *         found is replied once on the last fragment
+ * @param  *server                : reference to the server protocol handle, contrl_msg
+ *                                  holds CONTRL_FRAME_HEADER_LENGTH bytes
+ * @param  device                 : reference to the server device structure
+ * @param  source_id              : client/device id of source device
+ * @param  destination_id         : client/device id of destination device
+ * @param  *fragment              : fragment header and payload
+ * @param  fragment_length        : fragment length
+ * @param  *segments              : CONTRL_MAX_SEGMENTS payload segments
+ * @retval uint8_t                : nothing to send: 0, success: number of payload segments
+ ****************************************************************************************/
+uint8_t comms_control_fragment_v(protocol_handle_t *server, device_config_t device, uint8_t source_id,
+                                 uint8_t destination_id, const char *fragment, uint16_t fragment_length,
+                                 net_segment_t *segments);
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to configure CONTRL message header and payload segments of an
+ *         encoded STATUS payload, relayed encoded to a destination client with codec
+ *         support, server replies (echo prefix, not found) are not encoded
+ * @param  *server                : reference to the server protocol handle, contrl_msg
+ *                                  holds CONTRL_FRAME_HEADER_LENGTH bytes
+ * @param  device                 : reference to the server device structure
+ * @param  source_id              : client/device id of source device
+ * @param  destination_id         : client/device id of destination device
+ * @param  codec                  : payload codec, comms_codec_t
+ * @param  *payload               : encoded payload
+ * @param  payload_length         : encoded payload length
+ * @param  *segments              : CONTRL_MAX_SEGMENTS payload segments
+ * @retval uint8_t                : error: 0, success: number of payload segments
+ ****************************************************************************************/
+uint8_t comms_control_codec_v(protocol_handle_t *server, device_config_t device, uint8_t source_id,
+                              uint8_t destination_id, uint8_t codec, const char *payload, uint16_t payload_length,
+                              net_segment_t *segments);
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to configure an aggregated CONTRL message header, records are
+ *         added with comms_control_aggregate_add
+ * @param  *server : reference to the server protocol handle
+ * @param  device  : reference to the server device structure
+ * @retval uint8_t : error: 0, success: length of message
+ ****************************************************************************************/
+uint8_t comms_control_aggregate_init(protocol_handle_t *server, device_config_t device);
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to add a record to an aggregated CONTRL message, echo and client
+ *         not found records are addressed back to the source like CONTRL messages
+ * @param  *server         : reference to the server protocol handle
+ * @param  device          : reference to the server device structure
+ * @param  message_length  : length of message so far
+ * @param  frame_limit     : largest frame, comms_network_frame_limit()
+ * @param  source_id       : client/device id of source device
+ * @param  destination_id  : client/device id of destination device
+ * @param  *payload        : record payload
+ * @param  payload_length  : record payload length
+ * @retval uint8_t         : record does not fit: 0, success: length of message
+ ****************************************************************************************/
+uint8_t comms_control_aggregate_add(protocol_handle_t *server, device_config_t device, uint8_t message_length,
+                                    uint8_t frame_limit, uint8_t source_id, uint8_t destination_id,
+                                    const char *payload, uint16_t payload_length);
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to complete an aggregated CONTRL message
+ * @param  *server         : reference to the server protocol handle
+ * @param  message_length  : length of message so far
+ * @retval uint8_t         : no records: 0, success: length of message
+ ****************************************************************************************/
+uint8_t comms_control_aggregate_end(protocol_handle_t *server, uint8_t message_length);
+
+
+
+
 /*****************************************************************************
  * @brief  Function to check/get JOINREQ message data
  * @param *client_mac_address     : client mac address
@@ -293,11 +613,90 @@ int8_t comms_get_joinreq_data(char *client_mac_address, uint8_t *client_requeste
 
 
 
+/*****************************************************************************
+ * @brief  Function to get JOINREQ message options
+ * @param  server      : reference to the protocol handle structure
+ * @param  *qos        : reference to quality of service value
+ * @param  *keep_alive : reference to keep alive request value
+ * @retval int8_t      : error: -10, success: 0
+ *****************************************************************************/
+int8_t comms_get_joinreq_options(protocol_handle_t server, uint8_t *qos, uint8_t *keep_alive);
+
+
+
+/*****************************************************************************
+ * @brief  Function to get JOINREQ codec support
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : no codec support: 0, codec support: 1
+ *****************************************************************************/
+uint8_t comms_get_joinreq_codec(protocol_handle_t server);
+
+
+
+/*****************************************************************************
+ * @brief  Function to get the JOINREQ reporting period
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : period 2^n frames, 0 every frame
+ *****************************************************************************/
+uint8_t comms_get_joinreq_period(protocol_handle_t server);
+
+
+/*****************************************************************************
+ * @brief  Function to get the JOINREQ low power flag
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : radio always on: 0, radio sleeps between slots: 1
+ *****************************************************************************/
+uint8_t comms_get_joinreq_sleep(protocol_handle_t server);
+
+
+
+/*****************************************************************************
+ * @brief  Function to get the message type of a received STATUS frame
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : error: 0, success: message type
+ *****************************************************************************/
+uint8_t comms_get_status_type(protocol_handle_t server);
+
+
+
+
+/*****************************************************
+ * @brief  Function to check for a STATUS message fragment
+ * @param  server  : Protocol handle structure
+ * @retval uint8_t : fragment: 1, STATUS message: 0
+ *****************************************************/
+uint8_t comms_get_status_fragment(protocol_handle_t server);
+
+
+
+/*****************************************************
+ * @brief  Function to get the payload codec of a
+ *         STATUS message
+ * @param  server  : Protocol handle structure
+ * @retval uint8_t : raw payload: COMMS_CODEC_NONE,
+ *                   encoded: comms_codec_t
+ *****************************************************/
+uint8_t comms_get_status_codec(protocol_handle_t server);
+
+
+
+
+/*****************************************************************************
+ * @brief  Function to configure a STATUSACK message, (client id, sequence
+ *         number) records of the QoS 1 STATUS messages received by the server
+ * @param  *server        : pointer to the protocol handle
+ * @param  device         : server device structure
+ * @param  *records       : client id and sequence number pairs
+ * @param  record_count   : number of records, up to COMMS_STATUSACK_RECORDS
+ * @retval uint8_t        : error 0, success: length of message
+ *****************************************************************************/
+uint8_t comms_statusack_message(protocol_handle_t *server, device_config_t device, const uint8_t *records,
+                                uint8_t record_count);
 
-int8_t comms_statusack_message(protocol_handle_t *client, device_config_t device, int8_t client_id, uint8_t destination_client_id);
 
 
 
+#pragma pack(pop)
 
 
 #endif
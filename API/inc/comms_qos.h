@@ -0,0 +1,190 @@
+/**
+ ******************************************************************************
+ * @file    comms_qos.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network QoS 1 delivery header file
+ *
+ *  Info
+ *          STATUS messages of QoS 1 clients carry a sequence number in front
+ *          of the payload. The client holds the sent frames in a bounded
+ *          retransmit queue until the server acknowledges them in the ack
+ *          bitmap of the next SYNC message, the server drops retransmissions
+ *          it relayed already with a duplicate window per client.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef COMMS_QOS_H_
+#define COMMS_QOS_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+#include "comms_network.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* QoS 1 sequence number in front of the STATUS payload */
+#define COMMS_QOS_SEQUENCE_SIZE 1
+
+
+/* Compile time check, window bitmap and queued frames inside the window */
+typedef char comms_qos_window_check[(COMMS_QOS_WINDOW <= 16 && COMMS_QOS_QUEUE_SIZE < COMMS_QOS_WINDOW) ? 1 : -1];
+
+
+/* Retransmit queue entry of one unacknowledged STATUS frame */
+typedef struct _net_retransmit
+{
+    uint8_t length;                  /*!< Frame length, 0: entry free          */
+    uint8_t sequence;                /*!< STATUS sequence number               */
+    uint8_t age;                     /*!< Owned slots since the last send      */
+    uint8_t retries;                 /*!< Retransmissions of the frame         */
+    char    frame[NET_DATA_LENGTH];  /*!< STATUS frame, sent again unchanged   */
+
+}net_retransmit_t;
+
+
+/* Duplicate window of the sequence numbers received from one client */
+typedef struct _net_sequence_window
+{
+    uint8_t  newest;  /*!< Newest sequence number received                  */
+    uint16_t seen;    /*!< Bit n: newest - n received, 0: nothing received  */
+
+}net_sequence_window_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to initialize a retransmit queue
+ * @param  *queue : reference to retransmit queue entries
+ * @param  count  : number of entries
+ *********************************************************/
+void init_retransmit(net_retransmit_t *queue, uint8_t count);
+
+
+/*********************************************************
+ * @brief  Function to get the number of frames waiting
+ *         for an acknowledgement
+ * @param  *queue  : reference to retransmit queue entries
+ * @param  count   : number of entries
+ * @retval uint8_t : number of held frames
+ *********************************************************/
+uint8_t comms_retransmit_count(const net_retransmit_t *queue, uint8_t count);
+
+
+/*********************************************************
+ * @brief  Function to hold a sent STATUS frame until the
+ *         server acknowledges its sequence number
+ * @param  *queue    : reference to retransmit queue entries
+ * @param  count     : number of entries
+ * @param  *frame    : sent STATUS frame
+ * @param  length    : frame length
+ * @param  sequence  : STATUS sequence number
+ * @retval int8_t    : error (queue full): -1, success: 0
+ *********************************************************/
+int8_t comms_retransmit_add(net_retransmit_t *queue, uint8_t count, const char *frame, uint8_t length,
+                            uint8_t sequence);
+
+
+/*********************************************************
+ * @brief  Function to release the frame of an
+ *         acknowledged sequence number
+ * @param  *queue    : reference to retransmit queue entries
+ * @param  count     : number of entries
+ * @param  sequence  : acknowledged sequence number
+ * @retval uint8_t   : released: 1, unknown sequence: 0
+ *********************************************************/
+uint8_t comms_retransmit_ack(net_retransmit_t *queue, uint8_t count, uint8_t sequence);
+
+
+/*********************************************************
+ * @brief  Function to age the held frames by one owned
+ *         slot, frames without acknowledgement after
+ *         COMMS_QOS_RETRIES retransmissions are dropped
+ * @param  *queue  : reference to retransmit queue entries
+ * @param  count   : number of entries
+ * @retval uint8_t : number of dropped frames
+ *********************************************************/
+uint8_t comms_retransmit_age(net_retransmit_t *queue, uint8_t count);
+
+
+/*********************************************************
+ * @brief  Function to get the frame to send again, the
+ *         oldest frame without acknowledgement for
+ *         COMMS_QOS_RETRY_FRAMES owned slots
+ * @param  *queue           : reference to retransmit queue entries
+ * @param  count            : number of entries
+ * @retval net_retransmit_t : none due: NULL, success: entry
+ *********************************************************/
+net_retransmit_t* comms_retransmit_due(net_retransmit_t *queue, uint8_t count);
+
+
+/*********************************************************
+ * @brief  Function to initialize a duplicate window
+ * @param  *window : reference to duplicate window
+ *********************************************************/
+void init_sequence_window(net_sequence_window_t *window);
+
+
+/*********************************************************
+ * @brief  Function to check a received sequence number,
+ *         numbers older than COMMS_QOS_WINDOW count as
+ *         received
+ * @param  *window  : reference to duplicate window
+ * @param  sequence : received sequence number
+ * @retval uint8_t  : new: 1, duplicate: 0
+ *********************************************************/
+uint8_t comms_sequence_window(net_sequence_window_t *window, uint8_t sequence);
+
+
+
+#endif /* COMMS_QOS_H_ */
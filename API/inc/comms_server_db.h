@@ -50,6 +50,12 @@
  * Standard Header and API Header files
  */
 #include "comms_network.h"
+#include "comms_qos.h"
+
+
+/* Registry and index arrays use natural alignment, includers may have pack(1) active */
+#pragma pack(push)
+#pragma pack()
 
 
 /******************************************************************************/
@@ -59,13 +65,41 @@
 /******************************************************************************/
 
 
+/* Client table rows, override at build time for larger networks */
+#ifndef CLIENT_TABLE_SIZE
 #define CLIENT_TABLE_SIZE 20
+#endif
+
+
+/* MAC address hash buckets, power of two and larger than the table */
+#ifndef CLIENT_HASH_SIZE
+#define CLIENT_HASH_SIZE 64
+#endif
+
+
+/* Keep alive timing wheel buckets, one per frame, power of two and at least COMMS_KEEP_ALIVE_FRAMES */
+#ifndef CLIENT_WHEEL_SIZE
+#define CLIENT_WHEEL_SIZE 64
+#endif
+
+
+/* Client id index entries, client ids are 8 bit on air */
+#define CLIENT_ID_INDEX_SIZE 256
+
+
+/* Slot bitmap words, one bit per slot number */
+#define CLIENT_SLOT_MAP_WORDS (CLIENT_ID_INDEX_SIZE / 32)
+
+
+/* Compile time check, bucket index wraps with a mask and probing needs an empty bucket */
+typedef char client_hash_size_check[((CLIENT_HASH_SIZE & (CLIENT_HASH_SIZE - 1)) == 0 &&
+                                     CLIENT_HASH_SIZE > CLIENT_TABLE_SIZE) ? 1 : -1];
 
 
 /* table return values structure */
 typedef struct table_return_values
 {
-    uint8_t table_index;
+    uint16_t table_index;
     int8_t table_retval;
 
 }table_retval_t;
@@ -74,8 +108,10 @@ typedef struct table_return_values
 typedef struct _client_states
 {
     uint8_t qos        : 1;
-    uint8_t keep_alive : 1;
-    uint8_t reserved   : 6;
+    uint8_t keep_alive : 1;  /*!< Client is evicted when silent for a keep alive period */
+    uint8_t codec      : 1;  /*!< Client decodes encoded CONTRL payloads                 */
+    uint8_t low_power  : 1;  /*!< Client radio sleeps, CONTRL messages wait in the mailbox */
+    uint8_t reserved   : 4;
 
 }client_states_t;
 
@@ -88,6 +124,13 @@ typedef struct _client_devices
     uint8_t         client_number_of_slots;
     client_states_t client_states;
     char            client_ip_address[4];
+    uint8_t         client_slot;     /*!< Superframe slot, 0: slots from the client id  */
+    uint8_t         client_period;   /*!< Superframe period, the slot every 2^n frames  */
+    uint8_t         client_offset;   /*!< Superframe offset, frame number mod 2^n       */
+    net_sequence_window_t client_sequence;  /*!< QoS 1 STATUS sequence numbers received  */
+    uint16_t        heard_frame;     /*!< Keep alive wheel frame of the last frame heard */
+    uint16_t        wheel_next;      /*!< Keep alive wheel bucket list, row + 1, 0: end */
+    uint16_t        wheel_prev;      /*!< Keep alive wheel bucket list, row + 1, 0: head */
 
     uint8_t client_table_lock;
 
@@ -102,6 +145,25 @@ typedef enum _table_search_type
 }search_type_t;
 
 
+/* Client registry, device rows indexed by MAC address (open addressing) and by client id */
+typedef struct _client_registry
+{
+    client_devices_t *rows;                             /*!< Device rows, capacity entries            */
+    uint16_t         *mac_index;                        /*!< MAC hash buckets, row + 1, 0 is empty    */
+    uint16_t          id_index[CLIENT_ID_INDEX_SIZE];   /*!< Rows by client id, row + 1, 0 is empty   */
+    uint16_t          capacity;                         /*!< Number of device rows                    */
+    uint16_t          hash_mask;                        /*!< Hash buckets - 1                         */
+    uint16_t          count;                            /*!< Rows in use                              */
+    uint16_t          free_hint;                        /*!< No free row below this index             */
+    uint32_t          slot_map[CLIENT_SLOT_MAP_WORDS];  /*!< Slots in use, bit n is slot number n     */
+    uint32_t          shared_offsets[CLIENT_ID_INDEX_SIZE]; /*!< Superframe frame offsets in use by slot, 0: not shared */
+    uint8_t           reserved_slots;                   /*!< Server slots 1 - n, set at first join    */
+    uint16_t          wheel[CLIENT_WHEEL_SIZE];         /*!< Keep alive rows by expiry frame, row + 1 */
+    uint16_t          wheel_frame;                      /*!< Keep alive wheel frame, one per SYNC     */
+
+}client_registry_t;
+
+
 
 
 /****************************************************************
@@ -112,6 +174,188 @@ client_devices_t* create_server_device_table(void);
 
 
 
+/****************************************************************
+ * @brief  Initialize caller owned client device table
+ * @param  *device_table : table of CLIENT_TABLE_SIZE entries
+ * @retval client_devices_t* : error: NULL, success: device table
+ ***************************************************************/
+client_devices_t* init_server_device_table(client_devices_t *device_table);
+
+
+
+/****************************************************************
+ * @brief  Client registry constructor, caller owned storage
+ * @param  *registry  : reference to the registry
+ * @param  *rows      : device rows storage
+ * @param  capacity   : number of device rows (max INT16_MAX)
+ * @param  *mac_index : MAC hash bucket storage
+ * @param  hash_size  : number of buckets, power of two > capacity
+ * @retval int8_t     : error: -1, success: 0
+ ***************************************************************/
+int8_t init_client_registry(client_registry_t *registry, client_devices_t *rows, uint16_t capacity,
+                            uint16_t *mac_index, uint32_t hash_size);
+
+
+
+/****************************************************************
+ * @brief  Registry of a CLIENT_TABLE_SIZE device table for the
+ *         client_devices_t functions (single instance, rows
+ *         already in the table are indexed when it changes)
+ * @param  *device_table : table of CLIENT_TABLE_SIZE entries
+ * @retval client_registry_t* : error: NULL, success: registry
+ ***************************************************************/
+client_registry_t* bind_server_device_table(client_devices_t *device_table);
+
+
+
+/****************************************************************
+ * @brief  Add a device row to the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @param  client_id           : client id, 1 - 255
+ * @retval int16_t             : error: -1, -2: table full,
+ *                               -3: duplicate MAC address,
+ *                               success: row index
+ ***************************************************************/
+int16_t client_registry_add(client_registry_t *registry, const char *client_mac_address, uint8_t client_id);
+
+
+
+/****************************************************************
+ * @brief  Remove a device row from the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @retval int8_t              : error: -1, success: 0
+ ***************************************************************/
+int8_t client_registry_remove(client_registry_t *registry, const char *client_mac_address);
+
+
+
+/****************************************************************
+ * @brief  Find device row by mac address
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @retval int16_t             : error: -1, success: row index
+ ***************************************************************/
+int16_t client_registry_find_mac(client_registry_t *registry, const char *client_mac_address);
+
+
+
+/****************************************************************
+ * @brief  Find device row by client id
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id
+ * @retval int16_t    : error: -1, success: row index
+ ***************************************************************/
+int16_t client_registry_find_id(client_registry_t *registry, uint8_t client_id);
+
+
+
+/*****************************************************************************
+ * @brief  Function to admit a client to the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address
+ * @param  requested_slots     : requested slots by the client
+ * @param  server              : reference to the protocol handle structure
+ * @retval int8_t              : error: -2 : JOINRESP_NACK, -3: JOINRESP_DUP,
+ *                               success: table current index
+ *****************************************************************************/
+table_retval_t update_client_registry(client_registry_t *registry, char *client_mac_address, uint8_t requested_slots,
+                                      device_config_t *server);
+
+
+
+/*****************************************************************************
+ * @brief  Function to admit a client with a reporting period to the registry,
+ *         clients with a period of 2^n frames share a superframe slot at
+ *         different frame offsets and get a client id from
+ *         COMMS_SUPERFRAME_CLIENT_ID down, period 0 owns slots every frame
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address
+ * @param  requested_slots     : requested slots by the client, period 0 only
+ * @param  period              : period 2^n frames, up to COMMS_SUPERFRAME_LIMIT
+ * @param  server              : reference to the protocol handle structure
+ * @retval int8_t              : error: -2 : JOINRESP_NACK, -3: JOINRESP_DUP,
+ *                               success: table current index
+ *****************************************************************************/
+table_retval_t update_client_registry_period(client_registry_t *registry, char *client_mac_address, uint8_t requested_slots,
+                                             uint8_t period, device_config_t *server);
+
+
+
+/*****************************************************************
+ * @brief  Function to release a client and its slots, frame length
+ *         shrinks to the highest slot still in use
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id (first slot of the client)
+ * @param  server     : reference to the server device structure
+ * @retval int8_t     : error: -1, success: 0
+ ****************************************************************/
+int8_t release_client_registry(client_registry_t *registry, uint8_t client_id, device_config_t *server);
+
+
+
+/*****************************************************************
+ * @brief  Function to mark a client heard in this frame, keep alive
+ *         clients expire COMMS_KEEP_ALIVE_FRAMES frames later
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id
+ * @retval int8_t     : error: -1, success: 0
+ ****************************************************************/
+int8_t touch_client_registry(client_registry_t *registry, uint8_t client_id);
+
+
+
+/*****************************************************************
+ * @brief  Function to check the sequence number of a QoS 1 STATUS
+ *         message against the duplicate window of the client
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id
+ * @param  sequence   : STATUS sequence number
+ * @retval int8_t     : error: -1, duplicate: 0, new: 1
+ ****************************************************************/
+int8_t sequence_client_registry(client_registry_t *registry, uint8_t client_id, uint8_t sequence);
+
+
+
+/*****************************************************************
+ * @brief  Function to advance the keep alive wheel by one frame,
+ *         releases the keep alive clients not heard for
+ *         COMMS_KEEP_ALIVE_FRAMES frames, call once per SYNC
+ * @param  *registry    : reference to the registry
+ * @param  server       : reference to the server device structure
+ * @param  *expired_map : CLIENT_SLOT_MAP_WORDS words, bit n set for
+ *                        released client id n, NULL: not reported
+ * @retval int16_t      : error: -1, success: number of released clients
+ ****************************************************************/
+int16_t expire_client_registry(client_registry_t *registry, device_config_t *server, uint32_t *expired_map);
+
+
+
+/*****************************************************************
+ * @brief  Function read from row index of the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address
+ * @param  *client_id          : reference to client ID variable
+ * @param  table index         : row index value
+ * @retval int8_t              : error = -4, success = 0
+ ****************************************************************/
+int8_t read_client_registry(client_registry_t *registry, char *client_mac_address, int8_t *client_id, int16_t table_index);
+
+
+
+/*******************************************************************
+ * @brief  Function to find device in the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_id          : reference to client ID variable
+ * @param  *client_mac_address : client mac address
+ * @param  search_mode         : search by client id or mac address
+ * @retval int8_t              : error = 0, success = 1
+ *******************************************************************/
+int8_t find_registry_device(client_registry_t *registry, uint8_t *client_id, char *client_mac_address, uint8_t search_mode);
+
+
+
 /*****************************************************************************
  * @brief  Function write to client device table
  * @param  *device_table       : reference to the device table
@@ -148,5 +392,7 @@ int8_t read_client_table(client_devices_t *device_table, char *client_mac_addres
 int8_t find_client_device(client_devices_t *device_table, uint8_t *client_id, char *client_mac_address, uint8_t search_mode);
 
 
+#pragma pack(pop)
+
 
 #endif /* COMMS_SERVER_DB_H_ */
@@ -54,6 +54,12 @@
 #include "comms_network.h"
 #include "comms_protocol.h"
 #include "comms_server_db.h"
+#include "comms_mailbox.h"
+
+
+/* Server context uses natural alignment, the registry indexes its hash buckets */
+#pragma pack(push)
+#pragma pack()
 
 
 
@@ -76,6 +82,58 @@ typedef enum _comms_server_modes
 
 
 
+/* Server state machine values persistent across transmit timer interrupts */
+typedef struct _comms_server_fsm
+{
+    int8_t         fsm_state;                              /*!< Current state machine state              */
+    char           status_message_buffer[NET_DATA_LENGTH]; /*!< STATUS message held for CONTRL message   */
+    int8_t         client_id;                              /*!< Client id of the last join response      */
+    char           join_mac[NET_MAC_SIZE];                 /*!< MAC address of the last JOINREQ message  */
+    uint8_t        destination_client_id;                  /*!< STATUS message destination client id     */
+    uint8_t        source_client_id;                       /*!< STATUS message source client id          */
+    int16_t        status_message_length;                  /*!< STATUS message length                    */
+    int8_t         device_found;                           /*!< Destination device found in device table */
+    table_retval_t table_values;                           /*!< Last device table update values          */
+    const char    *status_payload;                         /*!< STATUS payload in the held frame         */
+    uint8_t        status_event_held;                      /*!< STATUS frame kept queued for CONTRL      */
+    uint8_t        contrl_batch;                           /*!< CONTRL messages per broadcast slot       */
+    uint8_t        contrl_aggregate;                       /*!< STATUS messages as CONTRL records        */
+    uint8_t        status_fragment;                        /*!< STATUS message is a message fragment     */
+    uint8_t        status_codec;                           /*!< STATUS message payload codec             */
+    uint32_t       frames_received;                        /*!< Received frames at the last SYNC message */
+    uint32_t       join_requests;                          /*!< Received JOINREQ at the last SYNC message */
+    uint16_t       join_errors;                            /*!< Damaged frames at the last SYNC message  */
+    uint16_t       join_backlog;                           /*!< Contending clients, COMMS_JOIN_LOAD_ONE  */
+    uint8_t        access_slots_max;                       /*!< Largest access slot count                */
+    uint8_t        access_frames;                          /*!< Frames in this access slot period        */
+    uint8_t        access_collisions;                      /*!< Collisions in this access slot period    */
+    uint8_t        frame_rest;                             /*!< Timer armed for the rest of the frame    */
+    uint8_t        mail_announced;                         /*!< Mailbox messages of the last SYNC        */
+    comms_mailbox_t mailbox;                               /*!< CONTRL messages for low power clients    */
+
+}comms_server_fsm_t;
+
+
+
+/* Server instance context, all state of one server in caller owned storage,
+ * init_client_registry() on client_registry after comms_server_init() moves
+ * the device table to caller storage of any capacity */
+typedef struct _comms_server_context
+{
+    access_control_t       network;                          /*!< Network access handle           */
+    device_config_t        device;                           /*!< Server device configuration     */
+    comms_network_buffer_t buffers;                          /*!< Network buffers                 */
+    client_devices_t       client_table[CLIENT_TABLE_SIZE];  /*!< Client device table             */
+    uint16_t               client_hash[CLIENT_HASH_SIZE];    /*!< Client MAC hash buckets         */
+    client_registry_t      client_registry;                  /*!< Client device table index       */
+    comms_server_mode_t    server_mode;                      /*!< Server operation mode           */
+    uint8_t                rx_index;                         /*!< Receive interrupt buffer index  */
+    comms_server_fsm_t     fsm;                              /*!< State machine values            */
+
+}comms_server_context_t;
+
+
+
 
 /******************************************************************************/
 /*                                                                            */
@@ -85,8 +143,102 @@ typedef enum _comms_server_modes
 
 
 
+/**************************************************************************
+ * @brief  Server instance constructor, initializes caller owned context
+ * @param  *server           : reference to server context
+ * @param  *network_ops      : reference to network operations handle
+ * @param  *mac_address      : mac_address of the server device
+ * @param  network_id        : network id of the server
+ * @param  device_slot_time  : slot time interval
+ * @param  total_slots       : no of existing slots at start
+ * @param  *user_name        : network user name
+ * @param  *password         : network password
+ * @param  server_mode       : sever device operation mode
+ * @retval int8_t            : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_init(comms_server_context_t *server, network_operations_t *network_ops, char *mac_address,
+                         uint16_t network_id, uint16_t device_slot_time, uint8_t total_slots, char *user_name,
+                         uint8_t *password, comms_server_mode_t server_mode);
+
+
+/**************************************************************************
+ * @brief  Server state machine step for a server context, call from the
+ *         transmit timer interrupt of the instance
+ * @param  *server : reference to server context
+ * @retval int8_t  : error = 0
+ **************************************************************************/
+int8_t comms_server_run(comms_server_context_t *server);
+
+
+/**************************************************************************
+ * @brief  Server receive interrupt handler for a server context
+ * @param  *server : reference to server context
+ * @param  data    : received byte
+ * @retval int8_t  : error: -2, success: length of message
+ **************************************************************************/
+int8_t comms_server_recv(comms_server_context_t *server, char data);
+
+
+/**************************************************************************
+ * @brief  Set the number of CONTRL messages sent per broadcast slot, the
+ *         server relays the STATUS messages queued in the receive ring in
+ *         one pass instead of one STATUS per slot period
+ *         (frames beyond the broadcast slot airtime overlap client slots)
+ * @param  *server       : reference to server context
+ * @param  contrl_batch  : CONTRL messages per broadcast slot, 0 or 1 legacy
+ * @retval int8_t        : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_batch(comms_server_context_t *server, uint8_t contrl_batch);
+
+
+/**************************************************************************
+ * @brief  Select aggregated CONTRL messages, STATUS messages are relayed as
+ *         records packed into CONTRL messages of up to NET_DATA_LENGTH
+ *         bytes, clients read their records with comms_get_contrl_record
+ * @param  *server    : reference to server context
+ * @param  aggregate  : aggregated CONTRL messages on = 1, off = 0
+ * @retval int8_t     : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_aggregate(comms_server_context_t *server, uint8_t aggregate);
+
+
+/**************************************************************************
+ * @brief  Set the largest number of access slots per frame, the server
+ *         grows the access slots up to this count on JOINREQ collisions
+ * @param  *server       : reference to server context
+ * @param  access_slots  : largest access slot count, 0 or 1 single access slot
+ * @retval int8_t        : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_access_slots(comms_server_context_t *server, uint8_t access_slots);
+
+
+/**************************************************************************
+ * @brief  Set the connection state of the IP side of a gateway server,
+ *         STATUS messages to client id 1 are handed to the application
+ *         in network_message while connected
+ * @param  *server     : reference to server context
+ * @param  connected   : IP side connected = 1, offline = 0
+ * @retval int8_t      : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_gateway(comms_server_context_t *server, uint8_t connected);
+
+
+/**************************************************************************
+ * @brief  Post a downlink message from the IP side of a gateway server,
+ *         sent as a CONTRL message in the broadcast slot of the next frame
+ * @param  *server          : reference to server context
+ * @param  destination_id   : destination client id
+ * @param  *message         : downlink message
+ * @param  message_length   : message length
+ * @retval int8_t           : error = -1, busy = 0, posted = 1
+ **************************************************************************/
+int8_t comms_server_gateway_post(comms_server_context_t *server, uint8_t destination_id, const char *message,
+                                 uint16_t message_length);
+
+
 /**************************************************************************
  * @brief  Server State Machine Start Function
+ *         (single instance, state machine values kept in static storage)
  * @param  *wireless_network : reference to network access handle
  * @param  *server_device    : reference to device configuration structure
  * @param  *network_buffers  : reference to network buffers structure
@@ -101,5 +253,7 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
 
 
 
+#pragma pack(pop)
+
 
 #endif /* COMMS_SERVER_FSM_H_ */
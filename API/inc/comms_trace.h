@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ * @file    comms_trace.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network deferred debug trace header file
+ *
+ *  Info
+ *          State machine debug output is recorded as binary trace records, an
+ *          event id, a timestamp and up to four integer arguments, in a ring
+ *          written from the timer and receive interrupts. The main loop (or a
+ *          host tool) reads the records and formats the debug text later.
+ *          
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+#ifndef COMMS_TRACE_H_
+#define COMMS_TRACE_H_
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include "network_protocol_configs.h"
+
+
+/* Trace ring uses natural alignment, interrupts write its 32 bit fields */
+#pragma pack(push)
+#pragma pack()
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define COMMS_TRACE_ARGS      4   /*!< Integer arguments of a trace record           */
+#define COMMS_TRACE_DATA      8   /*!< Payload bytes kept by STATUS and CONTRL records */
+
+
+/* Trace ring indexes are free running uint8_t counters */
+typedef char comms_trace_size_check_t[(COMMS_TRACE_SIZE & (COMMS_TRACE_SIZE - 1)) == 0 &&
+                                      COMMS_TRACE_SIZE <= 128 ? 1 : -1];
+
+
+/* Keeps the compiler from moving record writes across the ring head update */
+#if defined(__GNUC__)
+#define COMMS_TRACE_BARRIER()  __asm__ volatile ("" ::: "memory")
+#else
+#define COMMS_TRACE_BARRIER()
+#endif
+
+
+/* Trace events, one per state machine debug print */
+typedef enum _comms_trace_event
+{
+    COMMS_TRACE_JOINREQ  = 1,  /*!< JOINREQ sent, args: requested slots                         */
+    COMMS_TRACE_JOINRESP = 2,  /*!< JOINRESP received, args: client id                          */
+    COMMS_TRACE_STATUS   = 3,  /*!< STATUS sent, args: destination id, length, payload bytes 0-7 */
+    COMMS_TRACE_CONTRL   = 4   /*!< CONTRL received, args: source id, length, payload bytes 0-7  */
+
+}comms_trace_event_t;
+
+
+/* Trace record */
+typedef struct _comms_trace_record
+{
+    uint32_t timestamp;                /*!< trace_timestamp value, 0 without the callback    */
+    uint16_t sequence;                 /*!< Record number, gaps are dropped records          */
+    uint8_t  event;                    /*!< comms_trace_event_t                              */
+    uint8_t  arg_count;                /*!< Valid arguments                                  */
+    uint32_t args[COMMS_TRACE_ARGS];   /*!< Event arguments                                  */
+
+}comms_trace_record_t;
+
+
+/* Trace ring, single producer (interrupts) and single consumer (main loop) */
+typedef struct _comms_trace
+{
+    comms_trace_record_t records[COMMS_TRACE_SIZE];  /*!< Record storage                     */
+    volatile uint8_t     head;                       /*!< Write index, producer              */
+    volatile uint8_t     tail;                       /*!< Read index, consumer               */
+    uint16_t             sequence;                   /*!< Next record number, producer       */
+    uint16_t             dropped;                    /*!< Records lost to a full ring        */
+
+}comms_trace_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to record a trace event, a few stores
+ *         and no formatting, safe in interrupt context.
+ *         New records are dropped while the ring is full
+ * @param  *trace     : reference to trace ring
+ * @param  timestamp  : record timestamp
+ * @param  event      : comms_trace_event_t
+ * @param  arg_count  : valid arguments, up to COMMS_TRACE_ARGS
+ * @param  arg0..arg3 : event arguments
+ * @retval int8_t     : error (ring full): -1, success: 0
+ *********************************************************/
+static inline int8_t comms_trace_record(comms_trace_t *trace, uint32_t timestamp, uint8_t event, uint8_t arg_count,
+                                        uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+    int8_t func_retval = 0;
+
+    comms_trace_record_t *record;
+
+    uint8_t head = trace->head;
+
+    if((uint8_t)(head - trace->tail) >= COMMS_TRACE_SIZE)
+    {
+        trace->dropped++;
+        trace->sequence++;
+
+        func_retval = -1;
+    }
+    else
+    {
+        record = &trace->records[head & (COMMS_TRACE_SIZE - 1)];
+
+        record->timestamp = timestamp;
+        record->sequence  = trace->sequence++;
+        record->event     = event;
+        record->arg_count = arg_count;
+        record->args[0]   = arg0;
+        record->args[1]   = arg1;
+        record->args[2]   = arg2;
+        record->args[3]   = arg3;
+
+        /* Publish the record after it is written */
+        COMMS_TRACE_BARRIER();
+
+        trace->head = head + 1;
+    }
+
+    return func_retval;
+}
+
+
+/*********************************************************
+ * @brief  Function to initialize a trace ring
+ * @param  *trace  : reference to trace ring
+ * @retval int8_t  : error: -1, success: 0
+ *********************************************************/
+int8_t init_trace(comms_trace_t *trace);
+
+
+/*********************************************************
+ * @brief  Function to read and release the oldest trace
+ *         record, main loop (consumer) side of the ring
+ * @param  *trace   : reference to trace ring
+ * @param  *record  : copy of the oldest record
+ * @retval int8_t   : empty: 0, success: 1
+ *********************************************************/
+int8_t comms_trace_read(comms_trace_t *trace, comms_trace_record_t *record);
+
+
+/*********************************************************
+ * @brief  Function to pack up to COMMS_TRACE_DATA payload
+ *         bytes in two trace arguments
+ * @param  *payload : payload data
+ * @param  length   : payload length
+ * @param  *args    : two trace arguments
+ *********************************************************/
+void comms_trace_pack(const char *payload, uint16_t length, uint32_t *args);
+
+
+/*********************************************************
+ * @brief  Function to format a trace record as the debug
+ *         text of the state machine, usable on the host
+ *         Formats: "JOINREQ (SL:x)\r\n"
+ *                  "JOINRESP (ID:x)\r\n"
+ *                  "STATUS (DID:x LEN:x) DATA: 'message'\r\n"
+ *                  "CONTROL (SID:x LEN:x) DATA: 'message'\r\n"
+ *         Payloads above COMMS_TRACE_DATA bytes are cut
+ * @param  *record  : reference to trace record
+ * @param  *buffer  : text buffer
+ * @param  size     : text buffer size
+ * @retval int16_t  : error: -1, success: text length
+ *********************************************************/
+int16_t comms_trace_format(const comms_trace_record_t *record, char *buffer, uint16_t size);
+
+
+#pragma pack(pop)
+
+
+#endif /* COMMS_TRACE_H_ */
@@ -68,6 +68,7 @@
 #define COMMS_EVNT_MESSAGE       7
 #define COMMS_HIBERNATE_MESSAGE  8
 #define COMMS_UNJOIN_MESSAGE     9
+#define COMMS_KEEPALIVE_MESSAGE  10
 
 
 /* Message Header Lengths */
@@ -77,6 +78,9 @@
 #define CONTRL_HEADER_SIZE    5
 #define STATUSACK_HEADER_SIZE 4
 
+/* Aggregated CONTRL record header, source id, destination id and payload length */
+#define CONTRL_RECORD_HEADER_SIZE 3
+
 
 
 /* Network slot defines */
@@ -93,6 +97,20 @@
 #define NET_MAC_SIZE           6
 #define NET_PREAMBLE_LENTH     2
 
+/* Clients sending in one frame, the server queues their frames while it relays the previous frame */
+#ifndef NET_EVENT_CLIENTS
+#define NET_EVENT_CLIENTS      16
+#endif
+
+/* Received frame events, power of two of two frames of client messages, clients may override with 8 */
+#ifndef NET_EVENT_QUEUE_SIZE
+#define NET_EVENT_QUEUE_SIZE   (2 * NET_EVENT_CLIENTS <= 8  ? 8  : 2 * NET_EVENT_CLIENTS <= 16 ? 16 : \
+                                2 * NET_EVENT_CLIENTS <= 32 ? 32 : 2 * NET_EVENT_CLIENTS <= 64 ? 64 : 128)
+#endif
+
+#define COMMS_CONTRL_BATCH     1    /*!< CONTRL messages per broadcast slot, 1 relays one STATUS per slot */
+#define COMMS_CONTRL_AGGREGATE 0    /*!< STATUS messages relayed as records of aggregated CONTRL messages */
+
 #define COMMS_FIXED_HEADER_LENGTH  3
 #define COMMS_CHECKSUM_SIZE        1
 #define COMMS_MESSAGE_TERMINATOR   "\rt"
@@ -109,6 +127,12 @@
 #define COMMS_JOINREQ_PAYLOAD   11
 #define COMMS_JOINRESP_PAYLOAD  12
 
+/* STATUS payload codecs of the single instance client, COMMS_CODEC_MASK bits, 0 sends raw payloads */
+#ifndef COMMS_PAYLOAD_CODECS
+#define COMMS_PAYLOAD_CODECS       0
+#endif
+
+
 /* STATUS, CONTRL and EVNT defines */
 #define COMMS_DESTINATION_DEVICEID_SIZE 1
 
@@ -121,6 +145,75 @@
 #define MAX_SLOT_TIME              1000
 
 
+/* Keep alive defines, in frames (SYNC messages) */
+#define COMMS_KEEP_ALIVE_FRAMES    64   /*!< Server evicts keep alive clients silent for this many frames   */
+#define COMMS_KEEP_ALIVE_PING      16   /*!< Client sends KEEPALIVE after this many frames without STATUS   */
+
+
+/* Fragmented messages, application messages above one frame are sent in STATUS and CONTRL fragments */
+#define COMMS_FRAGMENT_HEADER_SIZE 2    /*!< Message id, fragment index and last fragment flag          */
+
+#ifndef COMMS_MAX_MESSAGE_LENGTH
+#define COMMS_MAX_MESSAGE_LENGTH   512  /*!< Largest fragmented message, size of one reassembly buffer  */
+#endif
+
+#ifndef COMMS_REASSEMBLY_BUFFERS
+#define COMMS_REASSEMBLY_BUFFERS   2    /*!< Messages reassembled at the same time by a client          */
+#endif
+
+#define COMMS_REASSEMBLY_TIMEOUT   32   /*!< Frames (SYNC messages) without a fragment drop the message */
+
+
+/* QoS 1 STATUS messages, sequence numbered, acknowledged in the SYNC ack bitmap and retransmitted by the client */
+#define COMMS_QOS_QUEUE_SIZE       4    /*!< Unacknowledged STATUS messages held by a client            */
+#define COMMS_QOS_RETRY_FRAMES     1    /*!< Owned slots without acknowledgement before a retransmission */
+#define COMMS_QOS_RETRIES          8    /*!< Retransmissions before a STATUS message is dropped         */
+#define COMMS_QOS_WINDOW           16   /*!< Server duplicate window, sequence numbers up to the newest */
+#define COMMS_STATUSACK_RECORDS    8    /*!< Client id and sequence number records per STATUSACK        */
+
+
+/* SYNC payload, the ack bitmap and the mail bitmap, each behind its length byte */
+#define COMMS_SYNC_BITMAP_SIZE     16   /*!< One bit per client id up to 127, trimmed to the last set bit */
+#define COMMS_SYNC_PAYLOAD_SIZE    (2 * (1 + COMMS_SYNC_BITMAP_SIZE))
+#define COMMS_SYNC_CLIENT_IDS      (8 * COMMS_SYNC_BITMAP_SIZE) /*!< Larger ids join without QoS 1 and low power */
+
+
+/* Downlink mailboxes, CONTRL messages for low power clients wait for the SYNC message announcing them */
+#define COMMS_MAILBOX_SIZE         8    /*!< CONTRL messages held by the server for low power clients   */
+#define COMMS_MAILBOX_DEPTH        2    /*!< CONTRL messages held for one client                        */
+#define COMMS_MAILBOX_ANNOUNCE     4    /*!< CONTRL messages sent in the listen window after a SYNC     */
+
+
+/* Join access, slotted ALOHA in the access slot with binary exponential backoff in frames */
+#define COMMS_JOIN_BACKOFF_LIMIT   6    /*!< Largest backoff window exponent, windows up to 2^n frames  */
+#define COMMS_JOIN_ATTEMPTS        16   /*!< JOINREQ messages sent before the join request is dropped   */
+
+/* Access slots, more than one access slot are placed behind the client slots, client slot numbers stay */
+#define COMMS_ACCESS_SLOTS_MAX     1    /*!< Largest access slot count, 1 keeps a single access slot      */
+#define COMMS_ACCESS_ADAPT_FRAMES  8    /*!< Frames (SYNC messages) between access slot count updates    */
+#define COMMS_ACCESS_FRAME_SHARE   8    /*!< Access slots up to total slots / n, frame grows by 1 / n    */
+
+
+/* Low power clients, the radio sleeps outside the listen window of each frame and the client slot */
+#define COMMS_SLEEP_WINDOW_SLOTS   6    /*!< Guard slot, sync slot, broadcast slot and its CONTRL frames      */
+#define COMMS_SLEEP_SYNC_SLOTS     2    /*!< Guard slot and sync slot, frames without mail for the client     */
+#define COMMS_SLEEP_QUIET_WINDOWS  8    /*!< Listen until the next SYNC after windows without server frames   */
+
+
+/* Superframes, clients with a period of 2^n frames share a slot at different frame offsets */
+#define COMMS_SUPERFRAME_LIMIT     5    /*!< Longest period 2^n frames, a keep alive ping per period      */
+#define COMMS_SUPERFRAME_CLIENT_ID 127  /*!< Superframe client ids count down from here, not slot numbers */
+
+
+/* Node metrics, comms_metrics_t */
+#define COMMS_METRICS_BINS         8    /*!< Histogram bins, the last bin counts all larger values      */
+#define COMMS_METRICS_FRAMES       16   /*!< Frames (SYNC messages) between metrics_snapshot callbacks  */
+
+
+/* Deferred debug trace, comms_trace_t */
+#define COMMS_TRACE_SIZE           16   /*!< Trace records, power of two up to 128                      */
+
+
 /* STATUS, CONTRL and EVNT defines */
 #define COMMS_SOURCE_DEVICEID_SIZE      1
 #define COMMS_DESTINATION_DEVICEID_SIZE 1
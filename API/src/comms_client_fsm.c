@@ -45,6 +45,8 @@
 /*
  * Standard Header and API Header files
  */
+#include <stddef.h>
+
 #include <comms_client_fsm.h>
 
 
@@ -68,26 +70,483 @@ typedef enum client_state_machine_values
 }client_fsm_states_t;
 
 
+/* Low power timer phases of a joined client */
+typedef enum client_sleep_phase_values
+{
+    SLEEP_LISTEN = 0,  /*!< Radio on, timer in the client slot until the next SYNC    */
+    SLEEP_WINDOW = 1,  /*!< Radio on from the guard slot, timer in the client slot    */
+    SLEEP_TAIL   = 2,  /*!< Radio on to the end of the listen window                  */
+    SLEEP_SLOT   = 3,  /*!< Radio off until the client slot, SYNC message held        */
+    SLEEP_FRAME  = 4   /*!< Radio off until the guard slot of the next listen window  */
+
+}client_sleep_phase_t;
+
+
+/* Compile time check, the interrupt trace producer writes 32 bit words of the embedded ring */
+typedef char client_trace_align_check[(offsetof(comms_client_context_t, trace) % sizeof(uint32_t) == 0) ? 1 : -1];
+
+
+/* Deferred debug trace of the single instance client, zeroed storage is an empty ring */
+static comms_trace_t client_trace;
+
+
 
 
 /******************************************************************************/
 /*                                                                            */
-/*                           API Functions                                    */
+/*                              Private Functions                             */
 /*                                                                            */
 /******************************************************************************/
 
 
 
 /**************************************************************************
- * @brief  Client State Machine Start Function
+ * @brief  Count SYNC messages missed by a joined client from the gap in
+ *         the frame numbers
+ * @param  *fsm        : reference to state machine persistent values
+ * @param  *metrics    : reference to node metrics
+ * @param  *sync_frame : received SYNC message
+ **************************************************************************/
+static void client_sync_missed(comms_client_fsm_t *fsm, comms_metrics_t *metrics, const char *sync_frame)
+{
+    uint8_t frame_number = comms_get_sync_frame(sync_frame);
+    uint8_t frame_gap    = (uint8_t)(frame_number - fsm->sync_frame);
+
+    /* First SYNC message after the join starts the count, a duplicate changes nothing,
+       a frame behind the last one (gap of half the frame range or more) is a late
+       re-ordered frame unless the next one is behind as well, the count was lost */
+    if(!fsm->sync_received || (frame_gap >= 128 && fsm->sync_behind))
+    {
+        fsm->sync_frame    = frame_number;
+        fsm->sync_received = 1;
+        fsm->sync_behind   = 0;
+    }
+    else if(frame_gap >= 128)
+    {
+        fsm->sync_behind = 1;
+    }
+    else if(frame_gap != 0)
+    {
+        metrics->sync_missed += (uint8_t)(frame_gap - 1);
+
+        fsm->sync_frame  = frame_number;
+        fsm->sync_behind = 0;
+    }
+}
+
+
+
+/**************************************************************************
+ * @brief  Check if the client slot of a superframe client is in the frame
+ *         of the SYNC message, a client with period 2^n sends in one frame
+ *         of every 2^n at its frame offset
+ * @param  *client_device : reference to client device configuration
+ * @param  *sync_frame    : received SYNC message
+ * @retval uint8_t        : 1 slot in this frame, 0 slot of another client
+ **************************************************************************/
+static uint8_t client_slot_owned(const device_config_t *client_device, const char *sync_frame)
+{
+    uint8_t frame_mask = (uint8_t)((1U << client_device->device_slot_period) - 1);
+
+    return ((uint8_t)(comms_get_sync_frame(sync_frame) - client_device->device_slot_offset) & frame_mask) == 0;
+}
+
+
+
+/**************************************************************************
+ * @brief  Slot of a joined client, timer slots after the SYNC message
+ * @param  *client_device : reference to client device configuration
+ * @retval uint8_t        : client slot
+ **************************************************************************/
+static uint8_t client_sleep_slot(const device_config_t *client_device)
+{
+    return client_device->device_frame_slot ? client_device->device_frame_slot : client_device->device_slot_number;
+}
+
+
+
+/**************************************************************************
+ * @brief  Server frames received, a low power client stays in sync while
+ *         it hears the server in its listen windows
  * @param  *wireless_network : reference to network access handle
- * @param  *server_device    : reference to device configuration structure
+ * @retval uint32_t          : received SYNC, JOINRESP and CONTRL frames
+ **************************************************************************/
+static uint32_t client_sleep_heard(const access_control_t *wireless_network)
+{
+    return wireless_network->metrics.frames_rx[COMMS_SYNC_MESSAGE] +
+           wireless_network->metrics.frames_rx[COMMS_JOINRESP_MESSAGE] +
+           wireless_network->metrics.frames_rx[COMMS_CONTRL_MESSAGE];
+}
+
+
+
+/**************************************************************************
+ * @brief  Check if a joined client sends in the client slot of the frame
+ *         of a SYNC message, the conditions of the DEV_JOINED sends
+ * @param  *fsm             : reference to state machine persistent values
+ * @param  *client_device   : reference to client device configuration
+ * @param  *network_buffers : reference to network buffers structure
+ * @param  *sync_frame      : received SYNC message
+ * @retval uint8_t          : 1 client sends, 0 nothing to send
+ **************************************************************************/
+static uint8_t client_sleep_sends(const comms_client_fsm_t *fsm, const device_config_t *client_device,
+                                  const comms_network_buffer_t *network_buffers, const char *sync_frame)
+{
+    return client_slot_owned(client_device, sync_frame) &&
+           (network_buffers->application_flags.network_unjoin_request == 1 ||
+            network_buffers->application_flags.network_hibernate_request == 1 ||
+            network_buffers->application_flags.application_message_ready == 1 ||
+            comms_retransmit_count(fsm->retransmit, COMMS_QOS_QUEUE_SIZE) > 0 ||
+            fsm->keep_alive_frames + 1 >= COMMS_KEEP_ALIVE_PING);
+}
+
+
+
+/**************************************************************************
+ * @brief  Low power client, start of a transmit timer interrupt: wake the
+ *         radio for a listen window or the client slot, hold a SYNC
+ *         message heard early in the window until the client slot. The
+ *         window reaches the broadcast slot only after a SYNC message
+ *         announcing mail for the client
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client_device    : reference to client device configuration
+ * @param  *network_buffers  : reference to network buffers structure
+ * @retval uint8_t           : 1 radio off until the client slot, 0 run
+ **************************************************************************/
+static uint8_t client_sleep_wake(comms_client_fsm_t *fsm, access_control_t *wireless_network, device_config_t *client_device,
+                                 comms_network_buffer_t *network_buffers)
+{
+    uint8_t      func_retval = 0;
+    uint8_t      slot        = client_sleep_slot(client_device);
+    net_event_t *event;
+
+    switch(fsm->sleep_phase)
+    {
+
+    case SLEEP_FRAME:
+
+        /* Guard slot before the frame grid point, listen until the client slot or the window end */
+        comms_radio_wake(wireless_network);
+
+        fsm->sleep_window = fsm->sleep_mail ? COMMS_SLEEP_WINDOW_SLOTS : COMMS_SLEEP_SYNC_SLOTS;
+        fsm->sleep_mail   = 0;
+
+        wireless_network->wake_slots = slot < fsm->sleep_window ? slot : fsm->sleep_window;
+
+        comms_network_set_timer(wireless_network, client_device, NET_CLIENT_WAKE_SLOT);
+
+        fsm->sleep_phase  = SLEEP_WINDOW;
+        fsm->sleep_frames = client_sleep_heard(wireless_network);
+
+        func_retval = 1;
+
+        break;
+
+
+    case SLEEP_WINDOW:
+
+        event = comms_event_peek(network_buffers);
+
+        /* SYNC message reset the timer to the window length, sleep again until the client slot */
+        if(event != NULL && event->type == SYNC_FLAG && slot > fsm->sleep_window &&
+           client_sleep_sends(fsm, client_device, network_buffers, event->data))
+        {
+            comms_radio_sleep(wireless_network);
+
+            wireless_network->wake_slots = slot - fsm->sleep_window;
+
+            comms_network_set_timer(wireless_network, client_device, NET_CLIENT_WAKE_SLOT);
+
+            fsm->sleep_phase = SLEEP_SLOT;
+
+            func_retval = 1;
+        }
+
+        break;
+
+
+    case SLEEP_SLOT:
+
+        /* Client slot, send with the held SYNC message */
+        comms_radio_wake(wireless_network);
+
+        break;
+
+
+    default:
+
+        break;
+
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Low power client, end of a transmit timer interrupt: put the
+ *         radio to sleep until the guard slot before the next frame grid
+ *         point, the server sends only in the sync and broadcast slots
+ *         of its frames. Clients listen until the next SYNC message after
+ *         COMMS_SLEEP_QUIET_WINDOWS windows without server frames
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client_device    : reference to client device configuration
+ * @param  sync_heard        : SYNC message handled in this interrupt
+ **************************************************************************/
+static void client_sleep_next(comms_client_fsm_t *fsm, access_control_t *wireless_network, device_config_t *client_device,
+                              uint8_t sync_heard)
+{
+    uint8_t slot       = client_sleep_slot(client_device);
+    uint8_t window     = slot < fsm->sleep_window ? slot : fsm->sleep_window;
+    int16_t frame_slot = 0;
+    int16_t wake_slots = 0;
+
+    /* Sleep mode off or refused for the client id, left the network or frames too short to sleep in */
+    if(fsm->sleep_mode == 0 || fsm->bitmap_client == 0 || fsm->fsm_state != DEV_JOINED || slot == 0 ||
+       fsm->frame_slots <= COMMS_SLEEP_WINDOW_SLOTS)
+    {
+        if(fsm->sleep_phase != SLEEP_LISTEN)
+        {
+            comms_radio_wake(wireless_network);
+
+            comms_network_set_timer(wireless_network, client_device, NET_CLIENT_SLOT);
+
+            fsm->sleep_phase = SLEEP_LISTEN;
+        }
+    }
+    else if(sync_heard == 0 && fsm->sleep_phase == SLEEP_WINDOW && window < fsm->sleep_window)
+    {
+        /* Window of a client slot before the window end continues past the client slot */
+        wireless_network->wake_slots = fsm->sleep_window - window;
+
+        comms_network_set_timer(wireless_network, client_device, NET_CLIENT_WAKE_SLOT);
+
+        fsm->sleep_phase = SLEEP_TAIL;
+    }
+    else if(sync_heard || fsm->sleep_phase == SLEEP_WINDOW || fsm->sleep_phase == SLEEP_TAIL)
+    {
+        /* Slots from the frame grid point to this interrupt, the window starts a slot before the grid point */
+        if(sync_heard)
+            frame_slot = fsm->sleep_phase == SLEEP_WINDOW ? window : slot;
+        else
+            frame_slot = fsm->sleep_window - 1;
+
+        if(sync_heard || client_sleep_heard(wireless_network) != fsm->sleep_frames)
+            fsm->sleep_quiet = 0;
+        else
+            fsm->sleep_quiet++;
+
+        if(fsm->sleep_quiet >= COMMS_SLEEP_QUIET_WINDOWS)
+        {
+            /* Frame grid lost, listen for the next SYNC message */
+            comms_network_set_timer(wireless_network, client_device, NET_CLIENT_SLOT);
+
+            fsm->sleep_phase = SLEEP_LISTEN;
+            fsm->sleep_quiet = 0;
+        }
+        else
+        {
+            /* Guard slot of the next frame grid point, the server sends nothing at the grid point after a SYNC */
+            wake_slots = fsm->frame_slots - frame_slot - 1;
+
+            while(wake_slots <= 0)
+                wake_slots += fsm->frame_slots;
+
+            comms_radio_sleep(wireless_network);
+
+            wireless_network->wake_slots = (uint8_t)wake_slots;
+
+            comms_network_set_timer(wireless_network, client_device, NET_CLIENT_WAKE_SLOT);
+
+            fsm->sleep_phase = SLEEP_FRAME;
+        }
+    }
+}
+
+
+
+/**************************************************************************
+ * @brief  Next value of the join access random state, xorshift32 seeded
+ *         with the FNV-1a hash of the mac address
+ * @param  *fsm        : reference to state machine persistent values
+ * @param  *device_mac : client mac address
+ * @retval uint32_t    : random value
+ **************************************************************************/
+static uint32_t client_join_random(comms_client_fsm_t *fsm, const char *device_mac)
+{
+    uint8_t index = 0;
+
+    if(fsm->join_random == 0)
+    {
+        fsm->join_random = 2166136261u;
+
+        for(index = 0; index < NET_MAC_SIZE; index++)
+            fsm->join_random = (fsm->join_random ^ (uint8_t)device_mac[index]) * 16777619u;
+
+        if(fsm->join_random == 0)
+            fsm->join_random = 1;
+    }
+
+    fsm->join_random ^= fsm->join_random << 13;
+    fsm->join_random ^= fsm->join_random >> 17;
+    fsm->join_random ^= fsm->join_random << 5;
+
+    return fsm->join_random;
+}
+
+
+
+/**************************************************************************
+ * @brief  Slotted ALOHA access decision for the access slots of a frame,
+ *         p-persistent with p = access slots / join load hint of the server,
+ *         binary exponential backoff over the JOINREQ messages sent while
+ *         the server reports no contention
+ * @param  *fsm         : reference to state machine persistent values
+ * @param  *device_mac  : client mac address
+ * @param  *sync_frame  : received sync message
+ * @retval uint8_t      : send JOINREQ = 0, skip the frame = 1
+ **************************************************************************/
+static uint8_t client_join_defer(comms_client_fsm_t *fsm, const char *device_mac, const char *sync_frame)
+{
+    uint8_t func_retval  = 0;
+    uint8_t join_load    = comms_get_sync_join_load(sync_frame);
+    uint8_t access_slots = comms_get_sync_access_slots(sync_frame, NULL);
+
+    if(join_load > access_slots)
+    {
+        func_retval = (client_join_random(fsm, device_mac) % join_load) >= access_slots;
+    }
+    else if(join_load == 0 && fsm->join_backoff > 0)
+    {
+        fsm->join_backoff--;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Draw the backoff after a JOINREQ message, SYNC messages without
+ *         load hint to skip, uniform in a window of 2^n frames after n
+ *         JOINREQ messages, up to 2^COMMS_JOIN_BACKOFF_LIMIT
+ * @param  *fsm        : reference to state machine persistent values
+ * @param  *device_mac : client mac address
+ * @retval uint16_t    : SYNC messages to skip
+ **************************************************************************/
+static uint16_t client_join_backoff(comms_client_fsm_t *fsm, const char *device_mac)
+{
+    uint16_t window = (uint16_t)1 << (fsm->join_attempts < COMMS_JOIN_BACKOFF_LIMIT ?
+                                      fsm->join_attempts : COMMS_JOIN_BACKOFF_LIMIT);
+
+    return (uint16_t)(client_join_random(fsm, device_mac) % window);
+}
+
+
+
+/**************************************************************************
+ * @brief  Pick the access slot of the next JOINREQ message, uniform over
+ *         the access slots announced in the SYNC message
+ * @param  *fsm           : reference to state machine persistent values
+ * @param  *client_device : reference to device configuration structure
+ * @param  *sync_frame    : received sync message
+ * @retval uint8_t        : access slot changed = 1, same access slot = 0
+ **************************************************************************/
+static uint8_t client_join_slot(comms_client_fsm_t *fsm, device_config_t *client_device, const char *sync_frame)
+{
+    uint8_t func_retval  = 0;
+    uint8_t access_slot  = 0;
+    uint8_t access_slots = comms_get_sync_access_slots(sync_frame, &access_slot);
+
+    if(access_slots > 1)
+        access_slot += (uint8_t)(client_join_random(fsm, client_device->device_mac) % access_slots);
+
+    if(access_slot != client_device->network_access_slot)
+    {
+        client_device->network_access_slot = access_slot;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  QoS 1 client, the server refuses QoS 1 for client ids from
+ *         COMMS_SYNC_CLIENT_IDS, not in the SYNC ack bitmap
+ * @param  *fsm    : reference to state machine persistent values
+ * @retval uint8_t : 1 QoS 1, 0 QoS 0
+ **************************************************************************/
+static uint8_t client_qos_active(const comms_client_fsm_t *fsm)
+{
+    return fsm->qos && fsm->bitmap_client;
+}
+
+
+
+/**************************************************************************
+ * @brief  QoS 1 client, check for room in the retransmit queue before a
+ *         new STATUS message or fragment
+ * @param  *fsm    : reference to state machine persistent values
+ * @retval uint8_t : 1 send, 0 wait for acknowledgements
+ **************************************************************************/
+static uint8_t client_qos_room(const comms_client_fsm_t *fsm)
+{
+    return client_qos_active(fsm) == 0 || comms_retransmit_count(fsm->retransmit, COMMS_QOS_QUEUE_SIZE) < COMMS_QOS_QUEUE_SIZE;
+}
+
+
+
+/**************************************************************************
+ * @brief  QoS 1 client, add the sequence number to a configured STATUS
+ *         message and hold the frame until the server acknowledges it
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client           : protocol handle of the STATUS message
+ * @param  message_length    : length of the configured STATUS message
+ * @retval uint8_t           : length of the STATUS message to send
+ **************************************************************************/
+static uint8_t client_qos_status(comms_client_fsm_t *fsm, access_control_t *wireless_network, protocol_handle_t *client,
+                                 uint8_t message_length)
+{
+    if(client_qos_active(fsm) && message_length)
+    {
+        message_length = comms_status_sequence(client, fsm->qos_sequence, comms_network_frame_limit(wireless_network));
+
+        /* Frame is held before the send appends the CRC trailer */
+        if(message_length)
+        {
+            comms_retransmit_add(fsm->retransmit, COMMS_QOS_QUEUE_SIZE, (char*)client->status_msg, message_length,
+                                 fsm->qos_sequence);
+
+            fsm->qos_sent          = 1;
+            fsm->qos_sent_sequence = fsm->qos_sequence++;
+        }
+    }
+
+    return message_length;
+}
+
+
+
+/**************************************************************************
+ * @brief  Client state machine step, runs on every transmit timer interrupt
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client_device    : reference to device configuration structure
  * @param  *network_buffers  : reference to network buffers structure
  * @param  destination_id    : device id of the destination
  * @retval int8_t            : error = 0
  **************************************************************************/
-int8_t comms_start_client(access_control_t *wireless_network, device_config_t *client_device,
-                          comms_network_buffer_t *network_buffers, uint8_t destination_id)
+static int8_t client_fsm_step(comms_client_fsm_t *fsm, access_control_t *wireless_network, device_config_t *client_device,
+                              comms_network_buffer_t *network_buffers, uint8_t destination_id)
 {
 
     int8_t func_retval = 1;
@@ -97,207 +556,736 @@ int8_t comms_start_client(access_control_t *wireless_network, device_config_t *c
     char    message_buffer[NET_MTU_SIZE] = {0};
     uint8_t message_length               = 0;
 
-    static uint8_t debug_print_count = 0;
+    const char *reassembled_message = NULL;
+    int16_t     reassembly_length   = 0;
+    int16_t     fragment_length     = 0;
+    uint8_t     fragment_source     = 0;
+    uint8_t     fragment_last       = 0;
 
-    static  client_fsm_states_t fsm_state = DEV_INIT;
+    char        codec_buffer[NET_DATA_LENGTH] = {0};
+    uint16_t    codec_length                  = 0;
+    int16_t     decoded_length                = 0;
+    uint8_t     codec                         = COMMS_CODEC_NONE;
 
-    switch(fsm_state)
-    {
+    net_retransmit_t *retransmit  = NULL;
 
-    case DEV_INIT:
+    net_event_t *event;
+    uint8_t      event_done  = 1;
+    int8_t       join_status = 0;
+    uint8_t      slot_owned  = 1;
+    uint8_t      sync_heard  = 0;
 
-        fsm_state = DEV_SYNC;
+    if(fsm->fsm_state == DEV_INIT)
+        fsm->fsm_state = DEV_SYNC;
 
-        break;
+    comms_metrics_step(wireless_network, network_buffers);
 
+    /* Low power client, radio off until the client slot */
+    if(fsm->sleep_phase != SLEEP_LISTEN && client_sleep_wake(fsm, wireless_network, client_device, network_buffers))
+        return 0;
 
-    case DEV_SYNC:
+    /* Handle every message received since the last slot, oldest first */
+    while(event_done && (event = comms_event_peek(network_buffers)) != NULL)
+    {
 
-        if(network_buffers->flag_state == SYNC_FLAG)
+        switch(fsm->fsm_state)
         {
 
-            comms_sync_status(wireless_network);
+        case DEV_SYNC:
+
+            if(event->type == SYNC_FLAG)
+            {
+
+                comms_sync_status(wireless_network);
+
+                fsm->fsm_state = DEV_SYNC;
+
+                if(network_buffers->application_flags.network_join_request == 1)
+                {
+                    /* Get data from the event buffer */
+                    wireless_network->sync_message = (void*)event->data;
+
+                    /* Get sync data (access slot and network id) */
+                    get_sync_data(client_device, sync_message_buff, *wireless_network);
+
+                    client_join_slot(fsm, client_device, event->data);
+
+                    /* calibrate timer to access slot */
+                    comms_network_set_timer(wireless_network, client_device, NET_CLIENT_ACCESS_SLOT);
+
+                    fsm->join_attempts = 0;
+                    fsm->join_backoff  = 0;
+
+                    fsm->fsm_state = DEV_JOINREQ;
+                }
+            }
 
-            fsm_state = DEV_SYNC;
+            break;
 
-            if(network_buffers->application_flags.network_join_request == 1)
+
+        case DEV_JOINREQ:
+
+
+            /* Send JOINREQ Message until JOINRESP message is not received, slotted ALOHA in the access slot */
+            if(event->type == SYNC_FLAG && network_buffers->application_flags.network_join_request == 1 &&
+               fsm->join_attempts >= COMMS_JOIN_ATTEMPTS)
+            {
+                /* No JOINRESP message, drop the request until the application joins again */
+                network_buffers->application_flags.network_join_request = 0;
+
+                fsm->join_attempts = 0;
+            }
+            else if(event->type == SYNC_FLAG && network_buffers->application_flags.network_join_request == 1 &&
+                    client_join_defer(fsm, client_device->device_mac, event->data) == 0)
             {
-                /* Get data from read buffer */
-                wireless_network->sync_message = (void*)network_buffers->read_message;
 
-                /* Get sync data (access slot and network id) */
-                get_sync_data(client_device, sync_message_buff, *wireless_network);
+                comms_send_status(wireless_network);
+
+                client.joinrequest_msg = (void*)message_buffer;
+
+                /* configure JOINREQ message options*/
+                comms_joinreq_options(&client, fsm->qos, 1);
+
+                comms_joinreq_codec(&client, fsm->payload_codecs ? 1 : 0);
+
+                comms_joinreq_sleep(&client, fsm->sleep_mode);
+
+                comms_joinreq_period(&client, fsm->slot_period);
+
+                /* configure JOINREQ message fields */
+                message_length = comms_joinreq_message(&client, *client_device, 1);
+
+                /* Send join request message */
+                comms_send(wireless_network, (char*)client.joinrequest_msg, message_length);
+
+                /* Print once */
+                comms_joinreq_debug_print(wireless_network, "JOINREQ", client_device->total_slots);
 
-                /* Clear read buffer after reading the message */
-                memset(network_buffers->read_message, 0, sizeof(network_buffers->read_message));
+                /* Lost to a collision unless the JOINRESP message arrives before the backoff ends */
+                fsm->join_attempts++;
+                fsm->join_backoff = client_join_backoff(fsm, client_device->device_mac);
 
-                /* calibrate timer to access slot */
+            }
+
+            /* Access slot of the next frame, the access slots change with the frame length */
+            if(event->type == SYNC_FLAG && network_buffers->application_flags.network_join_request == 1 &&
+               client_join_slot(fsm, client_device, event->data))
+            {
                 comms_network_set_timer(wireless_network, client_device, NET_CLIENT_ACCESS_SLOT);
+            }
+
+
+            /*Get JOINRESP Message data from WI network server*/
+            if(event->type == JOINRESP_FLAG)
+            {
+
+                client.joinresponse_msg = (void*)event->data;
+
+                /* Get JOINRESP data */
+                join_status = comms_get_joinresp_data(client_device, client);
+
+                if(join_status == JOINRESP_ACK)
+                    wireless_network->metrics.join_accepted++;
+                else if(join_status == JOINRESP_NACK)
+                    wireless_network->metrics.join_rejected++;
+                else if(join_status == JOINRESP_DUP)
+                    wireless_network->metrics.join_duplicates++;
+
+                if(client_device->device_slot_number)
+                {
+
+                    comms_clear_activity(wireless_network);
+
+                    /* Set network flag as joined */
+                    client_device->network_joined = 1;
+                    network_buffers->application_flags.network_joined_state = 1;
+
+                    /* Calibrate new slot time */
+                    comms_network_set_timer(wireless_network, client_device, NET_CLIENT_SLOT);
+
+                    /* Reset join request flag */
+                    network_buffers->application_flags.network_join_request = 0;
+
+                    /* Change state to joined */
+                    fsm->fsm_state = DEV_JOINED;
+
+                    fsm->sync_received = 0;
+                    fsm->sync_behind   = 0;
+                    fsm->frames_sent   = wireless_network->metrics.frames_sent;
+
+                    /* Server refuses QoS 1 and low power for client ids outside the SYNC bitmaps */
+                    fsm->bitmap_client = client_device->device_slot_number < COMMS_SYNC_CLIENT_IDS;
+
+                    /*Print JOINREQ debug message */
+                    comms_joinresp_debug_print(wireless_network, "JOINRESP", client_device->device_slot_number);
+
+                    /* Clear print only once for JOINREQ debug message */
+                    fsm->debug_print_count = 0;
+
+                }
 
-                fsm_state = DEV_JOINREQ;
             }
 
-            network_buffers->flag_state = CLEAR_FLAG;
-        }
+            break;
 
 
-        break;
+        case DEV_JOINED:
 
+            /* Network joined status*/
+            if(event->type == SYNC_FLAG)
+            {
+                comms_net_connected_status(wireless_network);
 
-    case DEV_JOINREQ:
+                /* Frames sent in the client slots of the last frame */
+                comms_metrics_frame(wireless_network, wireless_network->metrics.frames_sent - fsm->frames_sent);
 
+                fsm->frames_sent = wireless_network->metrics.frames_sent;
 
-        /* Send JOINREQ Message until JOINRESP message is not received */
-        if(network_buffers->flag_state == SYNC_FLAG && network_buffers->flag_state != JOINRESP_FLAG && \
-                network_buffers->application_flags.network_join_request == 1)
-        {
+                client_sync_missed(fsm, &wireless_network->metrics, event->data);
 
-            comms_send_status(wireless_network);
+                /* Drop fragmented messages missing fragments */
+                comms_reassembly_age(fsm->reassembly, COMMS_REASSEMBLY_BUFFERS);
 
-            client.joinrequest_msg = (void*)message_buffer;
+                /* Superframe clients share the slot with clients at other frame offsets */
+                slot_owned = client_slot_owned(client_device, event->data);
 
-            /* configure JOINREQ message options*/
-            comms_joinreq_options(&client, 0, 1);
+                /* Frame grid of the low power listen windows */
+                fsm->frame_slots = comms_get_sync_frame_slots(event->data);
 
-            /* configure JOINREQ message fields */
-            message_length = comms_joinreq_message(&client, *client_device, 1);
+                /* QoS 1, the ack bitmap acknowledges the STATUS frame sent in the last frame */
+                if(fsm->qos_sent && comms_get_sync_ack(event->data, client_device->device_slot_number))
+                    comms_retransmit_ack(fsm->retransmit, COMMS_QOS_QUEUE_SIZE, fsm->qos_sent_sequence);
 
-            /* Send join request message */
-            comms_send(wireless_network, (char*)client.joinrequest_msg, message_length);
+                fsm->qos_sent = 0;
 
-            network_buffers->flag_state = CLEAR_FLAG;
+                /* Mail held by the server, the next listen window reaches the broadcast slot */
+                fsm->sleep_mail = comms_get_sync_mail(event->data, client_device->device_slot_number);
 
-            /* Print once */
-            comms_joinreq_debug_print(wireless_network, "JOINREQ", client_device->total_slots);
+                /* Frames without acknowledgement are sent again in the next owned slots */
+                if(slot_owned && client_qos_active(fsm))
+                    wireless_network->metrics.qos_dropped += comms_retransmit_age(fsm->retransmit, COMMS_QOS_QUEUE_SIZE);
 
+                sync_heard = 1;
 
-#if JOINREQ_ONCE
-            network_buffers->application_flags.network_join_request = 0;
-#endif
+            }
 
-        }
 
+            /* Leave the network, server releases the slots */
+            if(event->type == SYNC_FLAG && slot_owned &&
+               (network_buffers->application_flags.network_unjoin_request == 1 ||
+                network_buffers->application_flags.network_hibernate_request == 1))
+            {
+                comms_send_status(wireless_network);
+
+                client.status_msg = (void*)message_buffer;
 
-        /*Get JOINRESP Message data from WI network server*/
-        if(network_buffers->flag_state == JOINRESP_FLAG)
-        {
+                message_length = comms_status_notify_message(&client, *client_device,
+                                                             network_buffers->application_flags.network_unjoin_request ?
+                                                             COMMS_UNJOIN_MESSAGE : COMMS_HIBERNATE_MESSAGE);
+
+                comms_send(wireless_network, (char*)client.status_msg, message_length);
+
+                network_buffers->application_flags.network_unjoin_request    = 0;
+                network_buffers->application_flags.network_hibernate_request = 0;
+                network_buffers->application_flags.network_joined_state      = 0;
+                network_buffers->application_flags.application_message_ready = 0;
+
+                client_device->network_joined     = 0;
+                client_device->device_slot_number = 0;
+                client_device->device_frame_slot  = 0;
+                client_device->device_slot_period = 0;
+                client_device->device_slot_offset = 0;
+
+                fsm->contrl_record   = 0;
+                fsm->fragment_index  = 0;
+                fsm->fragment_offset = 0;
+
+                init_reassembly(fsm->reassembly, COMMS_REASSEMBLY_BUFFERS);
 
-            client.joinresponse_msg = (void*)network_buffers->read_message;
+                init_retransmit(fsm->retransmit, COMMS_QOS_QUEUE_SIZE);
 
-            /* Get JOINRESP data */
-            comms_get_joinresp_data(client_device, client);
+                fsm->fsm_state = DEV_SYNC;
 
-            if(client_device->device_slot_number)
+                break;
+            }
+
+
+            /* QoS 1, send the oldest STATUS frame without acknowledgement again, copied for the CRC trailer */
+            if(event->type == SYNC_FLAG && slot_owned && client_qos_active(fsm) &&
+               (retransmit = comms_retransmit_due(fsm->retransmit, COMMS_QOS_QUEUE_SIZE)) != NULL)
             {
+                comms_send_status(wireless_network);
 
-                comms_clear_activity(wireless_network);
+                memcpy(message_buffer, retransmit->frame, retransmit->length);
 
-                /* Set network flag as joined */
-                client_device->network_joined = 1;
-                network_buffers->application_flags.network_joined_state = 1;
+                comms_send(wireless_network, message_buffer, retransmit->length);
 
-                /* Calibrate new slot time */
-                comms_network_set_timer(wireless_network, client_device, NET_CLIENT_SLOT);
+                fsm->qos_sent          = 1;
+                fsm->qos_sent_sequence = retransmit->sequence;
 
-                /* Reset join request flag */
-                network_buffers->application_flags.network_join_request = 0;
+                retransmit->age = 0;
+                retransmit->retries++;
+
+                wireless_network->metrics.qos_retransmits++;
+
+                fsm->keep_alive_frames = 0;
+            }
+            /* Send a fragment of a long app message per slot */
+            else if(event->type == SYNC_FLAG && slot_owned && client_qos_room(fsm) &&
+                    network_buffers->application_flags.application_message_ready == 1 &&
+                    network_buffers->app_message_length > comms_fragment_size(wireless_network))
+            {
+                comms_send_status(wireless_network);
+
+                client.status_msg = (void*)message_buffer;
+
+                fragment_length = network_buffers->app_message_length - fsm->fragment_offset;
+                fragment_last   = fragment_length <= comms_fragment_size(wireless_network);
+
+                if(!fragment_last)
+                    fragment_length = comms_fragment_size(wireless_network);
 
-                /* Change state to joined */
-                fsm_state = DEV_JOINED;
+                message_length = comms_status_fragment_message(&client, *client_device, destination_id,
+                                                               fsm->fragment_message_id, fsm->fragment_index,
+                                                               fragment_last,
+                                                               network_buffers->app_message_data + fsm->fragment_offset,
+                                                               fragment_length);
 
-                /*Print JOINREQ debug message */
-                comms_joinresp_debug_print(wireless_network, "JOINRESP", client_device->device_slot_number);
+                message_length = client_qos_status(fsm, wireless_network, &client, message_length);
 
-                /* Clear print only once for JOINREQ debug message */
-                debug_print_count = 0;
+                comms_send(wireless_network, (char*)client.status_msg, message_length);
 
+                fsm->fragment_offset += fragment_length;
+                fsm->fragment_index++;
+
+                /* Application buffer is released with the last fragment */
+                if(fragment_last)
+                {
+                    network_buffers->application_flags.application_message_ready = 0;
+
+                    fsm->fragment_message_id++;
+                    fsm->fragment_index  = 0;
+                    fsm->fragment_offset = 0;
+                }
+
+                fsm->keep_alive_frames = 0;
             }
+            /* Send Status message when app message is ready */
+            else if(event->type == SYNC_FLAG && slot_owned && client_qos_room(fsm) &&
+                    network_buffers->application_flags.application_message_ready == 1 )
+            {
+                /* Send STATUS Message when application message is available */
+                comms_send_status(wireless_network);
+
+                client.status_msg = (void*)message_buffer;
+
+                /* Encoded payload when a codec makes it smaller */
+                if(fsm->payload_codecs)
+                    codec = comms_codec_encode(network_buffers->application_message, network_buffers->app_message_length,
+                                               codec_buffer, sizeof(codec_buffer), fsm->payload_codecs, &codec_length);
+
+                /* Configure Status message */
+                if(codec)
+                    message_length = comms_status_codec_message(&client, *client_device, destination_id, codec,
+                                                                codec_buffer, codec_length);
+                else
+                    message_length = comms_status_message(&client, *client_device, destination_id,
+                                                          network_buffers->application_message, network_buffers->app_message_length);
+
+                message_length = client_qos_status(fsm, wireless_network, &client, message_length);
+
+                /* Send Status Message */
+                comms_send(wireless_network, (char*)client.status_msg, message_length);
+
+                network_buffers->application_flags.application_message_ready = 0;
+
+                comms_status_debug_print(wireless_network, "STATUS",destination_id, network_buffers->application_message);
+
+                fsm->keep_alive_frames = 0;
+
+            }
+            /* Keep the slot, server releases clients silent for a keep alive period */
+            else if(event->type == SYNC_FLAG && ++fsm->keep_alive_frames >= COMMS_KEEP_ALIVE_PING && slot_owned)
+            {
+                client.status_msg = (void*)message_buffer;
+
+                message_length = comms_status_notify_message(&client, *client_device, COMMS_KEEPALIVE_MESSAGE);
+
+                comms_send(wireless_network, (char*)client.status_msg, message_length);
+
+                fsm->keep_alive_frames = 0;
+            }
+
+
+            /* Get CONTROL Message data*/
+            if(event->type == CONTRLMSG_FLAG)
+            {
+                /* Keep the message queued until the application read the previous one */
+                if(network_buffers->application_flags.network_message_ready == 1)
+                {
+                    event_done = 0;
+
+                    break;
+                }
+
+                client.contrl_msg = (void*)event->data;
+
+                /* The application read the previous reassembled message */
+                comms_reassembly_release(fsm->reassembly, COMMS_REASSEMBLY_BUFFERS);
 
-            memset(network_buffers->read_message, 0, sizeof(network_buffers->read_message));
+                fragment_length = comms_get_contrl_fragment(message_buffer, &fragment_source, client,
+                                                            client_device->device_network_id,
+                                                            client_device->device_slot_number);
 
-            network_buffers->flag_state = CLEAR_FLAG;
+                /* Fragment of a long message, delivered from the reassembly buffer when complete */
+                if(fragment_length > 0)
+                {
+                    reassembly_length = comms_reassembly_add(fsm->reassembly, COMMS_REASSEMBLY_BUFFERS, fragment_source,
+                                                             message_buffer, fragment_length, &reassembled_message);
+
+                    if(reassembly_length > 0)
+                    {
+                        network_buffers->network_message_data = reassembled_message;
+                        network_buffers->net_message_length   = (uint16_t)reassembly_length;
+                        network_buffers->source_id            = fragment_source;
+                        network_buffers->destination_id       = client_device->device_slot_number;
+
+                        /* Message head for readers of the network message buffer */
+                        memset(network_buffers->network_message, 0, sizeof(network_buffers->network_message));
+                        memcpy(network_buffers->network_message, reassembled_message,
+                               reassembly_length < NET_DATA_LENGTH ? (size_t)reassembly_length : NET_DATA_LENGTH - 1);
+
+                        network_buffers->application_flags.network_message_ready = 1;
+
+                        comms_recv_status(wireless_network);
+                    }
+
+                    break;
+                }
+
+                memset(network_buffers->network_message, 0, sizeof(network_buffers->network_message));
+
+                /* read control message, one record of an aggregated CONTRL message per application read */
+                message_length = comms_get_contrl_record(network_buffers->network_message, &network_buffers->source_id, client,
+                                                         client_device->device_network_id, client_device->device_slot_number,
+                                                         &fsm->contrl_record);
+
+                network_buffers->destination_id = client_device->device_slot_number;
+
+                if(message_length && comms_get_contrl_status(client) == CLIENT_NOT_FOUND)
+                    wireless_network->metrics.client_not_found++;
+
+                codec = comms_get_contrl_codec(client);
+
+                /* Decode in place, encoded CONTRL messages are sent only after codec support at join */
+                if(message_length && codec)
+                {
+                    decoded_length = comms_codec_decode(codec, network_buffers->network_message, message_length,
+                                                        codec_buffer, sizeof(codec_buffer) - 1);
+
+                    message_length = decoded_length > 0 ? (uint8_t)decoded_length : 0;
+
+                    memset(network_buffers->network_message, 0, sizeof(network_buffers->network_message));
+                    memcpy(network_buffers->network_message, codec_buffer, message_length);
+                }
+
+                if(message_length)
+                {
+                    network_buffers->network_message_data = network_buffers->network_message;
+                    network_buffers->net_message_length   = message_length;
+
+                    network_buffers->application_flags.network_message_ready = 1;
+
+                    comms_recv_status(wireless_network);
+
+                    comms_contrl_debug_print(wireless_network, "CONTROL", network_buffers->source_id, network_buffers->network_message);
+
+                }
+
+                /* Keep the message queued for the next record addressed to this device */
+                if(fsm->contrl_record)
+                    event_done = 0;
+
+            }
+
+            break;
+
+
+        default:
+
+            fsm->fsm_state = DEV_SYNC;
+
+            break;
 
         }
 
-        break;
+        if(event_done)
+            comms_event_pop(network_buffers);
+    }
+
+    /* Low power client, radio off until the next listen window */
+    if(fsm->sleep_mode || fsm->sleep_phase != SLEEP_LISTEN)
+        client_sleep_next(fsm, wireless_network, client_device, sync_heard);
+
+    func_retval = 0;
+
+    return func_retval;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
 
 
-    case DEV_JOINED:
 
-        /* Network joined status*/
-        if(network_buffers->flag_state == SYNC_FLAG)
+/**************************************************************************
+ * @brief  Client instance constructor, initializes caller owned context
+ *         and attaches the context trace, comms_network_trace_flush
+ *         prints the recorded debug output from the main loop
+ * @param  *client           : reference to client context
+ * @param  *network_ops      : reference to network operations handle
+ * @param  *mac_address      : mac_address of the client device
+ * @param  requested_slots   : number of slots requested
+ * @param  *user_name        : network user name
+ * @param  *password         : network password
+ * @retval int8_t            : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_init(comms_client_context_t *client, network_operations_t *network_ops, char *mac_address,
+                         uint8_t requested_slots, char *user_name, uint8_t *password)
+{
+    int8_t func_retval = 0;
+
+    if(client == NULL || network_ops == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        memset(client, 0, sizeof(comms_client_context_t));
+
+        init_network_handle(&client->network, network_ops);
+
+        if(init_client_device(&client->device, mac_address, requested_slots, user_name, password) == NULL)
+        {
+            func_retval = -1;
+        }
+        else
         {
-            comms_net_connected_status(wireless_network);
+            client->fsm.fsm_state = DEV_INIT;
 
+            init_reassembly(client->fsm.reassembly, COMMS_REASSEMBLY_BUFFERS);
 
+            init_retransmit(client->fsm.retransmit, COMMS_QOS_QUEUE_SIZE);
+
+            /* Debug prints of the state machine are recorded, comms_network_trace_flush prints them */
+            init_trace(&client->trace);
+
+            func_retval = comms_network_set_trace(&client->network, &client->trace);
         }
+    }
+
+    return func_retval;
+}
 
 
-        /* Send Status message when app message is ready */
-        if(network_buffers->flag_state == SYNC_FLAG && network_buffers->application_flags.application_message_ready == 1 )
-        {
-            /* Send STATUS Message when application message is available */
-            comms_send_status(wireless_network);
 
-            client.status_msg = (void*)message_buffer;
+/**************************************************************************
+ * @brief  Client state machine step for a client context, call from the
+ *         transmit timer interrupt of the instance
+ * @param  *client        : reference to client context
+ * @param  destination_id : device id of the destination
+ * @retval int8_t         : error = 0
+ **************************************************************************/
+int8_t comms_client_run(comms_client_context_t *client, uint8_t destination_id)
+{
+    return client_fsm_step(&client->fsm, &client->network, &client->device, &client->buffers, destination_id);
+}
 
-            /* Configure Status message */
-            message_length = comms_status_message(&client, *client_device, destination_id,
-                                                  network_buffers->application_message, network_buffers->app_message_length);
 
-            /* Send Status Message */
-            comms_send(wireless_network, (char*)client.status_msg, message_length);
 
-            network_buffers->application_flags.application_message_ready = 0;
+/**************************************************************************
+ * @brief  Client receive interrupt handler for a client context
+ * @param  *client : reference to client context
+ * @param  data    : received byte
+ * @retval int8_t  : error: -2, success: length of message
+ **************************************************************************/
+int8_t comms_client_recv(comms_client_context_t *client, char data)
+{
+    /* Drop partial frame instead of overrunning the read buffer */
+    if(client->rx_index >= sizeof(client->buffers.read_message))
+        client->rx_index = 0;
 
-            comms_status_debug_print(wireless_network, "STATUS",destination_id, network_buffers->application_message);
+    client->buffers.read_message[client->rx_index] = data;
 
-        }
+    return comms_client_recv_it(&client->network, &client->buffers, &client->rx_index);
+}
 
 
-        /* Get CONTROL Message data*/
-        if(network_buffers->flag_state == CONTRLMSG_FLAG)
-        {
 
-            client.contrl_msg = (void*)network_buffers->read_message;
+/**************************************************************************
+ * @brief  Select STATUS payload codecs, application messages are sent
+ *         encoded when smaller, set before joining, the server relays
+ *         encoded CONTRL messages only to clients that joined with codecs
+ * @param  *client  : reference to client context
+ * @param  codecs   : COMMS_CODEC_MASK bits, 0 sends raw payloads
+ * @retval int8_t   : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_codec(comms_client_context_t *client, uint8_t codecs)
+{
+    int8_t func_retval = 0;
 
-            memset(network_buffers->network_message, 0, sizeof(network_buffers->network_message));
+    if(client == NULL || (codecs & ~COMMS_CODEC_ALL))
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        client->fsm.payload_codecs = codecs;
 
-            /* read control message */
-            message_length = comms_get_contrl_data(network_buffers->network_message, &network_buffers->source_id, client, \
-                                                   client_device->device_network_id, client_device->device_slot_number);
+        func_retval = 0;
+    }
 
-            network_buffers->destination_id = client_device->device_slot_number;
+    return func_retval;
+}
 
-            if(message_length)
-            {
-                network_buffers->application_flags.network_message_ready = 1;
 
-                comms_recv_status(wireless_network);
 
-                comms_contrl_debug_print(wireless_network, "CONTROL", network_buffers->source_id, network_buffers->network_message);
+/**************************************************************************
+ * @brief  Select the low power mode of the client, the radio sleeps
+ *         outside the listen window at each server frame grid point and
+ *         the client slot of frames the client sends in, needs the
+ *         radio_sleep and radio_wake network operations
+ * @param  *client : reference to client context
+ * @param  enable  : 1 radio sleeps between the slots it needs, 0 always on
+ * @retval int8_t  : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_sleep(comms_client_context_t *client, uint8_t enable)
+{
+    int8_t func_retval = 0;
 
-            }
+    if(client == NULL || (enable && (client->network.network_commands->radio_sleep == NULL ||
+                                     client->network.network_commands->radio_wake == NULL)))
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        client->fsm.sleep_mode = enable ? 1 : 0;
 
-            memset(network_buffers->read_message, 0, sizeof(network_buffers->read_message));
+        func_retval = 0;
+    }
 
-        }
+    return func_retval;
+}
 
-        network_buffers->flag_state = CLEAR_FLAG;
 
-        break;
 
+/**************************************************************************
+ * @brief  Select the quality of service of the STATUS messages, set before
+ *         joining, QoS 1 messages carry a sequence number and are sent
+ *         again in later owned slots until the server acknowledges them
+ *         in the SYNC ack bitmap, at most COMMS_QOS_QUEUE_SIZE at a time
+ * @param  *client : reference to client context
+ * @param  qos     : 0 at most once, 1 at least once
+ * @retval int8_t  : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_qos(comms_client_context_t *client, uint8_t qos)
+{
+    int8_t func_retval = 0;
 
-    default:
+    if(client == NULL || qos > 1)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        client->fsm.qos = qos;
 
-        fsm_state = DEV_SYNC;
+        func_retval = 0;
+    }
 
-        break;
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Select the reporting period of the client, set before joining,
+ *         the server schedules the slot of a client with a period of
+ *         2^n frames once every 2^n frames in a shared superframe slot
+ * @param  *client       : reference to client context
+ * @param  period_frames : frames between STATUS messages, rounded down to
+ *                         a power of 2, 0 or 1 sends in every frame
+ * @retval int8_t        : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_client_set_period(comms_client_context_t *client, uint16_t period_frames)
+{
+    int8_t  func_retval = 0;
+    uint8_t period      = 0;
 
+    if(client == NULL || period_frames > (1U << COMMS_SUPERFRAME_LIMIT))
+    {
+        func_retval = -1;
     }
+    else
+    {
+        while(period_frames >>= 1)
+            period++;
 
-    func_retval = 0;
+        client->fsm.slot_period = period;
+
+        func_retval = 0;
+    }
 
     return func_retval;
 }
 
+
+
+/**************************************************************************
+ * @brief  Client State Machine Start Function
+ *         (single instance, state machine values kept in static storage),
+ *         debug prints go to a static trace, comms_start_client_flush
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *network_buffers  : reference to network buffers structure
+ * @param  destination_id    : device id of the destination
+ * @retval int8_t            : error = 0
+ **************************************************************************/
+int8_t comms_start_client(access_control_t *wireless_network, device_config_t *client_device,
+                          comms_network_buffer_t *network_buffers, uint8_t destination_id)
+{
+    static comms_client_fsm_t fsm = { .fsm_state      = DEV_INIT,
+                                      .payload_codecs = COMMS_PAYLOAD_CODECS };
+
+    /* Debug prints of the timer interrupt are recorded, handles created again in the interrupt have no trace */
+    if(wireless_network->trace == NULL)
+        comms_network_set_trace(wireless_network, &client_trace);
+
+    return client_fsm_step(&fsm, wireless_network, client_device, network_buffers, destination_id);
+}
+
+
+
+/**************************************************************************
+ * @brief  Print the deferred debug trace of the single instance client
+ *         state machine, call from the main loop
+ * @param  *wireless_network : reference to network access handle
+ * @retval int16_t           : error: -1, success: records printed
+ **************************************************************************/
+int16_t comms_start_client_flush(access_control_t *wireless_network)
+{
+    int16_t func_retval = 0;
+
+    if(comms_network_set_trace(wireless_network, &client_trace) != 0)
+        func_retval = -1;
+    else
+        func_retval = comms_network_trace_flush(wireless_network);
+
+    return func_retval;
+}
@@ -0,0 +1,534 @@
+/**
+ ******************************************************************************
+ * @file    comms_codec.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network payload codec source file
+ *
+ *  Info
+ *          Payload codecs for repetitive telemetry, zigzag delta varints for
+ *          separated decimal integer records and a static dictionary for
+ *          sensor text. The codec of a frame is carried in the message status
+ *          field, the encoder keeps the raw payload when no codec is smaller.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "comms_codec.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Dictionary codec, 0x80 + index is a dictionary word, escape is followed by a raw byte */
+#define CODEC_DICT_WORD    0x80
+#define CODEC_DICT_ESCAPE  0xFF
+
+
+/* Varint codec, 7 bits per byte, continuation in the MSB */
+#define CODEC_VARINT_MORE  0x80
+#define CODEC_VARINT_BYTES 5
+
+
+/* Static dictionary, sensor telemetry words, longest match wins */
+static const char* const codec_dictionary[] =
+{
+    "temperature", "humidity", "pressure", "battery", "voltage", "current", "status", "sensor",
+    "value", "light", "motion", "alarm", "error", "ERROR", "node", "time", "temp", "level",
+    "count", "state", "power", "speed", "door", "water", "flow", "open", "close", "true",
+    "false", "on", "off", "OK", "low", "high", "min", "max", "avg", "id",
+    ", ", ": ", "=", "\r\n", "000", "00", ".0", ".5", "\":", "\",\"",
+};
+
+#define CODEC_DICT_SIZE  (sizeof(codec_dictionary) / sizeof(codec_dictionary[0]))
+
+
+/* Compile time check, dictionary words are one byte below the escape */
+typedef char codec_dictionary_size_check[(CODEC_DICT_SIZE < CODEC_DICT_ESCAPE - CODEC_DICT_WORD) ? 1 : -1];
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  static function to read a canonical decimal
+ *         integer, no sign other than '-', no leading
+ *         zeros and no "-0" so decoding gives the same text
+ * @param  *payload  : payload
+ * @param  length    : payload length
+ * @param  *index    : payload index, moved past the number
+ * @param  *value    : number
+ * @retval int8_t    : not a number: -1, success: 0
+ *********************************************************/
+static int8_t codec_read_number(const char *payload, uint16_t length, uint16_t *index, int32_t *value)
+{
+    int8_t   func_retval = -1;
+    uint16_t position    = *index;
+    uint8_t  negative    = 0;
+    int64_t  number      = 0;
+
+    if(position < length && payload[position] == '-')
+    {
+        negative = 1;
+        position++;
+    }
+
+    /* Leading zero only for the number 0 */
+    if(position < length && payload[position] >= '0' && payload[position] <= '9' &&
+       !(payload[position] == '0' && (negative || (position + 1 < length && payload[position + 1] >= '0' &&
+                                                   payload[position + 1] <= '9'))))
+    {
+        while(position < length && payload[position] >= '0' && payload[position] <= '9' && number <= INT32_MAX)
+        {
+            number = number * 10 + (payload[position] - '0');
+            position++;
+        }
+
+        if(number <= INT32_MAX)
+        {
+            *value = (int32_t)(negative ? -number : number);
+            *index = position;
+
+            func_retval = 0;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  static function to write a zigzag varint
+ * @param  value     : signed value
+ * @param  *encoded  : encoded buffer
+ * @param  size      : encoded buffer size
+ * @param  *index    : buffer index, moved past the varint
+ * @retval int8_t    : no space: -1, success: 0
+ *********************************************************/
+static int8_t codec_write_varint(int64_t value, char *encoded, uint16_t size, uint16_t *index)
+{
+    uint64_t zigzag = value < 0 ? ((uint64_t)(-(value + 1)) << 1) | 1 : (uint64_t)value << 1;
+
+    do
+    {
+        if(*index >= size)
+            return -1;
+
+        encoded[(*index)++] = (char)((zigzag & 0x7F) | (zigzag > 0x7F ? CODEC_VARINT_MORE : 0));
+
+        zigzag >>= 7;
+
+    }while(zigzag);
+
+    return 0;
+}
+
+
+
+/*********************************************************
+ * @brief  static function to read a zigzag varint
+ * @param  *encoded  : encoded buffer
+ * @param  length    : encoded length
+ * @param  *index    : buffer index, moved past the varint
+ * @param  *value    : signed value
+ * @retval int8_t    : truncated: -1, success: 0
+ *********************************************************/
+static int8_t codec_read_varint(const char *encoded, uint16_t length, uint16_t *index, int64_t *value)
+{
+    uint64_t zigzag = 0;
+    uint8_t  shift  = 0;
+    uint8_t  byte   = CODEC_VARINT_MORE;
+
+    while(byte & CODEC_VARINT_MORE)
+    {
+        if(*index >= length || shift >= 7 * (CODEC_VARINT_BYTES + 1))
+            return -1;
+
+        byte = (uint8_t)encoded[(*index)++];
+
+        zigzag |= (uint64_t)(byte & 0x7F) << shift;
+        shift  += 7;
+    }
+
+    *value = (zigzag & 1) ? -(int64_t)(zigzag >> 1) - 1 : (int64_t)(zigzag >> 1);
+
+    return 0;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to encode decimal integer records,
+ *         numbers split by one non digit separator are
+ *         sent as zigzag varint deltas of the previous
+ *         number, the separators are kept
+ * @param  *payload        : payload
+ * @param  payload_length  : payload length
+ * @param  *encoded        : encoded payload buffer
+ * @param  encoded_size    : encoded payload buffer size
+ * @retval int16_t         : not numeric or no space: -1,
+ *                           success: encoded length
+ *********************************************************/
+int16_t comms_codec_varint_encode(const char *payload, uint16_t payload_length, char *encoded, uint16_t encoded_size)
+{
+    uint16_t payload_index = 0;
+    uint16_t encoded_index = 0;
+    int32_t  previous      = 0;
+    int32_t  value         = 0;
+
+    if(payload == NULL || encoded == NULL || payload_length == 0)
+        return -1;
+
+    /* number (separator number)* */
+    while(1)
+    {
+        if(codec_read_number(payload, payload_length, &payload_index, &value) < 0)
+            return -1;
+
+        if(codec_write_varint((int64_t)value - previous, encoded, encoded_size, &encoded_index) < 0)
+            return -1;
+
+        previous = value;
+
+        if(payload_index >= payload_length)
+            break;
+
+        /* Separator, the next number starts behind it */
+        if(payload[payload_index] >= '0' && payload[payload_index] <= '9')
+            return -1;
+
+        if(encoded_index >= encoded_size)
+            return -1;
+
+        encoded[encoded_index++] = payload[payload_index++];
+    }
+
+    return (int16_t)encoded_index;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to decode decimal integer records
+ * @param  *encoded        : encoded payload
+ * @param  encoded_length  : encoded payload length
+ * @param  *payload        : payload buffer
+ * @param  payload_size    : payload buffer size
+ * @retval int16_t         : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_codec_varint_decode(const char *encoded, uint16_t encoded_length, char *payload, uint16_t payload_size)
+{
+    uint16_t encoded_index = 0;
+    uint16_t payload_index = 0;
+    int64_t  value         = 0;
+    int64_t  delta         = 0;
+    char     digits[12];
+    uint8_t  digit_count   = 0;
+    uint64_t magnitude     = 0;
+
+    if(encoded == NULL || payload == NULL || encoded_length == 0)
+        return -1;
+
+    while(1)
+    {
+        if(codec_read_varint(encoded, encoded_length, &encoded_index, &delta) < 0)
+            return -1;
+
+        value += delta;
+
+        if(value > INT32_MAX || value < INT32_MIN)
+            return -1;
+
+        /* Number text, digits are written in reverse */
+        magnitude   = value < 0 ? (uint64_t)(-value) : (uint64_t)value;
+        digit_count = 0;
+
+        do
+        {
+            digits[digit_count++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+
+        }while(magnitude);
+
+        if(payload_index + digit_count + (value < 0) > payload_size)
+            return -1;
+
+        if(value < 0)
+            payload[payload_index++] = '-';
+
+        while(digit_count)
+            payload[payload_index++] = digits[--digit_count];
+
+        if(encoded_index >= encoded_length)
+            break;
+
+        if(payload_index >= payload_size)
+            return -1;
+
+        payload[payload_index++] = encoded[encoded_index++];
+    }
+
+    return (int16_t)payload_index;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to encode text with the static
+ *         dictionary, dictionary words are sent as one
+ *         byte, bytes above 0x7F are escaped
+ * @param  *payload        : payload
+ * @param  payload_length  : payload length
+ * @param  *encoded        : encoded payload buffer
+ * @param  encoded_size    : encoded payload buffer size
+ * @retval int16_t         : no space: -1, success: encoded length
+ *********************************************************/
+int16_t comms_codec_dict_encode(const char *payload, uint16_t payload_length, char *encoded, uint16_t encoded_size)
+{
+    uint16_t payload_index = 0;
+    uint16_t encoded_index = 0;
+    uint16_t word_length   = 0;
+    uint16_t best_length   = 0;
+    uint8_t  best_word     = 0;
+    uint8_t  word          = 0;
+
+    if(payload == NULL || encoded == NULL)
+        return -1;
+
+    while(payload_index < payload_length)
+    {
+        best_length = 1;
+
+        /* Longest dictionary word at this position */
+        for(word = 0; word < CODEC_DICT_SIZE; word++)
+        {
+            word_length = (uint16_t)strlen(codec_dictionary[word]);
+
+            if(word_length > best_length && word_length <= payload_length - payload_index &&
+               memcmp(payload + payload_index, codec_dictionary[word], word_length) == 0)
+            {
+                best_length = word_length;
+                best_word   = word;
+            }
+        }
+
+        if(encoded_index + 2 > encoded_size)
+            return -1;
+
+        if(best_length > 1)
+        {
+            encoded[encoded_index++] = (char)(CODEC_DICT_WORD + best_word);
+        }
+        else
+        {
+            if((uint8_t)payload[payload_index] >= CODEC_DICT_WORD)
+                encoded[encoded_index++] = (char)CODEC_DICT_ESCAPE;
+
+            encoded[encoded_index++] = payload[payload_index];
+        }
+
+        payload_index += best_length;
+    }
+
+    return (int16_t)encoded_index;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to decode static dictionary text
+ * @param  *encoded        : encoded payload
+ * @param  encoded_length  : encoded payload length
+ * @param  *payload        : payload buffer
+ * @param  payload_size    : payload buffer size
+ * @retval int16_t         : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_codec_dict_decode(const char *encoded, uint16_t encoded_length, char *payload, uint16_t payload_size)
+{
+    uint16_t encoded_index = 0;
+    uint16_t payload_index = 0;
+    uint16_t word_length   = 0;
+    uint8_t  byte          = 0;
+
+    if(encoded == NULL || payload == NULL)
+        return -1;
+
+    while(encoded_index < encoded_length)
+    {
+        byte = (uint8_t)encoded[encoded_index++];
+
+        if(byte == CODEC_DICT_ESCAPE)
+        {
+            if(encoded_index >= encoded_length || payload_index >= payload_size)
+                return -1;
+
+            payload[payload_index++] = encoded[encoded_index++];
+        }
+        else if(byte >= CODEC_DICT_WORD)
+        {
+            if((uint8_t)(byte - CODEC_DICT_WORD) >= CODEC_DICT_SIZE)
+                return -1;
+
+            word_length = (uint16_t)strlen(codec_dictionary[byte - CODEC_DICT_WORD]);
+
+            if(payload_index + word_length > payload_size)
+                return -1;
+
+            memcpy(payload + payload_index, codec_dictionary[byte - CODEC_DICT_WORD], word_length);
+
+            payload_index += word_length;
+        }
+        else
+        {
+            if(payload_index >= payload_size)
+                return -1;
+
+            payload[payload_index++] = (char)byte;
+        }
+    }
+
+    return (int16_t)payload_index;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to encode a payload with the smallest
+ *         of the codecs in the codec mask
+ * @param  *payload         : payload
+ * @param  payload_length   : payload length
+ * @param  *encoded         : encoded payload buffer
+ * @param  encoded_size     : encoded payload buffer size
+ * @param  codecs           : COMMS_CODEC_MASK bits
+ * @param  *encoded_length  : encoded payload length
+ * @retval uint8_t          : raw payload smaller: COMMS_CODEC_NONE,
+ *                            success: comms_codec_t
+ *********************************************************/
+uint8_t comms_codec_encode(const char *payload, uint16_t payload_length, char *encoded, uint16_t encoded_size,
+                           uint8_t codecs, uint16_t *encoded_length)
+{
+    uint8_t func_retval = COMMS_CODEC_NONE;
+    int16_t length      = -1;
+
+    *encoded_length = payload_length;
+
+    /* Numeric records, text is rejected by the varint encoder */
+    if(codecs & COMMS_CODEC_MASK(COMMS_CODEC_VARINT))
+        length = comms_codec_varint_encode(payload, payload_length, encoded, encoded_size);
+
+    if(length > 0 && length < payload_length)
+    {
+        func_retval = COMMS_CODEC_VARINT;
+    }
+    else if(codecs & COMMS_CODEC_MASK(COMMS_CODEC_DICT))
+    {
+        length = comms_codec_dict_encode(payload, payload_length, encoded, encoded_size);
+
+        if(length > 0 && length < payload_length)
+            func_retval = COMMS_CODEC_DICT;
+    }
+
+    if(func_retval != COMMS_CODEC_NONE)
+        *encoded_length = (uint16_t)length;
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to decode a payload
+ * @param  codec           : comms_codec_t
+ * @param  *encoded        : encoded payload
+ * @param  encoded_length  : encoded payload length
+ * @param  *payload        : payload buffer
+ * @param  payload_size    : payload buffer size
+ * @retval int16_t         : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_codec_decode(uint8_t codec, const char *encoded, uint16_t encoded_length, char *payload,
+                           uint16_t payload_size)
+{
+    int16_t func_retval = -1;
+
+    switch(codec)
+    {
+
+    case COMMS_CODEC_VARINT:
+
+        func_retval = comms_codec_varint_decode(encoded, encoded_length, payload, payload_size);
+
+        break;
+
+    case COMMS_CODEC_DICT:
+
+        func_retval = comms_codec_dict_decode(encoded, encoded_length, payload, payload_size);
+
+        break;
+
+    default:
+
+        func_retval = -1;
+
+        break;
+    }
+
+    return func_retval;
+}
@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ * @file    comms_crc.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network frame integrity CRC source file
+ *
+ *  Info
+ *          CRC-16/CCITT-FALSE and CRC-32 (IEEE 802.3) with lookup tables
+ *          generated by the preprocessor, per byte update for the receive
+ *          interrupt.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+#include "comms_crc.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* One bit step of CRC-32 (reflected 0xEDB88320) and CRC-16 (0x1021) */
+#define CRC32_STEP(c)  (((c) >> 1) ^ (0xEDB88320UL & (0UL - ((c) & 1UL))))
+#define CRC16_STEP(c)  ((((c) << 1) ^ (0x1021UL & (0UL - (((c) >> 15) & 1UL)))) & 0xFFFFUL)
+
+/* Table entry, eight bit steps of the byte value */
+#define CRC32_ENTRY(n) CRC32_STEP(CRC32_STEP(CRC32_STEP(CRC32_STEP(CRC32_STEP(CRC32_STEP(CRC32_STEP(CRC32_STEP( \
+                       (uint32_t)(n)))))))))
+#define CRC16_ENTRY(n) CRC16_STEP(CRC16_STEP(CRC16_STEP(CRC16_STEP(CRC16_STEP(CRC16_STEP(CRC16_STEP(CRC16_STEP( \
+                       (uint32_t)(n) << 8))))))))
+
+/* Expand an entry macro for all 256 byte values */
+#define CRC_ROW4(E, n)    E(n), E((n) + 1), E((n) + 2), E((n) + 3)
+#define CRC_ROW16(E, n)   CRC_ROW4(E, n), CRC_ROW4(E, (n) + 4), CRC_ROW4(E, (n) + 8), CRC_ROW4(E, (n) + 12)
+#define CRC_ROW64(E, n)   CRC_ROW16(E, n), CRC_ROW16(E, (n) + 16), CRC_ROW16(E, (n) + 32), CRC_ROW16(E, (n) + 48)
+#define CRC_TABLE(E)      CRC_ROW64(E, 0), CRC_ROW64(E, 64), CRC_ROW64(E, 128), CRC_ROW64(E, 192)
+
+
+/* Lookup tables, constant data generated at compile time */
+static const uint16_t crc16_table[256] = { CRC_TABLE(CRC16_ENTRY) };
+static const uint32_t crc32_table[256] = { CRC_TABLE(CRC32_ENTRY) };
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Update CRC-16/CCITT-FALSE with one byte
+ * @param  crc      : running crc, start with COMMS_CRC16_INIT
+ * @param  data     : next byte
+ * @retval uint16_t : updated crc
+ *********************************************************/
+uint16_t comms_crc16_update(uint16_t crc, uint8_t data)
+{
+    return (uint16_t)((crc << 8) ^ crc16_table[((crc >> 8) ^ data) & 0xFF]);
+}
+
+
+
+/*********************************************************
+ * @brief  Calculate CRC-16/CCITT-FALSE of a buffer
+ * @param  *data    : buffer
+ * @param  length   : buffer length
+ * @retval uint16_t : crc
+ *********************************************************/
+uint16_t comms_crc16(const char *data, uint16_t length)
+{
+    uint16_t crc = COMMS_CRC16_INIT;
+    uint16_t index;
+
+    for(index = 0; index < length; index++)
+        crc = comms_crc16_update(crc, (uint8_t)data[index]);
+
+    return crc;
+}
+
+
+
+/*********************************************************
+ * @brief  Update CRC-32 with one byte
+ * @param  crc      : running crc, start with COMMS_CRC32_INIT
+ * @param  data     : next byte
+ * @retval uint32_t : updated crc, final value is crc ^ COMMS_CRC32_INIT
+ *********************************************************/
+uint32_t comms_crc32_update(uint32_t crc, uint8_t data)
+{
+    return (crc >> 8) ^ crc32_table[(crc ^ data) & 0xFF];
+}
+
+
+
+/*********************************************************
+ * @brief  Calculate CRC-32 of a buffer
+ * @param  *data    : buffer
+ * @param  length   : buffer length
+ * @retval uint32_t : crc
+ *********************************************************/
+uint32_t comms_crc32(const char *data, uint32_t length)
+{
+    const uint8_t *bytes = (const uint8_t*)data;
+
+    uint32_t crc = COMMS_CRC32_INIT;
+
+    while(length--)
+        crc = comms_crc32_update(crc, *bytes++);
+
+    return crc ^ COMMS_CRC32_INIT;
+}
@@ -0,0 +1,349 @@
+/**
+ ******************************************************************************
+ * @file    comms_fragment.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network message fragmentation source file
+ *
+ *  Info
+ *          Application messages longer than one frame are sent as fragments,
+ *          the fragment header holds a message id, the fragment index and a
+ *          last fragment flag. Fragments are reassembled in order into a
+ *          bounded set of caller owned buffers that time out in frames.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "comms_fragment.h"
+#include "comms_protocol.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Reassembly return values */
+typedef enum _reassembly_retval
+{
+    REASSEMBLY_INVALID      = -1,  /*!< Invalid fragment                    */
+    REASSEMBLY_OUT_OF_ORDER = -2,  /*!< Fragment missing, message dropped   */
+    REASSEMBLY_NO_BUFFER    = -3,  /*!< All buffers hold complete messages  */
+    REASSEMBLY_TOO_LONG     = -4   /*!< Above COMMS_MAX_MESSAGE_LENGTH      */
+
+}reassembly_retval_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  static function to get a buffer for the first
+ *         fragment of a message, the oldest incomplete
+ *         message is dropped when all buffers are in use
+ * @param  *buffers         : reference to reassembly buffers
+ * @param  count            : number of buffers
+ * @retval net_reassembly_t : no buffer: NULL, success: buffer
+ *********************************************************/
+static net_reassembly_t* reassembly_alloc(net_reassembly_t *buffers, uint8_t count)
+{
+    net_reassembly_t *func_retval = NULL;
+    uint8_t           index       = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(buffers[index].state == NET_REASSEMBLY_FREE)
+        {
+            func_retval = &buffers[index];
+
+            break;
+        }
+
+        if(buffers[index].state == NET_REASSEMBLY_RECEIVING &&
+           (func_retval == NULL || buffers[index].age > func_retval->age))
+        {
+            func_retval = &buffers[index];
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to get the fragment payload size, a
+ *         fragment fits the relayed CONTRL message
+ * @param  *network : reference to network handle structure
+ * @retval uint8_t  : payload bytes per fragment
+ *********************************************************/
+uint8_t comms_fragment_size(access_control_t *network)
+{
+    return comms_network_frame_limit(network) - (CONTRL_FRAME_HEADER_LENGTH + COMMS_TERMINATOR_LENGTH +
+                                                 COMMS_FRAGMENT_HEADER_SIZE);
+}
+
+
+
+/*********************************************************
+ * @brief  Function to configure a fragment header
+ * @param  *header        : COMMS_FRAGMENT_HEADER_SIZE bytes
+ * @param  message_id     : message id of the sender
+ * @param  fragment_index : fragment index, 0 to 127
+ * @param  last           : last fragment of the message
+ * @retval uint8_t        : length of fragment header
+ *********************************************************/
+uint8_t comms_fragment_header(char *header, uint8_t message_id, uint8_t fragment_index, uint8_t last)
+{
+    header[0] = (char)message_id;
+    header[1] = (char)((fragment_index & COMMS_FRAGMENT_INDEX) | (last ? COMMS_FRAGMENT_LAST : 0));
+
+    return COMMS_FRAGMENT_HEADER_SIZE;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to get the fragment header values
+ * @param  *fragment        : fragment, header and payload
+ * @param  length           : fragment length
+ * @param  *message_id      : message id of the sender
+ * @param  *fragment_index  : fragment index
+ * @param  *last            : last fragment of the message
+ * @retval int16_t          : error: -1, success: payload length
+ *********************************************************/
+int16_t comms_fragment_parse(const char *fragment, uint16_t length, uint8_t *message_id, uint8_t *fragment_index,
+                             uint8_t *last)
+{
+    int16_t func_retval = 0;
+
+    if(fragment == NULL || length < COMMS_FRAGMENT_HEADER_SIZE)
+    {
+        func_retval = REASSEMBLY_INVALID;
+    }
+    else
+    {
+        *message_id     = (uint8_t)fragment[0];
+        *fragment_index = (uint8_t)fragment[1] & COMMS_FRAGMENT_INDEX;
+        *last           = ((uint8_t)fragment[1] & COMMS_FRAGMENT_LAST) ? 1 : 0;
+
+        func_retval = length - COMMS_FRAGMENT_HEADER_SIZE;
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to initialize reassembly buffers
+ * @param  *buffers : reference to reassembly buffers
+ * @param  count    : number of buffers
+ *********************************************************/
+void init_reassembly(net_reassembly_t *buffers, uint8_t count)
+{
+    uint8_t index = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        buffers[index].state  = NET_REASSEMBLY_FREE;
+        buffers[index].length = 0;
+    }
+}
+
+
+
+/*********************************************************
+ * @brief  Function to add a received fragment, fragments
+ *         of a message are accepted in order only, a
+ *         missing fragment drops the message
+ * @param  *buffers   : reference to reassembly buffers
+ * @param  count      : number of buffers
+ * @param  source_id  : source client id of the fragment
+ * @param  *fragment  : fragment, header and payload
+ * @param  length     : fragment length
+ * @param  **message  : reassembled message when complete
+ * @retval int16_t    : error: -1 invalid, -2 out of order,
+ *                      -3 no buffer, -4 too long,
+ *                      incomplete: 0, complete: length
+ *********************************************************/
+int16_t comms_reassembly_add(net_reassembly_t *buffers, uint8_t count, uint8_t source_id, const char *fragment,
+                             uint16_t length, const char **message)
+{
+    int16_t func_retval    = 0;
+    int16_t payload_length = 0;
+    uint8_t message_id     = 0;
+    uint8_t fragment_index = 0;
+    uint8_t last           = 0;
+    uint8_t index          = 0;
+
+    net_reassembly_t *buffer = NULL;
+
+    payload_length = comms_fragment_parse(fragment, length, &message_id, &fragment_index, &last);
+
+    if(payload_length < 0 || buffers == NULL || message == NULL)
+        return REASSEMBLY_INVALID;
+
+    /* Message of the source in reassembly */
+    for(index = 0; index < count; index++)
+    {
+        if(buffers[index].state == NET_REASSEMBLY_RECEIVING && buffers[index].source_id == source_id &&
+           buffers[index].message_id == message_id)
+        {
+            buffer = &buffers[index];
+
+            break;
+        }
+    }
+
+    if(buffer == NULL && fragment_index == 0)
+    {
+        buffer = reassembly_alloc(buffers, count);
+
+        if(buffer != NULL)
+        {
+            buffer->state         = NET_REASSEMBLY_RECEIVING;
+            buffer->source_id     = source_id;
+            buffer->message_id    = message_id;
+            buffer->next_fragment = 0;
+            buffer->length        = 0;
+        }
+    }
+
+    if(buffer == NULL)
+    {
+        func_retval = fragment_index == 0 ? REASSEMBLY_NO_BUFFER : REASSEMBLY_OUT_OF_ORDER;
+    }
+    else if(fragment_index != buffer->next_fragment)
+    {
+        buffer->state = NET_REASSEMBLY_FREE;
+
+        func_retval = REASSEMBLY_OUT_OF_ORDER;
+    }
+    else if(buffer->length + payload_length > COMMS_MAX_MESSAGE_LENGTH)
+    {
+        buffer->state = NET_REASSEMBLY_FREE;
+
+        func_retval = REASSEMBLY_TOO_LONG;
+    }
+    else
+    {
+        memcpy(buffer->data + buffer->length, fragment + COMMS_FRAGMENT_HEADER_SIZE, (size_t)payload_length);
+
+        buffer->length += payload_length;
+        buffer->age     = 0;
+        buffer->next_fragment++;
+
+        if(last)
+        {
+            buffer->state = NET_REASSEMBLY_COMPLETE;
+
+            *message = buffer->data;
+
+            func_retval = (int16_t)buffer->length;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to age reassembly buffers by one frame,
+ *         messages without fragment for
+ *         COMMS_REASSEMBLY_TIMEOUT frames are dropped
+ * @param  *buffers : reference to reassembly buffers
+ * @param  count    : number of buffers
+ * @retval uint8_t  : number of dropped messages
+ *********************************************************/
+uint8_t comms_reassembly_age(net_reassembly_t *buffers, uint8_t count)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(buffers[index].state == NET_REASSEMBLY_RECEIVING && ++buffers[index].age >= COMMS_REASSEMBLY_TIMEOUT)
+        {
+            buffers[index].state = NET_REASSEMBLY_FREE;
+
+            func_retval++;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to free the buffers of messages read
+ *         by the application
+ * @param  *buffers : reference to reassembly buffers
+ * @param  count    : number of buffers
+ *********************************************************/
+void comms_reassembly_release(net_reassembly_t *buffers, uint8_t count)
+{
+    uint8_t index = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(buffers[index].state == NET_REASSEMBLY_COMPLETE)
+            buffers[index].state = NET_REASSEMBLY_FREE;
+    }
+}
@@ -0,0 +1,243 @@
+/**
+ ******************************************************************************
+ * @file    comms_mailbox.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network server downlink mailbox source file
+ *
+ *  Info
+ *          Bounded mailbox of the CONTRL messages the server holds for low
+ *          power clients until the SYNC message announcing them.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "comms_mailbox.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to initialize a mailbox
+ * @param  *mailbox : reference to server mailbox
+ *********************************************************/
+void init_mailbox(comms_mailbox_t *mailbox)
+{
+    mailbox->count = 0;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to get the number of messages held
+ *         for a client
+ * @param  *mailbox       : reference to server mailbox
+ * @param  destination_id : destination client id
+ * @retval uint8_t        : number of held messages
+ *********************************************************/
+uint8_t comms_mailbox_count(const comms_mailbox_t *mailbox, uint8_t destination_id)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+
+    for(index = 0; index < mailbox->count; index++)
+    {
+        if(mailbox->messages[index].destination_id == destination_id)
+            func_retval++;
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to hold a CONTRL message for a client,
+ *         at most COMMS_MAILBOX_DEPTH per client, client
+ *         ids beyond the SYNC mail bitmap are never announced
+ * @param  *mailbox       : reference to server mailbox
+ * @param  destination_id : destination client id
+ * @param  source_id      : source client id
+ * @param  codec          : payload codec
+ * @param  fragment       : payload is a message fragment
+ * @param  *payload       : CONTRL message payload
+ * @param  length         : payload length
+ * @retval int8_t         : error (mailbox full, id not
+ *                          announced): -1, success: 0
+ *********************************************************/
+int8_t comms_mailbox_add(comms_mailbox_t *mailbox, uint8_t destination_id, uint8_t source_id, uint8_t codec,
+                         uint8_t fragment, const char *payload, uint8_t length)
+{
+    int8_t      func_retval = 0;
+    net_mail_t *mail        = NULL;
+
+    /* An entry never announced would block the oldest first pool */
+    if(mailbox->count >= COMMS_MAILBOX_SIZE || length > NET_DATA_LENGTH ||
+       destination_id >= COMMS_SYNC_CLIENT_IDS ||
+       comms_mailbox_count(mailbox, destination_id) >= COMMS_MAILBOX_DEPTH)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        mail = &mailbox->messages[mailbox->count++];
+
+        mail->destination_id = destination_id;
+        mail->source_id      = source_id;
+        mail->codec          = codec;
+        mail->fragment       = fragment;
+        mail->announced      = 0;
+        mail->length         = length;
+
+        memcpy(mail->payload, payload, length);
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to announce the oldest messages, sets
+ *         the bit of each destination client id
+ * @param  *mailbox     : reference to server mailbox
+ * @param  *bitmap      : mail bitmap, one bit per client id
+ * @param  bitmap_size  : bitmap size in bytes
+ * @param  limit        : messages sent in one broadcast slot
+ * @retval uint8_t      : number of announced messages
+ *********************************************************/
+uint8_t comms_mailbox_announce(comms_mailbox_t *mailbox, uint8_t *bitmap, uint8_t bitmap_size, uint8_t limit)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+    uint8_t client_id   = 0;
+
+    for(index = 0; index < mailbox->count; index++)
+    {
+        client_id = mailbox->messages[index].destination_id;
+
+        mailbox->messages[index].announced = index < limit && client_id / 8 < bitmap_size;
+
+        if(mailbox->messages[index].announced)
+        {
+            bitmap[client_id / 8] |= 1 << (client_id % 8);
+
+            func_retval++;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to get the oldest announced message
+ * @param  *mailbox    : reference to server mailbox
+ * @retval net_mail_t  : none announced: NULL, success: message
+ *********************************************************/
+net_mail_t* comms_mailbox_peek(comms_mailbox_t *mailbox)
+{
+    net_mail_t *func_retval = NULL;
+
+    if(mailbox->count > 0 && mailbox->messages[0].announced)
+        func_retval = &mailbox->messages[0];
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to remove the oldest message
+ * @param  *mailbox : reference to server mailbox
+ *********************************************************/
+void comms_mailbox_pop(comms_mailbox_t *mailbox)
+{
+    if(mailbox->count > 0)
+    {
+        mailbox->count--;
+
+        memmove(&mailbox->messages[0], &mailbox->messages[1], mailbox->count * sizeof(net_mail_t));
+    }
+}
+
+
+
+/*********************************************************
+ * @brief  Function to drop the messages of a client that
+ *         left the network
+ * @param  *mailbox       : reference to server mailbox
+ * @param  destination_id : destination client id
+ * @retval uint8_t        : number of dropped messages
+ *********************************************************/
+uint8_t comms_mailbox_release(comms_mailbox_t *mailbox, uint8_t destination_id)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+    uint8_t kept        = 0;
+
+    for(index = 0; index < mailbox->count; index++)
+    {
+        if(mailbox->messages[index].destination_id == destination_id)
+        {
+            func_retval++;
+        }
+        else
+        {
+            if(kept != index)
+                mailbox->messages[kept] = mailbox->messages[index];
+
+            kept++;
+        }
+    }
+
+    mailbox->count = kept;
+
+    return func_retval;
+}
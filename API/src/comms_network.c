@@ -51,6 +51,7 @@
 #include <stdlib.h>
 
 #include <comms_network.h>
+#include <comms_frame.h>
 
 
 
@@ -63,9 +64,12 @@
 /*                                                                            */
 /******************************************************************************/
 
-#define SYNC_HEADER_SIZE 6
+#define SYNC_HEADER_SIZE COMMS_FRAME_HEADER_SIZE(sync)
+
+/* Sync Message structure, packed */
+#pragma pack(push)
+#pragma pack(1)
 
-/* Sync Message structure */
 struct _sync_packet
 {
     char         preamble[NET_PREAMBLE_LENTH];  /*!< Message preamble           */
@@ -74,9 +78,26 @@ struct _sync_packet
     uint8_t      message_slot_number;           /*!< Message slot number        */
     uint16_t     slot_time;                     /*!< Time interval of each slot */
     uint8_t      access_slot;                   /*!< Server Access number       */
+    uint8_t      access_slots;                  /*!< Access slots from number   */
+    uint8_t      frame_number;                  /*!< Frame number, wraps around */
+    uint8_t      join_load;                     /*!< Join load hint             */
+    uint8_t      frame_slots;                   /*!< Slots from SYNC to SYNC    */
     uint8_t      payload;                       /*!< Message payload            */
 };
 
+#pragma pack(pop)
+
+
+/* Packed SYNC structure follows the comms_frame.h descriptor */
+#define SYNC_LAYOUT(message, field, kind) COMMS_FRAME_CHECK_FIELD(struct _sync_packet, message, field);
+
+COMMS_SYNC_FIELDS(SYNC_LAYOUT)
+
+COMMS_FRAME_CHECK_PAYLOAD(struct _sync_packet, sync);
+
+/* SYNC ack bitmap covers superframe client ids */
+COMMS_FRAME_CHECK(COMMS_SUPERFRAME_CLIENT_ID < 8 * COMMS_SYNC_BITMAP_SIZE, sync_bitmap_size);
+
 
 /* Network api error codes */
 typedef enum _network_api_error_codes
@@ -95,10 +116,20 @@ typedef enum _network_api_error_codes
     COMMS_CLRSTATUS_ERROR   = -11,
     COMMS_GETSYNC_ERROR     = -12,
     COMMS_NETSTATUS_ERROR   = -13,
+    COMMS_METRICS_ERROR     = -18,
+    COMMS_RADIO_ERROR       = -19,
 
 }net_api_retval_t;
 
 
+/* Keeps the compiler from moving event data accesses across ring index updates */
+#if defined(__GNUC__)
+#define NET_COMPILER_BARRIER()  __asm__ volatile ("" ::: "memory")
+#else
+#define NET_COMPILER_BARRIER()
+#endif
+
+
 
 
 /******************************************************************************/
@@ -234,6 +265,397 @@ static int8_t set_mac_address(char *device_mac, char *mac_address)
 
 
 
+/* Compile time check, preamble ids leave the integrity mode bits of the second preamble byte clear */
+COMMS_FRAME_CHECK(((PREAMBLE_SYNC | PREAMBLE_JOINREQ | PREMABLE_JOINRESP | PREAMBLE_STATUS | PREAMBLE_CONTRL |
+                    PREAMBLE_STATUSACK) & (uint8_t)~COMMS_PREAMBLE_ID_MASK) == 0, preamble_integrity_bits);
+
+
+
+/********************************************************
+ * @brief  static function to check message preamble,
+ *         integrity mode bits are not part of the check
+ * @param  preamble : received preamble (MSB first)
+ * @retval uint8_t  : invalid = 0, valid = 1
+ ********************************************************/
+static uint8_t comms_valid_preamble(uint16_t preamble)
+{
+    uint8_t func_retval = 0;
+
+    switch(preamble & (0xFF00 | COMMS_PREAMBLE_ID_MASK))
+    {
+
+    case PREAMBLE_SYNC:
+    case PREAMBLE_JOINREQ:
+    case PREMABLE_JOINRESP:
+    case PREAMBLE_STATUS:
+    case PREAMBLE_CONTRL:
+    case PREAMBLE_STATUSACK:
+
+        func_retval = 1;
+
+        break;
+
+    default:
+
+        func_retval = 0;
+
+        break;
+    }
+
+    return func_retval;
+}
+
+
+
+/********************************************************
+ * @brief  static function to check first preamble byte
+ * @param  data    : received byte
+ * @retval uint8_t : invalid = 0, valid = 1
+ ********************************************************/
+static uint8_t comms_valid_preamble_msb(uint8_t data)
+{
+    return (data == ((PREAMBLE_SYNC >> 8) & 0xFF) || data == ((PREAMBLE_JOINREQ >> 8) & 0xFF) || \
+            data == ((PREAMBLE_STATUS >> 8) & 0xFF));
+}
+
+
+
+/********************************************************
+ * @brief  static function to get CRC trailer length
+ * @param  mode    : frame integrity mode
+ * @retval uint8_t : trailer length
+ ********************************************************/
+static uint8_t comms_trailer_length(uint8_t mode)
+{
+    uint8_t func_retval = 0;
+
+    if(mode == NET_INTEGRITY_CRC16)
+        func_retval = 2;
+    else if(mode == NET_INTEGRITY_CRC32)
+        func_retval = 4;
+
+    return func_retval;
+}
+
+
+
+/********************************************************
+ * @brief  static function to compare CRC with trailer
+ * @param  *trailer : little endian CRC trailer
+ * @param  crc      : calculated CRC
+ * @param  length   : trailer length
+ * @retval uint8_t  : mismatch = 0, match = 1
+ ********************************************************/
+static uint8_t comms_trailer_match(char *trailer, uint32_t crc, uint8_t length)
+{
+    uint8_t index;
+
+    for(index = 0; index < length; index++)
+    {
+        if((uint8_t)trailer[index] != ((crc >> (8 * index)) & 0xFF))
+            return 0;
+    }
+
+    return 1;
+}
+
+
+
+/*************************************************************************
+ * @brief  static function to parse one received byte, the byte is at
+ *         read_message[*read_index]. Frame end is taken from the fixed
+ *         header length so payload bytes are never mistaken for the
+ *         terminator, the checksum or CRC is updated as the bytes arrive.
+ * @param  *recv_buffer : reference to network buffer structure
+ * @param  *read_index  : index of buffer loop
+ * @param  *metrics     : reference to node metrics
+ * @retval int8_t       : error: -2, in progress: 0,
+ *                        success: length of the received frame
+ *************************************************************************/
+static int8_t comms_network_parse_byte(comms_network_buffer_t *recv_buffer, uint8_t *read_index, comms_metrics_t *metrics)
+{
+    int8_t  func_retval = 0;
+    uint8_t data        = (uint8_t)recv_buffer->read_message[*read_index];
+
+    net_rx_parser_t *parser = &recv_buffer->rx_parser;
+
+    switch(parser->state)
+    {
+
+    case NET_RX_PREAMBLE_MSB:
+
+        if(comms_valid_preamble_msb(data))
+        {
+            recv_buffer->read_message[0] = data;
+
+            *read_index   = 1;
+            parser->state = NET_RX_PREAMBLE_LSB;
+        }
+        else
+        {
+            metrics->resync_bytes++;
+
+            *read_index = 0;
+        }
+
+        break;
+
+
+    case NET_RX_PREAMBLE_LSB:
+
+        if(comms_valid_preamble(((uint16_t)(uint8_t)recv_buffer->read_message[0] << 8) | data))
+        {
+            /* Integrity mode in the two upper bits, baseline preambles are sum8 frames */
+            parser->integrity_mode = data >> 6;
+            parser->trailer_length = comms_trailer_length(parser->integrity_mode);
+
+            *read_index   = 2;
+            parser->state = NET_RX_HEADER;
+        }
+        else if(comms_valid_preamble_msb(data))
+        {
+            /* Byte may start the next preamble */
+            recv_buffer->read_message[0] = data;
+
+            metrics->resync_bytes++;
+
+            *read_index = 1;
+        }
+        else
+        {
+            metrics->resync_bytes += 2;
+
+            *read_index   = 0;
+            parser->state = NET_RX_PREAMBLE_MSB;
+        }
+
+        break;
+
+
+    case NET_RX_HEADER:
+
+        *read_index   = 3;
+        parser->state = NET_RX_LENGTH;
+
+        break;
+
+
+    case NET_RX_LENGTH:
+
+        /* Length of fixed header + preamble = 5 */
+        if(parser->integrity_mode > NET_INTEGRITY_CRC32 || data < COMMS_TERMINATOR_LENGTH + parser->trailer_length || \
+           data > sizeof(recv_buffer->read_message) - 5)
+        {
+            metrics->length_errors++;
+
+            *read_index   = 0;
+            parser->state = NET_RX_PREAMBLE_MSB;
+
+            func_retval = COMMS_RECV_ERROR;
+        }
+        else
+        {
+            parser->frame_length = data + 5;
+
+            /* CRC covers the fixed header and the body */
+            if(parser->integrity_mode == NET_INTEGRITY_CRC16)
+            {
+                parser->crc = comms_crc16_update(COMMS_CRC16_INIT, (uint8_t)recv_buffer->read_message[2]);
+                parser->crc = comms_crc16_update((uint16_t)parser->crc, (uint8_t)recv_buffer->read_message[3]);
+            }
+            else if(parser->integrity_mode == NET_INTEGRITY_CRC32)
+            {
+                parser->crc = comms_crc32_update(COMMS_CRC32_INIT, (uint8_t)recv_buffer->read_message[2]);
+                parser->crc = comms_crc32_update(parser->crc, (uint8_t)recv_buffer->read_message[3]);
+            }
+
+            *read_index   = 4;
+            parser->state = NET_RX_CHECKSUM;
+        }
+
+        break;
+
+
+    case NET_RX_CHECKSUM:
+
+        parser->checksum = 0;
+
+        if(parser->integrity_mode == NET_INTEGRITY_CRC16)
+            parser->crc = comms_crc16_update((uint16_t)parser->crc, data);
+        else if(parser->integrity_mode == NET_INTEGRITY_CRC32)
+            parser->crc = comms_crc32_update(parser->crc, data);
+
+        *read_index   = 5;
+        parser->state = NET_RX_BODY;
+
+        break;
+
+
+    case NET_RX_BODY:
+
+        /* Trailer bytes are only stored */
+        if(*read_index < parser->frame_length - parser->trailer_length)
+        {
+            if(parser->integrity_mode == NET_INTEGRITY_CRC16)
+                parser->crc = comms_crc16_update((uint16_t)parser->crc, data);
+            else if(parser->integrity_mode == NET_INTEGRITY_CRC32)
+                parser->crc = comms_crc32_update(parser->crc, data);
+            else
+                parser->checksum = (uint8_t)(parser->checksum + data);  /* Same sum as comms_network_checksum */
+        }
+
+        (*read_index)++;
+
+        if(*read_index == parser->frame_length)
+        {
+            parser->state = NET_RX_PREAMBLE_MSB;
+
+            if(parser->integrity_mode == NET_INTEGRITY_SUM8)
+            {
+                if(parser->checksum == (uint8_t)recv_buffer->read_message[4])
+                    func_retval = (int8_t)parser->frame_length;
+            }
+            else
+            {
+                if(parser->integrity_mode == NET_INTEGRITY_CRC32)
+                    parser->crc ^= COMMS_CRC32_INIT;
+
+                if(comms_trailer_match(recv_buffer->read_message + parser->frame_length - parser->trailer_length,
+                                       parser->crc, parser->trailer_length))
+                {
+                    /* Hand the frame on in its 8 bit checksum form */
+                    *read_index = parser->frame_length - parser->trailer_length;
+
+                    recv_buffer->read_message[COMMS_FRAME_INTEGRITY_BYTE] &= COMMS_PREAMBLE_ID_MASK;
+                    recv_buffer->read_message[3] = *read_index - 5;
+
+                    func_retval = (int8_t)*read_index;
+                }
+            }
+
+            if(func_retval == 0)
+            {
+                metrics->checksum_errors++;
+
+                *read_index = 0;
+
+                func_retval = COMMS_RECV_ERROR;
+            }
+        }
+
+        break;
+
+
+    default:
+
+        *read_index   = 0;
+        parser->state = NET_RX_PREAMBLE_MSB;
+
+        break;
+    }
+
+    return func_retval;
+}
+
+
+
+
+/*************************************************************************
+ * @brief  static function to queue a received frame, receive interrupt
+ *         (producer) side of the event ring
+ * @param  *recv_buffer : reference to network buffer structure
+ * @param  *metrics     : reference to node metrics
+ * @param  type         : message type
+ * @param  *frame       : received frame
+ * @param  length       : frame length
+ * @retval int8_t       : error (ring full): -2, success: 0
+ *************************************************************************/
+static int8_t comms_event_push(comms_network_buffer_t *recv_buffer, comms_metrics_t *metrics, uint8_t type, char *frame,
+                               uint8_t length)
+{
+    int8_t func_retval = 0;
+
+    net_event_queue_t *queue = &recv_buffer->rx_events;
+    net_event_t       *event;
+
+    uint8_t head = queue->head;
+
+    if((uint8_t)(head - queue->tail) >= NET_EVENT_QUEUE_SIZE)
+    {
+        metrics->rx_dropped[type & 0x0F]++;
+
+        func_retval = COMMS_RECV_ERROR;
+    }
+    else
+    {
+        event = &queue->events[head & (NET_EVENT_QUEUE_SIZE - 1)];
+
+        event->type   = type;
+        event->length = length;
+        event->acked  = 0;
+
+        memcpy(event->data, frame, length);
+
+        /* Publish the event after it is written */
+        NET_COMPILER_BARRIER();
+
+        queue->head = head + 1;
+    }
+
+    return func_retval;
+}
+
+
+
+
+/*********************************************************
+ * @brief  static function to get a trace record timestamp
+ * @param  *network : reference to network handle structure
+ * @retval uint32_t : trace_timestamp value, 0 without it
+ *********************************************************/
+static uint32_t comms_trace_timestamp(access_control_t *network)
+{
+    uint32_t func_retval = 0;
+
+    if(network->network_commands->trace_timestamp != NULL)
+        func_retval = network->network_commands->trace_timestamp();
+
+    return func_retval;
+}
+
+
+
+
+/*********************************************************
+ * @brief  static function to read a bit of a sync message
+ *         bitmap, the payload holds the ack bitmap and the
+ *         mail bitmap, each behind its length byte
+ * @param  *sync_frame : received sync message
+ * @param  bitmap      : 0 ack bitmap, 1 mail bitmap
+ * @param  client_id   : client id
+ * @retval uint8_t     : bit value
+ *********************************************************/
+static uint8_t comms_sync_bitmap(const char *sync_frame, uint8_t bitmap, uint8_t client_id)
+{
+    const uint8_t *payload = (const uint8_t*)sync_frame + COMMS_PAYLOAD_OFFSET(sync);
+
+    uint8_t func_retval = 0;
+
+    if(payload[0] <= COMMS_SYNC_BITMAP_SIZE)
+    {
+        if(bitmap)
+            payload += 1 + payload[0];
+
+        if(payload[0] <= COMMS_SYNC_BITMAP_SIZE && client_id / 8 < payload[0])
+            func_retval = (payload[1 + client_id / 8] >> (client_id % 8)) & 1;
+    }
+
+    return func_retval;
+}
+
+
+
+
 /******************************************************************************/
 /*                                                                            */
 /*                         Weak Linked Functions                              */
@@ -379,15 +801,29 @@ __attribute__((weak)) int8_t debug_print_statusack(char *debug_message)
 
 
 /**************************************************************************************
- * @brief  Constructor function to create network access handle object
+ * @brief  Initialize caller owned network access handle object
+ * @param  *network              : reference to network access handle storage
  * @param  *network_operations_t : reference to network operations handle
- * @retval access_control_t      : error: NULL, success: address of the created object
+ * @retval access_control_t      : error: NULL, success: address of the network handle
  **************************************************************************************/
-access_control_t* create_network_handle(network_operations_t *network_ops)
+access_control_t* init_network_handle(access_control_t *network, network_operations_t *network_ops)
 {
-    static access_control_t network;
+    if(network == NULL || network_ops == NULL)
+        return NULL;
 
-    network.network_commands = network_ops;
+    network->network_commands = network_ops;
+
+    memset(&network->metrics, 0, sizeof(network->metrics));
+
+    network->trace        = NULL;
+    network->network_id   = 0;
+    network->join_load    = 0;
+    network->access_slot  = COMMS_ACCESS_SLOTNUM;
+    network->access_slots = 1;
+    network->frame_slots  = 0;
+    network->wake_slots   = 0;
+
+    network->radio_sleeping = 0;
 
     /* Configure weak implementations */
 
@@ -446,27 +882,41 @@ access_control_t* create_network_handle(network_operations_t *network_ops)
 
 #endif
 
-    return &network;
+    return network;
 }
 
 
 
 
 /**************************************************************************************
- * @brief  Constructor function to create server device configure object
+ * @brief  Constructor function to create network access handle object
+ * @param  *network_operations_t : reference to network operations handle
+ * @retval access_control_t      : error: NULL, success: address of the created object
+ **************************************************************************************/
+access_control_t* create_network_handle(network_operations_t *network_ops)
+{
+    static access_control_t network;
+
+    return init_network_handle(&network, network_ops);
+}
+
+
+
+
+/**************************************************************************************
+ * @brief  Initialize caller owned server device configure object
+ * @param  *server_device        : reference to device configuration storage
  * @param  *mac_address          : mac_address of the server device
  * @param  network_id            : network id of the server
  * @param  device_slot_time      : slot time interval
  * @param  total_slots           : no of existing slots at start
- * @retval device_config_t       : error: NULL, success: address of the created object
+ * @retval device_config_t       : error: NULL, success: address of the device object
  **************************************************************************************/
-device_config_t* create_server_device(char *mac_address, uint16_t network_id, uint16_t device_slot_time, uint8_t total_slots,
-                                      char *user_name, uint8_t *password)
+device_config_t* init_server_device(device_config_t *server_device, char *mac_address, uint16_t network_id,
+                                    uint16_t device_slot_time, uint8_t total_slots, char *user_name, uint8_t *password)
 {
 
-    static device_config_t server_device;
-
-    if(device_slot_time == 0 || total_slots == 0 || network_id == 0 || mac_address == NULL)
+    if(server_device == NULL || device_slot_time == 0 || total_slots == 0 || network_id == 0 || mac_address == NULL)
     {
         return NULL;
     }
@@ -474,73 +924,109 @@ device_config_t* create_server_device(char *mac_address, uint16_t network_id, ui
     {
         /* Fixed Initializations */
 
-        set_mac_address(server_device.device_mac, mac_address);
+        set_mac_address(server_device->device_mac, mac_address);
 
-        server_device.device_network_id = network_id;
+        server_device->device_network_id = network_id;
 
-        server_device.device_slot_number = COMMS_SERVER_SLOTNUM;
+        server_device->device_slot_number = COMMS_SERVER_SLOTNUM;
 
-        server_device.device_slot_time = device_slot_time;
+        server_device->device_slot_time = device_slot_time;
 
         /* Values will change accordingly */
 
-        /* Avoid reinitization of slots if called in ISR, (new object is created at every call) */
-        if(total_slots > server_device.total_slots)
-            server_device.total_slots = total_slots;
+        /* Avoid reinitization of slots if called in ISR */
+        if(total_slots > server_device->total_slots)
+            server_device->total_slots = total_slots;
 
         /* Server User name and password */
-        memset(server_device.user_name, 0, 10);
-        memset(server_device.password, 0, 10);
+        memset(server_device->user_name, 0, 10);
+        memset(server_device->password, 0, 10);
 
-        strncpy(server_device.user_name, user_name, 10);
+        strncpy(server_device->user_name, user_name, 10);
 
-        memcpy(server_device.password, password, 10);
+        memcpy(server_device->password, password, 10);
 
     }
 
-    return &server_device;
+    return server_device;
 }
 
 
 
 
 /**************************************************************************************
- * @brief  Constructor function to create client device configure object
+ * @brief  Constructor function to create server device configure object
  * @param  *mac_address          : mac_address of the server device
- * @param  requested_total_slots : number of slots requested
- *
- *
+ * @param  network_id            : network id of the server
+ * @param  device_slot_time      : slot time interval
+ * @param  total_slots           : no of existing slots at start
  * @retval device_config_t       : error: NULL, success: address of the created object
  **************************************************************************************/
-device_config_t* create_client_device(char *mac_address, uint8_t requested_total_slots, char *user_name,
-                                      uint8_t *password)
+device_config_t* create_server_device(char *mac_address, uint16_t network_id, uint16_t device_slot_time, uint8_t total_slots,
+                                      char *user_name, uint8_t *password)
 {
+    /* Single instance, new object is not created at every call */
+    static device_config_t server_device;
+
+    return init_server_device(&server_device, mac_address, network_id, device_slot_time, total_slots, user_name, password);
+}
+
 
-    static device_config_t client_device;
 
-    if(requested_total_slots == 0 || mac_address == NULL)
+
+/**************************************************************************************
+ * @brief  Initialize caller owned client device configure object
+ * @param  *client_device        : reference to device configuration storage
+ * @param  *mac_address          : mac_address of the client device
+ * @param  requested_total_slots : number of slots requested
+ * @retval device_config_t       : error: NULL, success: address of the device object
+ **************************************************************************************/
+device_config_t* init_client_device(device_config_t *client_device, char *mac_address, uint8_t requested_total_slots,
+                                    char *user_name, uint8_t *password)
+{
+
+    if(client_device == NULL || requested_total_slots == 0 || mac_address == NULL)
     {
         return NULL;
     }
     else
     {
         /* Set client mac address */
-        set_mac_address(client_device.device_mac, mac_address);
+        set_mac_address(client_device->device_mac, mac_address);
 
         /* requested slots are the total slots held by the client device */
-        client_device.total_slots = requested_total_slots;
+        client_device->total_slots = requested_total_slots;
 
         /* get user name and password */
-        memset(client_device.user_name, 0, 10);
-        memset(client_device.password, 0, 10);
+        memset(client_device->user_name, 0, 10);
+        memset(client_device->password, 0, 10);
 
-        strncpy(client_device.user_name, user_name, 10);
+        strncpy(client_device->user_name, user_name, 10);
 
-        memcpy(client_device.password, password, 10);
+        memcpy(client_device->password, password, 10);
 
     }
 
-    return &client_device;
+    return client_device;
+}
+
+
+
+
+/**************************************************************************************
+ * @brief  Constructor function to create client device configure object
+ * @param  *mac_address          : mac_address of the server device
+ * @param  requested_total_slots : number of slots requested
+ *
+ *
+ * @retval device_config_t       : error: NULL, success: address of the created object
+ **************************************************************************************/
+device_config_t* create_client_device(char *mac_address, uint8_t requested_total_slots, char *user_name,
+                                      uint8_t *password)
+{
+    static device_config_t client_device;
+
+    return init_client_device(&client_device, mac_address, requested_total_slots, user_name, password);
 }
 
 
@@ -555,13 +1041,24 @@ device_config_t* create_client_device(char *mac_address, uint8_t requested_total
  ***********************************************************************/
 int8_t comms_send(access_control_t *network, char *message_buffer, uint16_t message_length)
 {
-    int8_t  func_retval   = 0;
-    int8_t  send_retval   = 0;
+    int8_t   func_retval    = 0;
+    int8_t   send_retval    = 0;
+    uint8_t  trailer_length = 0;
+    uint8_t  index          = 0;
+    uint32_t crc            = 0;
 
-    if(message_buffer == NULL || message_length == 0)
+    trailer_length = comms_trailer_length(network->integrity_mode);
+
+    /* Receivers hold frames of up to NET_DATA_LENGTH bytes, including the CRC trailer */
+    if(message_buffer == NULL || message_length == 0 || (trailer_length && message_length + trailer_length > NET_DATA_LENGTH))
     {
         func_retval = COMMS_SEND_ERROR;
     }
+    else if(network->network_commands->send_message_v != NULL && message_length > COMMS_FIXED_HEADER_LENGTH + 1)
+    {
+        /* Gather send, CRC trailer goes out as its own segment */
+        func_retval = (int8_t)comms_send_v(network, message_buffer, (uint8_t)message_length, NULL, 0);
+    }
     else
     {
 
@@ -570,11 +1067,35 @@ int8_t comms_send(access_control_t *network, char *message_buffer, uint16_t mess
         strncpy(message_buffer + message_length, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
 #endif
 
+        /* Append CRC trailer, length is updated in the fixed header and integrity mode in the preamble */
+        if(trailer_length)
+        {
+            comms_frame_set_length(message_buffer, comms_frame_get_length(message_buffer) + trailer_length);
+            comms_frame_set_integrity(message_buffer, network->integrity_mode);
+
+            if(network->integrity_mode == NET_INTEGRITY_CRC16)
+                crc = comms_crc16(message_buffer + 2, message_length - 2);
+            else
+                crc = comms_crc32(message_buffer + 2, message_length - 2);
+
+            for(index = 0; index < trailer_length; index++)
+                message_buffer[message_length + index] = (crc >> (8 * index)) & 0xFF;
+
+            message_length += trailer_length;
+        }
+
         send_retval = network->network_commands->send_message(message_buffer, message_length);
         if(send_retval < 0)
+        {
             func_retval = -1;
+        }
         else
+        {
+            network->metrics.frames_tx[comms_frame_get_type(message_buffer)]++;
+            network->metrics.frames_sent++;
+
             func_retval = message_length;
+        }
     }
 
 
@@ -583,6 +1104,135 @@ int8_t comms_send(access_control_t *network, char *message_buffer, uint16_t mess
 
 
 
+/*******************************************************************
+ * @brief  Function to send a frame of a header and payload segments,
+ *         sets length, integrity mode and checksum in the header and
+ *         sends through send_message_v, or send_message if not set
+ * @param  *network       : reference to network handle structure
+ * @param  *header        : preamble, fixed header and message header
+ * @param  header_length  : header length, at least 5
+ * @param  *segments      : payload segments, terminator included
+ * @param  segment_count  : number of payload segments
+ * @retval int16_t        : error: -1, success: length of message
+ *******************************************************************/
+int16_t comms_send_v(access_control_t *network, char *header, uint8_t header_length, const net_segment_t *segments,
+                     uint8_t segment_count)
+{
+    int16_t  func_retval    = 0;
+    uint16_t message_length = header_length;
+    uint8_t  trailer_length = 0;
+    uint8_t  checksum       = 0;
+    uint8_t  segment        = 0;
+    uint16_t index          = 0;
+    uint32_t crc            = 0;
+
+    net_segment_t frame[NET_MAX_SEGMENTS];
+    char          trailer[4];
+    char          send_buffer[NET_MTU_SIZE];
+
+    trailer_length = comms_trailer_length(network->integrity_mode);
+
+    for(segment = 0; segment < segment_count; segment++)
+        message_length += segments[segment].length;
+
+    /* Header, payload segments and trailer, frames of the sum8 mode may use the full MTU */
+    if(header == NULL || header_length < NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH ||
+       segment_count + 2 > NET_MAX_SEGMENTS || (segment_count && segments == NULL) ||
+       message_length + trailer_length > (trailer_length ? NET_DATA_LENGTH : NET_MTU_SIZE))
+    {
+        func_retval = COMMS_SEND_ERROR;
+    }
+    else
+    {
+        frame[0].data   = header;
+        frame[0].length = header_length;
+
+        for(segment = 0; segment < segment_count; segment++)
+            frame[segment + 1] = segments[segment];
+
+        segment_count++;
+
+        comms_frame_set_length(header, message_length + trailer_length - COMMS_FRAME_FIELDS_START);
+        comms_frame_set_integrity(header, network->integrity_mode);
+
+        /* 8 bit checksum of the message after the fixed header, same as comms_network_checksum */
+        for(index = NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH; index < header_length; index++)
+            checksum += (uint8_t)header[index];
+
+        for(segment = 1; segment < segment_count; segment++)
+        {
+            for(index = 0; index < frame[segment].length; index++)
+                checksum += (uint8_t)frame[segment].data[index];
+        }
+
+        comms_frame_set_checksum(header, checksum);
+
+        /* CRC from the fixed header to the end of the message, little endian trailer */
+        if(trailer_length)
+        {
+            crc = network->integrity_mode == NET_INTEGRITY_CRC16 ? COMMS_CRC16_INIT : COMMS_CRC32_INIT;
+
+            for(segment = 0; segment < segment_count; segment++)
+            {
+                for(index = segment ? 0 : NET_PREAMBLE_LENTH; index < frame[segment].length; index++)
+                {
+                    if(network->integrity_mode == NET_INTEGRITY_CRC16)
+                        crc = comms_crc16_update((uint16_t)crc, (uint8_t)frame[segment].data[index]);
+                    else
+                        crc = comms_crc32_update(crc, (uint8_t)frame[segment].data[index]);
+                }
+            }
+
+            if(network->integrity_mode == NET_INTEGRITY_CRC32)
+                crc ^= 0xFFFFFFFFUL;
+
+            for(index = 0; index < trailer_length; index++)
+                trailer[index] = (crc >> (8 * index)) & 0xFF;
+
+            frame[segment_count].data   = trailer;
+            frame[segment_count].length = trailer_length;
+
+            segment_count++;
+
+            message_length += trailer_length;
+        }
+
+        if(network->network_commands->send_message_v != NULL)
+        {
+            func_retval = network->network_commands->send_message_v(frame, segment_count);
+        }
+        else
+        {
+            /* Assemble the frame for the contiguous send callback */
+            for(segment = 0, index = 0; segment < segment_count; segment++)
+            {
+                if(frame[segment].length)
+                    memcpy(send_buffer + index, frame[segment].data, frame[segment].length);
+
+                index += frame[segment].length;
+            }
+
+            func_retval = network->network_commands->send_message(send_buffer, message_length);
+        }
+
+        if(func_retval < 0)
+        {
+            func_retval = COMMS_SEND_ERROR;
+        }
+        else
+        {
+            network->metrics.frames_tx[comms_frame_get_type(header)]++;
+            network->metrics.frames_sent++;
+
+            func_retval = (int16_t)message_length;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
 /************************************************************************
  * @brief  Function to receive message through network hardware interrupt
  * @param  *network         : reference to network handle structure
@@ -594,58 +1244,63 @@ int8_t comms_server_recv_it(access_control_t *network,comms_network_buffer_t *re
 {
 
     int8_t  func_retval = 0;
-    uint8_t checksum   = 0;
+    uint8_t source_id   = 0;
 
-    /* Terminate the message on the message termination characters */
-    if(recv_buffer->read_message[*read_index] == 't' && recv_buffer->read_message[*read_index - 1] == '\r')
+    func_retval = comms_network_parse_byte(recv_buffer, read_index, &network->metrics);
+
+    /* Complete frame with valid checksum */
+    if(func_retval > 0)
     {
         network->network_commands->clear_recv_interrupt();
 
         network->packet_type = (void*)recv_buffer->read_message;
 
-        /* Validate checksum, Length of fixed header + preamble = 5 */
-        checksum = comms_network_checksum((char*)recv_buffer->read_message, 5, *read_index + 1);
+        network->metrics.frames_rx[comms_frame_get_type(recv_buffer->read_message)]++;
+        network->metrics.frames_received++;
 
-        if(network->packet_type->fixed_header.message_checksum == checksum)
+        /* Client frames of this network keep the source joined, also when the receive ring is full */
+        if((comms_frame_get_type(recv_buffer->read_message) == COMMS_STATUS_MESSAGE    ||
+            comms_frame_get_type(recv_buffer->read_message) == COMMS_KEEPALIVE_MESSAGE ||
+            comms_frame_get_type(recv_buffer->read_message) == COMMS_HIBERNATE_MESSAGE ||
+            comms_frame_get_type(recv_buffer->read_message) == COMMS_UNJOIN_MESSAGE) &&
+           comms_status_get_network_id(recv_buffer->read_message) == network->network_id)
         {
-            checksum = 0;
+            source_id = comms_status_get_message_slot_number(recv_buffer->read_message);
 
-            /* Manage Network Access */
-            if(network->packet_type->fixed_header.message_type < 10)
-            {
-                if(network->packet_type->fixed_header.message_type == COMMS_JOINREQ_MESSAGE)
-                {
+            if(source_id < 8 * sizeof(network->clients_heard))
+                network->clients_heard[source_id / 8] |= 1 << (source_id % 8);
+        }
 
-                    recv_buffer->flag_state = JOINREQ_FLAG;
-                }
+        /* Manage Network Access, queue the messages handled by the server */
+        switch(comms_frame_get_type(recv_buffer->read_message))
+        {
 
-                if(network->packet_type->fixed_header.message_type == COMMS_STATUS_MESSAGE)
-                {
-                    if(recv_buffer->queue_pos < 5)
-                    {
-                        memcpy(recv_buffer->network_queue[recv_buffer->queue_pos].data, recv_buffer->read_message, *read_index);
+        case COMMS_JOINREQ_MESSAGE:
 
-                        recv_buffer->queue_pos++;
+            comms_event_push(recv_buffer, &network->metrics, comms_frame_get_type(recv_buffer->read_message),
+                             recv_buffer->read_message, *read_index);
 
-                        recv_buffer->flag_state = STATUSMSG_FLAG;
+            break;
 
-                        memset(recv_buffer->read_message, 0, sizeof(recv_buffer->read_message));
-                    }
-                }
-            }
+        /* Client messages and notifications, QoS 1 STATUS messages are acknowledged by the state machine */
+        case COMMS_STATUS_MESSAGE:
+        case COMMS_HIBERNATE_MESSAGE:
+        case COMMS_UNJOIN_MESSAGE:
+        case COMMS_KEEPALIVE_MESSAGE:
+
+            comms_event_push(recv_buffer, &network->metrics, STATUSMSG_FLAG, recv_buffer->read_message, *read_index);
+
+            break;
+
+        default:
+
+            break;
         }
 
         *read_index = 0;
     }
-    else
-    {
-        (*read_index)++;
-
-    }
 
     /* return length of message */
-    func_retval = *read_index;
-
     return func_retval;
 }
 
@@ -663,60 +1318,208 @@ int8_t comms_client_recv_it(access_control_t *network, comms_network_buffer_t *r
 {
     int8_t func_retval =  0;
 
-    uint8_t checksum = 0;
+    func_retval = comms_network_parse_byte(recv_buffer, read_index, &network->metrics);
 
-    if(recv_buffer->read_message[*read_index] == 't' && recv_buffer->read_message[*read_index - 1] == '\r')
+    /* Complete frame with valid checksum */
+    if(func_retval > 0)
     {
 
         network->network_commands->clear_recv_interrupt();
 
         network->packet_type = (void*)recv_buffer->read_message;
 
-        /* Validate checksum */
-        checksum = comms_network_checksum((char*)recv_buffer->read_message, 5, network->packet_type->fixed_header.message_length + 5);
+        network->metrics.frames_rx[comms_frame_get_type(recv_buffer->read_message)]++;
+        network->metrics.frames_received++;
 
         *read_index = 0;
 
-        if(network->packet_type->fixed_header.message_checksum == checksum)
+        switch(comms_frame_get_type(recv_buffer->read_message))
         {
-            checksum = 0;
 
-            switch(network->packet_type->fixed_header.message_type)
-            {
+        case SYNC_FLAG:
+
+            comms_event_push(recv_buffer, &network->metrics, SYNC_FLAG, recv_buffer->read_message, (uint8_t)func_retval);
+
+            /* reset timer */
+            network->network_commands->reset_tx_timer();
+
+            break;
+
+        case JOINRESP_FLAG:
+        case CONTRLMSG_FLAG:
+
+            comms_event_push(recv_buffer, &network->metrics, comms_frame_get_type(recv_buffer->read_message),
+                             recv_buffer->read_message, (uint8_t)func_retval);
+
+            break;
+
+        default:
+
+            break;
+
+        }
+
+    }
+
+    return func_retval;
+}
+
+
+
+
+
+
+/*******************************************************************
+ * @brief  Function to get the oldest received frame event
+ * @param  *recv_buffer : reference to network buffer structure
+ * @retval net_event_t  : empty: NULL, success: oldest event
+ *******************************************************************/
+net_event_t* comms_event_peek(comms_network_buffer_t *recv_buffer)
+{
+    net_event_queue_t *queue = &recv_buffer->rx_events;
+    net_event_t       *event = NULL;
+
+    uint8_t tail = queue->tail;
+
+    if(queue->head != tail)
+    {
+        /* Read the event only after its publication is seen */
+        NET_COMPILER_BARRIER();
+
+        event = &queue->events[tail & (NET_EVENT_QUEUE_SIZE - 1)];
+    }
+
+    return event;
+}
+
+
+
+/*******************************************************************
+ * @brief  Function to get a queued received frame event
+ * @param  *recv_buffer : reference to network buffer structure
+ * @param  position     : events before it, 0 is the oldest event
+ * @retval net_event_t  : not queued: NULL, success: event
+ *******************************************************************/
+net_event_t* comms_event_peek_at(comms_network_buffer_t *recv_buffer, uint8_t position)
+{
+    net_event_queue_t *queue = &recv_buffer->rx_events;
+    net_event_t       *event = NULL;
+
+    uint8_t tail = queue->tail;
+
+    if((uint8_t)(queue->head - tail) > position)
+    {
+        /* Read the event only after its publication is seen */
+        NET_COMPILER_BARRIER();
+
+        event = &queue->events[(uint8_t)(tail + position) & (NET_EVENT_QUEUE_SIZE - 1)];
+    }
+
+    return event;
+}
+
+
+
+/*******************************************************************
+ * @brief  Function to release the oldest received frame event
+ * @param  *recv_buffer : reference to network buffer structure
+ *******************************************************************/
+void comms_event_pop(comms_network_buffer_t *recv_buffer)
+{
+    net_event_queue_t *queue = &recv_buffer->rx_events;
+
+    uint8_t tail = queue->tail;
+
+    if(queue->head != tail)
+    {
+        /* Event storage is reused by the producer after the tail moves */
+        NET_COMPILER_BARRIER();
+
+        queue->tail = tail + 1;
+    }
+}
+
+
+
+
+/*******************************************************************
+ * @brief  Function to count a state machine step in the node
+ *         metrics, bins the receive ring depth
+ * @param  *network     : reference to network handle structure
+ * @param  *recv_buffer : reference to network buffer structure
+ *******************************************************************/
+void comms_metrics_step(access_control_t *network, comms_network_buffer_t *recv_buffer)
+{
+    uint8_t depth = (uint8_t)(recv_buffer->rx_events.head - recv_buffer->rx_events.tail);
 
-            case SYNC_FLAG:
+    network->metrics.queue_depth[depth < COMMS_METRICS_BINS ? depth : COMMS_METRICS_BINS - 1]++;
+}
 
-                recv_buffer->flag_state = SYNC_FLAG;
 
-                /* reset timer */
-                network->network_commands->reset_tx_timer();
 
-                break;
+/*******************************************************************
+ * @brief  Function to count a frame (SYNC message) in the node
+ *         metrics, bins the used client slots and hands the
+ *         metrics to metrics_snapshot every COMMS_METRICS_FRAMES
+ * @param  *network    : reference to network handle structure
+ * @param  slot_frames : frames in client slots of the frame
+ * @retval int8_t      : error: -18, success: 0
+ *******************************************************************/
+int8_t comms_metrics_frame(access_control_t *network, uint32_t slot_frames)
+{
+    int8_t func_retval = 0;
 
-            case JOINRESP_FLAG:
+    comms_metrics_t *metrics;
 
-                recv_buffer->flag_state = JOINRESP_FLAG;
+    if(network == NULL)
+    {
+        func_retval = COMMS_METRICS_ERROR;
+    }
+    else
+    {
+        metrics = &network->metrics;
 
-                break;
+        metrics->sync_frames++;
+        metrics->slot_usage[slot_frames < COMMS_METRICS_BINS ? slot_frames : COMMS_METRICS_BINS - 1]++;
 
-            case CONTRLMSG_FLAG:
+        /* Copy out between slots, the block is consistent for the state machine counters */
+        if(++metrics->snapshot_frames >= COMMS_METRICS_FRAMES)
+        {
+            metrics->snapshot_frames = 0;
 
-                recv_buffer->flag_state = CONTRLMSG_FLAG;
+            if(network->network_commands->metrics_snapshot != NULL)
+                network->network_commands->metrics_snapshot(metrics);
+        }
 
-                break;
+        func_retval = 0;
+    }
 
-            default:
+    return func_retval;
+}
 
-                break;
 
-            }
 
-        }
+/*******************************************************************
+ * @brief  Function to copy the node metrics, the state machine and
+ *         receive interrupt keep running, fields written by the
+ *         receive interrupt may be one frame apart
+ * @param  *network  : reference to network handle structure
+ * @param  *metrics  : reference to metrics copy
+ * @retval int8_t    : error: -18, success: 0
+ *******************************************************************/
+int8_t comms_metrics_snapshot(access_control_t *network, comms_metrics_t *metrics)
+{
+    int8_t func_retval = 0;
 
+    if(network == NULL || metrics == NULL)
+    {
+        func_retval = COMMS_METRICS_ERROR;
     }
     else
     {
-        (*read_index)++;
+        memcpy(metrics, &network->metrics, sizeof(comms_metrics_t));
+
+        func_retval = 0;
     }
 
     return func_retval;
@@ -725,14 +1528,14 @@ int8_t comms_client_recv_it(access_control_t *network, comms_network_buffer_t *r
 
 
 
-
-
 /*******************************************************************
- * @brief  Function to send application message.
+ * @brief  Function to send application message, messages longer
+ *         than a frame are sent as fragments from the user buffer,
+ *         which must be kept until application_message_ready clears
  * @param  *network         : reference to network buffer structure
  * @param  *message_buffer  : user message
- * @param  message_length   : message length
- * @retval int8_t           : error: -2, success: length of message
+ * @param  message_length   : message length, COMMS_MAX_MESSAGE_LENGTH
+ * @retval int8_t           : error: -1, success: 1
  *******************************************************************/
 int8_t send_application_message(comms_network_buffer_t *network_buffer, char *user_message, uint16_t message_length)
 {
@@ -742,15 +1545,26 @@ int8_t send_application_message(comms_network_buffer_t *network_buffer, char *us
     {
         func_retval = 0;
     }
-    else if(message_length >= NET_DATA_LENGTH - COMMS_TERMINATOR_LENGTH)
+    else if(message_length > COMMS_MAX_MESSAGE_LENGTH)
     {
         func_retval = -1;
     }
+    else if(message_length >= NET_DATA_LENGTH - COMMS_TERMINATOR_LENGTH)
+    {
+        /* Fragmented by the client state machine, no copy */
+        network_buffer->app_message_data   = user_message;
+        network_buffer->app_message_length = message_length;
+
+        network_buffer->application_flags.application_message_ready = 1;
+
+        func_retval = 1;
+    }
     else
     {
         memset(network_buffer->application_message, 0, NET_DATA_LENGTH);
         memcpy(network_buffer->application_message, user_message, message_length);
 
+        network_buffer->app_message_data   = network_buffer->application_message;
         network_buffer->app_message_length = message_length;
 
         network_buffer->application_flags.application_message_ready = 1;
@@ -808,11 +1622,16 @@ int8_t comms_network_set_timer(access_control_t *network, device_config_t *devic
 
         case NET_SYNC_SLOT:
 
-            /* sync slot is only a ranked slot as 1 by default and changes as per addition of devices */
-            timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, device->total_slots);
+            /* sync slot is only a ranked slot as 1 by default and changes as per addition of devices,
+             * more than one access slot are placed behind the client slots, the next SYNC announces the frame */
+            network->frame_slots = device->total_slots + (network->access_slots > 1 ? network->access_slots : 0);
+
+            timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, network->frame_slots);
 
             func_retval = 0;
 
+            break;
+
 
         case NET_CLIENT_ACCESS_SLOT:
 
@@ -827,7 +1646,40 @@ int8_t comms_network_set_timer(access_control_t *network, device_config_t *devic
         case NET_CLIENT_SLOT:
 
             /* Client device slot received from server after successful join */
-            timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, device->device_slot_number);
+            timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, device->device_frame_slot ?
+                                                                       device->device_frame_slot : device->device_slot_number);
+
+            func_retval = 0;
+
+            break;
+
+
+        case NET_FRAME_SLOT:
+
+            /* Frame length announced by the last SYNC message, changes take effect with the next SYNC message */
+            timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, network->frame_slots);
+
+            func_retval = 0;
+
+            break;
+
+
+        case NET_FRAME_REST_SLOT:
+
+            /* Server frames start on the frame grid after a broadcast slot, a short frame skips a grid point */
+            if(network->frame_slots)
+                timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, network->frame_slots -
+                                                                           NET_BROADCAST_SLOT % network->frame_slots);
+
+            func_retval = network->frame_slots ? 0 : COMMS_SETTIMER_ERROR;
+
+            break;
+
+
+        case NET_CLIENT_WAKE_SLOT:
+
+            /* Low power client, radio wake or client slot computed by the state machine */
+            timer_api_retval = network->network_commands->set_tx_timer(device->device_slot_time, network->wake_slots);
 
             func_retval = 0;
 
@@ -864,7 +1716,7 @@ int8_t comms_network_set_timer(access_control_t *network, device_config_t *devic
  ********************************************************/
 int8_t comms_network_checksum(char *data, uint8_t offset, uint8_t size)
 {
-    int8_t i = 0;
+    uint8_t i = 0;
     uint8_t checksum = 0;
 
     for(i = offset; i < size; i++)
@@ -877,6 +1729,46 @@ int8_t comms_network_checksum(char *data, uint8_t offset, uint8_t size)
 
 
 
+
+/*********************************************************
+ * @brief  Function to select integrity mode of sent frames,
+ *         frames of every mode are accepted on receive
+ * @param  *network : reference to network handle structure
+ * @param  mode     : frame integrity mode
+ * @retval int8_t   : error: -1, success: 0
+ *********************************************************/
+int8_t comms_network_set_integrity(access_control_t *network, net_integrity_t mode)
+{
+    int8_t func_retval = 0;
+
+    if(network == NULL || mode > NET_INTEGRITY_CRC32)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        network->integrity_mode = mode;
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to get the largest frame to build for
+ *         the integrity mode of sent frames, receivers hold
+ *         NET_DATA_LENGTH bytes including the CRC trailer
+ * @param  *network : reference to network handle structure
+ * @retval uint8_t  : frame length without CRC trailer
+ *********************************************************/
+uint8_t comms_network_frame_limit(access_control_t *network)
+{
+    return NET_DATA_LENGTH - comms_trailer_length(network->integrity_mode);
+}
+
+
+
 /******************************************************************************/
 /*                                                                            */
 /*                  Network Activity / Status Functions                       */
@@ -996,6 +1888,64 @@ int8_t comms_clear_activity(access_control_t *network)
 
 
 
+/************************************************************
+ * @brief  Function to put the radio to sleep, optional
+ *         radio_sleep operation of low power clients
+ * @param  *network  : reference to network handle structure
+ * @retval int8_t    : error = -19, success = 0
+ ************************************************************/
+int8_t comms_radio_sleep(access_control_t *network)
+{
+    int8_t func_retval = 0;
+
+    if(network == NULL || network->network_commands->radio_sleep == NULL)
+    {
+        func_retval = COMMS_RADIO_ERROR;
+    }
+    else
+    {
+        if(network->radio_sleeping == 0)
+            network->network_commands->radio_sleep();
+
+        network->radio_sleeping = 1;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/************************************************************
+ * @brief  Function to wake the radio, optional radio_wake
+ *         operation of low power clients
+ * @param  *network  : reference to network handle structure
+ * @retval int8_t    : error = -19, success = 0
+ ************************************************************/
+int8_t comms_radio_wake(access_control_t *network)
+{
+    int8_t func_retval = 0;
+
+    if(network == NULL || network->network_commands->radio_wake == NULL)
+    {
+        func_retval = COMMS_RADIO_ERROR;
+    }
+    else
+    {
+        if(network->radio_sleeping)
+            network->network_commands->radio_wake();
+
+        network->radio_sleeping = 0;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
 /************************************************************
  * @brief  Function to enable network connected status
  * @param  *network  : reference to network handle structure
@@ -1048,6 +1998,11 @@ int8_t comms_joinreq_debug_print(access_control_t *network, char *debug_message,
     {
         func_retval = -14;
     }
+    else if(network->trace != NULL)
+    {
+        comms_trace_record(network->trace, comms_trace_timestamp(network), COMMS_TRACE_JOINREQ, 1,
+                           requested_slots, 0, 0, 0);
+    }
     else
     {
 
@@ -1088,6 +2043,11 @@ int8_t comms_joinresp_debug_print(access_control_t *network, char *debug_message
     {
         func_retval = -15;
     }
+    else if(network->trace != NULL)
+    {
+        comms_trace_record(network->trace, comms_trace_timestamp(network), COMMS_TRACE_JOINRESP, 1,
+                           received_slot_id, 0, 0, 0);
+    }
     else
     {
 
@@ -1127,12 +2087,21 @@ int8_t comms_status_debug_print(access_control_t *network, char *debug_message,
 
     char ltoa_buffer[4] = {0};
 
+    uint32_t payload_args[2];
+
     uint8_t payload_length = strlen(payload_data);
 
     if(network == NULL || debug_message == NULL || destination_id == 0 || destination_id > 999)
     {
         func_retval = -16;
     }
+    else if(network->trace != NULL)
+    {
+        comms_trace_pack(payload_data, payload_length, payload_args);
+
+        comms_trace_record(network->trace, comms_trace_timestamp(network), COMMS_TRACE_STATUS, 4,
+                           destination_id, payload_length, payload_args[0], payload_args[1]);
+    }
     else
     {
         api_ltoa(destination_id, ltoa_buffer, 1);
@@ -1186,12 +2155,21 @@ int8_t comms_contrl_debug_print(access_control_t *network, char *debug_message,
 
     char ltoa_buffer[4] = {0};
 
+    uint32_t payload_args[2];
+
     uint8_t payload_length = strlen(payload_data);
 
     if(network == NULL || debug_message == NULL || source_id == 0 || source_id > 999)
     {
         func_retval = -17;
     }
+    else if(network->trace != NULL)
+    {
+        comms_trace_pack(payload_data, payload_length, payload_args);
+
+        comms_trace_record(network->trace, comms_trace_timestamp(network), COMMS_TRACE_CONTRL, 4,
+                           source_id, payload_length, payload_args[0], payload_args[1]);
+    }
     else
     {
         api_ltoa(source_id, ltoa_buffer, 1);
@@ -1228,6 +2206,66 @@ int8_t comms_contrl_debug_print(access_control_t *network, char *debug_message,
 
 
 
+/*******************************************************************
+ * @brief  Function to attach a trace ring, debug prints of the
+ *         state machine are recorded and printed by
+ *         comms_network_trace_flush, NULL prints directly
+ * @param  *network : reference to network handle structure
+ * @param  *trace   : reference to trace ring, or NULL
+ * @retval int8_t   : error: -1, success: 0
+ *******************************************************************/
+int8_t comms_network_set_trace(access_control_t *network, comms_trace_t *trace)
+{
+    int8_t func_retval = 0;
+
+    if(network == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        network->trace = trace;
+    }
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Function to print the recorded trace, main loop side,
+ *         one net_debug_print call per record
+ * @param  *network : reference to network handle structure
+ * @retval int16_t  : error: -1, success: records printed
+ *******************************************************************/
+int16_t comms_network_trace_flush(access_control_t *network)
+{
+    int16_t func_retval = 0;
+
+    comms_trace_record_t record;
+
+    char debug_message[NET_DATA_LENGTH + COMMS_TRACE_DATA] = {0};
+
+    if(network == NULL || network->trace == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        while(comms_trace_read(network->trace, &record))
+        {
+            if(comms_trace_format(&record, debug_message, sizeof(debug_message)) > 0)
+                network->network_commands->net_debug_print(debug_message);
+
+            func_retval++;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
 
 
 /******************************************************************************/
@@ -1256,13 +2294,13 @@ int8_t get_sync_data(device_config_t *client_device, char *message_payload ,acce
     else
     {
         /* Get network id */
-        client_device->device_network_id = network.sync_message->network_id;
+        client_device->device_network_id = comms_sync_get_network_id((const char*)network.sync_message);
 
         /* Get Slot Number */
-        client_device->network_access_slot = network.sync_message->access_slot;
+        client_device->network_access_slot = comms_sync_get_access_slot((const char*)network.sync_message);
 
         /* get Slot time */
-        client_device->device_slot_time = network.sync_message->slot_time;
+        client_device->device_slot_time = comms_sync_get_slot_time((const char*)network.sync_message);
 
         /* Get Payload Data */
 
@@ -1275,6 +2313,94 @@ int8_t get_sync_data(device_config_t *client_device, char *message_payload ,acce
 
 
 
+/*************************************************************************
+ * @brief  Function to get the frame number of a sync message, clients
+ *         count missed sync messages from gaps in the frame number
+ * @param  *sync_frame : received sync message
+ * @retval uint8_t     : frame number
+ *************************************************************************/
+uint8_t comms_get_sync_frame(const char *sync_frame)
+{
+    return comms_sync_get_frame_number(sync_frame);
+}
+
+
+
+/*************************************************************************
+ * @brief  Function to get the join load hint of a sync message, the
+ *         estimated number of clients contending for the access slot
+ * @param  *sync_frame : received sync message
+ * @retval uint8_t     : join load hint, 0 no contention
+ *************************************************************************/
+uint8_t comms_get_sync_join_load(const char *sync_frame)
+{
+    return comms_sync_get_join_load(sync_frame);
+}
+
+
+
+/*************************************************************************
+ * @brief  Function to get the access slots of a sync message, clients
+ *         send JOINREQ in one of the access slots from the first slot
+ * @param  *sync_frame : received sync message
+ * @param  *first_slot : first access slot number
+ * @retval uint8_t     : number of access slots, at least 1
+ *************************************************************************/
+uint8_t comms_get_sync_access_slots(const char *sync_frame, uint8_t *first_slot)
+{
+    uint8_t access_slots = comms_sync_get_access_slots(sync_frame);
+
+    if(first_slot != NULL)
+        *first_slot = comms_sync_get_access_slot(sync_frame);
+
+    return access_slots ? access_slots : 1;
+}
+
+
+
+/*************************************************************************
+ * @brief  Function to get the frame length of a sync message, the server
+ *         sends only in the sync and broadcast slots of each frame
+ * @param  *sync_frame : received sync message
+ * @retval uint8_t     : slots from SYNC to SYNC, 0 unknown
+ *************************************************************************/
+uint8_t comms_get_sync_frame_slots(const char *sync_frame)
+{
+    return comms_sync_get_frame_slots(sync_frame);
+}
+
+
+
+/*************************************************************************
+ * @brief  Function to read the ack bitmap of a sync message, the server
+ *         sets the bit of each client id with a STATUS message received
+ *         in the frame before the sync message
+ * @param  *sync_frame : received sync message
+ * @param  client_id   : client id of the STATUS message
+ * @retval uint8_t     : STATUS message received = 1, else 0
+ *************************************************************************/
+uint8_t comms_get_sync_ack(const char *sync_frame, uint8_t client_id)
+{
+    return comms_sync_bitmap(sync_frame, 0, client_id);
+}
+
+
+
+/*************************************************************************
+ * @brief  Function to read the mail bitmap of a sync message, the server
+ *         sends CONTRL messages held for the clients with the bit set in
+ *         the broadcast slot of the next frame
+ * @param  *sync_frame : received sync message
+ * @param  client_id   : client id
+ * @retval uint8_t     : mail announced = 1, else 0
+ *************************************************************************/
+uint8_t comms_get_sync_mail(const char *sync_frame, uint8_t client_id)
+{
+    return comms_sync_bitmap(sync_frame, 1, client_id);
+}
+
+
+
 
 /******************************************************************************/
 /*                                                                            */
@@ -1299,7 +2425,7 @@ uint8_t comms_network_sync_message(access_control_t *network, uint16_t network_i
     uint8_t func_retval    = 0;
     uint8_t message_length = 0;
     uint8_t payload_index  = 0;
-    char    *copy_payload  = 0;
+    char    *frame         = 0;
 
     /* Check parameter error */
     if( network == NULL || slot_time > MAX_SLOT_TIME || payload == NULL)
@@ -1315,36 +2441,43 @@ uint8_t comms_network_sync_message(access_control_t *network, uint16_t network_i
         }
         else
         {
-            network->sync_message->preamble[0] = (PREAMBLE_SYNC >> 8) & 0xFF;
-            network->sync_message->preamble[1] = (PREAMBLE_SYNC >> 0) & 0xFF;
+            frame = (char*)network->sync_message;
 
-            network->sync_message->fixed_header.message_type = COMMS_SYNC_MESSAGE;
+            comms_frame_set_preamble(frame, PREAMBLE_SYNC);
 
-            network->sync_message->message_slot_number = COMMS_SERVER_SLOTNUM;
+            comms_frame_set_type(frame, COMMS_SYNC_MESSAGE);
 
-            network->sync_message->network_id = network_id;
+            comms_sync_set_message_slot_number(frame, COMMS_SERVER_SLOTNUM);
 
-            network->sync_message->access_slot = COMMS_ACCESS_SLOTNUM;
+            comms_sync_set_network_id(frame, network_id);
 
-            network->sync_message->slot_time = slot_time;
+            comms_sync_set_access_slot(frame, network->access_slot);
 
-            /* Add payload message */
-            copy_payload = (void*)&network->sync_message->payload;
+            comms_sync_set_access_slots(frame, network->access_slots);
+
+            comms_sync_set_slot_time(frame, slot_time);
+
+            comms_sync_set_frame_number(frame, network->frame_number++);
 
-            memcpy(copy_payload, payload, payload_length);
+            comms_sync_set_join_load(frame, network->join_load);
+
+            comms_sync_set_frame_slots(frame, network->frame_slots);
+
+            /* Add payload message */
+            memcpy(frame + COMMS_PAYLOAD_OFFSET(sync), payload, payload_length);
 
             payload_index = payload_length;
 
             /* Add message terminator */
-            strncpy(copy_payload + payload_index, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+            strncpy(frame + COMMS_PAYLOAD_OFFSET(sync) + payload_index, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
 
             /* Calculate remaining length */
-            network->sync_message->fixed_header.message_length = SYNC_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH;
+            comms_frame_set_length(frame, SYNC_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH);
 
-            message_length = network->sync_message->fixed_header.message_length + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+            message_length = comms_frame_get_length(frame) + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
 
-            /* Calculate checksum Length of fixed header + PREAMBLE = 5 */
-            network->sync_message->fixed_header.message_checksum = comms_network_checksum((char*)network->sync_message, 5 , message_length);
+            /* Checksum after the preamble and fixed header */
+            comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
 
             func_retval = message_length;
 
@@ -1355,3 +2488,60 @@ uint8_t comms_network_sync_message(access_control_t *network, uint16_t network_i
 }
 
 
+
+/***********************************************************************
+ * @brief  Function to build the sync message payload, the ack bitmap
+ *         of the QoS 1 client ids with a STATUS message accepted since
+ *         the last sync message and the mail bitmap, each behind its length
+ *         byte, clears the ack bitmap
+ * @param  *network     : reference to server network handle
+ * @param  *mail_bitmap : mail bitmap of COMMS_SYNC_BITMAP_SIZE, or NULL
+ * @param  *payload     : payload buffer of COMMS_SYNC_PAYLOAD_SIZE
+ * @retval uint8_t      : payload length
+ ***********************************************************************/
+uint8_t comms_network_sync_payload(access_control_t *network, const uint8_t *mail_bitmap, char *payload)
+{
+    uint8_t func_retval  = 0;
+    uint8_t bitmap_bytes = 0;
+    uint8_t index        = 0;
+
+    if(network == NULL || payload == NULL)
+    {
+        func_retval = 0;
+    }
+    else
+    {
+        /* Bitmaps end at the last byte with a bit set */
+        for(index = 0; index < COMMS_SYNC_BITMAP_SIZE; index++)
+        {
+            payload[1 + index] = (char)network->status_acks[index];
+
+            if(network->status_acks[index])
+                bitmap_bytes = index + 1;
+        }
+
+        payload[0] = (char)bitmap_bytes;
+
+        func_retval = 1 + bitmap_bytes;
+
+        bitmap_bytes = 0;
+
+        for(index = 0; mail_bitmap != NULL && index < COMMS_SYNC_BITMAP_SIZE; index++)
+        {
+            payload[func_retval + 1 + index] = (char)mail_bitmap[index];
+
+            if(mail_bitmap[index])
+                bitmap_bytes = index + 1;
+        }
+
+        payload[func_retval] = (char)bitmap_bytes;
+
+        func_retval += 1 + bitmap_bytes;
+
+        memset(network->status_acks, 0, sizeof(network->status_acks));
+    }
+
+    return func_retval;
+}
+
+
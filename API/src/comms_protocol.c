@@ -52,6 +52,8 @@
 
 
 #include "comms_protocol.h"
+#include "comms_fragment.h"
+#include "comms_frame.h"
 #include "network_protocol_configs.h"
 
 
@@ -64,13 +66,20 @@
 /******************************************************************************/
 
 
+/* Wire message structures, packed */
+#pragma pack(push)
+#pragma pack(1)
+
+
 /* JOINREQ options */
 typedef struct _join_options
 {
-    uint8_t reserved           : 4; /*!< (LSB) Reserved                                                */
+    uint8_t slot_period        : 3; /*!< (LSB) Superframe period, slot every 2^n frames, 0 every frame */
+    uint8_t payload_codec      : 1; /*!< (LSB) Client decodes comms_codec_t payloads                   */
     uint8_t request_slots      : 1; /*!< (MSB) Request slots from server                               */
     uint8_t request_keep_alive : 1; /*!< (MSB) Request keep alive at server                            */
-    uint8_t quality_of_service : 2; /*!< (MSB) Quality of service, Fire and Forget: 0, Atleast Once: 1 */
+    uint8_t quality_of_service : 1; /*!< (MSB) Quality of service, Fire and Forget: 0, Atleast Once: 1 */
+    uint8_t low_power          : 1; /*!< (MSB) Client radio sleeps, CONTRL messages wait in a mailbox  */
 
 }join_opts_t;
 
@@ -145,18 +154,66 @@ struct _contrl
 
 
 
-/* Not tested */
+/* STATUSACK message structure */
 struct _statusack
 {
-    char           preamble[NET_PREAMBLE_LENTH]; /*!< */
-    comms_header_t fixed_header;                 /*!< */
-    uint16_t       network_id;                   /*!< */
-    uint8_t        message_slot_number;          /*!< */
-    uint8_t        destination_client_id;        /*!< */
-    char           payload[PAYLOAD_LENGTH];      /*!< */
+    char           preamble[NET_PREAMBLE_LENTH]; /*!< Message preamble                        */
+    comms_header_t fixed_header;                 /*!< Network header                          */
+    uint16_t       network_id;                   /*!< Network ID                              */
+    uint8_t        message_slot_number;          /*!< Device/Message slot number              */
+    uint8_t        destination_client_id;        /*!< Destination Client ID, 0: all clients   */
+    char           payload[PAYLOAD_LENGTH];      /*!< (client id, sequence number) records    */
 
 };
 
+#pragma pack(pop)
+
+
+/* JOINREQ options byte, join_opts_t bits */
+#define JOIN_OPTION_PERIOD      0x07  /*!< Superframe period, slot every 2^n frames */
+#define JOIN_OPTION_CODEC       0x08  /*!< Client decodes comms_codec_t payloads    */
+#define JOIN_OPTION_SLOTS       0x10  /*!< Request slots from server                */
+#define JOIN_OPTION_KEEP_ALIVE  0x20  /*!< Request keep alive at server             */
+#define JOIN_OPTION_QOS         0x40  /*!< Quality of service, at least once        */
+#define JOIN_OPTION_LOW_POWER   0x80  /*!< Client radio sleeps between slots        */
+
+
+/* JOINREQ payload, join_user_pswd_t offsets */
+#define JOINREQ_SLOTS_OFFSET     0   /*!< Number of slots requested */
+#define JOINREQ_USER_OFFSET      1   /*!< Network user name         */
+#define JOINREQ_PASSWORD_OFFSET  11  /*!< Network password          */
+#define JOINREQ_PAYLOAD_LENGTH   21  /*!< slot(1) + name(10) + password(10) */
+
+COMMS_FRAME_CHECK(offsetof(join_user_pswd_t, user_name) == JOINREQ_USER_OFFSET &&
+                  offsetof(join_user_pswd_t, password) == JOINREQ_PASSWORD_OFFSET &&
+                  sizeof(join_user_pswd_t) == JOINREQ_PAYLOAD_LENGTH, joinreq_payload_layout);
+
+
+/* Packed message structures follow the comms_frame.h message descriptors */
+#define JOINREQ_LAYOUT(message, field, kind)   COMMS_FRAME_CHECK_FIELD(struct _joinreq, message, field);
+#define JOINRESP_LAYOUT(message, field, kind)  COMMS_FRAME_CHECK_FIELD(struct _joinresp, message, field);
+#define STATUS_LAYOUT(message, field, kind)    COMMS_FRAME_CHECK_FIELD(struct _status, message, field);
+#define CONTRL_LAYOUT(message, field, kind)    COMMS_FRAME_CHECK_FIELD(struct _contrl, message, field);
+#define STATUSACK_LAYOUT(message, field, kind) COMMS_FRAME_CHECK_FIELD(struct _statusack, message, field);
+
+COMMS_JOINREQ_FIELDS(JOINREQ_LAYOUT)
+COMMS_JOINRESP_FIELDS(JOINRESP_LAYOUT)
+COMMS_STATUS_FIELDS(STATUS_LAYOUT)
+COMMS_CONTRL_FIELDS(CONTRL_LAYOUT)
+COMMS_STATUSACK_FIELDS(STATUSACK_LAYOUT)
+
+COMMS_FRAME_CHECK_PAYLOAD(struct _joinreq, joinreq);
+COMMS_FRAME_CHECK_PAYLOAD(struct _joinresp, joinresp);
+COMMS_FRAME_CHECK_PAYLOAD(struct _status, status);
+COMMS_FRAME_CHECK_PAYLOAD(struct _contrl, contrl);
+COMMS_FRAME_CHECK_PAYLOAD(struct _statusack, statusack);
+
+COMMS_FRAME_CHECK(sizeof(comms_header_t) == COMMS_FIXED_HEADER_LENGTH, fixed_header_size);
+
+/* STATUSACK records fit a frame with the largest CRC trailer */
+COMMS_FRAME_CHECK(COMMS_PAYLOAD_OFFSET(statusack) + 2 * COMMS_STATUSACK_RECORDS + COMMS_TERMINATOR_LENGTH + 4 <= NET_DATA_LENGTH,
+                  statusack_frame_size);
+
 
 
 
@@ -186,30 +243,162 @@ typedef enum _protocol_api_retval
 /******************************************************************************/
 
 
-/********************************************************
- * @brief  static function to calculate message checksum
- * @param  data   : message data
- * @param  offset : starting offset for message data
- * @param  size   : length of message
- * @retval int8_t : checksum
- ********************************************************/
-static int8_t comms_checksum(char *data, uint8_t offset, uint8_t size)
+/*************************************************************************
+ * @brief  static function to set a JOINREQ option of the options byte
+ * @param  *frame  : JOINREQ frame
+ * @param  option  : JOIN_OPTION_* bits
+ * @param  value   : option value, right aligned
+ **************************************************************************/
+static void joinreq_set_option(char *frame, uint8_t option, uint8_t value)
+{
+    uint8_t shift = 0;
+
+    while(((option >> shift) & 1) == 0)
+        shift++;
+
+    comms_joinreq_set_join_options(frame, (comms_joinreq_get_join_options(frame) & (uint8_t)~option) |
+                                          ((uint8_t)(value << shift) & option));
+}
+
+
+
+/*************************************************************************
+ * @brief  static function to get a JOINREQ option of the options byte
+ * @param  *frame   : JOINREQ frame
+ * @param  option   : JOIN_OPTION_* bits
+ * @retval uint8_t  : option value, right aligned
+ **************************************************************************/
+static uint8_t joinreq_get_option(const char *frame, uint8_t option)
+{
+    uint8_t shift = 0;
+
+    while(((option >> shift) & 1) == 0)
+        shift++;
+
+    return (comms_joinreq_get_join_options(frame) & option) >> shift;
+}
+
+
+
+/*************************************************************************
+ * @brief  static function to find the next aggregated CONTRL record for
+ *         a device
+ * @param  *records     : first record of the CONTRL message
+ * @param  records_size : size of all records
+ * @param  offset       : record to start from
+ * @param  device_id    : device slot number / device id
+ * @retval uint8_t      : offset of the record, records_size when none
+ **************************************************************************/
+static uint8_t contrl_find_record(const uint8_t *records, uint8_t records_size, uint8_t offset, uint8_t device_id)
+{
+    while(offset + CONTRL_RECORD_HEADER_SIZE <= records_size &&
+          offset + CONTRL_RECORD_HEADER_SIZE + records[offset + 2] <= records_size)
+    {
+        if(records[offset + 1] == device_id)
+            return offset;
+
+        offset += CONTRL_RECORD_HEADER_SIZE + records[offset + 2];
+    }
+
+    return records_size;
+}
+
+
+
+/*************************************************************************
+ * @brief  static function to configure a JOINRESP message with a payload
+ * @param  *server         : reference to the protocol handle
+ * @param  device_server   : server device structure
+ * @param  destination_mac : destination mac address
+ * @param  *payload        : JOINRESP payload, client id and slot schedule
+ * @param  payload_length  : length of the payload
+ * @retval uint8_t         : error 0, success: length of message
+ **************************************************************************/
+static uint8_t joinresp_payload_message(protocol_handle_t *server, device_config_t device_server, char *destination_mac,
+                                        const char *payload, uint8_t payload_length)
+{
+    uint8_t func_retval    = 0;
+    uint8_t message_length = 0;
+
+    char *frame;
+
+    if(server == NULL)
+    {
+        func_retval = 0;
+    }
+    else
+    {
+        frame = (char*)server->joinresponse_msg;
+
+        comms_frame_set_preamble(frame, PREMABLE_JOINRESP);
+
+        /* Message status set by comms_set_joinresp_message_status */
+        comms_frame_set_type(frame, COMMS_JOINRESP_MESSAGE);
+
+        comms_joinresp_set_source_mac(frame, device_server.device_mac);
+        comms_joinresp_set_destination_mac(frame, destination_mac);
+
+        comms_joinresp_set_network_id(frame, device_server.device_network_id);
+        comms_joinresp_set_message_slot_number(frame, COMMS_SERVER_SLOTNUM);
+
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(joinresp), payload, payload_length);
+
+        /* Add message terminator */
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(joinresp) + payload_length, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+
+        /* Calculate remaining message length */
+        comms_frame_set_length(frame, JOINRESP_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH);
+
+        /* Total message Length */
+        message_length = comms_frame_get_length(frame) + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+
+        /* Calculate checksum */
+        comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
+
+        func_retval = message_length;
+    }
+
+    return func_retval;
+}
+
+
+
+/*************************************************************************
+ * @brief  static function to read the superframe schedule of a JOINRESP
+ *         payload, ":slot:period:offset" after the client id
+ * @param  *device        : client device structure
+ * @param  *joinresp_data : JOINRESP payload
+ **************************************************************************/
+static void joinresp_superframe(device_config_t *device, const char *joinresp_data)
 {
-    int8_t i = 0;
+    uint8_t schedule[3] = {0};
+    uint8_t index       = 0;
 
-    uint8_t checksum = 0;
+    /* Skip the client id */
+    while(*joinresp_data >= '0' && *joinresp_data <= '9')
+        joinresp_data++;
 
-    for(i = offset; i < size; i++)
+    for(index = 0; index < 3 && *joinresp_data == ':'; index++)
     {
-        checksum = data[i] + ((checksum & 0xFF) + ((checksum >> 8) & 0xFF)) ;
+        schedule[index] = (uint8_t)atoi(++joinresp_data);
+
+        while(*joinresp_data >= '0' && *joinresp_data <= '9')
+            joinresp_data++;
     }
 
-    return checksum;
+    /* Slot every frame without a complete schedule */
+    if(index < 3 || schedule[1] > COMMS_SUPERFRAME_LIMIT || schedule[2] >= (1U << schedule[1]))
+        memset(schedule, 0, sizeof(schedule));
+
+    device->device_frame_slot  = schedule[0];
+    device->device_slot_period = schedule[1];
+    device->device_slot_offset = schedule[2];
 }
 
 
 
 
+
 /******************************************************************************/
 /*                                                                            */
 /*                              API Functions (Client)                        */
@@ -236,8 +425,94 @@ int8_t comms_joinreq_options(protocol_handle_t *client, uint8_t qos, uint8_t kee
     else
     {
         /* Configure flags */
-        client->joinrequest_msg->join_options.quality_of_service = qos;
-        client->joinrequest_msg->join_options.request_keep_alive = keep_alive;
+        joinreq_set_option((char*)client->joinrequest_msg, JOIN_OPTION_QOS, qos);
+        joinreq_set_option((char*)client->joinrequest_msg, JOIN_OPTION_KEEP_ALIVE, keep_alive);
+
+        func_retval = DEV_FUNC_SUCCESS;
+    }
+
+    return func_retval;
+}
+
+
+
+/********************************************************
+ * @brief  Function to configure JOINREQ codec support,
+ *         the server relays encoded payloads to clients
+ *         with codec support
+ * @param  *client        : pointer to comms protocol handle
+ * @param  codec_support  : payload codecs supported set/reset
+ * @retval int8_t         : error -3, success: 1
+ ********************************************************/
+int8_t comms_joinreq_codec(protocol_handle_t *client, uint8_t codec_support)
+{
+    int8_t func_retval = 0;
+
+    if(client == NULL || client->joinrequest_msg == NULL || codec_support > 1)
+    {
+        func_retval = JOINREQ_OPTS_FUNC_ERROR;
+    }
+    else
+    {
+        joinreq_set_option((char*)client->joinrequest_msg, JOIN_OPTION_CODEC, codec_support);
+
+        func_retval = DEV_FUNC_SUCCESS;
+    }
+
+    return func_retval;
+}
+
+
+
+/********************************************************
+ * @brief  Function to configure the JOINREQ reporting
+ *         period, the server schedules the client slot
+ *         every 2^period frames in a shared superframe
+ *         slot
+ * @param  *client  : pointer to comms protocol handle
+ * @param  period   : period 2^n frames, 0 every frame
+ * @retval int8_t   : error -3, success: 1
+ ********************************************************/
+int8_t comms_joinreq_period(protocol_handle_t *client, uint8_t period)
+{
+    int8_t func_retval = 0;
+
+    if(client == NULL || client->joinrequest_msg == NULL || period > COMMS_SUPERFRAME_LIMIT)
+    {
+        func_retval = JOINREQ_OPTS_FUNC_ERROR;
+    }
+    else
+    {
+        joinreq_set_option((char*)client->joinrequest_msg, JOIN_OPTION_PERIOD, period);
+
+        func_retval = DEV_FUNC_SUCCESS;
+    }
+
+    return func_retval;
+}
+
+
+
+/********************************************************
+ * @brief  Function to configure the JOINREQ low power
+ *         flag, the server holds the CONTRL messages of a
+ *         sleeping client in a mailbox and announces them
+ *         in the mail bitmap of the SYNC message
+ * @param  *client     : pointer to comms protocol handle
+ * @param  low_power   : radio sleeps between slots set/reset
+ * @retval int8_t      : error -3, success: 1
+ ********************************************************/
+int8_t comms_joinreq_sleep(protocol_handle_t *client, uint8_t low_power)
+{
+    int8_t func_retval = 0;
+
+    if(client == NULL || client->joinrequest_msg == NULL || low_power > 1)
+    {
+        func_retval = JOINREQ_OPTS_FUNC_ERROR;
+    }
+    else
+    {
+        joinreq_set_option((char*)client->joinrequest_msg, JOIN_OPTION_LOW_POWER, low_power);
 
         func_retval = DEV_FUNC_SUCCESS;
     }
@@ -261,9 +536,7 @@ uint8_t comms_joinreq_message(protocol_handle_t *client, device_config_t device,
     uint8_t payload_length = 0;
     uint8_t message_length = 0;
 
-    join_user_pswd_t *join_options_2;
-
-    char *copy_payload;
+    char *frame;
 
     /* Handle error */
     if(client == NULL || device.device_network_id == 0 || requested_slots > COMMS_SERVER_MAX_SLOTS)
@@ -274,56 +547,51 @@ uint8_t comms_joinreq_message(protocol_handle_t *client, device_config_t device,
     }
     else
     {
-        client->joinrequest_msg->preamble[0] = (PREAMBLE_JOINREQ >> 8) & 0xFF;
-        client->joinrequest_msg->preamble[1] = (PREAMBLE_JOINREQ >> 0) & 0xFF;
+        frame = (char*)client->joinrequest_msg;
 
-        client->joinrequest_msg->fixed_header.message_type = COMMS_JOINREQ_MESSAGE;
+        comms_frame_set_preamble(frame, PREAMBLE_JOINREQ);
+
+        comms_frame_set_type(frame, COMMS_JOINREQ_MESSAGE);
 
         /* Put mac address */
-        strncpy(client->joinrequest_msg->source_mac, device.device_mac, NET_MAC_SIZE);
+        comms_joinreq_set_source_mac(frame, device.device_mac);
 
         /* destination mac address (not defined)*/
 
         /* put network id received from server */
-        client->joinrequest_msg->network_id = device.device_network_id;
+        comms_joinreq_set_network_id(frame, device.device_network_id);
 
-        client->joinrequest_msg->message_slot_number = 0;
+        comms_joinreq_set_message_slot_number(frame, 0);
 
         /* Configure slot options */
         if(requested_slots != 0)
         {
-            client->joinrequest_msg->join_options.request_slots = 1;
+            joinreq_set_option(frame, JOIN_OPTION_SLOTS, 1);
         }
 
         /* !! Join Options set by comms_joinreq_options functions (externally called), else options are empty !! */
 
 
-        /* Add payload message */
-
-        join_options_2 = (void*)&client->joinrequest_msg->payload;
-
-        join_options_2->slots_requested = requested_slots;
+        /* Add payload message, slots requested, user name and password */
+        frame[COMMS_PAYLOAD_OFFSET(joinreq) + JOINREQ_SLOTS_OFFSET] = (char)requested_slots;
 
-        strcpy(join_options_2->user_name, device.user_name);
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(joinreq) + JOINREQ_USER_OFFSET, device.user_name, sizeof(device.user_name));
 
-        memcpy(join_options_2->password, device.password, 10);
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(joinreq) + JOINREQ_PASSWORD_OFFSET, device.password, sizeof(device.password));
 
-        /* Join option 2 length, slot(1) + name(10) + password(10) = 21 */
-        payload_length = 21;
+        payload_length = JOINREQ_PAYLOAD_LENGTH;
 
-        /* Null terminator */
-        copy_payload = (void*)((uint8_t*)&client->joinrequest_msg->payload + 21);
-
-        strncpy(copy_payload, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+        /* Message terminator */
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(joinreq) + payload_length, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
 
         /* Calculate remaining length */
-        client->joinrequest_msg->fixed_header.message_length = JOINREQ_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH;
+        comms_frame_set_length(frame, JOINREQ_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH);
 
         /* Total message Length */
-        message_length = client->joinrequest_msg->fixed_header.message_length + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+        message_length = comms_frame_get_length(frame) + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
 
         /* Calculate checksum */
-        client->joinrequest_msg->fixed_header.message_checksum = comms_checksum((char*)client->joinrequest_msg, 5, message_length);
+        comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
 
         func_retval = message_length;
 
@@ -344,7 +612,9 @@ int8_t comms_get_joinresp_data(device_config_t *device, protocol_handle_t client
     int8_t func_retval = 0;
     uint8_t message_status = 0;
 
-    char *joinresp_data;
+    const char *frame = (const char*)client.joinresponse_msg;
+    const char *joinresp_data;
+    char        destination_mac[NET_MAC_SIZE];
 
     if(device == NULL)
     {
@@ -353,16 +623,18 @@ int8_t comms_get_joinresp_data(device_config_t *device, protocol_handle_t client
     else
     {
         /* Get JOINRESP payload data */
-        joinresp_data = (void*)&client.joinresponse_msg->payload;
+        joinresp_data = frame + COMMS_PAYLOAD_OFFSET(joinresp);
+
+        comms_joinresp_get_destination_mac(frame, destination_mac);
 
         /* Initialize value of client id / device slot number */
         device->device_slot_number = 0;
 
         /* Check if JOINRESP message is intended for current device (MAC Address check) */
-        if(strncmp(device->device_mac, client.joinresponse_msg->destination_mac, NET_MAC_SIZE) == 0)
+        if(memcmp(device->device_mac, destination_mac, NET_MAC_SIZE) == 0)
         {
 
-            message_status = client.joinresponse_msg->fixed_header.message_status;
+            message_status = comms_frame_get_status(frame);
 
             /* Get client id from message payload */
             switch(message_status)
@@ -370,20 +642,22 @@ int8_t comms_get_joinresp_data(device_config_t *device, protocol_handle_t client
 
             case JOINRESP_NACK:
 
-                func_retval = client.joinresponse_msg->fixed_header.message_status;
+                func_retval = message_status;
 
                 break;
 
             case JOINRESP_ACK:
 
-                func_retval = client.joinresponse_msg->fixed_header.message_status;
+                func_retval = message_status;
                 device->device_slot_number = atoi(joinresp_data);
 
             case JOINRESP_DUP:
 
-                func_retval = client.joinresponse_msg->fixed_header.message_status;
+                func_retval = message_status;
                 device->device_slot_number  = atoi(joinresp_data);
 
+                joinresp_superframe(device, joinresp_data);
+
                 break;
 
             default:
@@ -422,12 +696,12 @@ uint8_t comms_status_message(protocol_handle_t *client, device_config_t device,
     uint8_t message_length = 0;
     uint8_t payload_index  = 0;
 
-    char *copy_payload;
+    char *frame;
 
-    /* Truncate PAYLOAD message */
-    if(payload_length > NET_DATA_LENGTH - COMMS_TERMINATOR_LENGTH)
+    /* Truncate PAYLOAD message to the frame, longer messages are sent as fragments */
+    if(payload_length > NET_DATA_LENGTH - (STATUS_FRAME_HEADER_LENGTH + COMMS_TERMINATOR_LENGTH))
     {
-        payload_length = NET_DATA_LENGTH - 2;
+        payload_length = NET_DATA_LENGTH - (STATUS_FRAME_HEADER_LENGTH + COMMS_TERMINATOR_LENGTH);
     }
 
     /* Handle parameter error */
@@ -437,35 +711,34 @@ uint8_t comms_status_message(protocol_handle_t *client, device_config_t device,
     }
     else
     {
-        client->status_msg->preamble[0] = (PREAMBLE_STATUS >> 8) & 0xFF;
-        client->status_msg->preamble[1] = (PREAMBLE_STATUS >> 0) & 0xFF;
+        frame = (char*)client->status_msg;
 
-        client->status_msg->fixed_header.message_type = COMMS_STATUS_MESSAGE;
+        comms_frame_set_preamble(frame, PREAMBLE_STATUS);
 
-        client->status_msg->network_id = device.device_network_id;
+        comms_frame_set_type(frame, COMMS_STATUS_MESSAGE);
 
-        client->status_msg->message_slot_number = device.device_slot_number;
+        comms_status_set_network_id(frame, device.device_network_id);
 
-        client->status_msg->destination_client_id = destination_id;
+        comms_status_set_message_slot_number(frame, device.device_slot_number);
 
-        /* Add payload message */
-        copy_payload = (void*)&client->status_msg->payload;
+        comms_status_set_destination_client_id(frame, destination_id);
 
-        memcpy(copy_payload, payload_message, payload_length);
+        /* Add payload message */
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(status), payload_message, payload_length);
 
         /* Add Message terminator */
         payload_index = payload_length;
 
-        strncpy(copy_payload + payload_index, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+        strncpy(frame + COMMS_PAYLOAD_OFFSET(status) + payload_index, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
 
         /* Calculate remaining message length */
-        client->status_msg->fixed_header.message_length = STATUS_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH;
+        comms_frame_set_length(frame, STATUS_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH);
 
         /* Total message length */
-        message_length = client->status_msg->fixed_header.message_length + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+        message_length = comms_frame_get_length(frame) + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
 
         /* Get Checksum */
-        client->status_msg->fixed_header.message_checksum = comms_checksum((char*)client->status_msg, 5, message_length);
+        comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
 
         func_retval = message_length;
 
@@ -476,191 +749,497 @@ uint8_t comms_status_message(protocol_handle_t *client, device_config_t device,
 }
 
 
-/*****************************************************
- * @brief  Function to configure STATUS message
- * @param  client : Protocol handle structure
- * @retval int8_t : error -6, success: message status
- *****************************************************/
-int8_t comms_get_statusack(protocol_handle_t client, uint16_t network_id, uint8_t device_id)
+/************************************************************************************
+ * @brief  Function to configure a STATUS frame without payload for the server,
+ *         UNJOIN, HIBERNATE or KEEPALIVE message
+ * @param  *client       : pointer to the protocol handle
+ * @param  device        : client device structure
+ * @param  message_type  : COMMS_UNJOIN_MESSAGE, COMMS_HIBERNATE_MESSAGE or
+ *                         COMMS_KEEPALIVE_MESSAGE
+ * @retval uint8_t       : error 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_notify_message(protocol_handle_t *client, device_config_t device, uint8_t message_type)
 {
-    int8_t func_retval = 0;
+    uint8_t func_retval = 0;
 
-    if(client.statusack_msg == NULL)
-    {
-        func_retval = STATUSACK_FUNC_ERROR;
-    }
-    else
+    if(message_type == COMMS_UNJOIN_MESSAGE || message_type == COMMS_HIBERNATE_MESSAGE ||
+       message_type == COMMS_KEEPALIVE_MESSAGE)
     {
-        if(client.statusack_msg->network_id == network_id && client.statusack_msg->message_slot_number == device_id)
-        {
-            func_retval = (int8_t)client.statusack_msg->fixed_header.message_status;
-        }
+        func_retval = comms_status_message(client, device, COMMS_SERVER_SLOTNUM, "", 0);
+
+        /* Checksum does not cover the fixed header type field */
+        if(func_retval)
+            comms_frame_set_type((char*)client->status_msg, message_type);
     }
 
     return func_retval;
 }
 
 
-/*************************************************************************
- * @brief  Function to get CONTRL message
- * @param  message_buffer    : message data from CONTRL message
- * @param  *source_client_id : pointer to client/device id of source device
- * @param  client            : Protocol handle structure
- * @param  network_id        : network id
- * @param  device_id         : device slot number / device id
- * @retval int8_t            : error -7, success: message length of payload
- **************************************************************************/
-int8_t comms_get_contrl_data(char *message_buffer, uint8_t* source_client_id, protocol_handle_t device,
-                             uint16_t network_id, uint8_t device_id)
+/************************************************************************************
+ * @brief  Function to configure a STATUS message fragment
+ * @param  *client         : pointer to the protocol handle
+ * @param  device          : client device structure
+ * @param  destination_id  : destination id of device to send the fragment to
+ * @param  message_id      : message id of the fragmented message
+ * @param  fragment_index  : fragment index
+ * @param  last            : last fragment of the message
+ * @param  *payload        : fragment payload, up to comms_fragment_size() bytes
+ * @param  payload_length  : fragment payload length
+ * @retval uint8_t         : error 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_fragment_message(protocol_handle_t *client, device_config_t device, uint8_t destination_id,
+                                      uint8_t message_id, uint8_t fragment_index, uint8_t last,
+                                      const char *payload, uint16_t payload_length)
 {
-    int8_t func_retval    = 0;
-    int8_t message_length = 0;
+    uint8_t func_retval = 0;
 
-    char *contrl_data;
+    char fragment[NET_DATA_LENGTH] = {0};
 
-    if(device.contrl_msg == NULL || network_id == 0 || device_id == 0)
-    {
-        func_retval = CONTRL_FUNC_ERROR;
-    }
-    else
+    if(payload_length <= NET_DATA_LENGTH - (CONTRL_FRAME_HEADER_LENGTH + COMMS_FRAGMENT_HEADER_SIZE + COMMS_TERMINATOR_LENGTH))
     {
-        /* Get CONTRL message data */
-        contrl_data = (void*)&device.contrl_msg->payload;
-
-        /* Check if message is for receiving device and on the same network */
-        if(device.contrl_msg->network_id == network_id && device.contrl_msg->destination_client_id == device_id)
-        {
-            /* Get source device id */
-            *source_client_id = device.contrl_msg->source_client_id;
+        comms_fragment_header(fragment, message_id, fragment_index, last);
 
-            /* Get payload data */
-            message_length = (int8_t)strlen(contrl_data);
+        memcpy(fragment + COMMS_FRAGMENT_HEADER_SIZE, payload, payload_length);
 
-            memcpy(message_buffer, contrl_data, (size_t)(message_length - COMMS_TERMINATOR_LENGTH));
+        func_retval = comms_status_message(client, device, destination_id, fragment,
+                                           payload_length + COMMS_FRAGMENT_HEADER_SIZE);
 
-            func_retval = message_length - COMMS_TERMINATOR_LENGTH;
-        }
+        /* Checksum does not cover the fixed header status field */
+        if(func_retval)
+            comms_frame_set_status((char*)client->status_msg, MESSAGE_FRAGMENT);
     }
 
     return func_retval;
 }
 
 
-
-/******************************************************************************/
-/*                                                                            */
-/*                              API Functions (Sever)                         */
-/*                                                                            */
-/******************************************************************************/
-
-
-/*******************************************************************
- * @brief  Function to set JOINRESP message status
- * @param  server       : reference to the protocol handle structure
- * @param  status_value : Join response status value
- * @retval int8_t       : error: -8, success: 0
- *******************************************************************/
-int8_t comms_set_joinresp_message_status(protocol_handle_t *server, int8_t status_value)
+/************************************************************************************
+ * @brief  Function to configure a STATUS message with an encoded payload
+ * @param  *client         : pointer to the protocol handle
+ * @param  device          : client device structure
+ * @param  destination_id  : destination id of device to send the status message to
+ * @param  codec           : payload codec, comms_codec_t
+ * @param  *payload        : encoded payload
+ * @param  payload_length  : encoded payload length
+ * @retval uint8_t         : error 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_codec_message(protocol_handle_t *client, device_config_t device, uint8_t destination_id,
+                                   uint8_t codec, const char *payload, uint16_t payload_length)
 {
-    int8_t func_retval = 0;
+    uint8_t func_retval = 0;
 
-    if(server == NULL)
+    /* Encoded payloads are not truncated */
+    if((codec == COMMS_CODEC_VARINT || codec == COMMS_CODEC_DICT) &&
+       payload_length <= NET_DATA_LENGTH - (STATUS_FRAME_HEADER_LENGTH + COMMS_TERMINATOR_LENGTH))
     {
-        func_retval = JOINRESP_STATUS_ERROR;
-    }
-    else
-    {
-        /*TODO !! if else redundant here, will be changed later */
-        if(status_value == -2)
-        {
-            server->joinresponse_msg->fixed_header.message_status = JOINRESP_NACK;
-        }
-        else if(status_value == -3)
-        {
-            server->joinresponse_msg->fixed_header.message_status = JOINREQ_DUP;
-        }
-        else
-        {
-            server->joinresponse_msg->fixed_header.message_status = JOINRESP_ACK;
-        }
+        func_retval = comms_status_message(client, device, destination_id, payload, payload_length);
 
-        func_retval = DEV_FUNC_SUCCESS;
+        /* Checksum does not cover the fixed header status field */
+        if(func_retval)
+            comms_frame_set_status((char*)client->status_msg, COMMS_CODEC_STATUS(codec));
     }
 
     return func_retval;
 }
 
 
-/***********************************************************************************
- * @brief  Function to configure JOINRESP message
- * @param  *server         : reference to the protocol handle
- * @param  device_server   : server protocol handle structure
- * @param  destination_mac : destination mac address
- * @param  client_id       : destination client id, new id given to the client
- * @retval uint8_t         : error 0, success: length of message
- ***********************************************************************************/
-uint8_t comms_joinresp_message(protocol_handle_t *server, device_config_t device_server, char *destination_mac, int8_t client_id)
+/************************************************************************************
+ * @brief  Function to add the QoS 1 sequence number in front of the payload of a
+ *         configured STATUS message, plain, fragment or encoded
+ * @param  *client       : pointer to the protocol handle
+ * @param  sequence      : STATUS sequence number
+ * @param  frame_limit   : largest frame, comms_network_frame_limit()
+ * @retval uint8_t       : error (frame full) 0, success: length of message
+ ************************************************************************************/
+uint8_t comms_status_sequence(protocol_handle_t *client, uint8_t sequence, uint8_t frame_limit)
 {
-
     uint8_t func_retval    = 0;
-    uint8_t payload_length = 0;
-    uint8_t payload_index  = 0;
     uint8_t message_length = 0;
 
-    char *copy_payload;
-    char payload_buff[4] = {0};
+    char *frame;
 
-    if(server == NULL)
-    {
-        func_retval = 0;
-    }
-    else
+    if(client != NULL && client->status_msg != NULL)
     {
-        server->joinresponse_msg->preamble[0] = (PREMABLE_JOINRESP >> 8) & 0xFF;
-        server->joinresponse_msg->preamble[1] = (PREMABLE_JOINRESP >> 0) & 0xFF;
+        frame = (char*)client->status_msg;
 
+        message_length = comms_frame_get_length(frame) + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
 
-        //server->joinresponse_msg->fixed_header.message_status = JOINRESP_ACK;
-        server->joinresponse_msg->fixed_header.message_type   = COMMS_JOINRESP_MESSAGE;
+        if(message_length + 1 <= frame_limit && message_length + 1 <= NET_DATA_LENGTH)
+        {
+            /* Payload and terminator move up by one byte */
+            memmove(frame + COMMS_PAYLOAD_OFFSET(status) + 1, frame + COMMS_PAYLOAD_OFFSET(status),
+                    message_length - COMMS_PAYLOAD_OFFSET(status));
 
-        memcpy(server->joinresponse_msg->source_mac, device_server.device_mac, NET_MAC_SIZE);
-        memcpy(server->joinresponse_msg->destination_mac, destination_mac, NET_MAC_SIZE);
+            frame[COMMS_PAYLOAD_OFFSET(status)] = (char)sequence;
 
-        server->joinresponse_msg->network_id = device_server.device_network_id;
-        server->joinresponse_msg->message_slot_number = COMMS_SERVER_SLOTNUM;
+            comms_frame_set_length(frame, comms_frame_get_length(frame) + 1);
 
-        /* Send client id as JOINREQ payload */
+            message_length++;
 
-        copy_payload = (void*)&server->joinresponse_msg->payload;
+            comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
 
-        ltoa((long int)client_id, payload_buff);
+            func_retval = message_length;
+        }
+    }
 
-        payload_length = strlen(payload_buff);
+    return func_retval;
+}
 
-        memcpy(copy_payload, payload_buff, payload_length);
 
-        /* Add message terminator */
-        payload_index = payload_length;
+/*****************************************************************************
+ * @brief  Function to get the next acknowledged sequence number of a device
+ *         from the records of a STATUSACK message
+ * @param  client      : Protocol handle structure
+ * @param  network_id  : network id
+ * @param  device_id   : device slot number / device id
+ * @param  *record     : offset of the next record, 0 for the first call
+ * @retval int16_t     : error or no more records -6, success: sequence number
+ *****************************************************************************/
+int16_t comms_get_statusack(protocol_handle_t client, uint16_t network_id, uint8_t device_id, uint8_t *record)
+{
+    int16_t func_retval  = STATUSACK_FUNC_ERROR;
+    uint8_t records_size = 0;
 
-        strncpy(copy_payload + payload_index, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+    const uint8_t *records;
 
-        /* Calculate remaining message length */
-        server->joinresponse_msg->fixed_header.message_length = JOINRESP_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH;
+    if(client.statusack_msg != NULL && record != NULL &&
+       comms_statusack_get_network_id((char*)client.statusack_msg) == network_id &&
+       comms_frame_get_length((char*)client.statusack_msg) >= STATUSACK_HEADER_SIZE + COMMS_TERMINATOR_LENGTH)
+    {
+        records      = (const uint8_t*)client.statusack_msg + COMMS_PAYLOAD_OFFSET(statusack);
+        records_size = comms_frame_get_length((char*)client.statusack_msg) - (STATUSACK_HEADER_SIZE + COMMS_TERMINATOR_LENGTH);
 
-        /* Total message Length */
-        message_length = server->joinresponse_msg->fixed_header.message_length + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+        while(*record + 2 <= records_size)
+        {
+            *record += 2;
 
-        /* Calculate checksum */
-        server->joinresponse_msg->fixed_header.message_checksum = comms_checksum((char*)server->joinresponse_msg, 5, message_length);
+            if(records[*record - 2] == device_id)
+            {
+                func_retval = records[*record - 1];
 
-        func_retval = message_length;
+                break;
+            }
+        }
+    }
+
+    return func_retval;
+}
+
+
+/*************************************************************************
+ * @brief  Function to get CONTRL message, first record for the device
+ *         of an aggregated CONTRL message
+ * @param  message_buffer    : message data from CONTRL message
+ * @param  *source_client_id : pointer to client/device id of source device
+ * @param  client            : Protocol handle structure
+ * @param  network_id        : network id
+ * @param  device_id         : device slot number / device id
+ * @retval int8_t            : error -7, success: message length of payload
+ **************************************************************************/
+int8_t comms_get_contrl_data(char *message_buffer, uint8_t* source_client_id, protocol_handle_t device,
+                             uint16_t network_id, uint8_t device_id)
+{
+    int8_t  func_retval    = 0;
+    int8_t  message_length = 0;
+    uint8_t record_offset  = 0;
+
+    const char *frame = (const char*)device.contrl_msg;
+
+    if(frame == NULL || network_id == 0 || device_id == 0)
+    {
+        func_retval = CONTRL_FUNC_ERROR;
+    }
+    else if(comms_frame_get_status(frame) == MESSAGE_FRAGMENT)
+    {
+        /* Fragments are read with comms_get_contrl_fragment */
+        func_retval = 0;
+    }
+    else if(comms_frame_get_status(frame) == CONTRL_AGGREGATE)
+    {
+        /* First record for the device */
+        func_retval = comms_get_contrl_record(message_buffer, source_client_id, device, network_id, device_id, &record_offset);
+    }
+    else
+    {
+        /* Check if message is for receiving device and on the same network */
+        if(comms_contrl_get_network_id(frame) == network_id && comms_contrl_get_destination_client_id(frame) == device_id)
+        {
+            /* Get source device id */
+            *source_client_id = comms_contrl_get_source_client_id(frame);
+
+            /* Get payload data, encoded payloads are binary, length comes from the header */
+            message_length = (int8_t)(comms_frame_get_length(frame) - CONTRL_HEADER_SIZE);
+
+            if(message_length >= COMMS_TERMINATOR_LENGTH)
+            {
+                memcpy(message_buffer, frame + COMMS_PAYLOAD_OFFSET(contrl), (size_t)(message_length - COMMS_TERMINATOR_LENGTH));
+
+                func_retval = message_length - COMMS_TERMINATOR_LENGTH;
+            }
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*************************************************************************
+ * @brief  Function to get a CONTRL message record, aggregated CONTRL
+ *         messages carry records for several devices, only records for
+ *         device_id are read
+ * @param  message_buffer    : message data from CONTRL message record
+ * @param  *source_client_id : pointer to client/device id of source device
+ * @param  client            : Protocol handle structure
+ * @param  network_id        : network id
+ * @param  device_id         : device slot number / device id
+ * @param  *record_offset    : record to read, 0 for the first one, set to
+ *                             the next record for device_id, 0 when none
+ * @retval int8_t            : error -7, success: message length of payload
+ **************************************************************************/
+int8_t comms_get_contrl_record(char *message_buffer, uint8_t *source_client_id, protocol_handle_t device,
+                               uint16_t network_id, uint8_t device_id, uint8_t *record_offset)
+{
+    int8_t  func_retval  = 0;
+    uint8_t records_size = 0;
+    uint8_t offset       = 0;
+
+    const uint8_t *records;
+    const char    *frame = (const char*)device.contrl_msg;
+
+    if(frame == NULL || network_id == 0 || device_id == 0 || record_offset == NULL)
+    {
+        func_retval = CONTRL_FUNC_ERROR;
+    }
+    else if(comms_frame_get_status(frame) != CONTRL_AGGREGATE)
+    {
+        *record_offset = 0;
+
+        func_retval = comms_get_contrl_data(message_buffer, source_client_id, device, network_id, device_id);
+    }
+    else if(comms_contrl_get_network_id(frame) == network_id &&
+            comms_frame_get_length(frame) >= CONTRL_HEADER_SIZE + COMMS_TERMINATOR_LENGTH)
+    {
+        /* Records between the CONTRL header and the terminator */
+        records      = (const uint8_t*)(frame + COMMS_PAYLOAD_OFFSET(contrl));
+        records_size = comms_frame_get_length(frame) - (CONTRL_HEADER_SIZE + COMMS_TERMINATOR_LENGTH);
+
+        offset = contrl_find_record(records, records_size, *record_offset, device_id);
+
+        *record_offset = 0;
+
+        if(offset < records_size)
+        {
+            *source_client_id = records[offset];
+
+            func_retval = (int8_t)records[offset + 2];
+
+            memcpy(message_buffer, records + offset + CONTRL_RECORD_HEADER_SIZE, records[offset + 2]);
+
+            /* Next record for this device */
+            offset = contrl_find_record(records, records_size, offset + CONTRL_RECORD_HEADER_SIZE + records[offset + 2],
+                                        device_id);
+
+            if(offset < records_size)
+                *record_offset = offset;
+        }
+    }
+    else
+    {
+        *record_offset = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+
+/*************************************************************************
+ * @brief  Function to get a CONTRL message fragment
+ * @param  fragment_buffer   : fragment header and payload
+ * @param  *source_client_id : pointer to client/device id of source device
+ * @param  client            : Protocol handle structure
+ * @param  network_id        : network id
+ * @param  device_id         : device slot number / device id
+ * @retval int8_t            : error -7, not a fragment for the device: 0,
+ *                             success: length of fragment
+ **************************************************************************/
+int8_t comms_get_contrl_fragment(char *fragment_buffer, uint8_t *source_client_id, protocol_handle_t device,
+                                 uint16_t network_id, uint8_t device_id)
+{
+    int8_t func_retval = 0;
+
+    const char *frame = (const char*)device.contrl_msg;
+
+    if(frame == NULL || network_id == 0 || device_id == 0)
+    {
+        func_retval = CONTRL_FUNC_ERROR;
+    }
+    else if(comms_frame_get_status(frame) == MESSAGE_FRAGMENT &&
+            comms_contrl_get_network_id(frame) == network_id && comms_contrl_get_destination_client_id(frame) == device_id &&
+            comms_frame_get_length(frame) >= CONTRL_HEADER_SIZE + COMMS_TERMINATOR_LENGTH + COMMS_FRAGMENT_HEADER_SIZE)
+    {
+        /* Get source device id */
+        *source_client_id = comms_contrl_get_source_client_id(frame);
+
+        /* Fragment payload is binary, length comes from the header */
+        func_retval = (int8_t)(comms_frame_get_length(frame) - (CONTRL_HEADER_SIZE + COMMS_TERMINATOR_LENGTH));
+
+        memcpy(fragment_buffer, frame + COMMS_PAYLOAD_OFFSET(contrl), (size_t)func_retval);
+    }
+
+    return func_retval;
+}
+
+
+
+/*****************************************************
+ * @brief  Function to get the payload codec of a
+ *         CONTRL message
+ * @param  client  : Protocol handle structure
+ * @retval uint8_t : raw payload: COMMS_CODEC_NONE,
+ *                   encoded: comms_codec_t
+ *****************************************************/
+uint8_t comms_get_contrl_codec(protocol_handle_t device)
+{
+    uint8_t func_retval = COMMS_CODEC_NONE;
+    uint8_t status      = 0;
+
+    if(device.contrl_msg != NULL)
+    {
+        status = comms_frame_get_status((const char*)device.contrl_msg);
+    }
+
+    if(status == CODEC_VARINT || status == CODEC_DICT)
+    {
+        func_retval = status - CODEC_VARINT + COMMS_CODEC_VARINT;
+    }
 
+    return func_retval;
+}
+
+
+
+
+/*****************************************************
+ * @brief  Function to get the message status of a
+ *         CONTRL message
+ * @param  client  : Protocol handle structure
+ * @retval uint8_t : comms_message_status value
+ *****************************************************/
+uint8_t comms_get_contrl_status(protocol_handle_t device)
+{
+    uint8_t func_retval = 0;
+
+    if(device.contrl_msg != NULL)
+        func_retval = comms_frame_get_status((const char*)device.contrl_msg);
+
+    return func_retval;
+}
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              API Functions (Sever)                         */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Function to set JOINRESP message status
+ * @param  server       : reference to the protocol handle structure
+ * @param  status_value : Join response status value
+ * @retval int8_t       : error: -8, success: 0
+ *******************************************************************/
+int8_t comms_set_joinresp_message_status(protocol_handle_t *server, int8_t status_value)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL)
+    {
+        func_retval = JOINRESP_STATUS_ERROR;
+    }
+    else
+    {
+        /*TODO !! if else redundant here, will be changed later */
+        if(status_value == -2)
+        {
+            comms_frame_set_status((char*)server->joinresponse_msg, JOINRESP_NACK);
+        }
+        else if(status_value == -3)
+        {
+            comms_frame_set_status((char*)server->joinresponse_msg, JOINREQ_DUP);
+        }
+        else
+        {
+            comms_frame_set_status((char*)server->joinresponse_msg, JOINRESP_ACK);
+        }
+
+        func_retval = DEV_FUNC_SUCCESS;
     }
 
     return func_retval;
 }
 
 
+/***********************************************************************************
+ * @brief  Function to configure JOINRESP message
+ * @param  *server         : reference to the protocol handle
+ * @param  device_server   : server protocol handle structure
+ * @param  destination_mac : destination mac address
+ * @param  client_id       : destination client id, new id given to the client
+ * @retval uint8_t         : error 0, success: length of message
+ ***********************************************************************************/
+uint8_t comms_joinresp_message(protocol_handle_t *server, device_config_t device_server, char *destination_mac, int8_t client_id)
+{
+    char payload_buff[4] = {0};
+
+    /* Send client id as JOINREQ payload */
+    api_ltoa((long int)client_id, payload_buff, 10);
+
+    return joinresp_payload_message(server, device_server, destination_mac, payload_buff, strlen(payload_buff));
+}
+
+
+
+/***********************************************************************************
+ * @brief  Function to configure JOINRESP message of a superframe client, the
+ *         payload carries ":slot:period:offset" after the client id
+ * @param  *server         : reference to the protocol handle
+ * @param  device_server   : server protocol handle structure
+ * @param  destination_mac : destination mac address
+ * @param  client_id       : destination client id, new id given to the client
+ * @param  frame_slot      : superframe slot number
+ * @param  period          : superframe period, slot every 2^period frames
+ * @param  offset          : frame offset, frame number mod 2^period
+ * @retval uint8_t         : error 0, success: length of message
+ ***********************************************************************************/
+uint8_t comms_joinresp_superframe_message(protocol_handle_t *server, device_config_t device_server, char *destination_mac,
+                                          int8_t client_id, uint8_t frame_slot, uint8_t period, uint8_t offset)
+{
+    char    payload_buff[16] = {0};
+    uint8_t payload_length   = 0;
+    uint8_t schedule[3]      = {frame_slot, period, offset};
+    uint8_t index            = 0;
+
+    api_ltoa((long int)client_id, payload_buff, 10);
+
+    for(index = 0; index < 3; index++)
+    {
+        payload_length = strlen(payload_buff);
+
+        payload_buff[payload_length] = ':';
+
+        api_ltoa((long int)schedule[index], payload_buff + payload_length + 1, 10);
+    }
+
+    return joinresp_payload_message(server, device_server, destination_mac, payload_buff, strlen(payload_buff));
+}
+
+
 /******************************************************************************************
  * @brief  Function to get STATUS Message from client
  * @param  server                 : reference to the server protocol handle structure
@@ -672,40 +1251,68 @@ uint8_t comms_joinresp_message(protocol_handle_t *server, device_config_t device
  ******************************************************************************************/
 int16_t comms_get_status_message(protocol_handle_t server, device_config_t server_device, char *client_payload,
                                  uint8_t *source_client_id, uint8_t *destination_client_id)
+{
+    int16_t func_retval = 0;
+
+    const char *status_data = NULL;
+
+    func_retval = comms_get_status_payload(server, server_device, &status_data, source_client_id, destination_client_id);
+
+    /* get payload data from client, get rid of the terminator */
+    if(func_retval > 0)
+        memcpy(client_payload, status_data, func_retval);
+
+    return func_retval;
+}
+
+
+
+/******************************************************************************************
+ * @brief  Function to get STATUS Message payload in place, without copy
+ * @param  server                 : reference to the server protocol handle structure
+ * @param  server_device          : reference to the server device configuration structure
+ * @param  **client_payload       : reference to payload pointer, points into the frame
+ * @param  *source_client_id      : pointer to client/device id of source device
+ * @param  *destination_client_id : pointer to client/device id of destination device
+ * @retval int16_t                : error: -9, success: length of status message payload,
+ *                                  0 for notifications without payload
+ ******************************************************************************************/
+int16_t comms_get_status_payload(protocol_handle_t server, device_config_t server_device, const char **client_payload,
+                                 uint8_t *source_client_id, uint8_t *destination_client_id)
 {
     int16_t func_retval           = 0;
     int16_t status_payload_length = 0;
 
-    char *status_data;
+    const char *frame = (const char*)server.status_msg;
+
+    /* No ids of a previous STATUS message on error */
+    *source_client_id      = 0;
+    *destination_client_id = 0;
 
     /* 1-3 slots are reserved can't be taken by any device */
-    if(server.status_msg->message_slot_number <= 3)
+    if(comms_status_get_message_slot_number(frame) <= 3)
+    {
+        func_retval = STATUSMSG_RECV_ERROR;
+    }
+    /* Check network ID, frames of other networks are errors */
+    else if(comms_status_get_network_id(frame) != server_device.device_network_id)
     {
-        *destination_client_id = 0;
         func_retval = STATUSMSG_RECV_ERROR;
     }
     else
     {
-        /* Get Status Data */
-        status_data = (void*)&server.status_msg->payload;
-
-        /* Check network ID */
-        if(server.status_msg->network_id == server_device.device_network_id)
-        {
-            status_payload_length = abs(server.status_msg->fixed_header.message_length - \
-                                        (STATUS_HEADER_SIZE + COMMS_TERMINATOR_LENGTH));
+        status_payload_length = abs(comms_frame_get_length(frame) - (STATUS_HEADER_SIZE + COMMS_TERMINATOR_LENGTH));
 
-            /* get source client id*/
-            *source_client_id = server.status_msg->message_slot_number;
+        /* get source client id*/
+        *source_client_id = comms_status_get_message_slot_number(frame);
 
-            /* get destination client id */
-            *destination_client_id = server.status_msg->destination_client_id;
+        /* get destination client id */
+        *destination_client_id = comms_status_get_destination_client_id(frame);
 
-            /* get payload data from client, get rid of the terminator */
-            memcpy(client_payload, status_data, status_payload_length);
+        /* Payload without the terminator, in the received frame */
+        *client_payload = frame + COMMS_PAYLOAD_OFFSET(status);
 
-            func_retval = status_payload_length;
-        }
+        func_retval = status_payload_length;
     }
 
 
@@ -726,92 +1333,377 @@ int16_t comms_get_status_message(protocol_handle_t server, device_config_t serve
 uint8_t comms_control_message(protocol_handle_t *server, device_config_t device, uint8_t source_id,
                               uint8_t destination_id, const char *payload, uint16_t payload_length)
 {
-    uint8_t func_retval      = 0;
-    uint8_t payload_index    = 0;
-    uint8_t message_length   = 0;
-    uint8_t payload_length_2 = 0;
+    uint8_t func_retval    = 0;
+    uint8_t message_length = CONTRL_FRAME_HEADER_LENGTH;
+    uint8_t segment_count  = 0;
+    uint8_t segment        = 0;
+
+    net_segment_t segments[CONTRL_MAX_SEGMENTS];
+
+    segment_count = comms_control_message_v(server, device, source_id, destination_id, payload, payload_length, segments);
+
+    /* Copy payload segments behind the header */
+    for(segment = 0; segment < segment_count; segment++)
+    {
+        if(segments[segment].length)
+            memcpy((char*)server->contrl_msg + message_length, segments[segment].data, segments[segment].length);
+
+        message_length += segments[segment].length;
+    }
+
+    if(segment_count)
+    {
+        /* Calculate remaining message length */
+        comms_frame_set_length((char*)server->contrl_msg, message_length - COMMS_FRAME_FIELDS_START);
+
+        /* Get Checksum */
+        comms_frame_set_checksum((char*)server->contrl_msg,
+                                 comms_network_checksum((char*)server->contrl_msg, COMMS_FRAME_FIELDS_START, message_length));
+
+        func_retval = message_length;
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************************************
+ * @brief  Function to configure CONTRL message header and payload segments for
+ *         comms_send_v, the payload is not copied
+ * @param  *server                : reference to the server protocol handle, contrl_msg
+ *                                  holds CONTRL_FRAME_HEADER_LENGTH bytes
+ * @param  device                 : reference to the server device structure
+ * @param  source_id              : client/device id of source device
+ * @param  destination_id         : client/device id of destination device
+ * @param  *payload               : CONTRL message payload
+ * @param  payload_length         : CONTRL message payload length
+ * @param  *segments              : CONTRL_MAX_SEGMENTS payload segments
+ * @retval uint8_t                : error: 0, success: number of payload segments
+ ****************************************************************************************/
+uint8_t comms_control_message_v(protocol_handle_t *server, device_config_t device, uint8_t source_id,
+                                uint8_t destination_id, const char *payload, uint16_t payload_length,
+                                net_segment_t *segments)
+{
+    uint8_t segment_count = 0;
+
+    char *frame;
 
-    char *copy_payload;
+    if(server == NULL || server->contrl_msg == NULL || segments == NULL)
+        return 0;
 
-    server->contrl_msg->preamble[0] = (PREAMBLE_CONTRL >> 8) & 0xFF;
-    server->contrl_msg->preamble[1] = (PREAMBLE_CONTRL >> 0) & 0xFF;
+    frame = (char*)server->contrl_msg;
 
-    server->contrl_msg->fixed_header.message_type = COMMS_CONTRL_MESSAGE;
+    comms_frame_set_preamble(frame, PREAMBLE_CONTRL);
 
-    server->contrl_msg->network_id            = device.device_network_id;
-    server->contrl_msg->message_slot_number   = device.device_slot_number;
-    server->contrl_msg->source_client_id      = source_id;
-    server->contrl_msg->destination_client_id = destination_id;
+    comms_frame_set_type(frame, COMMS_CONTRL_MESSAGE);
 
+    comms_contrl_set_network_id(frame, device.device_network_id);
+    comms_contrl_set_message_slot_number(frame, device.device_slot_number);
+    comms_contrl_set_source_client_id(frame, source_id);
+    comms_contrl_set_destination_client_id(frame, destination_id);
 
-    /* Get payload */
-    copy_payload = (void*)&server->contrl_msg->payload;
 
     /* Client echo condition */
     if(destination_id == source_id)
     {
-        server->contrl_msg->fixed_header.message_status = CLIENT_ECHO;
+        comms_frame_set_status(frame, CLIENT_ECHO);
 
-        server->contrl_msg->source_client_id = device.device_slot_number;
+        comms_contrl_set_source_client_id(frame, device.device_slot_number);
 
         /* add payload */
-        memcpy(copy_payload, payload, payload_length);
+        segments[segment_count].data   = payload;
+        segments[segment_count].length = payload_length;
+        segment_count++;
     }
     /* Client not found condition */
     else if(destination_id == 0)
     {
-        server->contrl_msg->fixed_header.message_status = CLIENT_NOT_FOUND;
-        server->contrl_msg->source_client_id            = device.device_slot_number;
-        server->contrl_msg->destination_client_id       = source_id;
+        comms_frame_set_status(frame, CLIENT_NOT_FOUND);
+        comms_contrl_set_source_client_id(frame, device.device_slot_number);
+        comms_contrl_set_destination_client_id(frame, source_id);
 
         /* add NOT FOUND condition to payload */
-        payload_length = 16;
-
-        memcpy(copy_payload, "DEVICE NOT FOUND", payload_length);
+        segments[segment_count].data   = "DEVICE NOT FOUND";
+        segments[segment_count].length = 16;
+        segment_count++;
     }
     /* Client echo condition */
     else if(destination_id == 1)
     {
-        server->contrl_msg->fixed_header.message_status = CLIENT_ECHO;
-        server->contrl_msg->source_client_id            = device.device_slot_number;
-        server->contrl_msg->destination_client_id       = source_id;
+        comms_frame_set_status(frame, CLIENT_ECHO);
+        comms_contrl_set_source_client_id(frame, device.device_slot_number);
+        comms_contrl_set_destination_client_id(frame, source_id);
 
         /* Add ECHO condition to payload */
-        payload_length_2 = 7;
+        segments[segment_count].data   = "[Echo]:";
+        segments[segment_count].length = 7;
+        segment_count++;
+
+        /* Add payload */
+        segments[segment_count].data   = payload;
+        segments[segment_count].length = payload_length;
+        segment_count++;
+    }
+    else
+    {
+        comms_frame_set_status(frame, MESSSAGE_OK);
+
+        /* add payload */
+        segments[segment_count].data   = payload;
+        segments[segment_count].length = payload_length;
+        segment_count++;
+    }
+
+    /* add message terminator */
+    segments[segment_count].data   = COMMS_MESSAGE_TERMINATOR;
+    segments[segment_count].length = COMMS_TERMINATOR_LENGTH;
+    segment_count++;
+
+    return segment_count;
+}
 
-        memcpy(copy_payload, "[Echo]:", payload_length_2);
 
-        payload_index = payload_length_2;
 
-        /* Add payload */
-        memcpy(copy_payload + payload_index, payload, payload_length);
 
-        payload_length += payload_length_2;
+/****************************************************************************************
+ * @brief  Function to configure CONTRL message header and payload segments of a STATUS
+ *         message fragment, the fragment header goes out with the payload, client not
+ *         found is replied once on the last fragment
+ * @param  *server                : reference to the server protocol handle, contrl_msg
+ *                                  holds CONTRL_FRAME_HEADER_LENGTH bytes
+ * @param  device                 : reference to the server device structure
+ * @param  source_id              : client/device id of source device
+ * @param  destination_id         : client/device id of destination device
+ * @param  *fragment              : fragment header and payload
+ * @param  fragment_length        : fragment length
+ * @param  *segments              : CONTRL_MAX_SEGMENTS payload segments
+ * @retval uint8_t                : nothing to send: 0, success: number of payload segments
+ ****************************************************************************************/
+uint8_t comms_control_fragment_v(protocol_handle_t *server, device_config_t device, uint8_t source_id,
+                                 uint8_t destination_id, const char *fragment, uint16_t fragment_length,
+                                 net_segment_t *segments)
+{
+    uint8_t segment_count  = 0;
+    uint8_t message_id     = 0;
+    uint8_t fragment_index = 0;
+    uint8_t last           = 0;
+
+    if(comms_fragment_parse(fragment, fragment_length, &message_id, &fragment_index, &last) < 0)
+    {
+        segment_count = 0;
+    }
+    else if(destination_id == 0)
+    {
+        /* One DEVICE NOT FOUND reply per message */
+        if(last)
+            segment_count = comms_control_message_v(server, device, source_id, destination_id, NULL, 0, segments);
     }
     else
     {
-        server->contrl_msg->fixed_header.message_status = MESSSAGE_OK;
+        segment_count = comms_control_message_v(server, device, source_id, destination_id, fragment,
+                                                fragment_length, segments);
 
-        /* add payload */
-        memcpy(copy_payload, payload, payload_length);
+        if(segment_count)
+        {
+            /* Echo fragments go back unchanged, reassembly needs the fragment header first */
+            if(destination_id == 1)
+            {
+                segments[0] = segments[1];
+                segments[1] = segments[2];
+                segment_count--;
+            }
+
+            comms_frame_set_status((char*)server->contrl_msg, MESSAGE_FRAGMENT);
+        }
     }
 
+    return segment_count;
+}
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to configure CONTRL message header and payload segments of an
+ *         encoded STATUS payload, relayed encoded to a destination client with codec
+ *         support, server replies (echo prefix, not found) are not encoded
+ * @param  *server                : reference to the server protocol handle, contrl_msg
+ *                                  holds CONTRL_FRAME_HEADER_LENGTH bytes
+ * @param  device                 : reference to the server device structure
+ * @param  source_id              : client/device id of source device
+ * @param  destination_id         : client/device id of destination device
+ * @param  codec                  : payload codec, comms_codec_t
+ * @param  *payload               : encoded payload
+ * @param  payload_length         : encoded payload length
+ * @param  *segments              : CONTRL_MAX_SEGMENTS payload segments
+ * @retval uint8_t                : error: 0, success: number of payload segments
+ ****************************************************************************************/
+uint8_t comms_control_codec_v(protocol_handle_t *server, device_config_t device, uint8_t source_id,
+                              uint8_t destination_id, uint8_t codec, const char *payload, uint16_t payload_length,
+                              net_segment_t *segments)
+{
+    uint8_t segment_count = 0;
+
+    if(codec != COMMS_CODEC_VARINT && codec != COMMS_CODEC_DICT)
+        return 0;
+
+    segment_count = comms_control_message_v(server, device, source_id, destination_id, payload, payload_length, segments);
+
+    /* Payload relayed as it is, to another client or echoed to the source */
+    if(segment_count && destination_id > 1)
+        comms_frame_set_status((char*)server->contrl_msg, COMMS_CODEC_STATUS(codec));
+
+    return segment_count;
+}
+
+
+
+
+/****************************************************************************************
+ * @brief  Function to configure an aggregated CONTRL message header, records are
+ *         added with comms_control_aggregate_add
+ * @param  *server : reference to the server protocol handle
+ * @param  device  : reference to the server device structure
+ * @retval uint8_t : error: 0, success: length of message
+ ****************************************************************************************/
+uint8_t comms_control_aggregate_init(protocol_handle_t *server, device_config_t device)
+{
+    uint8_t func_retval = 0;
+
+    char *frame;
+
+    if(server != NULL && server->contrl_msg != NULL)
+    {
+        frame = (char*)server->contrl_msg;
+
+        comms_frame_set_preamble(frame, PREAMBLE_CONTRL);
+
+        comms_frame_set_type(frame, COMMS_CONTRL_MESSAGE);
+        comms_frame_set_status(frame, CONTRL_AGGREGATE);
+
+        comms_contrl_set_network_id(frame, device.device_network_id);
+        comms_contrl_set_message_slot_number(frame, device.device_slot_number);
+        comms_contrl_set_source_client_id(frame, device.device_slot_number);
+
+        /* Record count */
+        comms_contrl_set_destination_client_id(frame, 0);
+
+        func_retval = CONTRL_FRAME_HEADER_LENGTH;
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************************************
+ * @brief  Function to add a record to an aggregated CONTRL message, echo and client
+ *         not found records are addressed back to the source like CONTRL messages
+ * @param  *server         : reference to the server protocol handle
+ * @param  device          : reference to the server device structure
+ * @param  message_length  : length of message so far
+ * @param  frame_limit     : largest frame, comms_network_frame_limit()
+ * @param  source_id       : client/device id of source device
+ * @param  destination_id  : client/device id of destination device
+ * @param  *payload        : record payload
+ * @param  payload_length  : record payload length
+ * @retval uint8_t         : record does not fit: 0, success: length of message
+ ****************************************************************************************/
+uint8_t comms_control_aggregate_add(protocol_handle_t *server, device_config_t device, uint8_t message_length,
+                                    uint8_t frame_limit, uint8_t source_id, uint8_t destination_id,
+                                    const char *payload, uint16_t payload_length)
+{
+    uint8_t func_retval   = 0;
+    uint8_t prefix_length = 0;
+
+    const char *prefix = NULL;
+
+    char *record;
+
+    /* Echo and client not found records go back to the source, from the server */
+    if(destination_id == source_id)
+    {
+        source_id = device.device_slot_number;
+    }
+    else if(destination_id == 0)
+    {
+        destination_id = source_id;
+        source_id      = device.device_slot_number;
+
+        payload        = "DEVICE NOT FOUND";
+        payload_length = 16;
+    }
+    else if(destination_id == 1)
+    {
+        destination_id = source_id;
+        source_id      = device.device_slot_number;
+
+        prefix         = "[Echo]:";
+        prefix_length  = 7;
+    }
+
+    if(server == NULL || server->contrl_msg == NULL || message_length < CONTRL_FRAME_HEADER_LENGTH ||
+       (uint16_t)message_length + CONTRL_RECORD_HEADER_SIZE + prefix_length + payload_length + COMMS_TERMINATOR_LENGTH > frame_limit)
+    {
+        func_retval = 0;
+    }
+    else
+    {
+        record = (char*)server->contrl_msg + message_length;
+
+        record[0] = (char)source_id;
+        record[1] = (char)destination_id;
+        record[2] = (char)(prefix_length + payload_length);
+
+        if(prefix_length)
+            memcpy(record + CONTRL_RECORD_HEADER_SIZE, prefix, prefix_length);
+
+        if(payload_length)
+            memcpy(record + CONTRL_RECORD_HEADER_SIZE + prefix_length, payload, payload_length);
+
+        /* Record count */
+        comms_contrl_set_destination_client_id((char*)server->contrl_msg,
+                                               comms_contrl_get_destination_client_id((char*)server->contrl_msg) + 1);
+
+        func_retval = message_length + CONTRL_RECORD_HEADER_SIZE + prefix_length + payload_length;
+    }
+
+    return func_retval;
+}
+
 
-    /* add message terminator */
-    payload_index = payload_length;
 
-    strncpy(copy_payload + payload_index, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+/****************************************************************************************
+ * @brief  Function to complete an aggregated CONTRL message
+ * @param  *server         : reference to the server protocol handle
+ * @param  message_length  : length of message so far
+ * @retval uint8_t         : no records: 0, success: length of message
+ ****************************************************************************************/
+uint8_t comms_control_aggregate_end(protocol_handle_t *server, uint8_t message_length)
+{
+    uint8_t func_retval = 0;
+
+    char *frame = NULL;
 
-    /* Calculate remaining message length */
-    server->contrl_msg->fixed_header.message_length = CONTRL_HEADER_SIZE + payload_length + COMMS_TERMINATOR_LENGTH;
+    if(server != NULL)
+        frame = (char*)server->contrl_msg;
 
-    /* calculate total message length  */
-    message_length = server->contrl_msg->fixed_header.message_length + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+    if(frame != NULL && comms_contrl_get_destination_client_id(frame) > 0)
+    {
+        /* Add message terminator */
+        memcpy(frame + message_length, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
 
-    /* Get Checksum */
-    server->contrl_msg->fixed_header.message_checksum = comms_checksum((char*)server->contrl_msg, 5, message_length);
+        message_length += COMMS_TERMINATOR_LENGTH;
 
-    func_retval = message_length;
+        /* Calculate remaining message length */
+        comms_frame_set_length(frame, message_length - COMMS_FRAME_FIELDS_START);
+
+        /* Get Checksum */
+        comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
+
+        func_retval = message_length;
+    }
 
     return func_retval;
 }
@@ -833,7 +1725,8 @@ int8_t comms_get_joinreq_data(char *client_mac_address, uint8_t *client_requeste
 {
     int8_t  func_retval = 0;
 
-    join_user_pswd_t *join_options_2;
+    const char *frame = (const char*)server.joinrequest_msg;
+    const char *join_options_2;
 
     if(server.joinrequest_msg == NULL)
     {
@@ -843,21 +1736,21 @@ int8_t comms_get_joinreq_data(char *client_mac_address, uint8_t *client_requeste
     {
 
         /* Get JOINREQ data */
-        join_options_2 = (void*)&server.joinrequest_msg->payload;
+        join_options_2 = frame + COMMS_PAYLOAD_OFFSET(joinreq);
 
         /* Check network id */
-        if( (server.joinrequest_msg->network_id == server_device.device_network_id) && (joinresponse_state == 1) )
+        if( (comms_joinreq_get_network_id(frame) == server_device.device_network_id) && (joinresponse_state == 1) )
         {
 
             /* Authentication check */
-            if( (strncmp(server_device.user_name, join_options_2->user_name, 10) == 0 ) && \
-                    (memcmp(server_device.password, join_options_2->password, 10) == 0 ) )
+            if( (strncmp(server_device.user_name, join_options_2 + JOINREQ_USER_OFFSET, 10) == 0 ) && \
+                    (memcmp(server_device.password, join_options_2 + JOINREQ_PASSWORD_OFFSET, 10) == 0 ) )
             {
                 /* Get client requested slots */
-                *client_requested_slots = join_options_2->slots_requested;
+                *client_requested_slots = (uint8_t)join_options_2[JOINREQ_SLOTS_OFFSET];
 
                 /* Get client MAC address */
-                memcpy(client_mac_address, server.joinrequest_msg->source_mac, NET_MAC_SIZE);
+                comms_joinreq_get_source_mac(frame, client_mac_address);
 
                 /* Can be used for as JOINRESP fsm state value */
                 func_retval = 4;
@@ -874,54 +1767,206 @@ int8_t comms_get_joinreq_data(char *client_mac_address, uint8_t *client_requeste
 
 
 
-/*
- * client_id : client id value from table
- */
-int8_t comms_statusack_message(protocol_handle_t *client, device_config_t device, int8_t client_id, uint8_t destination_client_id)
+/*****************************************************************************
+ * @brief  Function to get JOINREQ message options
+ * @param  server      : reference to the protocol handle structure
+ * @param  *qos        : reference to quality of service value
+ * @param  *keep_alive : reference to keep alive request value
+ * @retval int8_t      : error: -10, success: 0
+ *****************************************************************************/
+int8_t comms_get_joinreq_options(protocol_handle_t server, uint8_t *qos, uint8_t *keep_alive)
+{
+    int8_t func_retval = 0;
+
+    if(server.joinrequest_msg == NULL)
+    {
+        func_retval = -10;
+    }
+    else
+    {
+        *qos        = joinreq_get_option((const char*)server.joinrequest_msg, JOIN_OPTION_QOS);
+        *keep_alive = joinreq_get_option((const char*)server.joinrequest_msg, JOIN_OPTION_KEEP_ALIVE);
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/*****************************************************************************
+ * @brief  Function to get JOINREQ codec support
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : no codec support: 0, codec support: 1
+ *****************************************************************************/
+uint8_t comms_get_joinreq_codec(protocol_handle_t server)
+{
+    uint8_t func_retval = 0;
+
+    if(server.joinrequest_msg != NULL)
+        func_retval = joinreq_get_option((const char*)server.joinrequest_msg, JOIN_OPTION_CODEC);
+
+    return func_retval;
+}
+
+
+
+/*****************************************************************************
+ * @brief  Function to get the JOINREQ reporting period
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : period 2^n frames, 0 every frame
+ *****************************************************************************/
+uint8_t comms_get_joinreq_period(protocol_handle_t server)
+{
+    uint8_t func_retval = 0;
+
+    if(server.joinrequest_msg != NULL)
+        func_retval = joinreq_get_option((const char*)server.joinrequest_msg, JOIN_OPTION_PERIOD);
+
+    return func_retval;
+}
+
+
+
+/*****************************************************************************
+ * @brief  Function to get the JOINREQ low power flag
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : radio always on: 0, radio sleeps between slots: 1
+ *****************************************************************************/
+uint8_t comms_get_joinreq_sleep(protocol_handle_t server)
+{
+    uint8_t func_retval = 0;
+
+    if(server.joinrequest_msg != NULL)
+        func_retval = joinreq_get_option((const char*)server.joinrequest_msg, JOIN_OPTION_LOW_POWER);
+
+    return func_retval;
+}
+
+
+
+/*****************************************************************************
+ * @brief  Function to get the message type of a received STATUS frame
+ * @param  server  : reference to the protocol handle structure
+ * @retval uint8_t : error: 0, success: message type
+ *****************************************************************************/
+uint8_t comms_get_status_type(protocol_handle_t server)
+{
+    uint8_t func_retval = 0;
+
+    if(server.status_msg != NULL)
+        func_retval = comms_frame_get_type((const char*)server.status_msg);
+
+    return func_retval;
+}
+
+
+
+
+
+/*****************************************************
+ * @brief  Function to check for a STATUS message fragment
+ * @param  server  : Protocol handle structure
+ * @retval uint8_t : fragment: 1, STATUS message: 0
+ *****************************************************/
+uint8_t comms_get_status_fragment(protocol_handle_t server)
+{
+    uint8_t func_retval = 0;
+
+    if(server.status_msg != NULL && comms_frame_get_type((const char*)server.status_msg) == COMMS_STATUS_MESSAGE &&
+       comms_frame_get_status((const char*)server.status_msg) == MESSAGE_FRAGMENT)
+    {
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+
+
+/*****************************************************
+ * @brief  Function to get the payload codec of a
+ *         STATUS message
+ * @param  server  : Protocol handle structure
+ * @retval uint8_t : raw payload: COMMS_CODEC_NONE,
+ *                   encoded: comms_codec_t
+ *****************************************************/
+uint8_t comms_get_status_codec(protocol_handle_t server)
+{
+    uint8_t func_retval = COMMS_CODEC_NONE;
+    uint8_t status      = 0;
+
+    if(server.status_msg != NULL && comms_frame_get_type((const char*)server.status_msg) == COMMS_STATUS_MESSAGE)
+    {
+        status = comms_frame_get_status((const char*)server.status_msg);
+    }
+
+    if(status == CODEC_VARINT || status == CODEC_DICT)
+    {
+        func_retval = status - CODEC_VARINT + COMMS_CODEC_VARINT;
+    }
+
+    return func_retval;
+}
+
+
+
+
+
+/*****************************************************************************
+ * @brief  Function to configure a STATUSACK message, (client id, sequence
+ *         number) records of the QoS 1 STATUS messages received by the server
+ * @param  *server        : pointer to the protocol handle
+ * @param  device         : server device structure
+ * @param  *records       : client id and sequence number pairs
+ * @param  record_count   : number of records, up to COMMS_STATUSACK_RECORDS
+ * @retval uint8_t        : error 0, success: length of message
+ *****************************************************************************/
+uint8_t comms_statusack_message(protocol_handle_t *server, device_config_t device, const uint8_t *records,
+                                uint8_t record_count)
 {
     uint8_t func_retval    = 0;
     uint8_t message_length = 0;
 
+    char *frame;
 
     /* Handle parameter error */
-    if(client == NULL)
+    if(server == NULL || records == NULL || record_count == 0 || record_count > COMMS_STATUSACK_RECORDS)
     {
         func_retval = 0;
-
     }
     else
     {
-        client->statusack_msg->preamble[0] = (PREAMBLE_STATUSACK >> 8) & 0xFF;
-        client->statusack_msg->preamble[1] = (PREAMBLE_STATUSACK >> 0) & 0xFF;
+        frame = (char*)server->statusack_msg;
 
-        if(client_id == 0)
-        {
-            client->statusack_msg->fixed_header.message_status = CLIENT_NOT_FOUND;
-        }
-        else
-        {
-            client->statusack_msg->fixed_header.message_status = MESSSAGE_OK;
-        }
+        comms_frame_set_preamble(frame, PREAMBLE_STATUSACK);
 
-        client->statusack_msg->fixed_header.message_type = COMMS_STATUSACK_MESSAGE;
+        comms_frame_set_status(frame, MESSSAGE_OK);
 
+        comms_frame_set_type(frame, COMMS_STATUSACK_MESSAGE);
 
-        client->statusack_msg->network_id = device.device_network_id;
-        client->statusack_msg->message_slot_number = device.device_slot_number;
+        comms_statusack_set_network_id(frame, device.device_network_id);
+        comms_statusack_set_message_slot_number(frame, COMMS_SERVER_SLOTNUM);
 
-        client->statusack_msg->destination_client_id = destination_client_id;
+        /* Records name the clients */
+        comms_statusack_set_destination_client_id(frame, 0);
+
+        memcpy(frame + COMMS_PAYLOAD_OFFSET(statusack), records, 2 * record_count);
 
         /* Add Message terminator */
-        strncpy(client->statusack_msg->payload, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
+        strncpy(frame + COMMS_PAYLOAD_OFFSET(statusack) + 2 * record_count, COMMS_MESSAGE_TERMINATOR, COMMS_TERMINATOR_LENGTH);
 
         /* Calculate remaining message length */
-        client->statusack_msg->fixed_header.message_length = STATUSACK_HEADER_SIZE + COMMS_TERMINATOR_LENGTH;
+        comms_frame_set_length(frame, STATUSACK_HEADER_SIZE + 2 * record_count + COMMS_TERMINATOR_LENGTH);
 
         /* Total message length */
-        message_length = client->statusack_msg->fixed_header.message_length + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
+        message_length = comms_frame_get_length(frame) + NET_PREAMBLE_LENTH + COMMS_FIXED_HEADER_LENGTH;
 
         /* Get Checksum */
-        client->statusack_msg->fixed_header.message_checksum = comms_checksum((char*)client->statusack_msg, 5, message_length);
+        comms_frame_set_checksum(frame, comms_network_checksum(frame, COMMS_FRAME_FIELDS_START, message_length));
 
         func_retval = message_length;
 
@@ -929,7 +1974,3 @@ int8_t comms_statusack_message(protocol_handle_t *client, device_config_t device
 
     return func_retval;
 }
-
-
-
-
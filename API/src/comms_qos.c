@@ -0,0 +1,289 @@
+/**
+ ******************************************************************************
+ * @file    comms_qos.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network QoS 1 delivery source file
+ *
+ *  Info
+ *          Retransmit queue of the unacknowledged STATUS frames of a client
+ *          and the duplicate window of the sequence numbers the server
+ *          received from a client.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "comms_qos.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to initialize a retransmit queue
+ * @param  *queue : reference to retransmit queue entries
+ * @param  count  : number of entries
+ *********************************************************/
+void init_retransmit(net_retransmit_t *queue, uint8_t count)
+{
+    uint8_t index = 0;
+
+    for(index = 0; index < count; index++)
+        queue[index].length = 0;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to get the number of frames waiting
+ *         for an acknowledgement
+ * @param  *queue  : reference to retransmit queue entries
+ * @param  count   : number of entries
+ * @retval uint8_t : number of held frames
+ *********************************************************/
+uint8_t comms_retransmit_count(const net_retransmit_t *queue, uint8_t count)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(queue[index].length)
+            func_retval++;
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to hold a sent STATUS frame until the
+ *         server acknowledges its sequence number
+ * @param  *queue    : reference to retransmit queue entries
+ * @param  count     : number of entries
+ * @param  *frame    : sent STATUS frame
+ * @param  length    : frame length
+ * @param  sequence  : STATUS sequence number
+ * @retval int8_t    : error (queue full): -1, success: 0
+ *********************************************************/
+int8_t comms_retransmit_add(net_retransmit_t *queue, uint8_t count, const char *frame, uint8_t length,
+                            uint8_t sequence)
+{
+    int8_t  func_retval = -1;
+    uint8_t index       = 0;
+
+    if(frame == NULL || length == 0 || length > NET_DATA_LENGTH)
+        return func_retval;
+
+    for(index = 0; index < count; index++)
+    {
+        if(queue[index].length == 0)
+        {
+            memcpy(queue[index].frame, frame, length);
+
+            queue[index].length   = length;
+            queue[index].sequence = sequence;
+            queue[index].age      = 0;
+            queue[index].retries  = 0;
+
+            func_retval = 0;
+
+            break;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to release the frame of an
+ *         acknowledged sequence number
+ * @param  *queue    : reference to retransmit queue entries
+ * @param  count     : number of entries
+ * @param  sequence  : acknowledged sequence number
+ * @retval uint8_t   : released: 1, unknown sequence: 0
+ *********************************************************/
+uint8_t comms_retransmit_ack(net_retransmit_t *queue, uint8_t count, uint8_t sequence)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(queue[index].length && queue[index].sequence == sequence)
+        {
+            queue[index].length = 0;
+
+            func_retval = 1;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to age the held frames by one owned
+ *         slot, frames without acknowledgement after
+ *         COMMS_QOS_RETRIES retransmissions are dropped
+ * @param  *queue  : reference to retransmit queue entries
+ * @param  count   : number of entries
+ * @retval uint8_t : number of dropped frames
+ *********************************************************/
+uint8_t comms_retransmit_age(net_retransmit_t *queue, uint8_t count)
+{
+    uint8_t func_retval = 0;
+    uint8_t index       = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(queue[index].length == 0)
+            continue;
+
+        if(queue[index].age < 255)
+            queue[index].age++;
+
+        /* Last retransmission unacknowledged */
+        if(queue[index].age >= COMMS_QOS_RETRY_FRAMES && queue[index].retries >= COMMS_QOS_RETRIES)
+        {
+            queue[index].length = 0;
+
+            func_retval++;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to get the frame to send again, the
+ *         oldest frame without acknowledgement for
+ *         COMMS_QOS_RETRY_FRAMES owned slots
+ * @param  *queue           : reference to retransmit queue entries
+ * @param  count            : number of entries
+ * @retval net_retransmit_t : none due: NULL, success: entry
+ *********************************************************/
+net_retransmit_t* comms_retransmit_due(net_retransmit_t *queue, uint8_t count)
+{
+    net_retransmit_t *func_retval = NULL;
+    uint8_t           index       = 0;
+
+    for(index = 0; index < count; index++)
+    {
+        if(queue[index].length == 0 || queue[index].age < COMMS_QOS_RETRY_FRAMES)
+            continue;
+
+        /* Sequence numbers wrap, oldest is the furthest behind */
+        if(func_retval == NULL || (int8_t)(queue[index].sequence - func_retval->sequence) < 0)
+            func_retval = &queue[index];
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to initialize a duplicate window
+ * @param  *window : reference to duplicate window
+ *********************************************************/
+void init_sequence_window(net_sequence_window_t *window)
+{
+    window->newest = 0;
+    window->seen   = 0;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to check a received sequence number,
+ *         numbers older than COMMS_QOS_WINDOW count as
+ *         received
+ * @param  *window  : reference to duplicate window
+ * @param  sequence : received sequence number
+ * @retval uint8_t  : new: 1, duplicate: 0
+ *********************************************************/
+uint8_t comms_sequence_window(net_sequence_window_t *window, uint8_t sequence)
+{
+    uint8_t func_retval = 0;
+    uint8_t distance    = (uint8_t)(sequence - window->newest);
+
+    if(window->seen == 0)
+    {
+        /* First sequence number of the client */
+        window->newest = sequence;
+        window->seen   = 1;
+
+        func_retval = 1;
+    }
+    else if(distance != 0 && distance < 128)
+    {
+        /* Ahead of the newest, window slides */
+        window->seen   = distance < COMMS_QOS_WINDOW ? (uint16_t)((window->seen << distance) | 1) : 1;
+        window->newest = sequence;
+
+        func_retval = 1;
+    }
+    else
+    {
+        /* Behind the newest, inside the window and not seen yet */
+        distance = (uint8_t)(window->newest - sequence);
+
+        if(distance < COMMS_QOS_WINDOW && (window->seen & (1U << distance)) == 0)
+        {
+            window->seen |= (uint16_t)(1U << distance);
+
+            func_retval = 1;
+        }
+    }
+
+    return func_retval;
+}
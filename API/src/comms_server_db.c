@@ -53,6 +53,7 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -60,6 +61,343 @@
 
 
 
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Superframe frame offsets, one bit per offset of the longest period */
+#define CLIENT_SUPERFRAME_PHASES (1UL << COMMS_SUPERFRAME_LIMIT)
+
+
+/* Compile time check, offsets fit a 32 bit mask and superframe clients send within a keep alive period */
+typedef char client_superframe_check[(COMMS_SUPERFRAME_LIMIT <= 5 &&
+                                      CLIENT_SUPERFRAME_PHASES <= COMMS_KEEP_ALIVE_FRAMES / 2) ? 1 : -1];
+
+
+/* Compile time check, a wheel bucket holds only the clients expiring in its frame */
+typedef char client_wheel_size_check[((CLIENT_WHEEL_SIZE & (CLIENT_WHEEL_SIZE - 1)) == 0 &&
+                                      CLIENT_WHEEL_SIZE >= COMMS_KEEP_ALIVE_FRAMES && COMMS_KEEP_ALIVE_FRAMES > 0) ? 1 : -1];
+
+
+/* Compile time check, the registry indexes are read as aligned uint16_t and uint32_t words */
+typedef char client_registry_align_check[(offsetof(client_registry_t, id_index) % sizeof(uint16_t) == 0 &&
+                                          offsetof(client_registry_t, slot_map) % sizeof(uint32_t) == 0 &&
+                                          offsetof(client_registry_t, wheel) % sizeof(uint16_t) == 0) ? 1 : -1];
+
+
+/* Registry of the client_devices_t functions, single instance like the table constructor */
+static client_registry_t server_device_registry;
+static uint16_t          server_device_hash[CLIENT_HASH_SIZE];
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Private Functions                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+/****************************************************************
+ * @brief  Remove a device row from its keep alive wheel bucket
+ * @param  *registry : reference to the registry
+ * @param  row       : device row
+ ***************************************************************/
+static void client_wheel_unlink(client_registry_t *registry, uint16_t row)
+{
+    client_devices_t *device = &registry->rows[row];
+    uint16_t          bucket = (uint16_t)(device->heard_frame + COMMS_KEEP_ALIVE_FRAMES) & (CLIENT_WHEEL_SIZE - 1);
+
+    /* Row is linked when it has a previous row or heads its bucket */
+    if(device->wheel_prev != 0)
+        registry->rows[device->wheel_prev - 1].wheel_next = device->wheel_next;
+    else if(registry->wheel[bucket] == row + 1)
+        registry->wheel[bucket] = device->wheel_next;
+    else
+        return;
+
+    if(device->wheel_next != 0)
+        registry->rows[device->wheel_next - 1].wheel_prev = device->wheel_prev;
+
+    device->wheel_next = 0;
+    device->wheel_prev = 0;
+}
+
+
+
+/****************************************************************
+ * @brief  Mark a device row heard in the current wheel frame, keep
+ *         alive rows move to the bucket of their expiry frame
+ * @param  *registry : reference to the registry
+ * @param  row       : device row
+ ***************************************************************/
+static void client_wheel_touch(client_registry_t *registry, uint16_t row)
+{
+    client_devices_t *device = &registry->rows[row];
+    uint16_t          bucket = 0;
+
+    client_wheel_unlink(registry, row);
+
+    device->heard_frame = registry->wheel_frame;
+
+    if(device->client_states.keep_alive)
+    {
+        bucket = (uint16_t)(device->heard_frame + COMMS_KEEP_ALIVE_FRAMES) & (CLIENT_WHEEL_SIZE - 1);
+
+        device->wheel_next = registry->wheel[bucket];
+
+        if(device->wheel_next != 0)
+            registry->rows[device->wheel_next - 1].wheel_prev = row + 1;
+
+        registry->wheel[bucket] = row + 1;
+    }
+}
+
+
+
+/****************************************************************
+ * @brief  Hash bucket of a 48 bit mac address
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @retval uint16_t            : bucket index
+ ***************************************************************/
+static uint16_t client_mac_hash(client_registry_t *registry, const char *client_mac_address)
+{
+    const uint8_t *mac = (const uint8_t*)client_mac_address;
+    uint32_t       hash;
+
+    /* Fold 48 bits into 32, multiplicative mix, upper half carries the entropy */
+    hash  = (uint32_t)mac[0] | ((uint32_t)mac[1] << 8) | ((uint32_t)mac[2] << 16) | ((uint32_t)mac[3] << 24);
+    hash ^= ((uint32_t)mac[4] | ((uint32_t)mac[5] << 8)) * 0x85EBCA6BUL;
+    hash *= 0x9E3779B1UL;
+    hash ^= hash >> 16;
+
+    return (uint16_t)(hash & registry->hash_mask);
+}
+
+
+
+/****************************************************************
+ * @brief  Bucket holding a mac address or the empty bucket that
+ *         ends its probe sequence
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @retval uint16_t            : bucket index
+ ***************************************************************/
+static uint16_t client_mac_bucket(client_registry_t *registry, const char *client_mac_address)
+{
+    uint16_t bucket = client_mac_hash(registry, client_mac_address);
+    uint16_t row;
+
+    /* Linear probing, the table is never full so an empty bucket ends the loop */
+    while((row = registry->mac_index[bucket]) != 0)
+    {
+        if(memcmp(registry->rows[row - 1].client_mac, client_mac_address, 6) == 0)
+            break;
+
+        bucket = (bucket + 1) & registry->hash_mask;
+    }
+
+    return bucket;
+}
+
+
+
+
+/****************************************************************
+ * @brief  Mark or clear a run of slots in the slot bitmap
+ * @param  *registry : reference to the registry
+ * @param  first     : first slot number
+ * @param  count     : number of slots
+ * @param  used      : 1: mark used, 0: mark free
+ ***************************************************************/
+static void client_slots_mark(client_registry_t *registry, uint16_t first, uint16_t count, uint8_t used)
+{
+    uint16_t slot;
+
+    for(slot = first; slot < first + count && slot < CLIENT_ID_INDEX_SIZE; slot++)
+    {
+        if(used)
+            registry->slot_map[slot >> 5] |= 1UL << (slot & 31);
+        else
+            registry->slot_map[slot >> 5] &= ~(1UL << (slot & 31));
+    }
+}
+
+
+
+/****************************************************************
+ * @brief  Lowest run of free slots above the server slots
+ * @param  *registry : reference to the registry
+ * @param  count     : number of slots
+ * @retval uint8_t   : error: 0, success: first slot number
+ ***************************************************************/
+static uint8_t client_slots_alloc(client_registry_t *registry, uint16_t count)
+{
+    uint16_t slot  = registry->reserved_slots + 1;
+    uint16_t first = slot;
+    uint8_t  func_retval = 0;
+
+    while(slot < CLIENT_ID_INDEX_SIZE)
+    {
+        /* Skip full words while no run is open */
+        if(first == slot && (slot & 31) == 0 && registry->slot_map[slot >> 5] == 0xFFFFFFFFUL)
+        {
+            slot += 32;
+            first = slot;
+
+            continue;
+        }
+
+        /* First slot is the client id, ids of superframe clients are taken */
+        if((registry->slot_map[slot >> 5] & (1UL << (slot & 31))) ||
+           (first == slot && registry->id_index[slot] != 0))
+        {
+            first = slot + 1;
+        }
+        else if(slot + 1 - first == count)
+        {
+            func_retval = (uint8_t)first;
+
+            break;
+        }
+
+        slot++;
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Highest slot in use, frame length of the server
+ * @param  *registry : reference to the registry
+ * @retval uint8_t   : highest used slot or the server slots
+ ***************************************************************/
+static uint8_t client_slots_last(client_registry_t *registry)
+{
+    int16_t  word = CLIENT_SLOT_MAP_WORDS - 1;
+    uint8_t  bit  = 31;
+    uint8_t  func_retval = registry->reserved_slots;
+
+    while(word >= 0 && registry->slot_map[word] == 0)
+        word--;
+
+    if(word >= 0)
+    {
+        while((registry->slot_map[word] & (1UL << bit)) == 0)
+            bit--;
+
+        if(word * 32 + bit > func_retval)
+            func_retval = (uint8_t)(word * 32 + bit);
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Frame offsets of a superframe client, its offset
+ *         repeated with its period
+ * @param  period    : period 2^n frames
+ * @param  offset    : frame offset
+ * @retval uint32_t  : offset mask, bit n is frame offset n
+ ***************************************************************/
+static uint32_t client_superframe_offsets(uint8_t period, uint8_t offset)
+{
+    uint32_t func_retval = 0;
+    uint32_t phase;
+
+    for(phase = offset; phase < CLIENT_SUPERFRAME_PHASES; phase += 1UL << period)
+        func_retval |= 1UL << phase;
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Superframe slot and lowest free frame offset for a
+ *         period, first fit over the shared slots, a new shared
+ *         slot from the lowest free slot otherwise
+ * @param  *registry : reference to the registry
+ * @param  period    : period 2^n frames
+ * @param  *offset   : reference to frame offset
+ * @retval uint8_t   : error: 0, success: superframe slot number
+ ***************************************************************/
+static uint8_t client_superframe_alloc(client_registry_t *registry, uint8_t period, uint8_t *offset)
+{
+    uint8_t  func_retval = 0;
+    uint32_t pattern     = client_superframe_offsets(period, 0);
+    uint32_t used        = 0;
+    uint16_t slot;
+    uint32_t phase;
+
+    for(slot = registry->reserved_slots + 1; slot < CLIENT_ID_INDEX_SIZE && func_retval == 0; slot++)
+    {
+        if((used = registry->shared_offsets[slot]) == 0)
+            continue;
+
+        for(phase = 0; phase < (1UL << period); phase++)
+        {
+            if((used & (pattern << phase)) == 0)
+            {
+                *offset     = (uint8_t)phase;
+                func_retval = (uint8_t)slot;
+
+                break;
+            }
+        }
+    }
+
+    if(func_retval == 0)
+    {
+        func_retval = client_slots_alloc(registry, 1);
+
+        *offset = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Client id of a superframe client, highest id from
+ *         COMMS_SUPERFRAME_CLIENT_ID down that is neither a client
+ *         id nor a slot in use
+ * @param  *registry : reference to the registry
+ * @retval uint8_t   : error: 0, success: client id
+ ***************************************************************/
+static uint8_t client_superframe_id(client_registry_t *registry)
+{
+    uint8_t func_retval = 0;
+    uint8_t client_id;
+
+    for(client_id = COMMS_SUPERFRAME_CLIENT_ID; client_id > registry->reserved_slots; client_id--)
+    {
+        if(registry->id_index[client_id] == 0 &&
+           (registry->slot_map[client_id >> 5] & (1UL << (client_id & 31))) == 0)
+        {
+            func_retval = client_id;
+
+            break;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+
 /******************************************************************************/
 /*                                                                            */
 /*                           API Functions                                    */
@@ -80,138 +418,608 @@ client_devices_t* create_server_device_table(void)
 }
 
 
+
+/****************************************************************
+ * @brief  Initialize caller owned client device table
+ * @param  *device_table : table of CLIENT_TABLE_SIZE entries
+ * @retval client_devices_t* : error: NULL, success: device table
+ ***************************************************************/
+client_devices_t* init_server_device_table(client_devices_t *device_table)
+{
+    if(device_table != NULL)
+    {
+        memset(device_table, 0, sizeof(client_devices_t) * CLIENT_TABLE_SIZE);
+
+        /* Drop a stale index of the same table */
+        if(server_device_registry.rows == device_table)
+            server_device_registry.rows = NULL;
+    }
+
+    return device_table;
+}
+
+
+
+/****************************************************************
+ * @brief  Client registry constructor, caller owned storage
+ * @param  *registry  : reference to the registry
+ * @param  *rows      : device rows storage
+ * @param  capacity   : number of device rows (max INT16_MAX)
+ * @param  *mac_index : MAC hash bucket storage
+ * @param  hash_size  : number of buckets, power of two > capacity
+ * @retval int8_t     : error: -1, success: 0
+ ***************************************************************/
+int8_t init_client_registry(client_registry_t *registry, client_devices_t *rows, uint16_t capacity,
+                            uint16_t *mac_index, uint32_t hash_size)
+{
+    int8_t func_retval = 0;
+
+    if(registry == NULL || rows == NULL || mac_index == NULL || capacity == 0 || capacity > INT16_MAX ||
+       hash_size <= capacity || hash_size > 65536UL || (hash_size & (hash_size - 1)) != 0)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        memset(registry, 0, sizeof(client_registry_t));
+        memset(rows, 0, sizeof(client_devices_t) * capacity);
+        memset(mac_index, 0, sizeof(uint16_t) * hash_size);
+
+        registry->rows      = rows;
+        registry->mac_index = mac_index;
+        registry->capacity  = capacity;
+        registry->hash_mask = (uint16_t)(hash_size - 1);
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Registry of a CLIENT_TABLE_SIZE device table for the
+ *         client_devices_t functions (single instance, rows
+ *         already in the table are indexed when it changes)
+ * @param  *device_table : table of CLIENT_TABLE_SIZE entries
+ * @retval client_registry_t* : error: NULL, success: registry
+ ***************************************************************/
+client_registry_t* bind_server_device_table(client_devices_t *device_table)
+{
+    client_registry_t *registry = &server_device_registry;
+    uint16_t           row;
+    uint16_t           bucket;
+
+    if(device_table == NULL)
+    {
+        registry = NULL;
+    }
+    else if(registry->rows != device_table)
+    {
+        memset(registry, 0, sizeof(client_registry_t));
+        memset(server_device_hash, 0, sizeof(server_device_hash));
+
+        registry->rows      = device_table;
+        registry->mac_index = server_device_hash;
+        registry->capacity  = CLIENT_TABLE_SIZE;
+        registry->hash_mask = CLIENT_HASH_SIZE - 1;
+
+        /* Index rows written before the table was bound */
+        for(row = 0; row < CLIENT_TABLE_SIZE; row++)
+        {
+            if(device_table[row].client_id == 0)
+                continue;
+
+            bucket = client_mac_bucket(registry, device_table[row].client_mac);
+
+            registry->mac_index[bucket] = row + 1;
+            registry->id_index[device_table[row].client_id] = row + 1;
+            registry->count++;
+
+            /* Keep alive clients are heard at the first frame of the wheel */
+            device_table[row].wheel_next = 0;
+            device_table[row].wheel_prev = 0;
+
+            client_wheel_touch(registry, row);
+
+            if(device_table[row].client_slot)
+            {
+                client_slots_mark(registry, device_table[row].client_slot, 1, 1);
+
+                registry->shared_offsets[device_table[row].client_slot] |=
+                    client_superframe_offsets(device_table[row].client_period, device_table[row].client_offset);
+            }
+            else
+            {
+                client_slots_mark(registry, device_table[row].client_id,
+                                  device_table[row].client_number_of_slots > 1 ? device_table[row].client_number_of_slots : 1, 1);
+            }
+        }
+    }
+
+    return registry;
+}
+
+
+
+/****************************************************************
+ * @brief  Add a device row to the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @param  client_id           : client id, 1 - 255
+ * @retval int16_t             : error: -1, -2: table full,
+ *                               -3: duplicate MAC address,
+ *                               success: row index
+ ***************************************************************/
+int16_t client_registry_add(client_registry_t *registry, const char *client_mac_address, uint8_t client_id)
+{
+    int16_t  func_retval = 0;
+    uint16_t bucket      = 0;
+    uint16_t row         = 0;
+
+    if(registry == NULL || registry->rows == NULL || client_mac_address == NULL || client_id == 0)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        bucket = client_mac_bucket(registry, client_mac_address);
+
+        if(registry->mac_index[bucket] != 0)
+        {
+            func_retval = -3;
+        }
+        else if(registry->count >= registry->capacity)
+        {
+            func_retval = -2;
+        }
+        else
+        {
+            /* Lowest free row, rows below the hint are in use */
+            row = registry->free_hint;
+
+            while(registry->rows[row].client_id != 0)
+                row++;
+
+            memset(&registry->rows[row], 0, sizeof(client_devices_t));
+            memcpy(registry->rows[row].client_mac, client_mac_address, 6);
+
+            registry->rows[row].client_id = client_id;
+
+            registry->mac_index[bucket] = row + 1;
+
+            registry->id_index[client_id] = row + 1;
+
+            registry->count++;
+            registry->free_hint = row + 1;
+
+            func_retval = (int16_t)row;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Remove a device row from the registry
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @retval int8_t              : error: -1, success: 0
+ ***************************************************************/
+int8_t client_registry_remove(client_registry_t *registry, const char *client_mac_address)
+{
+    int8_t   func_retval = 0;
+    uint16_t bucket      = 0;
+    uint16_t next        = 0;
+    uint16_t home        = 0;
+    uint16_t row         = 0;
+
+    if(registry == NULL || registry->rows == NULL || client_mac_address == NULL)
+    {
+        func_retval = -1;
+    }
+    else if(registry->mac_index[(bucket = client_mac_bucket(registry, client_mac_address))] == 0)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        row = registry->mac_index[bucket] - 1;
+
+        client_wheel_unlink(registry, row);
+
+        if(registry->id_index[registry->rows[row].client_id] == row + 1)
+            registry->id_index[registry->rows[row].client_id] = 0;
+
+        memset(&registry->rows[row], 0, sizeof(client_devices_t));
+
+        registry->mac_index[bucket] = 0;
+
+        /* Backward shift deletion, move later entries of the probe run into the hole */
+        next = (bucket + 1) & registry->hash_mask;
+
+        while(registry->mac_index[next] != 0)
+        {
+            home = client_mac_hash(registry, registry->rows[registry->mac_index[next] - 1].client_mac);
+
+            /* Entry may move if its home bucket is not inside (bucket, next] */
+            if(((next - home) & registry->hash_mask) >= ((next - bucket) & registry->hash_mask))
+            {
+                registry->mac_index[bucket] = registry->mac_index[next];
+                registry->mac_index[next]   = 0;
+
+                bucket = next;
+            }
+
+            next = (next + 1) & registry->hash_mask;
+        }
+
+        registry->count--;
+
+        if(row < registry->free_hint)
+            registry->free_hint = row;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Find device row by mac address
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address (6 bytes)
+ * @retval int16_t             : error: -1, success: row index
+ ***************************************************************/
+int16_t client_registry_find_mac(client_registry_t *registry, const char *client_mac_address)
+{
+    int16_t func_retval = -1;
+
+    if(registry != NULL && registry->rows != NULL && client_mac_address != NULL)
+        func_retval = (int16_t)registry->mac_index[client_mac_bucket(registry, client_mac_address)] - 1;
+
+    return func_retval;
+}
+
+
+
+/****************************************************************
+ * @brief  Find device row by client id
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id
+ * @retval int16_t    : error: -1, success: row index
+ ***************************************************************/
+int16_t client_registry_find_id(client_registry_t *registry, uint8_t client_id)
+{
+    int16_t func_retval = -1;
+
+    if(registry != NULL && registry->rows != NULL && client_id != 0)
+        func_retval = (int16_t)registry->id_index[client_id] - 1;
+
+    return func_retval;
+}
+
+
+
 /*****************************************************************************
- * @brief  Function write to client device table
- * @param  *device_table       : reference to the device table
+ * @brief  Function to admit a client to the registry
+ * @param  *registry           : reference to the registry
  * @param  *client_mac_address : client mac address
  * @param  requested_slots     : requested slots by the client
  * @param  server              : reference to the protocol handle structure
  * @retval int8_t              : error: -2 : JOINRESP_NACK, -3: JOINRESP_DUP,
  *                               success: table current index
  *****************************************************************************/
-table_retval_t update_server_device_table(client_devices_t *device_table, char *client_mac_address, uint8_t requested_slots, device_config_t *server)
+table_retval_t update_client_registry(client_registry_t *registry, char *client_mac_address, uint8_t requested_slots,
+                                      device_config_t *server)
 {
-    table_retval_t return_value;
+    return update_client_registry_period(registry, client_mac_address, requested_slots, 0, server);
+}
 
-    uint8_t index = 0;
-    uint8_t found = 0;
 
 
-    /* Lock client table */
-    device_table->client_table_lock = 1;
+/*****************************************************************************
+ * @brief  Function to admit a client with a reporting period to the registry,
+ *         clients with a period of 2^n frames share a superframe slot at
+ *         different frame offsets and get a client id from
+ *         COMMS_SUPERFRAME_CLIENT_ID down, period 0 owns slots every frame
+ * @param  *registry           : reference to the registry
+ * @param  *client_mac_address : client mac address
+ * @param  requested_slots     : requested slots by the client, period 0 only
+ * @param  period              : period 2^n frames, up to COMMS_SUPERFRAME_LIMIT
+ * @param  server              : reference to the protocol handle structure
+ * @retval int8_t              : error: -2 : JOINRESP_NACK, -3: JOINRESP_DUP,
+ *                               success: table current index
+ *****************************************************************************/
+table_retval_t update_client_registry_period(client_registry_t *registry, char *client_mac_address, uint8_t requested_slots,
+                                             uint8_t period, device_config_t *server)
+{
+    /* Table full is reported as JOINRESP_NACK */
+    table_retval_t return_value = {0, -2};
+
+    int16_t row        = 0;
+    uint8_t slot_count = requested_slots > 1 ? requested_slots : 1;
+    uint8_t first_slot = 0;
+    uint8_t client_id  = 0;
+    uint8_t offset     = 0;
 
 
     /* Error check */
-    if(device_table == NULL || client_mac_address == NULL || server == NULL )
+    if(registry == NULL || registry->rows == NULL || client_mac_address == NULL || server == NULL )
     {
         return_value.table_retval = -1;
     }
-    else if(requested_slots > COMMS_SERVER_MAX_SLOTS)
+    else if(requested_slots > COMMS_SERVER_MAX_SLOTS || period > COMMS_SUPERFRAME_LIMIT)
     {
         return_value.table_retval = -2;
     }
+    else if((row = client_registry_find_mac(registry, client_mac_address)) >= 0)
+    {
+        /* Request for already present device */
+        return_value.table_retval = -3;
+
+        return_value.table_index = (uint16_t)row;
+
+        client_wheel_touch(registry, (uint16_t)row);
+    }
     else
     {
-        /* get data from join request */
-        for(index = 0; index < CLIENT_TABLE_SIZE; index++)
+        /* Lock client table */
+        registry->rows->client_table_lock = 1;
+
+        /* Slots up to the server starting total slots are never given out */
+        if(registry->reserved_slots == 0)
         {
-            if(strncmp(device_table[index].client_mac, client_mac_address, 6) == 0)
-            {
-                found = 1;
+            registry->reserved_slots = server->total_slots;
 
-                /* Request for already present device */
-                return_value.table_retval = -3;
+            client_slots_mark(registry, 1, registry->reserved_slots, 1);
+        }
 
-                return_value.table_index = index;
+        if(period)
+        {
+            /* Superframe slot shared at another frame offset, the client id is not a slot */
+            first_slot = client_superframe_alloc(registry, period, &offset);
+            client_id  = client_superframe_id(registry);
 
+            slot_count = 1;
+        }
+        else
+        {
+            /* Lowest free run, slots of released clients are reused */
+            first_slot = client_slots_alloc(registry, slot_count);
+            client_id  = first_slot;
+        }
 
-                break;
-            }
-            else if(device_table[index].client_id == 0) /* Fill the next available row */
+        if(first_slot != 0 && client_id != 0)
+            row = client_registry_add(registry, client_mac_address, client_id);
+        else
+            row = -2;
+
+        if(row >= 0)
+        {
+            client_slots_mark(registry, first_slot, slot_count, 1);
+
+            if(period)
             {
-                found = 0;
+                registry->shared_offsets[first_slot] |= client_superframe_offsets(period, offset);
 
-                /* Add new device ID to table */
-                device_table[index].client_id = server->total_slots + 1;
+                registry->rows[row].client_slot   = first_slot;
+                registry->rows[row].client_period = period;
+                registry->rows[row].client_offset = offset;
+            }
 
-                /* Add MAC address to table */
-                memcpy(device_table[index].client_mac, client_mac_address, 6);
+            /* Frame ends at the highest slot in use */
+            server->total_slots = client_slots_last(registry);
 
-                /* Update slot */
-                if(requested_slots > 1)
-                {
-                    server->total_slots += requested_slots;
-                }
-                else
-                {
-                    server->total_slots++;
-                }
+            /* Add client slots to table */
+            registry->rows[row].client_number_of_slots = period ? 1 : requested_slots;
 
-                /* Add client slots to table */
-                device_table[index].client_number_of_slots = requested_slots;
+            client_wheel_touch(registry, (uint16_t)row);
 
+            /* update device count */
+            server->device_count++;
 
-                /* update device count */
-                server->device_count++;
+            /* return client ID */
+            return_value.table_index = (uint16_t)row;
 
-                /* return client ID */
-                return_value.table_index = index;
+            return_value.table_retval = 0;
+        }
 
-                return_value.table_retval = 0;
+        /* unlock client table */
+        registry->rows->client_table_lock = 0;
+    }
 
-                break;
-            }
 
-        }
+    return return_value;
+}
+
+
+
+/*****************************************************************
+ * @brief  Function to release a client and its slots, frame length
+ *         shrinks to the highest slot still in use
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id (first slot of the client)
+ * @param  server     : reference to the server device structure
+ * @retval int8_t     : error: -1, success: 0
+ ****************************************************************/
+int8_t release_client_registry(client_registry_t *registry, uint8_t client_id, device_config_t *server)
+{
+    int8_t  func_retval = 0;
+    int16_t row         = client_registry_find_id(registry, client_id);
+    uint8_t slot_count  = 0;
+    uint8_t shared_slot = 0;
+
+    if(row < 0 || server == NULL)
+    {
+        func_retval = -1;
     }
+    else
+    {
+        /* Lock client table */
+        registry->rows->client_table_lock = 1;
 
+        slot_count  = registry->rows[row].client_number_of_slots > 1 ? registry->rows[row].client_number_of_slots : 1;
+        shared_slot = registry->rows[row].client_slot;
 
-    /* unlock client table */
-    device_table->client_table_lock = 0;
+        if(shared_slot == 0)
+            client_slots_mark(registry, client_id, slot_count, 0);
+        else
+            registry->shared_offsets[shared_slot] &= ~client_superframe_offsets(registry->rows[row].client_period,
+                                                                                registry->rows[row].client_offset);
 
+        client_registry_remove(registry, registry->rows[row].client_mac);
 
-    return return_value;
+        /* Superframe slot is free with its last client */
+        if(shared_slot != 0 && registry->shared_offsets[shared_slot] == 0)
+            client_slots_mark(registry, shared_slot, 1, 0);
+
+        server->total_slots = client_slots_last(registry);
+
+        if(server->device_count)
+            server->device_count--;
+
+        /* unlock client table */
+        registry->rows->client_table_lock = 0;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
 }
 
 
 
+/*****************************************************************
+ * @brief  Function to mark a client heard in this frame, keep alive
+ *         clients expire COMMS_KEEP_ALIVE_FRAMES frames later
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id
+ * @retval int8_t     : error: -1, success: 0
+ ****************************************************************/
+int8_t touch_client_registry(client_registry_t *registry, uint8_t client_id)
+{
+    int8_t  func_retval = -1;
+    int16_t row         = client_registry_find_id(registry, client_id);
+
+    if(row >= 0)
+    {
+        client_wheel_touch(registry, (uint16_t)row);
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
 
 /*****************************************************************
- * @brief  Function read from index value of the device table
- * @param  *device_table       : reference to the device table
+ * @brief  Function to check the sequence number of a QoS 1 STATUS
+ *         message against the duplicate window of the client
+ * @param  *registry  : reference to the registry
+ * @param  client_id  : client id
+ * @param  sequence   : STATUS sequence number
+ * @retval int8_t     : error: -1, duplicate: 0, new: 1
+ ****************************************************************/
+int8_t sequence_client_registry(client_registry_t *registry, uint8_t client_id, uint8_t sequence)
+{
+    int8_t  func_retval = -1;
+    int16_t row         = client_registry_find_id(registry, client_id);
+
+    if(row >= 0)
+        func_retval = (int8_t)comms_sequence_window(&registry->rows[row].client_sequence, sequence);
+
+    return func_retval;
+}
+
+
+
+/*****************************************************************
+ * @brief  Function to advance the keep alive wheel by one frame,
+ *         releases the keep alive clients not heard for
+ *         COMMS_KEEP_ALIVE_FRAMES frames, call once per SYNC
+ * @param  *registry    : reference to the registry
+ * @param  server       : reference to the server device structure
+ * @param  *expired_map : CLIENT_SLOT_MAP_WORDS words, bit n set for
+ *                        released client id n, NULL: not reported
+ * @retval int16_t      : error: -1, success: number of released clients
+ ****************************************************************/
+int16_t expire_client_registry(client_registry_t *registry, device_config_t *server, uint32_t *expired_map)
+{
+    int16_t  func_retval = 0;
+    uint16_t bucket      = 0;
+    uint16_t row         = 0;
+    uint8_t  client_id   = 0;
+
+    if(registry == NULL || registry->rows == NULL || server == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        registry->wheel_frame++;
+
+        bucket = registry->wheel_frame & (CLIENT_WHEEL_SIZE - 1);
+
+        /* Rows heard since moved to a later bucket, the bucket holds only expired rows */
+        while(registry->wheel[bucket] != 0)
+        {
+            row       = registry->wheel[bucket] - 1;
+            client_id = registry->rows[row].client_id;
+
+            if(release_client_registry(registry, client_id, server) == 0)
+            {
+                if(expired_map != NULL)
+                    expired_map[client_id >> 5] |= 1UL << (client_id & 31);
+
+                func_retval++;
+            }
+            else
+            {
+                client_wheel_unlink(registry, row);
+            }
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/*****************************************************************
+ * @brief  Function read from row index of the registry
+ * @param  *registry           : reference to the registry
  * @param  *client_mac_address : client mac address
  * @param  *client_id          : reference to client ID variable
- * @param  table index         : table index value
+ * @param  table index         : row index value
  * @retval int8_t              : error = -4, success = 0
  ****************************************************************/
-int8_t read_client_table(client_devices_t *device_table, char *client_mac_address, int8_t *client_id,  int16_t table_index)
+int8_t read_client_registry(client_registry_t *registry, char *client_mac_address, int8_t *client_id, int16_t table_index)
 {
     int8_t func_retval;
 
 
-    /* Lock client table */
-    device_table->client_table_lock = 1;
-
-    if(table_index < 0)
+    if(registry == NULL || table_index < 0 || table_index >= registry->capacity)
     {
-        //strncpy(client_mac_address, device_table[table_index].client_mac, 6);
-        *client_id = table_index;
+        *client_id = (int8_t)table_index;
 
         func_retval = -4;
     }
     else
     {
-        strncpy(client_mac_address, device_table[table_index].client_mac, 6);
-        *client_id = device_table[table_index].client_id;
+        memcpy(client_mac_address, registry->rows[table_index].client_mac, 6);
+        *client_id = registry->rows[table_index].client_id;
 
         func_retval = 0;
 
     }
 
-
-    /* unlock client table */
-    device_table->client_table_lock = 0;
-
     return func_retval;
 
 }
@@ -219,75 +1027,86 @@ int8_t read_client_table(client_devices_t *device_table, char *client_mac_addres
 
 
 /*******************************************************************
- * @brief  Function to find device in client device table
- * @param  *device_table       : reference to the device table
+ * @brief  Function to find device in the registry
+ * @param  *registry           : reference to the registry
  * @param  *client_id          : reference to client ID variable
  * @param  *client_mac_address : client mac address
  * @param  search_mode         : search by client id or mac address
  * @retval int8_t              : error = 0, success = 1
  *******************************************************************/
-int8_t find_client_device(client_devices_t *device_table, uint8_t *client_id, char *client_mac_address, uint8_t search_mode)
+int8_t find_registry_device(client_registry_t *registry, uint8_t *client_id, char *client_mac_address, uint8_t search_mode)
 {
-    int8_t func_retval = 0;
-
-    uint8_t index = 0;
-
+    int8_t  func_retval = 0;
+    int16_t row         = -1;
 
-    /* Lock client table */
-    device_table->client_table_lock = 1;
 
-    for(index=0; index < CLIENT_TABLE_SIZE; index++)
+    /* Search by client id */
+    if(search_mode == FIND_BY_ID)
     {
+        row = client_registry_find_id(registry, *client_id);
 
-        /* Search by client id */
-        if(search_mode == FIND_BY_ID)
-        {
-            if(device_table[index].client_id == *client_id)
-            {
-                func_retval = 1;
-
-                strncpy(client_mac_address, device_table[index].client_mac, 6);
-
-                break;
-            }
-            else
-            {
-                func_retval = 0;
-            }
-
-        }
-        /* Search my mac-address */
-        else if(search_mode == FIND_BY_MAC)
-        {
-            if(strncmp(device_table[index].client_mac, client_mac_address, 6) == 0)
-            {
-                func_retval = 1;
-
-                *client_id = device_table[index].client_id;
+        if(row >= 0)
+            memcpy(client_mac_address, registry->rows[row].client_mac, 6);
+    }
+    /* Search my mac-address */
+    else if(search_mode == FIND_BY_MAC)
+    {
+        row = client_registry_find_mac(registry, client_mac_address);
 
-                break;
-            }
-            else
-            {
-                func_retval = 0;
-            }
+        if(row >= 0)
+            *client_id = registry->rows[row].client_id;
+    }
 
-        }
+    func_retval = row >= 0 ? 1 : 0;
 
+    return func_retval;
 
-    }
+}
 
-    /* unlock client table */
-    device_table->client_table_lock = 0;
 
 
-    return func_retval;
 
+/*****************************************************************************
+ * @brief  Function write to client device table
+ * @param  *device_table       : reference to the device table
+ * @param  *client_mac_address : client mac address
+ * @param  requested_slots     : requested slots by the client
+ * @param  server              : reference to the protocol handle structure
+ * @retval int8_t              : error: -2 : JOINRESP_NACK, -3: JOINRESP_DUP,
+ *                               success: table current index
+ *****************************************************************************/
+table_retval_t update_server_device_table(client_devices_t *device_table, char *client_mac_address, uint8_t requested_slots, device_config_t *server)
+{
+    return update_client_registry(bind_server_device_table(device_table), client_mac_address, requested_slots, server);
 }
 
 
 
 
+/*****************************************************************
+ * @brief  Function read from index value of the device table
+ * @param  *device_table       : reference to the device table
+ * @param  *client_mac_address : client mac address
+ * @param  *client_id          : reference to client ID variable
+ * @param  table index         : table index value
+ * @retval int8_t              : error = -4, success = 0
+ ****************************************************************/
+int8_t read_client_table(client_devices_t *device_table, char *client_mac_address, int8_t *client_id,  int16_t table_index)
+{
+    return read_client_registry(bind_server_device_table(device_table), client_mac_address, client_id, table_index);
+}
 
 
 
+/*******************************************************************
+ * @brief  Function to find device in client device table
+ * @param  *device_table       : reference to the device table
+ * @param  *client_id          : reference to client ID variable
+ * @param  *client_mac_address : client mac address
+ * @param  search_mode         : search by client id or mac address
+ * @retval int8_t              : error = 0, success = 1
+ *******************************************************************/
+int8_t find_client_device(client_devices_t *device_table, uint8_t *client_id, char *client_mac_address, uint8_t search_mode)
+{
+    return find_registry_device(bind_server_device_table(device_table), client_id, client_mac_address, search_mode);
+}
@@ -44,7 +44,10 @@
 /*
  * Standard Header and API Header files
  */
+#include <stddef.h>
+
 #include <comms_server_fsm.h>
+#include <comms_frame.h>
 
 
 
@@ -69,11 +72,27 @@ typedef enum fsm_state_values
     CONTROLMSG_STATE   = 6,
     EVENTMSG_STATE     = 7,
     TIMEOUT_STATE      = 8,
-    EXIT_STATE         = 9
+    EXIT_STATE         = 9,
+    MAILBOX_STATE      = 11
 
 }fsm_states_t;
 
 
+/* Compile time check, registry mac_index points at the context hash buckets as uint16_t */
+typedef char server_context_align_check[(offsetof(comms_server_context_t, client_hash) % sizeof(uint16_t) == 0 &&
+                                         offsetof(comms_server_context_t, client_registry) % sizeof(void *) == 0) ? 1 : -1];
+
+
+/* Join backlog estimate in 1/16 clients, a collision adds 1 / (e - 2) clients */
+#define COMMS_JOIN_LOAD_ONE        16
+#define COMMS_JOIN_LOAD_COLLISION  22
+#define COMMS_JOIN_LOAD_MAX        (255 * COMMS_JOIN_LOAD_ONE)
+
+
+/* CONTRL message to a client whose STATUS message finds the gateway disconnected */
+#define SERVER_GATEWAY_OFFLINE     "Gateway Offline"
+
+
 
 
 /******************************************************************************/
@@ -84,28 +103,707 @@ typedef enum fsm_state_values
 
 
 
+/**************************************************************************
+ * @brief  Update the join load hint of the next SYNC message, pseudo-Bayesian
+ *         backlog estimate of slotted ALOHA from the outcome of the access
+ *         slots of the last frame: received JOINREQ (successes), damaged
+ *         frames (collisions, two frames each) or neither (idle). Clients
+ *         send a JOINREQ with p = access slots / hint per frame
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @retval uint8_t           : estimated collided access slots
+ **************************************************************************/
+static uint8_t server_join_load(comms_server_fsm_t *fsm, access_control_t *wireless_network)
+{
+    uint32_t join_requests = wireless_network->metrics.frames_rx[COMMS_JOINREQ_MESSAGE];
+    uint16_t join_errors   = wireless_network->metrics.checksum_errors + wireless_network->metrics.length_errors;
+    uint32_t successes     = join_requests - fsm->join_requests;
+    uint16_t collisions    = (uint16_t)(join_errors - fsm->join_errors) / 2;
+    uint32_t decrement     = 0;
+
+    /* One collision at least in a frame of only damaged frames */
+    if(successes == 0 && join_errors != fsm->join_errors && collisions == 0)
+        collisions = 1;
+
+    /* Access slots left after the successes */
+    if(successes >= wireless_network->access_slots)
+        collisions = 0;
+    else if(collisions > wireless_network->access_slots - successes)
+        collisions = wireless_network->access_slots - successes;
+
+    if(collisions == 0)
+    {
+        /* Successes or idle, one contender less per success, idle counts as one */
+        decrement = successes ? successes * COMMS_JOIN_LOAD_ONE : COMMS_JOIN_LOAD_ONE;
+
+        fsm->join_backlog = fsm->join_backlog > decrement ? fsm->join_backlog - decrement : 0;
+    }
+    else
+    {
+        /* Collisions, two contenders at least */
+        decrement = successes * COMMS_JOIN_LOAD_ONE;
 
+        fsm->join_backlog  = fsm->join_backlog > decrement ? fsm->join_backlog - decrement : 0;
+        fsm->join_backlog += collisions * COMMS_JOIN_LOAD_COLLISION;
 
-/******************************************************************************/
-/*                                                                            */
-/*                           API Functions                                    */
-/*                                                                            */
-/******************************************************************************/
+        if(fsm->join_backlog < 2 * COMMS_JOIN_LOAD_ONE)
+            fsm->join_backlog = 2 * COMMS_JOIN_LOAD_ONE;
 
+        if(fsm->join_backlog > COMMS_JOIN_LOAD_MAX)
+            fsm->join_backlog = COMMS_JOIN_LOAD_MAX;
+    }
+
+    fsm->join_requests = join_requests;
+    fsm->join_errors   = join_errors;
+
+    wireless_network->join_load = (fsm->join_backlog + COMMS_JOIN_LOAD_ONE - 1) / COMMS_JOIN_LOAD_ONE;
+
+    return (uint8_t)collisions;
+}
 
 
 
 /**************************************************************************
- * @brief  Server State Machine Start Function
+ * @brief  Update the access slots of the next SYNC message, every
+ *         COMMS_ACCESS_ADAPT_FRAMES frames the count doubles after
+ *         collisions with more contenders than access slots and halves
+ *         when the join load hint fits in half of the access slots, up
+ *         to total slots / COMMS_ACCESS_FRAME_SHARE. One access slot is
+ *         the access slot number, more are placed behind the client slots
+ * @param  *fsm              : reference to state machine persistent values
  * @param  *wireless_network : reference to network access handle
  * @param  *server_device    : reference to device configuration structure
+ * @param  collisions        : collided access slots of the last frame
+ **************************************************************************/
+static void server_access_slots(comms_server_fsm_t *fsm, access_control_t *wireless_network,
+                                device_config_t *server_device, uint8_t collisions)
+{
+    uint8_t access_slots = wireless_network->access_slots;
+    uint8_t slots_max    = server_device->total_slots / COMMS_ACCESS_FRAME_SHARE;
+
+    /* Access slots lengthen the frame, at most a share of the frame */
+    if(slots_max > fsm->access_slots_max)
+        slots_max = fsm->access_slots_max;
+
+    if(slots_max == 0)
+        slots_max = 1;
+
+    if(fsm->access_collisions + collisions <= 255)
+        fsm->access_collisions += collisions;
+
+    if(++fsm->access_frames >= COMMS_ACCESS_ADAPT_FRAMES)
+    {
+        if(fsm->access_collisions > 0 && wireless_network->join_load > access_slots &&
+           access_slots < slots_max)
+        {
+            access_slots = access_slots * 2 < slots_max ? access_slots * 2 : slots_max;
+        }
+        else if(access_slots > 1 && wireless_network->join_load * 2 <= access_slots)
+        {
+            access_slots = access_slots / 2;
+        }
+
+        fsm->access_frames     = 0;
+        fsm->access_collisions = 0;
+    }
+
+    /* Frame shrinks with released client slots */
+    if(access_slots > slots_max)
+        access_slots = slots_max;
+
+    /* Hold the access slot count while the frame has no room behind the client slots */
+    if(access_slots > 1 && server_device->total_slots + access_slots > 255)
+        access_slots = 1;
+
+    wireless_network->access_slot = access_slots > 1 ? server_device->total_slots + 1 : COMMS_ACCESS_SLOTNUM;
+
+    /* Frame length follows the access slots with the SYNC message */
+    wireless_network->access_slots = access_slots;
+}
+
+
+
+/**************************************************************************
+ * @brief  Handle client notifications for the server, release slots and
+ *         held CONTRL messages of unjoined and hibernating clients
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *client_registry  : reference to server client device registry
+ * @param  status_type       : STATUS frame message type
+ * @param  source_client_id  : STATUS frame source client id
+ * @retval uint8_t           : notification = 1, STATUS message = 0
+ **************************************************************************/
+static uint8_t server_status_notify(comms_server_fsm_t *fsm, device_config_t *server_device, client_registry_t *client_registry,
+                                    uint8_t status_type, uint8_t source_client_id)
+{
+    uint8_t func_retval = 0;
+
+    if(status_type == COMMS_UNJOIN_MESSAGE || status_type == COMMS_HIBERNATE_MESSAGE ||
+       status_type == COMMS_KEEPALIVE_MESSAGE)
+    {
+        /* Release slots, frame shrinks with the next SYNC message when the highest slots are free */
+        if(status_type != COMMS_KEEPALIVE_MESSAGE)
+        {
+            release_client_registry(client_registry, source_client_id, server_device);
+
+            comms_mailbox_release(&fsm->mailbox, source_client_id);
+        }
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Decode an encoded STATUS payload into the STATUS message buffer,
+ *         unless it is relayed encoded to a client with codec support
+ * @param  *fsm            : reference to state machine persistent values
+ * @param  *client_registry: reference to server client device registry
+ * @param  relay_encoded   : CONTRL message can carry the codec
+ **************************************************************************/
+static void server_status_decode(comms_server_fsm_t *fsm, client_registry_t *client_registry, uint8_t relay_encoded)
+{
+    char    payload[NET_DATA_LENGTH] = {0};
+    int16_t payload_length           = 0;
+    int16_t row                      = -1;
+
+    if(fsm->status_codec == COMMS_CODEC_NONE)
+        return;
+
+    /* Destination decodes, echo prefix and not found replies are raw */
+    if(relay_encoded && fsm->destination_client_id > 1)
+    {
+        row = client_registry_find_id(client_registry, fsm->destination_client_id);
+
+        if(row >= 0 && client_registry->rows[row].client_states.codec)
+            return;
+    }
+
+    payload_length = comms_codec_decode(fsm->status_codec, fsm->status_payload,
+                                        fsm->status_message_length > 0 ? fsm->status_message_length : 0,
+                                        payload, sizeof(payload) - 1);
+
+    if(payload_length < 0)
+        payload_length = 0;
+
+    memset(fsm->status_message_buffer, 0, sizeof(fsm->status_message_buffer));
+    memcpy(fsm->status_message_buffer, payload, (size_t)payload_length);
+
+    fsm->status_payload        = fsm->status_message_buffer;
+    fsm->status_message_length = payload_length;
+    fsm->status_codec          = COMMS_CODEC_NONE;
+}
+
+
+
+/**************************************************************************
+ * @brief  Read the sequence number in front of the payload of a STATUS
+ *         message of a QoS 1 client and check it against the duplicate
+ *         window of the client, the SYNC ack bitmap acknowledges it
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client_registry  : reference to server client device registry
+ * @retval uint8_t           : retransmission relayed already = 1, relay = 0
+ **************************************************************************/
+static uint8_t server_status_qos(comms_server_fsm_t *fsm, access_control_t *wireless_network, client_registry_t *client_registry)
+{
+    uint8_t func_retval = 0;
+    uint8_t sequence    = 0;
+    int16_t row         = client_registry_find_id(client_registry, fsm->source_client_id);
+
+    if(row < 0 || client_registry->rows[row].client_states.qos == 0 || fsm->status_message_length < COMMS_QOS_SEQUENCE_SIZE)
+        return func_retval;
+
+    sequence = (uint8_t)fsm->status_payload[0];
+
+    fsm->status_payload        += COMMS_QOS_SEQUENCE_SIZE;
+    fsm->status_message_length -= COMMS_QOS_SEQUENCE_SIZE;
+
+    if(sequence_client_registry(client_registry, fsm->source_client_id, sequence) == 0)
+    {
+        wireless_network->metrics.qos_duplicates++;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Acknowledge a queued STATUS message in the ack bitmap of the
+ *         next SYNC message, once per frame and only for a joined QoS 1
+ *         source of this network, a duplicate is acknowledged again as
+ *         its ack was lost
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *client_registry  : reference to server client device registry
+ * @param  *event            : queued STATUS message event
+ **************************************************************************/
+static void server_status_ack(access_control_t *wireless_network, device_config_t *server_device,
+                              client_registry_t *client_registry, net_event_t *event)
+{
+    uint8_t source_id = comms_status_get_message_slot_number(event->data);
+    int16_t row       = -1;
+
+    if(event->acked || comms_frame_get_type(event->data) != COMMS_STATUS_MESSAGE ||
+       comms_status_get_network_id(event->data) != server_device->device_network_id)
+        return;
+
+    event->acked = 1;
+
+    row = client_registry_find_id(client_registry, source_id);
+
+    if(row >= 0 && client_registry->rows[row].client_states.qos && source_id < 8 * sizeof(wireless_network->status_acks))
+        wireless_network->status_acks[source_id / 8] |= 1 << (source_id % 8);
+}
+
+
+
+/**************************************************************************
+ * @brief  Hold the STATUS message for a low power destination in the
+ *         mailbox, a SYNC message announces it before the broadcast slot
+ *         the sleeping client listens to
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client_registry  : reference to server client device registry
+ * @retval uint8_t           : held or dropped = 1, relay = 0
+ **************************************************************************/
+static uint8_t server_status_mailbox(comms_server_fsm_t *fsm, access_control_t *wireless_network, client_registry_t *client_registry)
+{
+    uint8_t func_retval = 0;
+    int16_t row         = client_registry_find_id(client_registry, fsm->destination_client_id);
+
+    if(row >= 0 && client_registry->rows[row].client_states.low_power)
+    {
+        /* Held messages go out as CONTRL messages of their own */
+        server_status_decode(fsm, client_registry, 1);
+
+        if(comms_mailbox_add(&fsm->mailbox, fsm->destination_client_id, fsm->source_client_id, fsm->status_codec,
+                             fsm->status_fragment, fsm->status_payload,
+                             fsm->status_message_length > 0 ? fsm->status_message_length : 0) == 0)
+            wireless_network->metrics.mailbox_held++;
+        else
+            wireless_network->metrics.mailbox_dropped++;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Mark the sources of the client frames received in the last
+ *         frame heard, before the state machine reads them from the queue
+ * @param  *wireless_network : reference to network access handle
+ * @param  *client_registry  : reference to server client device registry
+ **************************************************************************/
+static void server_heard_clients(access_control_t *wireless_network, client_registry_t *client_registry)
+{
+    uint8_t index = 0;
+    uint8_t bit   = 0;
+
+    for(index = 0; index < sizeof(wireless_network->clients_heard); index++)
+    {
+        if(wireless_network->clients_heard[index] == 0)
+            continue;
+
+        for(bit = 0; bit < 8; bit++)
+        {
+            if(wireless_network->clients_heard[index] & (1 << bit))
+                touch_client_registry(client_registry, (uint8_t)(index * 8 + bit));
+        }
+    }
+
+    memset(wireless_network->clients_heard, 0, sizeof(wireless_network->clients_heard));
+}
+
+
+
+/**************************************************************************
+ * @brief  Release the keep alive clients not heard for
+ *         COMMS_KEEP_ALIVE_FRAMES frames with their held CONTRL messages,
+ *         a later client with the same id gets none of them
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *client_registry  : reference to server client device registry
+ **************************************************************************/
+static void server_expire_clients(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                                  client_registry_t *client_registry)
+{
+    uint32_t expired_map[CLIENT_SLOT_MAP_WORDS] = {0};
+    int16_t  expired_clients                    = 0;
+    uint16_t client_id                          = 0;
+
+    expired_clients = expire_client_registry(client_registry, server_device, expired_map);
+
+    if(expired_clients > 0)
+    {
+        wireless_network->metrics.clients_expired += (uint16_t)expired_clients;
+
+        for(client_id = 0; client_id < CLIENT_ID_INDEX_SIZE; client_id++)
+        {
+            if(expired_map[client_id >> 5] & (1UL << (client_id & 31)))
+                comms_mailbox_release(&fsm->mailbox, (uint8_t)client_id);
+        }
+    }
+}
+
+
+
+/**************************************************************************
+ * @brief  Next state from the oldest received message, JOINREQ or STATUS
+ *         messages are handled at the next frame grid point
+ * @param  *fsm              : reference to state machine persistent values
  * @param  *network_buffers  : reference to network buffers structure
- * @param  *client_devices   : reference to server client device DB table
+ **************************************************************************/
+static void server_read_queue(comms_server_fsm_t *fsm, comms_network_buffer_t *network_buffers)
+{
+    net_event_t *event = comms_event_peek(network_buffers);
+
+    fsm->fsm_state = SYNC_STATE;
+
+    if(event != NULL)
+    {
+        if(event->type == JOINREQ_FLAG)
+            fsm->fsm_state = JOINREQ_STATE;
+        else if(event->type == STATUSMSG_FLAG)
+            fsm->fsm_state = STATUSMSG_STATE;
+        else
+            comms_event_pop(network_buffers);
+    }
+}
+
+
+
+/**************************************************************************
+ * @brief  Read the STATUS message at the head of the receive queue for a
+ *         CONTRL message, notifications on the way are handled and removed
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *network_buffers  : reference to network buffers structure
+ * @param  *client_registry  : reference to server client device registry
+ * @retval net_event_t       : no STATUS message: NULL, success: queued event
+ **************************************************************************/
+static net_event_t* server_next_status(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                                       comms_network_buffer_t *network_buffers, client_registry_t *client_registry)
+{
+    net_event_t *func_retval = NULL;
+    net_event_t *event       = NULL;
+
+    protocol_handle_t server;
+
+    char    client_mac_address[NET_MAC_SIZE] = {0};
+    uint8_t status_type                      = 0;
+
+    event = comms_event_peek(network_buffers);
+
+    while(func_retval == NULL && event != NULL && event->type == STATUSMSG_FLAG)
+    {
+        server.status_msg = (void*)event->data;
+
+        server_status_ack(wireless_network, server_device, client_registry, event);
+
+        status_type = comms_get_status_type(server);
+
+        fsm->status_message_length = comms_get_status_payload(server, *server_device, &fsm->status_payload,
+                                                              &fsm->source_client_id, &fsm->destination_client_id);
+
+        fsm->status_fragment = comms_get_status_fragment(server);
+        fsm->status_codec    = comms_get_status_codec(server);
+
+        /* Frames of other networks and reserved slots are removed, no registry or mailbox changes */
+        if(fsm->status_message_length >= 0)
+            touch_client_registry(client_registry, fsm->source_client_id);
+
+        /* Notifications, relayed retransmissions and held messages are removed */
+        if(fsm->status_message_length >= 0 &&
+           server_status_notify(fsm, server_device, client_registry, status_type, fsm->source_client_id) == 0 &&
+           server_status_qos(fsm, wireless_network, client_registry) == 0 &&
+           server_status_mailbox(fsm, wireless_network, client_registry) == 0)
+        {
+            /* search table for destination device */
+            fsm->device_found = find_registry_device(client_registry, &fsm->destination_client_id, client_mac_address, FIND_BY_ID);
+
+            if(fsm->device_found == 0)
+            {
+                fsm->destination_client_id = fsm->device_found;
+
+                wireless_network->metrics.client_not_found++;
+            }
+
+            /* Aggregated records carry no codec */
+            server_status_decode(fsm, client_registry, fsm->contrl_aggregate == 0);
+
+            func_retval = event;
+        }
+        else
+        {
+            comms_event_pop(network_buffers);
+
+            event = comms_event_peek(network_buffers);
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Send the CONTRL message of the current STATUS message, payload
+ *         is sent from the queued STATUS frame
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *send_buffer      : CONTRL message header buffer
+ * @retval int16_t           : error: < 0, success: length of message
+ **************************************************************************/
+static int16_t server_contrl_send(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                                  char *send_buffer)
+{
+    protocol_handle_t server;
+
+    uint8_t       segment_count = 0;
+    net_segment_t segments[CONTRL_MAX_SEGMENTS];
+
+    server.contrl_msg = (void*)send_buffer;
+
+    int16_t func_retval = 0;
+
+    if(fsm->status_codec)
+    {
+        /* Encoded payload for a destination with codec support */
+        segment_count = comms_control_codec_v(&server, *server_device, fsm->source_client_id, fsm->destination_client_id,
+                                              fsm->status_codec, fsm->status_payload,
+                                              fsm->status_message_length > 0 ? fsm->status_message_length : 0,
+                                              segments);
+    }
+    else if(fsm->status_fragment)
+    {
+        /* Fragment header is relayed with the payload */
+        segment_count = comms_control_fragment_v(&server, *server_device, fsm->source_client_id, fsm->destination_client_id,
+                                                 fsm->status_payload,
+                                                 fsm->status_message_length > 0 ? fsm->status_message_length : 0,
+                                                 segments);
+    }
+    else
+    {
+        segment_count = comms_control_message_v(&server, *server_device, fsm->source_client_id, fsm->destination_client_id,
+                                                fsm->status_payload,
+                                                fsm->status_message_length > 0 ? fsm->status_message_length : 0,
+                                                segments);
+    }
+
+    if(segment_count)
+        func_retval = comms_send_v(wireless_network, send_buffer, CONTRL_FRAME_HEADER_LENGTH, segments, segment_count);
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Send the downlink message posted by the IP side of the gateway
+ *         as a CONTRL message from the server, low power destinations get
+ *         it from the mailbox
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *network_buffers  : reference to network buffers structure
+ * @param  *client_registry  : reference to server client device registry
+ * @param  *send_buffer      : CONTRL message header buffer
+ * @retval uint8_t           : no downlink message: 0, sent or held: 1
+ **************************************************************************/
+static uint8_t server_gateway_downlink(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                                       comms_network_buffer_t *network_buffers, client_registry_t *client_registry,
+                                       char *send_buffer)
+{
+    uint8_t func_retval = 0;
+
+    if(network_buffers->application_flags.application_message_ready)
+    {
+        fsm->source_client_id      = server_device->device_slot_number;
+        fsm->destination_client_id = network_buffers->destination_id;
+        fsm->status_payload        = network_buffers->app_message_data;
+        fsm->status_message_length = (int16_t)network_buffers->app_message_length;
+        fsm->status_codec          = COMMS_CODEC_NONE;
+        fsm->status_fragment       = 0;
+
+        if(server_status_mailbox(fsm, wireless_network, client_registry) == 0)
+            server_contrl_send(fsm, wireless_network, server_device, send_buffer);
+
+        /* Application posts the next downlink message */
+        network_buffers->application_flags.application_message_ready = 0;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Send the mailbox messages announced in the last SYNC message as
+ *         CONTRL messages, broadcast slot of the next frame while the low
+ *         power destinations listen
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *send_buffer      : CONTRL message header buffer
+ * @retval uint8_t           : number of CONTRL messages sent
+ **************************************************************************/
+static uint8_t server_mailbox_send(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                                   char *send_buffer)
+{
+    uint8_t     func_retval = 0;
+    net_mail_t *mail;
+
+    /* Activity, Status LED function for sending messages, access via user callback */
+    comms_send_status(wireless_network);
+
+    while((mail = comms_mailbox_peek(&fsm->mailbox)) != NULL)
+    {
+        fsm->source_client_id      = mail->source_id;
+        fsm->destination_client_id = mail->destination_id;
+        fsm->status_payload        = mail->payload;
+        fsm->status_message_length = mail->length;
+        fsm->status_fragment       = mail->fragment;
+        fsm->status_codec          = mail->codec;
+
+        server_contrl_send(fsm, wireless_network, server_device, send_buffer);
+
+        comms_mailbox_pop(&fsm->mailbox);
+
+        func_retval++;
+    }
+
+    fsm->mail_announced        = 0;
+    fsm->source_client_id      = 0;
+    fsm->destination_client_id = 0;
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Send the held STATUS message and the STATUS messages queued
+ *         behind it as records of aggregated CONTRL messages, up to
+ *         contrl_batch CONTRL messages
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *network_buffers  : reference to network buffers structure
+ * @param  *client_registry  : reference to server client device registry
+ * @param  *send_buffer      : CONTRL message buffer of NET_MTU_SIZE
+ * @retval uint8_t           : number of CONTRL messages sent
+ **************************************************************************/
+static uint8_t server_contrl_aggregate(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                                       comms_network_buffer_t *network_buffers, client_registry_t *client_registry,
+                                       char *send_buffer)
+{
+    protocol_handle_t server;
+
+    uint8_t contrl_count   = 0;
+    uint8_t contrl_batch   = fsm->contrl_batch > 1 ? fsm->contrl_batch : 1;
+    uint8_t record_count   = 0;
+    uint8_t message_length = 0;
+    uint8_t record_length  = 0;
+    uint8_t frame_limit    = comms_network_frame_limit(wireless_network);
+
+    server.contrl_msg = (void*)send_buffer;
+
+    message_length = comms_control_aggregate_init(&server, *server_device);
+
+    /* Current STATUS message is the head of the queue, held one first */
+    do
+    {
+        /* Fragments are never aggregated, the fragment header is not part of a record */
+        record_length = 0;
+
+        if(fsm->status_fragment == 0)
+            record_length = comms_control_aggregate_add(&server, *server_device, message_length, frame_limit,
+                                                        fsm->source_client_id, fsm->destination_client_id, fsm->status_payload,
+                                                        fsm->status_message_length > 0 ? fsm->status_message_length : 0);
+
+        /* CONTRL message full, send it and start the next one */
+        if(record_length == 0 && record_count > 0)
+        {
+            comms_send(wireless_network, send_buffer, comms_control_aggregate_end(&server, message_length));
+
+            contrl_count++;
+            record_count = 0;
+
+            /* STATUS message stays queued for the next broadcast slot */
+            if(contrl_count >= contrl_batch)
+                break;
+
+            message_length = comms_control_aggregate_init(&server, *server_device);
+
+            if(fsm->status_fragment == 0)
+                record_length = comms_control_aggregate_add(&server, *server_device, message_length, frame_limit,
+                                                            fsm->source_client_id, fsm->destination_client_id, fsm->status_payload,
+                                                            fsm->status_message_length > 0 ? fsm->status_message_length : 0);
+        }
+
+        if(record_length == 0)
+        {
+            /* Record larger than an aggregated CONTRL message or fragment, sent as a CONTRL message of its own */
+            server_contrl_send(fsm, wireless_network, server_device, send_buffer);
+
+            contrl_count++;
+
+            message_length = comms_control_aggregate_init(&server, *server_device);
+        }
+        else
+        {
+            message_length = record_length;
+
+            record_count++;
+        }
+
+        comms_event_pop(network_buffers);
+
+    }while(contrl_count < contrl_batch &&
+           server_next_status(fsm, wireless_network, server_device, network_buffers, client_registry) != NULL);
+
+    if(record_count > 0)
+    {
+        comms_send(wireless_network, send_buffer, comms_control_aggregate_end(&server, message_length));
+
+        contrl_count++;
+    }
+
+    fsm->status_event_held = 0;
+
+    return contrl_count;
+}
+
+
+
+/**************************************************************************
+ * @brief  Server state machine step, runs on every transmit timer interrupt
+ * @param  *fsm              : reference to state machine persistent values
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *network_buffers  : reference to network buffers structure
+ * @param  *client_registry  : reference to server client device registry
  * @param  server_mode       : sever device operation mode
  * @retval int8_t            : error = 0
  **************************************************************************/
-int8_t comms_start_server(access_control_t *wireless_network, device_config_t *server_device, comms_network_buffer_t *network_buffers,
-                          client_devices_t *client_devices, comms_server_mode_t server_mode)
+static int8_t server_fsm_step(comms_server_fsm_t *fsm, access_control_t *wireless_network, device_config_t *server_device,
+                              comms_network_buffer_t *network_buffers, client_registry_t *client_registry,
+                              comms_server_mode_t server_mode)
 {
 
     int8_t func_retval = 1;
@@ -116,35 +814,44 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
     char    send_message_buffer[NET_MTU_SIZE]          = {0};
     char    client_mac_address[NET_MAC_SIZE]           = {0};
     char    destination_mac_addr[NET_DATA_LENGTH]      = {0};
-    static char status_message_buffer[NET_DATA_LENGTH] = {0};
+    char    sync_payload[COMMS_SYNC_PAYLOAD_SIZE]      = {0};
+    uint8_t mail_bitmap[COMMS_SYNC_BITMAP_SIZE]        = {0};
 
     uint8_t client_requested_slots           = 0;
     uint8_t message_length                   = 0;
+    uint8_t payload_length                   = 0;
+    uint8_t join_qos                         = 0;
+    uint8_t join_keep_alive                  = 0;
+    uint8_t join_bitmap                      = 0;
+    uint8_t join_period                      = 0;
+    uint8_t status_type                      = 0;
+    uint8_t contrl_count                     = 0;
+    uint8_t position                         = 0;
 
-    static int8_t  client_id                 = 0;    /*!< from device table   */
-    static uint8_t destination_client_id     = 0;    /*!< from status message */
-    static uint8_t source_client_id          = 0;
-    static int16_t status_message_length     = 0;
-
-    static int8_t device_found = 0;
+    net_event_t *event;
 
-    static uint8_t contrl_flag = 0;
-
-    /* Device DB related declarations */
-    static table_retval_t  table_values;
+    comms_metrics_step(wireless_network, network_buffers);
 
+    /* Broadcast slot sent last, the frame grid continues with the frame length of the last SYNC message */
+    if(fsm->frame_rest)
+    {
+        comms_network_set_timer(wireless_network, server_device, NET_FRAME_SLOT);
 
-    static int8_t fsm_state = START_STATE;
+        fsm->frame_rest = 0;
+    }
 
-    switch(fsm_state)
+    switch(fsm->fsm_state)
     {
 
     case START_STATE:
 
+        /* Client frames of other networks keep no client joined */
+        wireless_network->network_id = server_device->device_network_id;
+
         /* Set timer */
         comms_network_set_timer(wireless_network, server_device, NET_SYNC_SLOT);
 
-        fsm_state = SYNC_STATE;
+        fsm->fsm_state = SYNC_STATE;
 
         break;
 
@@ -154,22 +861,33 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
         /* Clear Activity Status */
         comms_clear_activity(wireless_network);
 
-        fsm_state = network_buffers->flag_state;
-        if(fsm_state == 0)
+        /* Mail announced in the last SYNC message, broadcast slot of this frame */
+        if(fsm->mail_announced)
         {
-            fsm_state = SYNC_STATE;
+            comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
+
+            fsm->fsm_state = MAILBOX_STATE;
 
+            break;
         }
 
-        /* clear flag */
-        network_buffers->flag_state = CLEAR_FLAG;
+        /* Downlink message from the IP side of the gateway, broadcast slot of this frame, received
+         * STATUS messages follow it, a JOINREQ message goes first */
+        event = comms_event_peek(network_buffers);
 
-        /* Check Queue */
-        if(network_buffers->queue_pos > 0)
+        if(server_mode == WI_GATEWAY_SERVER && network_buffers->application_flags.gateway_connected == 1 &&
+           network_buffers->application_flags.application_message_ready && (event == NULL || event->type != JOINREQ_FLAG))
         {
-            fsm_state = STATUSMSG_STATE;
+            comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
+
+            fsm->fsm_state = CONTROLMSG_STATE;
+
+            break;
         }
 
+        /* Handle the oldest received message */
+        server_read_queue(fsm, network_buffers);
+
         break;
 
 
@@ -178,14 +896,40 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
         /* Activity, Status LED function for sync message, access via user callback */
         comms_sync_status(wireless_network);
 
+        /* Keep alive clients silent for COMMS_KEEP_ALIVE_FRAMES frames are released, the frame shrinks */
+        server_heard_clients(wireless_network, client_registry);
+
+        server_expire_clients(fsm, wireless_network, server_device, client_registry);
+
         wireless_network->sync_message = (void*)send_message_buffer;
 
+        server_access_slots(fsm, wireless_network, server_device, server_join_load(fsm, wireless_network));
+
+        /* Frame length changes take effect with the SYNC message announcing them */
+        comms_network_set_timer(wireless_network, server_device, NET_SYNC_SLOT);
+
+        /* Ack bitmap of the STATUS messages handled or queued since the last SYNC, mail bitmap of the next broadcast slot */
+        for(position = 0; (event = comms_event_peek_at(network_buffers, position)) != NULL; position++)
+        {
+            if(event->type == STATUSMSG_FLAG)
+                server_status_ack(wireless_network, server_device, client_registry, event);
+        }
+
+        fsm->mail_announced = comms_mailbox_announce(&fsm->mailbox, mail_bitmap, sizeof(mail_bitmap), COMMS_MAILBOX_ANNOUNCE);
+
+        payload_length = comms_network_sync_payload(wireless_network, mail_bitmap, sync_payload);
+
         message_length = comms_network_sync_message(wireless_network, server_device->device_network_id,
-                                                    server_device->device_slot_time, "sync", 4);
+                                                    server_device->device_slot_time, sync_payload, payload_length);
 
         comms_send(wireless_network, (char*)wireless_network->sync_message, message_length);
 
-        fsm_state = MSG_READ_STATE;
+        /* Frames received in the client slots of the last frame */
+        comms_metrics_frame(wireless_network, wireless_network->metrics.frames_received - fsm->frames_received);
+
+        fsm->frames_received = wireless_network->metrics.frames_received;
+
+        fsm->fsm_state = MSG_READ_STATE;
 
         break;
 
@@ -195,15 +939,51 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
         /* Activity, Status LED function for receiving messages, access via user callback */
         comms_recv_status(wireless_network);
 
-        server.joinrequest_msg = (void*)network_buffers->read_message;
+        event = comms_event_peek(network_buffers);
+
+        if(event == NULL)
+        {
+            fsm->fsm_state = SYNC_STATE;
+
+            break;
+        }
+
+        server.joinrequest_msg = (void*)event->data;
 
         api_retval = comms_get_joinreq_data(client_mac_address, &client_requested_slots, server,
                                             *server_device, network_buffers->application_flags.network_join_response);
 
         if(api_retval)
         {
+            /* Refused joins have no registry row, the JOINRESP message goes to the requester */
+            memcpy(fsm->join_mac, client_mac_address, NET_MAC_SIZE);
+
+            /* Clients with a reporting period share a superframe slot */
+            join_period = comms_get_joinreq_period(server);
 
-            table_values = update_server_device_table(client_devices, client_mac_address, client_requested_slots, server_device);
+            if(join_period > COMMS_SUPERFRAME_LIMIT)
+                join_period = COMMS_SUPERFRAME_LIMIT;
+
+            fsm->table_values = update_client_registry_period(client_registry, client_mac_address, client_requested_slots,
+                                                              join_period, server_device);
+
+            /* Keep alive clients are released when silent for a keep alive period, a join again restarts the QoS 1 sequence,
+               the SYNC ack and mail bitmaps hold no client ids from COMMS_SYNC_CLIENT_IDS, no QoS 1 and low power for them */
+            if((fsm->table_values.table_retval == 0 || fsm->table_values.table_retval == -3) &&
+               comms_get_joinreq_options(server, &join_qos, &join_keep_alive) == 0)
+            {
+                join_bitmap = client_registry->rows[fsm->table_values.table_index].client_id < COMMS_SYNC_CLIENT_IDS;
+
+                client_registry->rows[fsm->table_values.table_index].client_states.qos        = join_qos && join_bitmap;
+                client_registry->rows[fsm->table_values.table_index].client_states.keep_alive = join_keep_alive;
+                client_registry->rows[fsm->table_values.table_index].client_states.codec      = comms_get_joinreq_codec(server);
+                client_registry->rows[fsm->table_values.table_index].client_states.low_power  = comms_get_joinreq_sleep(server) &&
+                                                                                                join_bitmap;
+
+                touch_client_registry(client_registry, client_registry->rows[fsm->table_values.table_index].client_id);
+
+                init_sequence_window(&client_registry->rows[fsm->table_values.table_index].client_sequence);
+            }
 
             network_buffers->application_flags.network_join_response = 0;
 
@@ -215,7 +995,7 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
                 /* Set timer to broadcast slot */
                 comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
 
-                fsm_state = JOINRESP_STATE;
+                fsm->fsm_state = JOINRESP_STATE;
 
                 break;
 
@@ -225,7 +1005,7 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
                 /* Set timer to broadcast slot */
                 comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
 
-                fsm_state = JOINRESP_STATE;
+                fsm->fsm_state = JOINRESP_STATE;
 
                 break;
 
@@ -236,12 +1016,10 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
         {
             network_buffers->application_flags.network_join_response = 0;
 
-            fsm_state = SYNC_STATE;
+            fsm->fsm_state = SYNC_STATE;
         }
 
-        network_buffers->flag_state = CLEAR_FLAG;
-
-        memset(network_buffers->read_message, 0, sizeof(network_buffers->read_message));
+        comms_event_pop(network_buffers);
 
         break;
 
@@ -256,22 +1034,46 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
 
         server.joinresponse_msg = (void*)send_message_buffer;
 
-        /* Get client data from the device table */
-        read_client_table(client_devices, destination_mac_addr, &client_id, table_values.table_index);
+        /* Get client data from the device table, a refused join has no row and gets client id 0 */
+        if(fsm->table_values.table_retval == -2)
+        {
+            memcpy(destination_mac_addr, fsm->join_mac, NET_MAC_SIZE);
+
+            fsm->client_id = 0;
+        }
+        else
+        {
+            read_client_registry(client_registry, destination_mac_addr, &fsm->client_id, fsm->table_values.table_index);
+        }
 
         /* Set join response message type */
-        comms_set_joinresp_message_status(&server, table_values.table_retval);
+        comms_set_joinresp_message_status(&server, fsm->table_values.table_retval);
 
-        /* Configure JOINRESP message */
-        message_length = comms_joinresp_message(&server, *server_device, destination_mac_addr, client_id);
+        if(fsm->table_values.table_retval == -2)
+            wireless_network->metrics.join_rejected++;
+        else if(fsm->table_values.table_retval == -3)
+            wireless_network->metrics.join_duplicates++;
+        else
+            wireless_network->metrics.join_accepted++;
+
+        /* Configure JOINRESP message, superframe clients get the shared slot and their frame offset */
+        if(fsm->table_values.table_retval != -2 && client_registry->rows[fsm->table_values.table_index].client_slot)
+            message_length = comms_joinresp_superframe_message(&server, *server_device, destination_mac_addr, fsm->client_id,
+                                                               client_registry->rows[fsm->table_values.table_index].client_slot,
+                                                               client_registry->rows[fsm->table_values.table_index].client_period,
+                                                               client_registry->rows[fsm->table_values.table_index].client_offset);
+        else
+            message_length = comms_joinresp_message(&server, *server_device, destination_mac_addr, fsm->client_id);
 
         /* Send JOINRESP message */
         comms_send(wireless_network, (char*)server.joinresponse_msg, message_length);
 
-        /* update timer to accommodate new slot */
-        comms_network_set_timer(wireless_network, server_device, NET_SYNC_SLOT);
+        /* Back on the frame grid, the next SYNC message announces the new slot */
+        comms_network_set_timer(wireless_network, server_device, NET_FRAME_REST_SLOT);
+
+        fsm->frame_rest = 1;
 
-        fsm_state = SYNC_STATE;
+        fsm->fsm_state = SYNC_STATE;
 
         break;
 
@@ -282,53 +1084,173 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
         comms_recv_status(wireless_network);
 
         /* Read Status message and send control message to the destination device */
-        server.status_msg = (void*)network_buffers->network_queue[network_buffers->queue_pos - 1].data;
+        event = comms_event_peek(network_buffers);
+
+        if(event == NULL)
+        {
+            fsm->fsm_state = SYNC_STATE;
+
+            break;
+        }
+
+        server.status_msg = (void*)event->data;
+
+        server_status_ack(wireless_network, server_device, client_registry, event);
+
+        status_type = comms_get_status_type(server);
+
+        if(server_mode == WI_LOCAL_SERVER)
+        {
+            /* get destination client and payload from status, CONTRL message sends the payload from the queued frame */
+            fsm->status_message_length = comms_get_status_payload(server, *server_device, &fsm->status_payload,
+                                                                  &fsm->source_client_id, &fsm->destination_client_id);
+        }
+        else
+        {
+            memset(fsm->status_message_buffer, 0, sizeof(fsm->status_message_buffer));
+
+            /* get destination client and payload from status */
+            fsm->status_message_length = comms_get_status_message(server, *server_device, fsm->status_message_buffer,
+                                                                  &fsm->source_client_id, &fsm->destination_client_id);
+
+            fsm->status_payload = fsm->status_message_buffer;
+        }
+
+        fsm->status_fragment = comms_get_status_fragment(server);
+        fsm->status_codec    = comms_get_status_codec(server);
+
+        /* Keep the frame queued until the CONTRL message is sent */
+        fsm->status_event_held = (server_mode == WI_LOCAL_SERVER && status_type == COMMS_STATUS_MESSAGE);
+
+        if(fsm->status_event_held == 0)
+            comms_event_pop(network_buffers);
+
+        /* Frames of other networks and reserved slots, no registry or mailbox changes and no CONTRL message */
+        if(fsm->status_message_length < 0)
+        {
+            if(fsm->status_event_held)
+            {
+                comms_event_pop(network_buffers);
+
+                fsm->status_event_held = 0;
+            }
+
+            fsm->fsm_state = SYNC_STATE;
+
+            /* Check Queue */
+            event = comms_event_peek(network_buffers);
+
+            if(event != NULL && event->type == STATUSMSG_FLAG)
+            {
+                fsm->fsm_state = STATUSMSG_STATE;
+            }
+
+            break;
+        }
+
+        touch_client_registry(client_registry, fsm->source_client_id);
+
+        /* Client notifications for the server, relayed retransmissions and held messages, no CONTRL message */
+        if(server_status_notify(fsm, server_device, client_registry, status_type, fsm->source_client_id) ||
+           server_status_qos(fsm, wireless_network, client_registry) ||
+           (server_mode == WI_LOCAL_SERVER && server_status_mailbox(fsm, wireless_network, client_registry)))
+        {
+            if(fsm->status_event_held)
+            {
+                comms_event_pop(network_buffers);
+
+                fsm->status_event_held = 0;
+            }
+
+            /* Broadcast slot of this frame relays the next queued STATUS message */
+            if(server_mode == WI_LOCAL_SERVER && server_next_status(fsm, wireless_network, server_device, network_buffers, client_registry) != NULL)
+            {
+                fsm->status_event_held = 1;
+
+                comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
+
+                fsm->fsm_state = CONTROLMSG_STATE;
+
+                break;
+            }
+
+            fsm->source_client_id      = 0;
+            fsm->destination_client_id = 0;
 
-        memset(status_message_buffer, 0, sizeof(status_message_buffer));
+            fsm->fsm_state = SYNC_STATE;
 
-        /* get destination client and payload from status */
-        status_message_length = comms_get_status_message(server, *server_device, status_message_buffer,
-                                                         &source_client_id, &destination_client_id);
+            /* Check Queue */
+            event = comms_event_peek(network_buffers);
 
-        memset(network_buffers->network_queue[network_buffers->queue_pos - 1].data, 0,
-               sizeof(network_buffers->network_queue[network_buffers->queue_pos - 1].data));
+            if(event != NULL && event->type == STATUSMSG_FLAG)
+            {
+                fsm->fsm_state = STATUSMSG_STATE;
+            }
 
-        network_buffers->queue_pos--;
+            break;
+        }
 
         if(server_mode == WI_LOCAL_SERVER)
         {
 
             /* search table for destination device */
-            device_found = find_client_device(client_devices, &destination_client_id, client_mac_address, FIND_BY_ID);
+            fsm->device_found = find_registry_device(client_registry, &fsm->destination_client_id, client_mac_address, FIND_BY_ID);
 
             /* Check device found condition */
-            if(device_found == 0)
-                destination_client_id = device_found;
+            if(fsm->device_found == 0)
+            {
+                fsm->destination_client_id = fsm->device_found;
+
+                wireless_network->metrics.client_not_found++;
+            }
+
+            /* Aggregated records carry no codec */
+            server_status_decode(fsm, client_registry, fsm->contrl_aggregate == 0);
 
             /* Set timer to broadcast slot */
             comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
 
-            fsm_state = CONTROLMSG_STATE;
+            fsm->fsm_state = CONTROLMSG_STATE;
 
 
         }
-        else if(server_mode == WI_GATEWAY_SERVER && destination_client_id == 1)
+        else if(server_mode == WI_GATEWAY_SERVER && fsm->destination_client_id == 1)
         {
+            /* Gateway forwards raw payloads */
+            server_status_decode(fsm, client_registry, 0);
+
             /* search table for source device */
-            device_found = find_client_device(client_devices, &source_client_id, client_mac_address, FIND_BY_ID);
+            fsm->device_found = find_registry_device(client_registry, &fsm->source_client_id, client_mac_address, FIND_BY_ID);
 
-            if(device_found && network_buffers->application_flags.gateway_connected == 1)
+            if(fsm->device_found && network_buffers->application_flags.gateway_connected == 1)
             {
-                strncpy(network_buffers->network_message, status_message_buffer, status_message_length);
+                /* Raw payload with its source for the IP side, payloads may hold zero bytes,
+                 * destination_id keeps the destination of a pending downlink message */
+                payload_length = fsm->status_message_length > 0 ? (uint8_t)fsm->status_message_length : 0;
+
+                if(payload_length >= NET_DATA_LENGTH)
+                    payload_length = NET_DATA_LENGTH - 1;
+
+                memset(network_buffers->network_message, 0, NET_DATA_LENGTH);
+                memcpy(network_buffers->network_message, fsm->status_payload, payload_length);
+
+                network_buffers->network_message_data = network_buffers->network_message;
+                network_buffers->net_message_length   = payload_length;
+                network_buffers->source_id            = fsm->source_client_id;
 
                 network_buffers->application_flags.network_message_ready = 1;
 
-                fsm_state = SYNC_STATE;
+                fsm->source_client_id      = 0;
+                fsm->destination_client_id = 0;
+
+                fsm->fsm_state = SYNC_STATE;
 
                 /* Check Queue */
-                if(network_buffers->queue_pos > 0)
+                event = comms_event_peek(network_buffers);
+
+                if(event != NULL && event->type == STATUSMSG_FLAG)
                 {
-                    fsm_state = STATUSMSG_STATE;
+                    fsm->fsm_state = STATUSMSG_STATE;
                 }
 
             }
@@ -337,32 +1259,35 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
                 /* Set timer to broadcast slot */
                 comms_network_set_timer(wireless_network, server_device, NET_BROADCAST_SLOT);
 
-                fsm_state = CONTROLMSG_STATE;
+                fsm->fsm_state = CONTROLMSG_STATE;
             }
         }
         else
         {
-            fsm_state = SYNC_STATE;
+            fsm->fsm_state = SYNC_STATE;
         }
 
-        network_buffers->flag_state = CLEAR_FLAG;
-
         break;
 
 
-    case STATUSACK_STATE: /* Not implemented / tested */
+    case STATUSACK_STATE:
+
+        /* STATUS messages are acknowledged in the ack bitmap of the SYNC message */
+        fsm->fsm_state = SYNC_STATE;
+
+        break;
 
-        memset(send_message_buffer, 0, sizeof(send_message_buffer));
 
-        server.statusack_msg = (void*)send_message_buffer;
+    case MAILBOX_STATE:
 
-        message_length = comms_statusack_message(&server, *server_device, client_id, destination_client_id);
+        server_mailbox_send(fsm, wireless_network, server_device, send_message_buffer);
 
-        /* Call Send function */
+        /* Back on the frame grid after the broadcast slot, received messages are handled at the next grid point */
+        comms_network_set_timer(wireless_network, server_device, NET_FRAME_REST_SLOT);
 
-        contrl_flag = 1;
+        fsm->frame_rest = 1;
 
-        fsm_state = MSG_READ_STATE;
+        server_read_queue(fsm, network_buffers);
 
         break;
 
@@ -372,20 +1297,41 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
         /* Activity, Status LED function for sending messages, access via user callback */
         comms_send_status(wireless_network);
 
-        memset(send_message_buffer, 0, sizeof(send_message_buffer));
-
         server.contrl_msg = (void*)send_message_buffer;
 
         if(server_mode == WI_LOCAL_SERVER)
         {
-            message_length = comms_control_message(&server, *server_device, source_client_id, destination_client_id,
-                                                   status_message_buffer, status_message_length);
+            if(fsm->contrl_aggregate)
+            {
+                /* Records of the held and the queued STATUS messages in aggregated CONTRL messages */
+                server_contrl_aggregate(fsm, wireless_network, server_device, network_buffers, client_registry,
+                                        send_message_buffer);
+            }
+            else
+            {
+                /* Payload segment points into the held STATUS frame */
+                server_contrl_send(fsm, wireless_network, server_device, send_message_buffer);
 
-            /* Send CONTRL message */
-            comms_send(wireless_network, (char*)server.contrl_msg, message_length);
+                if(fsm->status_event_held)
+                {
+                    comms_event_pop(network_buffers);
+
+                    fsm->status_event_held = 0;
+                }
+
+                /* Batch mode, relay the STATUS messages queued behind it in the same broadcast slot */
+                contrl_count = 1;
 
-            /* set timer to sync slot after sending CONTRL message */
-            comms_network_set_timer(wireless_network, server_device, NET_SYNC_SLOT);
+                while(contrl_count < fsm->contrl_batch &&
+                      server_next_status(fsm, wireless_network, server_device, network_buffers, client_registry) != NULL)
+                {
+                    server_contrl_send(fsm, wireless_network, server_device, send_message_buffer);
+
+                    comms_event_pop(network_buffers);
+
+                    contrl_count++;
+                }
+            }
 
         }
         else if(server_mode == WI_GATEWAY_SERVER)
@@ -394,37 +1340,48 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
             if(network_buffers->application_flags.gateway_connected == 1)
             {
                 /* Handle messages from IP server */
-
+                server_gateway_downlink(fsm, wireless_network, server_device, network_buffers, client_registry,
+                                        send_message_buffer);
             }
             else
             {
+                memset(send_message_buffer, 0, sizeof(send_message_buffer));
+
                 /* Handle gateway offline message */
-                destination_client_id = source_client_id;
-                source_client_id      = server_device->device_slot_number;
+                fsm->destination_client_id = fsm->source_client_id;
+                fsm->source_client_id      = server_device->device_slot_number;
 
-                memset(status_message_buffer, 0, sizeof(status_message_buffer));
+                memset(fsm->status_message_buffer, 0, sizeof(fsm->status_message_buffer));
 
-                status_message_length = 15;
-                strncpy(status_message_buffer, "Gateway Offline", status_message_length);
+                /* Zeroed buffer keeps the text terminated */
+                fsm->status_message_length = sizeof(SERVER_GATEWAY_OFFLINE) - 1;
+                memcpy(fsm->status_message_buffer, SERVER_GATEWAY_OFFLINE, fsm->status_message_length);
 
-                message_length = comms_control_message(&server, *server_device, source_client_id, destination_client_id,
-                                                       status_message_buffer, status_message_length);
+                message_length = comms_control_message(&server, *server_device, fsm->source_client_id, fsm->destination_client_id,
+                                                       fsm->status_message_buffer, fsm->status_message_length);
                 /* Send CONTRL message */
                 comms_send(wireless_network, (char*)server.contrl_msg, message_length);
             }
         }
 
+        /* Back on the frame grid after the broadcast slot */
+        comms_network_set_timer(wireless_network, server_device, NET_FRAME_REST_SLOT);
+
+        fsm->frame_rest = 1;
+
         /* set flags and parameters to init values */
-        device_found          = 0;
-        source_client_id      = 0;
-        destination_client_id = 0;
+        fsm->device_found          = 0;
+        fsm->source_client_id      = 0;
+        fsm->destination_client_id = 0;
 
-        fsm_state = SYNC_STATE;
+        fsm->fsm_state = SYNC_STATE;
 
         /* Check Queue */
-        if(network_buffers->queue_pos > 0)
+        event = comms_event_peek(network_buffers);
+
+        if(event != NULL && event->type == STATUSMSG_FLAG)
         {
-            fsm_state = STATUSMSG_STATE;
+            fsm->fsm_state = STATUSMSG_STATE;
         }
 
         break;
@@ -432,7 +1389,7 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
 
     default:
 
-        fsm_state = MSG_READ_STATE;
+        fsm->fsm_state = MSG_READ_STATE;
 
         break;
 
@@ -445,3 +1402,280 @@ int8_t comms_start_server(access_control_t *wireless_network, device_config_t *s
 
 }
 
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+
+/**************************************************************************
+ * @brief  Server instance constructor, initializes caller owned context
+ * @param  *server           : reference to server context
+ * @param  *network_ops      : reference to network operations handle
+ * @param  *mac_address      : mac_address of the server device
+ * @param  network_id        : network id of the server
+ * @param  device_slot_time  : slot time interval
+ * @param  total_slots       : no of existing slots at start
+ * @param  *user_name        : network user name
+ * @param  *password         : network password
+ * @param  server_mode       : sever device operation mode
+ * @retval int8_t            : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_init(comms_server_context_t *server, network_operations_t *network_ops, char *mac_address,
+                         uint16_t network_id, uint16_t device_slot_time, uint8_t total_slots, char *user_name,
+                         uint8_t *password, comms_server_mode_t server_mode)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL || network_ops == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        memset(server, 0, sizeof(comms_server_context_t));
+
+        init_network_handle(&server->network, network_ops);
+
+        if(init_server_device(&server->device, mac_address, network_id, device_slot_time, total_slots,
+                              user_name, password) == NULL)
+        {
+            func_retval = -1;
+        }
+        else
+        {
+            init_client_registry(&server->client_registry, server->client_table, CLIENT_TABLE_SIZE,
+                                 server->client_hash, CLIENT_HASH_SIZE);
+
+            server->server_mode          = server_mode;
+            server->fsm.fsm_state        = START_STATE;
+            server->fsm.contrl_batch     = COMMS_CONTRL_BATCH;
+            server->fsm.contrl_aggregate = COMMS_CONTRL_AGGREGATE;
+            server->fsm.access_slots_max = COMMS_ACCESS_SLOTS_MAX;
+
+            init_mailbox(&server->fsm.mailbox);
+
+            func_retval = 0;
+        }
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Server state machine step for a server context, call from the
+ *         transmit timer interrupt of the instance
+ * @param  *server : reference to server context
+ * @retval int8_t  : error = 0
+ **************************************************************************/
+int8_t comms_server_run(comms_server_context_t *server)
+{
+    return server_fsm_step(&server->fsm, &server->network, &server->device, &server->buffers,
+                           &server->client_registry, server->server_mode);
+}
+
+
+
+/**************************************************************************
+ * @brief  Server receive interrupt handler for a server context
+ * @param  *server : reference to server context
+ * @param  data    : received byte
+ * @retval int8_t  : error: -2, success: length of message
+ **************************************************************************/
+int8_t comms_server_recv(comms_server_context_t *server, char data)
+{
+    /* Drop partial frame instead of overrunning the read buffer */
+    if(server->rx_index >= sizeof(server->buffers.read_message))
+        server->rx_index = 0;
+
+    server->buffers.read_message[server->rx_index] = data;
+
+    return comms_server_recv_it(&server->network, &server->buffers, &server->rx_index);
+}
+
+
+
+/**************************************************************************
+ * @brief  Set the number of CONTRL messages sent per broadcast slot, the
+ *         server relays the STATUS messages queued in the receive ring in
+ *         one pass instead of one STATUS per slot period
+ *         (frames beyond the broadcast slot airtime overlap client slots)
+ * @param  *server       : reference to server context
+ * @param  contrl_batch  : CONTRL messages per broadcast slot, 0 or 1 legacy
+ * @retval int8_t        : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_batch(comms_server_context_t *server, uint8_t contrl_batch)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        server->fsm.contrl_batch = contrl_batch;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Select aggregated CONTRL messages, STATUS messages are relayed as
+ *         records packed into CONTRL messages of up to NET_DATA_LENGTH
+ *         bytes, clients read their records with comms_get_contrl_record
+ * @param  *server    : reference to server context
+ * @param  aggregate  : aggregated CONTRL messages on = 1, off = 0
+ * @retval int8_t     : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_aggregate(comms_server_context_t *server, uint8_t aggregate)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        server->fsm.contrl_aggregate = aggregate ? 1 : 0;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Set the largest number of access slots per frame, the server
+ *         grows the access slots up to this count on JOINREQ collisions
+ * @param  *server       : reference to server context
+ * @param  access_slots  : largest access slot count, 0 or 1 single access slot
+ * @retval int8_t        : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_access_slots(comms_server_context_t *server, uint8_t access_slots)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        server->fsm.access_slots_max = access_slots > 1 ? access_slots : 1;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Set the connection state of the IP side of a gateway server,
+ *         STATUS messages to client id 1 are handed to the application
+ *         in network_message while connected
+ * @param  *server     : reference to server context
+ * @param  connected   : IP side connected = 1, offline = 0
+ * @retval int8_t      : error = -1, success = 0
+ **************************************************************************/
+int8_t comms_server_set_gateway(comms_server_context_t *server, uint8_t connected)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL || server->server_mode != WI_GATEWAY_SERVER)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        server->buffers.application_flags.gateway_connected = connected ? 1 : 0;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Post a downlink message from the IP side of a gateway server,
+ *         sent as a CONTRL message in the broadcast slot of the next frame
+ * @param  *server          : reference to server context
+ * @param  destination_id   : destination client id
+ * @param  *message         : downlink message
+ * @param  message_length   : message length
+ * @retval int8_t           : error = -1, busy = 0, posted = 1
+ **************************************************************************/
+int8_t comms_server_gateway_post(comms_server_context_t *server, uint8_t destination_id, const char *message,
+                                 uint16_t message_length)
+{
+    int8_t func_retval = 0;
+
+    if(server == NULL || message == NULL || server->server_mode != WI_GATEWAY_SERVER ||
+       message_length >= NET_DATA_LENGTH - COMMS_TERMINATOR_LENGTH || destination_id <= COMMS_SERVER_SLOTNUM)
+    {
+        func_retval = -1;
+    }
+    else if(server->buffers.application_flags.application_message_ready)
+    {
+        /* Last downlink message not sent yet */
+        func_retval = 0;
+    }
+    else
+    {
+        memset(server->buffers.application_message, 0, NET_DATA_LENGTH);
+        memcpy(server->buffers.application_message, message, message_length);
+
+        server->buffers.app_message_data   = server->buffers.application_message;
+        server->buffers.app_message_length = message_length;
+        server->buffers.destination_id     = destination_id;
+
+        server->buffers.application_flags.application_message_ready = 1;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/**************************************************************************
+ * @brief  Server State Machine Start Function
+ *         (single instance, state machine values kept in static storage)
+ * @param  *wireless_network : reference to network access handle
+ * @param  *server_device    : reference to device configuration structure
+ * @param  *network_buffers  : reference to network buffers structure
+ * @param  *client_devices   : reference to server client device DB table
+ * @param  server_mode       : sever device operation mode
+ * @retval int8_t            : error = 0
+ **************************************************************************/
+int8_t comms_start_server(access_control_t *wireless_network, device_config_t *server_device, comms_network_buffer_t *network_buffers,
+                          client_devices_t *client_devices, comms_server_mode_t server_mode)
+{
+    static comms_server_fsm_t fsm = { .fsm_state        = START_STATE,
+                                      .contrl_batch     = COMMS_CONTRL_BATCH,
+                                      .contrl_aggregate = COMMS_CONTRL_AGGREGATE,
+                                      .access_slots_max = COMMS_ACCESS_SLOTS_MAX };
+
+    return server_fsm_step(&fsm, wireless_network, server_device, network_buffers,
+                           bind_server_device_table(client_devices), server_mode);
+}
@@ -0,0 +1,272 @@
+/**
+ ******************************************************************************
+ * @file    comms_trace.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network deferred debug trace source file
+ *
+ *  Info
+ *          State machine debug output is recorded as binary trace records, an
+ *          event id, a timestamp and up to four integer arguments, in a ring
+ *          written from the timer and receive interrupts. The main loop (or a
+ *          host tool) reads the records and formats the debug text later.
+ *          
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "comms_trace.h"
+#include "comms_network.h"
+
+
+/* Compile time check, records and ring fields keep their 4 byte alignment in the ring */
+typedef char comms_trace_align_check_t[(offsetof(comms_trace_t, records) % sizeof(uint32_t) == 0 &&
+                                        sizeof(comms_trace_record_t) % sizeof(uint32_t) == 0 &&
+                                        offsetof(comms_trace_record_t, args) % sizeof(uint32_t) == 0) ? 1 : -1];
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  static function to append text to a buffer
+ * @param  *buffer  : text buffer
+ * @param  size     : text buffer size
+ * @param  *length  : text length, updated
+ * @param  *text    : text to append
+ * @retval int8_t   : error (buffer full): -1, success: 0
+ *********************************************************/
+static int8_t trace_append(char *buffer, uint16_t size, uint16_t *length, const char *text)
+{
+    int8_t func_retval = 0;
+
+    while(*text)
+    {
+        if(*length + 1 >= size)
+        {
+            func_retval = -1;
+
+            break;
+        }
+
+        buffer[(*length)++] = *text++;
+    }
+
+    buffer[*length] = '\0';
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  static function to append a number to a buffer
+ * @param  *buffer  : text buffer
+ * @param  size     : text buffer size
+ * @param  *length  : text length, updated
+ * @param  value    : number to append
+ * @retval int8_t   : error (buffer full): -1, success: 0
+ *********************************************************/
+static int8_t trace_append_number(char *buffer, uint16_t size, uint16_t *length, uint32_t value)
+{
+    char ltoa_buffer[12] = {0};
+
+    api_ltoa((long)value, ltoa_buffer, 10);
+
+    return trace_append(buffer, size, length, ltoa_buffer);
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*********************************************************
+ * @brief  Function to initialize a trace ring
+ * @param  *trace  : reference to trace ring
+ * @retval int8_t  : error: -1, success: 0
+ *********************************************************/
+int8_t init_trace(comms_trace_t *trace)
+{
+    int8_t func_retval = 0;
+
+    if(trace == NULL)
+    {
+        func_retval = -1;
+    }
+    else
+    {
+        memset(trace, 0, sizeof(comms_trace_t));
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to read and release the oldest trace
+ *         record, main loop (consumer) side of the ring
+ * @param  *trace   : reference to trace ring
+ * @param  *record  : copy of the oldest record
+ * @retval int8_t   : empty: 0, success: 1
+ *********************************************************/
+int8_t comms_trace_read(comms_trace_t *trace, comms_trace_record_t *record)
+{
+    int8_t func_retval = 0;
+
+    uint8_t tail = trace->tail;
+
+    if(trace->head != tail)
+    {
+        /* Read the record only after its publication is seen */
+        COMMS_TRACE_BARRIER();
+
+        memcpy(record, &trace->records[tail & (COMMS_TRACE_SIZE - 1)], sizeof(comms_trace_record_t));
+
+        /* Record storage is reused by the producer after the tail moves */
+        COMMS_TRACE_BARRIER();
+
+        trace->tail = tail + 1;
+
+        func_retval = 1;
+    }
+
+    return func_retval;
+}
+
+
+
+/*********************************************************
+ * @brief  Function to pack up to COMMS_TRACE_DATA payload
+ *         bytes in two trace arguments
+ * @param  *payload : payload data
+ * @param  length   : payload length
+ * @param  *args    : two trace arguments
+ *********************************************************/
+void comms_trace_pack(const char *payload, uint16_t length, uint32_t *args)
+{
+    uint8_t index = 0;
+
+    args[0] = 0;
+    args[1] = 0;
+
+    for(index = 0; index < length && index < COMMS_TRACE_DATA; index++)
+        args[index >> 2] |= (uint32_t)(uint8_t)payload[index] << ((index & 3) * 8);
+}
+
+
+
+/*********************************************************
+ * @brief  Function to format a trace record as the debug
+ *         text of the state machine, usable on the host
+ * @param  *record  : reference to trace record
+ * @param  *buffer  : text buffer
+ * @param  size     : text buffer size
+ * @retval int16_t  : error: -1, success: text length
+ *********************************************************/
+int16_t comms_trace_format(const comms_trace_record_t *record, char *buffer, uint16_t size)
+{
+    int16_t  func_retval = 0;
+    uint16_t length      = 0;
+    uint8_t  index       = 0;
+
+    char payload[COMMS_TRACE_DATA + 1] = {0};
+
+    if(record == NULL || buffer == NULL || size == 0)
+        return -1;
+
+    buffer[0] = '\0';
+
+    switch(record->event)
+    {
+        case COMMS_TRACE_JOINREQ:
+
+            trace_append(buffer, size, &length, "JOINREQ (SL:");
+            trace_append_number(buffer, size, &length, record->args[0]);
+            func_retval = trace_append(buffer, size, &length, ")\r\n");
+
+            break;
+
+        case COMMS_TRACE_JOINRESP:
+
+            trace_append(buffer, size, &length, "JOINRESP (ID:");
+            trace_append_number(buffer, size, &length, record->args[0]);
+            func_retval = trace_append(buffer, size, &length, ")\r\n");
+
+            break;
+
+        case COMMS_TRACE_STATUS:
+        case COMMS_TRACE_CONTRL:
+
+            for(index = 0; index < record->args[1] && index < COMMS_TRACE_DATA; index++)
+                payload[index] = (char)(record->args[2 + (index >> 2)] >> ((index & 3) * 8));
+
+            trace_append(buffer, size, &length, record->event == COMMS_TRACE_STATUS ? "STATUS (DID:" : "CONTROL (SID:");
+            trace_append_number(buffer, size, &length, record->args[0]);
+            trace_append(buffer, size, &length, " LEN:");
+            trace_append_number(buffer, size, &length, record->args[1]);
+            trace_append(buffer, size, &length, ") DATA: ");
+            trace_append(buffer, size, &length, payload);
+            func_retval = trace_append(buffer, size, &length, "\r\n");
+
+            break;
+
+        default:
+
+            func_retval = -1;
+
+            break;
+    }
+
+    return func_retval < 0 ? -1 : (int16_t)length;
+}
@@ -0,0 +1,455 @@
+/**
+ ******************************************************************************
+ * @file    gw_bench.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway loopback benchmark source file
+ *
+ *  Info
+ *          The peer sends downlink messages to the joined loopback clients in
+ *          turn with a fixed number in flight, the clients post an uplink
+ *          message whenever their application buffer is free. Payloads carry
+ *          the sending time for the latency.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+#include "gw_bench.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Private Functions                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+static uint64_t gw_bench_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+
+/*******************************************************************
+ * @brief  Count a received message of the measurement period, the
+ *         payload carries its sequence number and sending time
+ * @param  *bench      : reference to the benchmark
+ * @param  *direction  : direction of the message
+ * @param  *message    : received message
+ * @param  length      : message length
+ *******************************************************************/
+static void gw_bench_count(gw_bench_t *bench, gw_bench_direction_t *direction, const char *message, uint16_t length)
+{
+    char               text[NET_DATA_LENGTH] = {0};
+    unsigned int       sequence;
+    unsigned long long sent;
+    uint64_t           latency;
+
+    memcpy(text, message, length < sizeof(text) ? length : sizeof(text) - 1);
+
+    if(!bench->measuring || sscanf(text + 1, "%u@%llu", &sequence, &sent) != 2 || sent < bench->measure_start)
+        return;
+
+    latency = gw_bench_now() - sent;
+
+    direction->received++;
+    direction->latency_total += latency;
+
+    if(latency > direction->latency_max)
+        direction->latency_max = latency;
+}
+
+
+/*******************************************************************
+ * @brief  Send a downlink message from the peer
+ * @param  *bench           : reference to the benchmark
+ * @param  destination_id   : destination client id
+ * @retval int8_t           : error: -1, success: 0
+ *******************************************************************/
+static int8_t gw_bench_send(gw_bench_t *bench, uint8_t destination_id)
+{
+    char    record[GW_RECORD_HEADER + NET_DATA_LENGTH];
+    int     length;
+    ssize_t sent;
+
+    length = snprintf(record + GW_RECORD_HEADER, NET_DATA_LENGTH, "d%u@%llu", bench->sequence++,
+                      (unsigned long long)gw_bench_now());
+
+    record[0] = (char)destination_id;
+    record[1] = (char)length;
+
+    /* Datagram is the client id and the payload, the stream carries the length too */
+    if(bench->config.transport == GW_BENCH_UDP)
+    {
+        record[1] = record[0];
+
+        sent = send(bench->peer_fd, record + 1, (size_t)length + 1, 0);
+    }
+    else
+    {
+        sent = send(bench->peer_fd, record, (size_t)length + GW_RECORD_HEADER, MSG_NOSIGNAL);
+    }
+
+    return sent > 0 ? 0 : -1;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+/*******************************************************************
+ * @brief  Open the IP side peer socket, a UDP peer is bound before
+ *         the bridge starts so the bridge sends uplinks to it
+ * @param  *bench    : reference to the benchmark
+ * @param  *config   : benchmark configuration
+ * @param  epoll_fd  : event loop
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_bench_open(gw_bench_t *bench, const gw_bench_config_t *config, int epoll_fd)
+{
+    int8_t             func_retval = 0;
+    struct sockaddr_in address;
+    socklen_t          address_length = sizeof(address);
+
+    memset(bench, 0, sizeof(*bench));
+
+    bench->config   = *config;
+    bench->epoll_fd = epoll_fd;
+    bench->peer_fd  = socket(AF_INET, (config->transport == GW_BENCH_UDP ? SOCK_DGRAM : SOCK_STREAM) |
+                             SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if(bench->peer_fd < 0)
+        return -1;
+
+    if(config->transport == GW_BENCH_UDP)
+    {
+        memset(&address, 0, sizeof(address));
+
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        /* Ephemeral port, the bridge sends the uplinks to it */
+        if(bind(bench->peer_fd, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+           getsockname(bench->peer_fd, (struct sockaddr*)&address, &address_length) < 0)
+            func_retval = -1;
+        else
+            bench->peer_port = ntohs(address.sin_port);
+    }
+
+    if(func_retval < 0)
+        gw_bench_close(bench);
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Start the benchmark, connects a TCP peer to the bridge
+ * @param  *bench  : reference to the benchmark
+ * @param  *radio  : gateway radio with the loopback clients
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_bench_start(gw_bench_t *bench, gw_radio_t *radio)
+{
+    int8_t             func_retval = 0;
+    struct sockaddr_in address;
+    struct epoll_event event;
+    int                nodelay = 1;
+
+    bench->radio      = radio;
+    bench->start_time = gw_bench_now();
+
+    memset(&address, 0, sizeof(address));
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(bench->config.gateway_port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bench->config.transport == GW_BENCH_TCP)
+        setsockopt(bench->peer_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    /* Non blocking connect, the local listener accepts from the event loop */
+    if(connect(bench->peer_fd, (struct sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS)
+        func_retval = -1;
+
+    event.events  = EPOLLIN | EPOLLET;
+    event.data.fd = bench->peer_fd;
+
+    if(func_retval == 0 && epoll_ctl(bench->epoll_fd, EPOLL_CTL_ADD, bench->peer_fd, &event) < 0)
+        func_retval = -1;
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Handle an event loop event of the peer socket
+ * @param  *bench  : reference to the benchmark
+ * @param  fd      : ready file descriptor
+ * @retval int8_t  : not the peer descriptor: 0, handled: 1
+ *******************************************************************/
+int8_t gw_bench_handle(gw_bench_t *bench, int fd)
+{
+    ssize_t  length;
+    uint16_t offset;
+    uint16_t record;
+
+    if(fd < 0 || fd != bench->peer_fd)
+        return 0;
+
+    for(;;)
+    {
+        length = recv(bench->peer_fd, bench->rx + bench->rx_length, sizeof(bench->rx) - bench->rx_length, 0);
+
+        if(length < 0 && errno == EINTR)
+            continue;
+
+        if(length <= 0)
+            break;
+
+        if(bench->config.transport == GW_BENCH_UDP)
+        {
+            if(length > 1)
+                gw_bench_count(bench, &bench->uplink, bench->rx + 1, (uint16_t)(length - 1));
+
+            continue;
+        }
+
+        bench->rx_length += (uint16_t)length;
+
+        offset = 0;
+
+        while(bench->rx_length - offset >= GW_RECORD_HEADER)
+        {
+            record = GW_RECORD_HEADER + (uint8_t)bench->rx[offset + 1];
+
+            if(bench->rx_length - offset < record)
+                break;
+
+            gw_bench_count(bench, &bench->uplink, bench->rx + offset + GW_RECORD_HEADER, record - GW_RECORD_HEADER);
+
+            offset += record;
+        }
+
+        memmove(bench->rx, bench->rx + offset, bench->rx_length - offset);
+
+        bench->rx_length -= offset;
+    }
+
+    return 1;
+}
+
+
+
+/*******************************************************************
+ * @brief  Downlink message delivered to a loopback client
+ * @param  *bench    : reference to the benchmark
+ * @param  *message  : delivered message
+ * @param  length    : message length
+ *******************************************************************/
+void gw_bench_delivered(gw_bench_t *bench, const char *message, uint16_t length)
+{
+    if(length == 0 || message[0] != 'd')
+        return;
+
+    bench->last_delivery = gw_bench_now();
+
+    gw_bench_count(bench, &bench->downlink, message, length);
+}
+
+
+
+/*******************************************************************
+ * @brief  Loopback client stepped, posts the next uplink message
+ *         when the application buffer is free
+ * @param  *bench   : reference to the benchmark
+ * @param  client   : client node index
+ *******************************************************************/
+void gw_bench_client(gw_bench_t *bench, uint32_t client)
+{
+    sim_node_t *node = &bench->radio->nodes[client];
+    char        message[NET_DATA_LENGTH];
+    int         length;
+
+    if(!bench->measuring || bench->done || !node->state.network_joined || node->state.application_pending)
+        return;
+
+    length = snprintf(message, sizeof(message), "u%u@%llu", bench->sequence++, (unsigned long long)gw_bench_now());
+
+    /* Client id 1 is the gateway */
+    if(sim_node_post(node, COMMS_SERVER_SLOTNUM, message, (uint16_t)length) == 0)
+        bench->uplink.sent++;
+}
+
+
+
+/*******************************************************************
+ * @brief  Advance the benchmark after every event loop pass, starts
+ *         the measurement and keeps the downlink window full
+ * @param  *bench  : reference to the benchmark
+ * @retval int8_t  : running: 0, done: 1
+ *******************************************************************/
+int8_t gw_bench_step(gw_bench_t *bench)
+{
+    gw_radio_t *radio = bench->radio;
+    uint64_t    now   = gw_bench_now();
+    uint32_t    joined = 0;
+    uint32_t    index;
+    uint32_t    tries;
+
+    if(bench->done)
+        return 1;
+
+    if(!bench->measuring)
+    {
+        for(index = GW_SERVER_NODE + 1; index < radio->node_count; index++)
+            joined += radio->nodes[index].state.network_joined;
+
+        /* Measure once every client joined, or with the joined ones after the join timeout */
+        if(joined == radio->node_count - 1 || (joined && now - bench->start_time > GW_BENCH_JOIN_TIMEOUT * 1000ULL))
+        {
+            bench->joined        = joined;
+            bench->join_time     = now;
+            bench->measure_start = now;
+            bench->last_delivery = now;
+            bench->measuring     = 1;
+        }
+        else if(now - bench->start_time > GW_BENCH_JOIN_TIMEOUT * 1000ULL * 2)
+        {
+            bench->done = 1;
+        }
+
+        return bench->done;
+    }
+
+    if(now - bench->measure_start >= (uint64_t)bench->config.duration * 1000)
+    {
+        bench->done = 1;
+
+        return 1;
+    }
+
+    /* Messages lost in flight would close the window for good */
+    if(bench->downlink.sent > bench->downlink.received + bench->downlink_lost &&
+       now - bench->last_delivery > GW_BENCH_STALL_TIME * 1000ULL)
+    {
+        bench->downlink_lost = bench->downlink.sent - bench->downlink.received;
+        bench->last_delivery = now;
+    }
+
+    /* Downlink messages to the joined clients in turn */
+    for(tries = 0; tries < radio->node_count &&
+        bench->downlink.sent - bench->downlink.received - bench->downlink_lost < bench->config.window; tries++)
+    {
+        bench->next_client = bench->next_client % (radio->node_count - 1) + 1;
+
+        if(!radio->nodes[bench->next_client].state.network_joined)
+            continue;
+
+        if(gw_bench_send(bench, radio->nodes[bench->next_client].state.device_slot_number) < 0)
+            break;
+
+        bench->downlink.sent++;
+    }
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Print the messages per second of both directions
+ * @param  *bench   : reference to the benchmark
+ * @param  *output  : output stream
+ *******************************************************************/
+void gw_bench_report(const gw_bench_t *bench, FILE *output)
+{
+    const gw_bench_direction_t *direction[2] = {&bench->uplink, &bench->downlink};
+    const char                 *name[2]      = {"uplink", "downlink"};
+    double                      seconds      = (double)bench->config.duration / 1000.0;
+    int                         index;
+
+    fprintf(output, "gateway loopback bench, %s endpoint, %u of %u clients joined in %.2f s, %.1f s measured\n",
+            bench->config.transport == GW_BENCH_UDP ? "udp" : "tcp", bench->joined,
+            bench->radio->node_count - 1, (double)(bench->join_time - bench->start_time) / 1000000.0, seconds);
+
+    for(index = 0; index < 2; index++)
+    {
+        fprintf(output, "  %-9s sent %8llu  received %8llu  %9.1f msg/s  latency mean %7.2f ms  max %7.2f ms\n",
+                name[index], (unsigned long long)direction[index]->sent, (unsigned long long)direction[index]->received,
+                (double)direction[index]->received / seconds,
+                direction[index]->received ? (double)direction[index]->latency_total / direction[index]->received / 1000.0 : 0.0,
+                (double)direction[index]->latency_max / 1000.0);
+    }
+}
+
+
+
+/*******************************************************************
+ * @brief  Close the peer socket
+ * @param  *bench  : reference to the benchmark
+ *******************************************************************/
+void gw_bench_close(gw_bench_t *bench)
+{
+    if(bench->peer_fd >= 0)
+        close(bench->peer_fd);
+
+    bench->peer_fd = -1;
+}
@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ * @file    gw_bench.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway loopback benchmark header file
+ *
+ *  Info
+ *          IP side peer on a real UDP or TCP socket and loopback client
+ *          applications, measures messages per second in both directions.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef GW_BENCH_H_
+#define GW_BENCH_H_
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "gw_radio.h"
+#include "gw_bridge.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Clients not joined after this time are left out of the measurement (ms) */
+#define GW_BENCH_JOIN_TIMEOUT   10000
+
+/* Downlink messages in flight written off after this time without a delivery (ms) */
+#define GW_BENCH_STALL_TIME     1000
+
+
+/* Transport of the local endpoint under test */
+typedef enum _gw_bench_transport
+{
+    GW_BENCH_UDP = 1,
+    GW_BENCH_TCP = 2
+
+}gw_bench_transport_t;
+
+
+/* Benchmark configuration */
+typedef struct _gw_bench_config
+{
+    gw_bench_transport_t transport;      /*!< UDP or TCP endpoint                       */
+    uint16_t             gateway_port;   /*!< Gateway port of the transport             */
+    uint32_t             duration;       /*!< Measurement period after the joins (ms)   */
+    uint8_t              window;         /*!< Downlink messages in flight               */
+
+}gw_bench_config_t;
+
+
+/* Messages of one direction */
+typedef struct _gw_bench_direction
+{
+    uint64_t sent;            /*!< Messages sent in the measurement period          */
+    uint64_t received;        /*!< Messages of the measurement period received       */
+    uint64_t latency_total;   /*!< Sum of the send to receive latencies (us)         */
+    uint64_t latency_max;     /*!< Largest latency (us)                              */
+
+}gw_bench_direction_t;
+
+
+/* Loopback benchmark, IP side peer and loopback client applications */
+typedef struct _gw_bench
+{
+    gw_bench_config_t config;          /*!< Benchmark configuration                  */
+    gw_radio_t       *radio;           /*!< Gateway radio with the loopback clients  */
+    int               epoll_fd;        /*!< Event loop                               */
+    int               peer_fd;         /*!< IP side peer socket                      */
+    uint16_t          peer_port;       /*!< UDP port of the peer                     */
+    char              rx[GW_TCP_BUFFER];   /*!< Partial uplink records              */
+    uint16_t          rx_length;           /*!< Bytes in rx                         */
+
+    uint64_t start_time;               /*!< Benchmark start (us)                     */
+    uint64_t join_time;                /*!< Clients joined (us)                      */
+    uint64_t measure_start;            /*!< Measurement period start (us)            */
+    uint64_t last_delivery;            /*!< Last downlink delivery or stall (us)     */
+    uint32_t joined;                   /*!< Clients joined at the measurement start  */
+    uint8_t  measuring;                /*!< Measurement period running               */
+    uint8_t  done;                     /*!< Measurement period over                  */
+    uint32_t next_client;              /*!< Next downlink destination node           */
+    uint32_t sequence;                 /*!< Message sequence number                  */
+    uint64_t downlink_lost;            /*!< Downlink messages written off            */
+
+    gw_bench_direction_t uplink;       /*!< Client to IP side                        */
+    gw_bench_direction_t downlink;     /*!< IP side to client                        */
+
+}gw_bench_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Open the IP side peer socket, a UDP peer is bound before
+ *         the bridge starts so the bridge sends uplinks to it
+ * @param  *bench    : reference to the benchmark
+ * @param  *config   : benchmark configuration
+ * @param  epoll_fd  : event loop
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_bench_open(gw_bench_t *bench, const gw_bench_config_t *config, int epoll_fd);
+
+
+/*******************************************************************
+ * @brief  Start the benchmark, connects a TCP peer to the bridge
+ * @param  *bench  : reference to the benchmark
+ * @param  *radio  : gateway radio with the loopback clients
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_bench_start(gw_bench_t *bench, gw_radio_t *radio);
+
+
+/*******************************************************************
+ * @brief  Handle an event loop event of the peer socket
+ * @param  *bench  : reference to the benchmark
+ * @param  fd      : ready file descriptor
+ * @retval int8_t  : not the peer descriptor: 0, handled: 1
+ *******************************************************************/
+int8_t gw_bench_handle(gw_bench_t *bench, int fd);
+
+
+/*******************************************************************
+ * @brief  Downlink message delivered to a loopback client
+ * @param  *bench    : reference to the benchmark
+ * @param  *message  : delivered message
+ * @param  length    : message length
+ *******************************************************************/
+void gw_bench_delivered(gw_bench_t *bench, const char *message, uint16_t length);
+
+
+/*******************************************************************
+ * @brief  Loopback client stepped, posts the next uplink message
+ *         when the application buffer is free
+ * @param  *bench   : reference to the benchmark
+ * @param  client   : client node index
+ *******************************************************************/
+void gw_bench_client(gw_bench_t *bench, uint32_t client);
+
+
+/*******************************************************************
+ * @brief  Advance the benchmark after every event loop pass, starts
+ *         the measurement and keeps the downlink window full
+ * @param  *bench  : reference to the benchmark
+ * @retval int8_t  : running: 0, done: 1
+ *******************************************************************/
+int8_t gw_bench_step(gw_bench_t *bench);
+
+
+/*******************************************************************
+ * @brief  Print the messages per second of both directions
+ * @param  *bench   : reference to the benchmark
+ * @param  *output  : output stream
+ *******************************************************************/
+void gw_bench_report(const gw_bench_t *bench, FILE *output);
+
+
+/*******************************************************************
+ * @brief  Close the peer socket
+ * @param  *bench  : reference to the benchmark
+ *******************************************************************/
+void gw_bench_close(gw_bench_t *bench);
+
+
+
+#endif /* GW_BENCH_H_ */
@@ -0,0 +1,527 @@
+/**
+ ******************************************************************************
+ * @file    gw_bridge.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway UDP/TCP bridge source file
+ *
+ *  Info
+ *          Sockets are non blocking and edge triggered, every handler reads or
+ *          writes until EAGAIN. The TCP endpoint keeps one connection, uplink
+ *          records wait in a stream buffer while the socket buffer is full.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
+
+#include "gw_bridge.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Private Functions                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Open a non blocking socket on 127.0.0.1 and register it
+ *         edge triggered with the event loop
+ * @param  *bridge   : reference to the bridge
+ * @param  type      : SOCK_DGRAM or SOCK_STREAM
+ * @param  port      : local port
+ * @retval int       : error: -1, success: file descriptor
+ *******************************************************************/
+static int gw_socket_open(gw_bridge_t *bridge, int type, uint16_t port)
+{
+    struct sockaddr_in address;
+    struct epoll_event event;
+    int                reuse = 1;
+    int                fd    = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if(fd < 0)
+        return -1;
+
+    memset(&address, 0, sizeof(address));
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    event.events  = EPOLLIN | EPOLLET;
+    event.data.fd = fd;
+
+    if(bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+       (type == SOCK_STREAM && listen(fd, 4) < 0) ||
+       epoll_ctl(bridge->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        fprintf(stderr, "gateway: cannot open %s port %u: %s\n", type == SOCK_STREAM ? "TCP" : "UDP", port,
+                strerror(errno));
+
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+
+/*******************************************************************
+ * @brief  Report a changed connection state of the IP side
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+static void gw_bridge_connection(gw_bridge_t *bridge)
+{
+    uint8_t connected = bridge->udp_peer_valid || bridge->tcp_fd >= 0;
+
+    if(connected != bridge->connected)
+    {
+        bridge->connected = connected;
+
+        bridge->events->on_connection(bridge->events->context, connected);
+    }
+}
+
+
+/*******************************************************************
+ * @brief  Close the TCP connection
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+static void gw_tcp_close(gw_bridge_t *bridge)
+{
+    if(bridge->tcp_fd < 0)
+        return;
+
+    epoll_ctl(bridge->epoll_fd, EPOLL_CTL_DEL, bridge->tcp_fd, NULL);
+    close(bridge->tcp_fd);
+
+    bridge->tcp_fd        = -1;
+    bridge->tcp_rx_length = 0;
+    bridge->tcp_tx_length = 0;
+
+    gw_bridge_connection(bridge);
+}
+
+
+/*******************************************************************
+ * @brief  Send queued uplink records until the socket buffer is full
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+static void gw_tcp_flush(gw_bridge_t *bridge)
+{
+    ssize_t sent;
+
+    while(bridge->tcp_fd >= 0 && bridge->tcp_tx_length)
+    {
+        sent = send(bridge->tcp_fd, bridge->tcp_tx, bridge->tcp_tx_length, MSG_NOSIGNAL);
+
+        if(sent > 0)
+        {
+            memmove(bridge->tcp_tx, bridge->tcp_tx + sent, bridge->tcp_tx_length - (size_t)sent);
+
+            bridge->tcp_tx_length -= (uint16_t)sent;
+        }
+        else if(sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            /* EPOLLOUT resumes a full socket buffer */
+            if(sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                gw_tcp_close(bridge);
+
+            break;
+        }
+    }
+}
+
+
+/*******************************************************************
+ * @brief  Accept TCP connections until the backlog is empty, a new
+ *         connection replaces the current one
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+static void gw_tcp_accept(gw_bridge_t *bridge)
+{
+    struct epoll_event event;
+    int                nodelay = 1;
+    int                fd;
+
+    for(;;)
+    {
+        fd = accept(bridge->listen_fd, NULL, NULL);
+
+        if(fd < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        gw_tcp_close(bridge);
+
+        /* Records are small and latency bound */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        event.events  = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+
+        if(epoll_ctl(bridge->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        bridge->tcp_fd = fd;
+
+        gw_bridge_connection(bridge);
+    }
+}
+
+
+/*******************************************************************
+ * @brief  Read the TCP connection until the socket buffer is empty
+ *         and hand every complete record to the gateway
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+static void gw_tcp_read(gw_bridge_t *bridge)
+{
+    ssize_t  length;
+    uint16_t offset;
+    uint16_t record;
+
+    while(bridge->tcp_fd >= 0)
+    {
+        length = recv(bridge->tcp_fd, bridge->tcp_rx + bridge->tcp_rx_length,
+                      sizeof(bridge->tcp_rx) - bridge->tcp_rx_length, 0);
+
+        if(length <= 0)
+        {
+            if(length == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                gw_tcp_close(bridge);
+
+            if(length == 0 || errno != EINTR)
+                break;
+
+            continue;
+        }
+
+        bridge->tcp_rx_length += (uint16_t)length;
+
+        /* Complete records, client id, payload length and payload */
+        offset = 0;
+
+        while(bridge->tcp_rx_length - offset >= GW_RECORD_HEADER)
+        {
+            record = GW_RECORD_HEADER + (uint8_t)bridge->tcp_rx[offset + 1];
+
+            if(bridge->tcp_rx_length - offset < record)
+                break;
+
+            bridge->stats.downlinks_tcp++;
+
+            bridge->events->on_downlink(bridge->events->context, (uint8_t)bridge->tcp_rx[offset],
+                                        bridge->tcp_rx + offset + GW_RECORD_HEADER, record - GW_RECORD_HEADER);
+
+            offset += record;
+        }
+
+        memmove(bridge->tcp_rx, bridge->tcp_rx + offset, bridge->tcp_rx_length - offset);
+
+        bridge->tcp_rx_length -= offset;
+    }
+}
+
+
+/*******************************************************************
+ * @brief  Read datagrams until the socket buffer is empty, the last
+ *         sender receives the uplinks without a configured peer
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+static void gw_udp_read(gw_bridge_t *bridge)
+{
+    char               datagram[GW_TCP_BUFFER];
+    struct sockaddr_in sender;
+    socklen_t          sender_length;
+    ssize_t            length;
+
+    for(;;)
+    {
+        sender_length = sizeof(sender);
+
+        length = recvfrom(bridge->udp_fd, datagram, sizeof(datagram), 0, (struct sockaddr*)&sender, &sender_length);
+
+        if(length < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        if(bridge->config.udp_peer_port == 0)
+        {
+            bridge->udp_peer       = sender;
+            bridge->udp_peer_valid = 1;
+
+            gw_bridge_connection(bridge);
+        }
+
+        if(length < 1)
+        {
+            bridge->stats.records_malformed++;
+            continue;
+        }
+
+        bridge->stats.downlinks_udp++;
+
+        bridge->events->on_downlink(bridge->events->context, (uint8_t)datagram[0], datagram + 1, (uint16_t)(length - 1));
+    }
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+/*******************************************************************
+ * @brief  Open the local endpoint sockets on 127.0.0.1, registers
+ *         them edge triggered with the event loop
+ * @param  *bridge   : reference to the bridge
+ * @param  *config   : endpoint configuration
+ * @param  *events   : bridge callbacks
+ * @param  epoll_fd  : event loop
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_bridge_start(gw_bridge_t *bridge, const gw_bridge_config_t *config, gw_bridge_events_t *events, int epoll_fd)
+{
+    int8_t func_retval = 0;
+
+    if(bridge == NULL || config == NULL || events == NULL)
+        return -1;
+
+    memset(bridge, 0, sizeof(*bridge));
+
+    bridge->config    = *config;
+    bridge->events    = events;
+    bridge->epoll_fd  = epoll_fd;
+    bridge->udp_fd    = -1;
+    bridge->listen_fd = -1;
+    bridge->tcp_fd    = -1;
+
+    if(config->udp_port)
+    {
+        bridge->udp_fd = gw_socket_open(bridge, SOCK_DGRAM, config->udp_port);
+
+        if(bridge->udp_fd < 0)
+            func_retval = -1;
+    }
+
+    if(func_retval == 0 && config->tcp_port)
+    {
+        bridge->listen_fd = gw_socket_open(bridge, SOCK_STREAM, config->tcp_port);
+
+        if(bridge->listen_fd < 0)
+            func_retval = -1;
+    }
+
+    /* Configured UDP endpoint counts as connected from the start */
+    if(func_retval == 0 && bridge->udp_fd >= 0 && config->udp_peer_port)
+    {
+        bridge->udp_peer.sin_family      = AF_INET;
+        bridge->udp_peer.sin_port        = htons(config->udp_peer_port);
+        bridge->udp_peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bridge->udp_peer_valid           = 1;
+
+        gw_bridge_connection(bridge);
+    }
+
+    if(func_retval < 0)
+        gw_bridge_stop(bridge);
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Handle an event loop event of a bridge file descriptor
+ * @param  *bridge      : reference to the bridge
+ * @param  fd           : ready file descriptor
+ * @param  epoll_events : ready events
+ * @retval int8_t       : not a bridge descriptor: 0, handled: 1
+ *******************************************************************/
+int8_t gw_bridge_handle(gw_bridge_t *bridge, int fd, uint32_t epoll_events)
+{
+    int8_t func_retval = 1;
+
+    if(fd < 0)
+    {
+        func_retval = 0;
+    }
+    else if(fd == bridge->udp_fd)
+    {
+        gw_udp_read(bridge);
+    }
+    else if(fd == bridge->listen_fd)
+    {
+        gw_tcp_accept(bridge);
+    }
+    else if(fd == bridge->tcp_fd)
+    {
+        if(epoll_events & EPOLLOUT)
+            gw_tcp_flush(bridge);
+
+        /* Records in front of a hang up are read first */
+        if(epoll_events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            gw_tcp_read(bridge);
+    }
+    else
+    {
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Forward an uplink message to the UDP endpoint and the TCP
+ *         connection
+ * @param  *bridge     : reference to the bridge
+ * @param  source_id   : source client id
+ * @param  *message    : uplink message
+ * @param  length      : message length
+ * @retval int8_t      : dropped: -1, success: 0
+ *******************************************************************/
+int8_t gw_bridge_uplink(gw_bridge_t *bridge, uint8_t source_id, const char *message, uint16_t length)
+{
+    int8_t        func_retval = -1;
+    char          record[GW_RECORD_HEADER + 255];
+    struct iovec  segments[2];
+    struct msghdr datagram;
+
+    if(length > 255)
+        length = 255;
+
+    record[0] = (char)source_id;
+    record[1] = (char)length;
+
+    memcpy(record + GW_RECORD_HEADER, message, length);
+
+    /* Datagram gathers the client id and the payload */
+    segments[0].iov_base = record;
+    segments[0].iov_len  = 1;
+    segments[1].iov_base = (void*)message;
+    segments[1].iov_len  = length;
+
+    memset(&datagram, 0, sizeof(datagram));
+
+    datagram.msg_name    = &bridge->udp_peer;
+    datagram.msg_namelen = sizeof(bridge->udp_peer);
+    datagram.msg_iov     = segments;
+    datagram.msg_iovlen  = 2;
+
+    if(bridge->udp_fd >= 0 && bridge->udp_peer_valid && sendmsg(bridge->udp_fd, &datagram, 0) >= 0)
+    {
+        bridge->stats.uplinks_udp++;
+
+        func_retval = 0;
+    }
+
+    if(bridge->tcp_fd >= 0 && (size_t)bridge->tcp_tx_length + GW_RECORD_HEADER + length <= sizeof(bridge->tcp_tx))
+    {
+        memcpy(bridge->tcp_tx + bridge->tcp_tx_length, record, GW_RECORD_HEADER + length);
+
+        bridge->tcp_tx_length += GW_RECORD_HEADER + length;
+
+        bridge->stats.uplinks_tcp++;
+
+        gw_tcp_flush(bridge);
+
+        func_retval = 0;
+    }
+
+    if(func_retval < 0)
+        bridge->stats.uplinks_dropped++;
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Close the bridge sockets
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+void gw_bridge_stop(gw_bridge_t *bridge)
+{
+    gw_tcp_close(bridge);
+
+    if(bridge->udp_fd >= 0)
+        close(bridge->udp_fd);
+
+    if(bridge->listen_fd >= 0)
+        close(bridge->listen_fd);
+
+    bridge->udp_fd    = -1;
+    bridge->listen_fd = -1;
+}
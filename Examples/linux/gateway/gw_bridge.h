@@ -0,0 +1,184 @@
+/**
+ ******************************************************************************
+ * @file    gw_bridge.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway UDP/TCP bridge header file
+ *
+ *  Info
+ *          Carries gateway messages to a local endpoint. A UDP datagram is the
+ *          client id followed by the payload, the TCP stream carries records of
+ *          client id, payload length and payload. Downlinks name the destination
+ *          client id, uplinks the source client id.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef GW_BRIDGE_H_
+#define GW_BRIDGE_H_
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <netinet/in.h>
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* TCP stream buffers, records are at most 2 + 255 bytes */
+#define GW_TCP_BUFFER      4096
+
+/* Record header on the TCP stream, client id and payload length */
+#define GW_RECORD_HEADER   2
+
+
+/* Local endpoint configuration, port 0 disables the transport */
+typedef struct _gw_bridge_config
+{
+    uint16_t udp_port;        /*!< UDP port of the gateway                              */
+    uint16_t udp_peer_port;   /*!< UDP port uplinks are sent to, 0 last downlink sender */
+    uint16_t tcp_port;        /*!< TCP listening port of the gateway                    */
+
+}gw_bridge_config_t;
+
+
+/* Bridge counters */
+typedef struct _gw_bridge_stats
+{
+    uint64_t uplinks_udp;         /*!< Uplink datagrams sent                      */
+    uint64_t uplinks_tcp;         /*!< Uplink records queued on the TCP stream    */
+    uint64_t uplinks_dropped;     /*!< Uplinks without endpoint or stream space   */
+    uint64_t downlinks_udp;       /*!< Downlink datagrams received                */
+    uint64_t downlinks_tcp;       /*!< Downlink records received                  */
+    uint64_t records_malformed;   /*!< Datagrams without a client id              */
+
+}gw_bridge_stats_t;
+
+
+/* Bridge callbacks */
+typedef struct _gw_bridge_events
+{
+    void *context;
+
+    /* Downlink message for a client from the IP side */
+    void (*on_downlink)(void *context, uint8_t destination_id, const char *message, uint16_t length);
+
+    /* IP side connection state changed */
+    void (*on_connection)(void *context, uint8_t connected);
+
+}gw_bridge_events_t;
+
+
+/* UDP/TCP bridge to a local endpoint */
+typedef struct _gw_bridge
+{
+    gw_bridge_config_t  config;            /*!< Endpoint configuration                  */
+    gw_bridge_events_t *events;            /*!< Bridge callbacks                        */
+    int                 epoll_fd;          /*!< Event loop                              */
+
+    int                 udp_fd;            /*!< UDP socket, -1 disabled                 */
+    struct sockaddr_in  udp_peer;          /*!< Uplink datagram destination             */
+    uint8_t             udp_peer_valid;    /*!< Uplink destination known                */
+
+    int                 listen_fd;         /*!< TCP listening socket, -1 disabled       */
+    int                 tcp_fd;            /*!< TCP connection, -1 not connected        */
+    char                tcp_rx[GW_TCP_BUFFER];  /*!< Partial downlink records           */
+    uint16_t            tcp_rx_length;          /*!< Bytes in tcp_rx                    */
+    char                tcp_tx[GW_TCP_BUFFER];  /*!< Uplink records not sent yet       */
+    uint16_t            tcp_tx_length;          /*!< Bytes in tcp_tx                    */
+
+    uint8_t             connected;         /*!< Last reported connection state          */
+    gw_bridge_stats_t   stats;             /*!< Bridge counters                         */
+
+}gw_bridge_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Open the local endpoint sockets on 127.0.0.1, registers
+ *         them edge triggered with the event loop
+ * @param  *bridge   : reference to the bridge
+ * @param  *config   : endpoint configuration
+ * @param  *events   : bridge callbacks
+ * @param  epoll_fd  : event loop
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_bridge_start(gw_bridge_t *bridge, const gw_bridge_config_t *config, gw_bridge_events_t *events, int epoll_fd);
+
+
+/*******************************************************************
+ * @brief  Handle an event loop event of a bridge file descriptor
+ * @param  *bridge      : reference to the bridge
+ * @param  fd           : ready file descriptor
+ * @param  epoll_events : ready events
+ * @retval int8_t       : not a bridge descriptor: 0, handled: 1
+ *******************************************************************/
+int8_t gw_bridge_handle(gw_bridge_t *bridge, int fd, uint32_t epoll_events);
+
+
+/*******************************************************************
+ * @brief  Forward an uplink message to the UDP endpoint and the TCP
+ *         connection
+ * @param  *bridge     : reference to the bridge
+ * @param  source_id   : source client id
+ * @param  *message    : uplink message
+ * @param  length      : message length
+ * @retval int8_t      : dropped: -1, success: 0
+ *******************************************************************/
+int8_t gw_bridge_uplink(gw_bridge_t *bridge, uint8_t source_id, const char *message, uint16_t length);
+
+
+/*******************************************************************
+ * @brief  Close the bridge sockets
+ * @param  *bridge  : reference to the bridge
+ *******************************************************************/
+void gw_bridge_stop(gw_bridge_t *bridge);
+
+
+
+#endif /* GW_BRIDGE_H_ */
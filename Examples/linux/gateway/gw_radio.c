@@ -0,0 +1,649 @@
+/**
+ ******************************************************************************
+ * @file    gw_radio.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway radio source file
+ *
+ *  Info
+ *          Nodes are simulator nodes stepped from timerfd expirations of the
+ *          event loop. Loopback frames are delivered after the sending step
+ *          returns, the network_operations_t callbacks run with one node current.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "gw_radio.h"
+
+/* API headers */
+#include "comms_network.h"
+#include "comms_server_fsm.h"
+#include "comms_client_fsm.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define GW_CLIENT_BOOT_TIMER  5000   /*!< Client timer before first SYNC (us), as on the launchpad */
+#define GW_SERVER_BOOT_TIMER  1000   /*!< Server timer before START_STATE (us)                     */
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Private Functions                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+static void gw_radio_flush(gw_radio_t *radio);
+
+
+/*******************************************************************
+ * @brief  Serial line speed of a baud rate
+ * @param  baud_rate : baud rate
+ * @retval speed_t   : unsupported: B0, success: line speed
+ *******************************************************************/
+static speed_t gw_serial_speed(uint32_t baud_rate)
+{
+    speed_t func_retval = B0;
+
+    switch(baud_rate)
+    {
+    case 9600:   func_retval = B9600;   break;
+    case 19200:  func_retval = B19200;  break;
+    case 38400:  func_retval = B38400;  break;
+    case 57600:  func_retval = B57600;  break;
+    case 115200: func_retval = B115200; break;
+    case 230400: func_retval = B230400; break;
+    case 460800: func_retval = B460800; break;
+    case 921600: func_retval = B921600; break;
+    default:     func_retval = B0;      break;
+    }
+
+    return func_retval;
+}
+
+
+/*******************************************************************
+ * @brief  Open the serial radio raw and non blocking
+ * @param  *device    : serial device path
+ * @param  baud_rate  : baud rate
+ * @retval int        : error: -1, success: file descriptor
+ *******************************************************************/
+static int gw_serial_open(const char *device, uint32_t baud_rate)
+{
+    struct termios settings;
+    speed_t        speed = gw_serial_speed(baud_rate);
+    int            fd    = -1;
+
+    if(device == NULL || speed == B0)
+        return -1;
+
+    fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if(fd < 0)
+        return -1;
+
+    if(tcgetattr(fd, &settings) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    /* 8N1, no flow control, frames are binary */
+    cfmakeraw(&settings);
+
+    settings.c_cflag |= CLOCAL | CREAD;
+    settings.c_cflag &= ~CRTSCTS;
+
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+
+    if(tcsetattr(fd, TCSANOW, &settings) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    tcflush(fd, TCIOFLUSH);
+
+    return fd;
+}
+
+
+/*******************************************************************
+ * @brief  Arm the periodic transmit timer of a node
+ * @param  *radio  : reference to the radio
+ * @param  *node   : reference to the node
+ *******************************************************************/
+static void gw_timer_arm(gw_radio_t *radio, sim_node_t *node)
+{
+    struct itimerspec period;
+
+    memset(&period, 0, sizeof(period));
+
+    period.it_value.tv_sec  = (time_t)(node->timer_period / 1000000);
+    period.it_value.tv_nsec = (long)(node->timer_period % 1000000) * 1000;
+    period.it_interval      = period.it_value;
+
+    timerfd_settime(radio->timer_fds[node->config.index], 0, &period, NULL);
+}
+
+
+
+/*********************************************************
+ * Node callbacks, network_operations_t of the nodes
+ *********************************************************/
+
+static void gw_on_send(void *context, sim_node_t *node, const char *frame, uint16_t length)
+{
+    gw_radio_t *radio = context;
+    gw_frame_t *air   = NULL;
+    ssize_t     sent  = 0;
+    uint32_t    capacity;
+
+    if(length == 0 || length > NET_MTU_SIZE)
+        return;
+
+    if(radio->serial_fd >= 0)
+    {
+        /* Frames are a few UART FIFO loads, a full driver buffer loses the frame like a radio collision */
+        sent = write(radio->serial_fd, frame, length);
+
+        if(sent != (ssize_t)length)
+            radio->stats.serial_errors++;
+
+        return;
+    }
+
+    /* Loopback channel, the other nodes receive it when the sending step returns */
+    if(radio->air_count == radio->air_capacity)
+    {
+        capacity = radio->air_capacity ? radio->air_capacity * 2 : 16;
+        air      = realloc(radio->air, capacity * sizeof(gw_frame_t));
+
+        if(air == NULL)
+            return;
+
+        radio->air          = air;
+        radio->air_capacity = capacity;
+    }
+
+    air = &radio->air[radio->air_count++];
+
+    air->sender = node->config.index;
+    air->length = length;
+
+    memcpy(air->data, frame, length);
+}
+
+
+static void gw_on_set_timer(void *context, sim_node_t *node, uint16_t slot_time, uint8_t slot_number)
+{
+    gw_radio_t *radio = context;
+
+    node->timer_period = (uint64_t)slot_time * slot_number * 1000;
+
+    gw_timer_arm(radio, node);
+}
+
+
+static void gw_on_reset_timer(void *context, sim_node_t *node)
+{
+    gw_radio_t *radio = context;
+
+    if(node->timer_period == 0)
+        return;
+
+    gw_timer_arm(radio, node);
+}
+
+
+static void gw_on_radio(void *context, sim_node_t *node, uint8_t awake)
+{
+    (void)context;
+
+    node->radio_asleep = awake ? 0 : 1;
+}
+
+
+
+/*********************************************************
+ * Node steps
+ *********************************************************/
+
+/*******************************************************************
+ * @brief  Hand the messages of a node to the gateway after a step
+ * @param  *radio  : reference to the radio
+ * @param  *node   : reference to the node
+ *******************************************************************/
+static void gw_node_done(gw_radio_t *radio, sim_node_t *node)
+{
+    comms_server_context_t *server;
+
+    if(node->config.role == SIM_ROLE_SERVER)
+    {
+        server = node->instance;
+
+        if(server->buffers.application_flags.network_message_ready)
+        {
+            radio->stats.uplinks++;
+
+            radio->events->on_uplink(radio->events->context, server->buffers.source_id,
+                                     server->buffers.network_message_data, server->buffers.net_message_length);
+
+            server->buffers.application_flags.network_message_ready = 0;
+        }
+    }
+    else
+    {
+        if(node->state.message_ready)
+        {
+            node->state.message_ready = 0;
+
+            radio->events->on_delivered(radio->events->context, radio, node->config.index, node->state.source_id,
+                                        node->state.message, node->state.message_length);
+        }
+
+        radio->events->on_client(radio->events->context, radio, node->config.index);
+    }
+}
+
+
+/*******************************************************************
+ * @brief  Deliver the loopback frames to every other node with the
+ *         radio awake, frames sent by receivers are delivered too
+ * @param  *radio  : reference to the radio
+ *******************************************************************/
+static void gw_radio_flush(gw_radio_t *radio)
+{
+    gw_frame_t frame;
+    uint32_t   index = 0;
+    uint32_t   node;
+
+    while(index < radio->air_count)
+    {
+        /* Receivers append frames and may move the channel buffer */
+        frame = radio->air[index++];
+
+        for(node = 0; node < radio->node_count; node++)
+        {
+            if(node == frame.sender || radio->nodes[node].radio_asleep)
+                continue;
+
+            sim_node_receive(&radio->nodes[node], frame.data, frame.length);
+
+            gw_node_done(radio, &radio->nodes[node]);
+        }
+    }
+
+    radio->air_count = 0;
+}
+
+
+/*******************************************************************
+ * @brief  Transmit timer interrupt of a node, the server posts the
+ *         oldest downlink message before its step
+ * @param  *radio  : reference to the radio
+ * @param  *node   : reference to the node
+ *******************************************************************/
+static void gw_node_timer(gw_radio_t *radio, sim_node_t *node)
+{
+    gw_downlink_t *downlink;
+
+    if(node->config.role == SIM_ROLE_SERVER)
+    {
+        if(radio->downlink_count)
+        {
+            downlink = &radio->downlink[radio->downlink_head];
+
+            if(comms_server_gateway_post(node->instance, downlink->destination_id, downlink->data, downlink->length) != 0)
+            {
+                radio->downlink_head = (radio->downlink_head + 1) % GW_DOWNLINK_QUEUE;
+                radio->downlink_count--;
+
+                radio->stats.downlinks++;
+            }
+        }
+    }
+    else if(node->state.network_joined == 0)
+    {
+        /* Loopback clients keep pressing join until the server admits them */
+        sim_node_join(node);
+    }
+
+    sim_node_timer_isr(node);
+
+    gw_node_done(radio, node);
+
+    gw_radio_flush(radio);
+}
+
+
+/*******************************************************************
+ * @brief  Read the serial radio until the driver buffer is empty,
+ *         the descriptor is edge triggered
+ * @param  *radio  : reference to the radio
+ *******************************************************************/
+static void gw_serial_read(gw_radio_t *radio)
+{
+    char    buffer[NET_MTU_SIZE];
+    ssize_t length;
+
+    for(;;)
+    {
+        length = read(radio->serial_fd, buffer, sizeof(buffer));
+
+        if(length > 0)
+        {
+            sim_node_receive(&radio->nodes[GW_SERVER_NODE], buffer, (uint16_t)length);
+
+            gw_node_done(radio, &radio->nodes[GW_SERVER_NODE]);
+        }
+        else
+        {
+            if(length < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                radio->stats.serial_errors++;
+
+            if(length == 0 || errno != EINTR)
+                break;
+        }
+    }
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+/*******************************************************************
+ * @brief  Start the gateway server and the radio, registers the
+ *         radio file descriptors edge triggered with the event loop
+ * @param  *radio    : reference to the radio
+ * @param  *config   : radio configuration
+ * @param  *events   : gateway callbacks
+ * @param  epoll_fd  : event loop
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_radio_start(gw_radio_t *radio, const gw_radio_config_t *config, gw_radio_events_t *events, int epoll_fd)
+{
+    int8_t             func_retval = 0;
+    sim_node_config_t  node_config;
+    struct epoll_event event;
+    uint32_t           index;
+
+    if(radio == NULL || config == NULL || events == NULL)
+        return -1;
+
+    memset(radio, 0, sizeof(*radio));
+
+    radio->config    = *config;
+    radio->events    = events;
+    radio->epoll_fd  = epoll_fd;
+    radio->serial_fd = -1;
+
+    radio->handlers.context        = radio;
+    radio->handlers.on_send        = gw_on_send;
+    radio->handlers.on_set_timer   = gw_on_set_timer;
+    radio->handlers.on_reset_timer = gw_on_reset_timer;
+    radio->handlers.on_radio       = gw_on_radio;
+
+    radio->node_count = 1 + (config->mode == GW_RADIO_LOOPBACK ? config->clients : 0);
+    radio->nodes      = calloc(radio->node_count, sizeof(sim_node_t));
+    radio->timer_fds  = calloc(radio->node_count, sizeof(int));
+
+    if(radio->nodes == NULL || radio->timer_fds == NULL)
+        func_retval = -1;
+
+    for(index = 0; index < radio->node_count && radio->timer_fds != NULL; index++)
+        radio->timer_fds[index] = -1;
+
+    if(func_retval == 0 && config->mode == GW_RADIO_SERIAL)
+    {
+        radio->serial_fd = gw_serial_open(config->device, config->baud_rate);
+
+        if(radio->serial_fd < 0)
+        {
+            fprintf(stderr, "gateway: cannot open %s at %u baud\n", config->device ? config->device : "(none)",
+                    config->baud_rate);
+
+            func_retval = -1;
+        }
+        else
+        {
+            event.events  = EPOLLIN | EPOLLET;
+            event.data.fd = radio->serial_fd;
+
+            if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, radio->serial_fd, &event) < 0)
+                func_retval = -1;
+        }
+    }
+
+    for(index = 0; index < radio->node_count && func_retval == 0; index++)
+    {
+        radio->timer_fds[index] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+        event.events  = EPOLLIN | EPOLLET;
+        event.data.fd = radio->timer_fds[index];
+
+        if(radio->timer_fds[index] < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, radio->timer_fds[index], &event) < 0)
+        {
+            func_retval = -1;
+            break;
+        }
+
+        memset(&node_config, 0, sizeof(node_config));
+
+        node_config.index   = index;
+        node_config.verbose = config->verbose;
+
+        if(index == GW_SERVER_NODE)
+        {
+            node_config.role        = SIM_ROLE_SERVER;
+            node_config.network_id  = config->network_id;
+            node_config.slot_time   = config->slot_time;
+            node_config.total_slots = config->total_slots;
+            node_config.server_mode = WI_GATEWAY_SERVER;
+        }
+        else
+        {
+            node_config.role = SIM_ROLE_CLIENT;
+        }
+
+        func_retval = sim_node_start(&radio->nodes[index], &node_config, &radio->handlers);
+
+        /* Boot timers, the server starts the frame grid and clients listen for a SYNC message */
+        if(func_retval == 0)
+        {
+            radio->nodes[index].timer_period = index == GW_SERVER_NODE ? GW_SERVER_BOOT_TIMER : GW_CLIENT_BOOT_TIMER;
+
+            gw_timer_arm(radio, &radio->nodes[index]);
+        }
+    }
+
+    if(func_retval < 0)
+        gw_radio_stop(radio);
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Handle an event loop event of a radio file descriptor
+ * @param  *radio  : reference to the radio
+ * @param  fd      : ready file descriptor
+ * @retval int8_t  : not a radio descriptor: 0, handled: 1
+ *******************************************************************/
+int8_t gw_radio_handle(gw_radio_t *radio, int fd)
+{
+    int8_t   func_retval = 0;
+    uint64_t expirations = 0;
+    uint32_t index;
+
+    if(fd == radio->serial_fd)
+    {
+        gw_serial_read(radio);
+
+        func_retval = 1;
+    }
+
+    for(index = 0; index < radio->node_count && func_retval == 0; index++)
+    {
+        if(fd != radio->timer_fds[index])
+            continue;
+
+        func_retval = 1;
+
+        /* One read drains the edge triggered timer, late periods run one step like a missed timer interrupt */
+        if(read(fd, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0)
+            break;
+
+        radio->stats.timer_overruns += expirations - 1;
+
+        gw_node_timer(radio, &radio->nodes[index]);
+    }
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Queue a downlink message for a client, sent as a CONTRL
+ *         message from the server
+ * @param  *radio          : reference to the radio
+ * @param  destination_id  : destination client id
+ * @param  *message        : downlink message
+ * @param  length          : message length
+ * @retval int8_t          : error or queue full: -1, success: 0
+ *******************************************************************/
+int8_t gw_radio_downlink(gw_radio_t *radio, uint8_t destination_id, const char *message, uint16_t length)
+{
+    int8_t         func_retval = 0;
+    gw_downlink_t *downlink;
+
+    if(length >= NET_DATA_LENGTH - COMMS_TERMINATOR_LENGTH || destination_id <= COMMS_SERVER_SLOTNUM ||
+       radio->downlink_count == GW_DOWNLINK_QUEUE)
+    {
+        radio->stats.downlinks_dropped++;
+
+        func_retval = -1;
+    }
+    else
+    {
+        downlink = &radio->downlink[(radio->downlink_head + radio->downlink_count) % GW_DOWNLINK_QUEUE];
+
+        downlink->destination_id = destination_id;
+        downlink->length         = length;
+
+        memcpy(downlink->data, message, length);
+
+        radio->downlink_count++;
+
+        func_retval = 0;
+    }
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Set the connection state of the IP side
+ * @param  *radio      : reference to the radio
+ * @param  connected   : IP side connected = 1, offline = 0
+ *******************************************************************/
+void gw_radio_set_connected(gw_radio_t *radio, uint8_t connected)
+{
+    if(radio->nodes != NULL && radio->nodes[GW_SERVER_NODE].instance != NULL)
+        comms_server_set_gateway(radio->nodes[GW_SERVER_NODE].instance, connected);
+}
+
+
+
+/*******************************************************************
+ * @brief  Stop the radio and release the nodes
+ * @param  *radio  : reference to the radio
+ *******************************************************************/
+void gw_radio_stop(gw_radio_t *radio)
+{
+    uint32_t index;
+
+    for(index = 0; index < radio->node_count; index++)
+    {
+        if(radio->nodes != NULL)
+            sim_node_stop(&radio->nodes[index]);
+
+        if(radio->timer_fds != NULL && radio->timer_fds[index] >= 0)
+            close(radio->timer_fds[index]);
+    }
+
+    if(radio->serial_fd >= 0)
+        close(radio->serial_fd);
+
+    free(radio->nodes);
+    free(radio->timer_fds);
+    free(radio->air);
+
+    radio->nodes      = NULL;
+    radio->timer_fds  = NULL;
+    radio->air        = NULL;
+    radio->node_count = 0;
+    radio->serial_fd  = -1;
+}
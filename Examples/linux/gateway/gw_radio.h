@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ * @file    gw_radio.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway radio header file
+ *
+ *  Info
+ *          Runs the gateway server state machine against a radio module on a
+ *          serial port or against in process clients on a loopback channel.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef GW_RADIO_H_
+#define GW_RADIO_H_
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+#include "sim_node.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Downlink messages waiting for comms_server_gateway_post, one is sent per frame */
+#define GW_DOWNLINK_QUEUE  16
+
+/* Server node index, loopback clients follow */
+#define GW_SERVER_NODE     0
+
+
+/* Radio the server state machine runs against */
+typedef enum _gw_radio_mode
+{
+    GW_RADIO_SERIAL   = 1,  /*!< Radio module on a serial port            */
+    GW_RADIO_LOOPBACK = 2   /*!< In process clients on a loopback channel  */
+
+}gw_radio_mode_t;
+
+
+/* Radio configuration */
+typedef struct _gw_radio_config
+{
+    gw_radio_mode_t mode;          /*!< Serial or loopback radio               */
+    const char     *device;        /*!< Serial device path                     */
+    uint32_t        baud_rate;     /*!< Serial baud rate                       */
+    uint16_t        network_id;    /*!< Server network id                      */
+    uint16_t        slot_time;     /*!< Server slot time (ms)                  */
+    uint8_t         total_slots;   /*!< Server starting slots                  */
+    uint32_t        clients;       /*!< Loopback clients                       */
+    uint8_t         verbose;       /*!< Forward net_debug_print to stderr      */
+
+}gw_radio_config_t;
+
+
+/* Frame sent on the loopback channel, delivered after the sending step */
+typedef struct _gw_frame
+{
+    uint32_t sender;               /*!< Sending node index   */
+    uint16_t length;               /*!< Frame length         */
+    char     data[NET_MTU_SIZE];   /*!< Frame                */
+
+}gw_frame_t;
+
+
+/* Downlink message from the IP side */
+typedef struct _gw_downlink
+{
+    uint8_t  destination_id;           /*!< Destination client id */
+    uint16_t length;                   /*!< Message length        */
+    char     data[NET_DATA_LENGTH];    /*!< Message               */
+
+}gw_downlink_t;
+
+
+/* Radio counters */
+typedef struct _gw_radio_stats
+{
+    uint64_t uplinks;              /*!< STATUS messages to the gateway handed to the IP side */
+    uint64_t downlinks;            /*!< Downlink messages posted to the server               */
+    uint64_t downlinks_dropped;    /*!< Downlink messages dropped on a full queue            */
+    uint64_t timer_overruns;       /*!< Timer periods missed by the event loop               */
+    uint64_t serial_errors;        /*!< Failed serial reads and writes                       */
+
+}gw_radio_stats_t;
+
+
+struct _gw_radio;
+
+/* Gateway callbacks */
+typedef struct _gw_radio_events
+{
+    void *context;
+
+    /* STATUS message to the gateway, client id 1 */
+    void (*on_uplink)(void *context, uint8_t source_id, const char *message, uint16_t length);
+
+    /* CONTRL message delivered to a loopback client */
+    void (*on_delivered)(void *context, struct _gw_radio *radio, uint32_t client, uint8_t source_id,
+                         const char *message, uint16_t length);
+
+    /* Loopback client stepped, the application may post a message */
+    void (*on_client)(void *context, struct _gw_radio *radio, uint32_t client);
+
+}gw_radio_events_t;
+
+
+/* Gateway radio */
+typedef struct _gw_radio
+{
+    gw_radio_config_t    config;       /*!< Radio configuration                    */
+    gw_radio_events_t   *events;       /*!< Gateway callbacks                      */
+    sim_node_handlers_t  handlers;     /*!< Node callbacks                         */
+    int                  epoll_fd;     /*!< Event loop                             */
+
+    sim_node_t *nodes;                 /*!< Server node and loopback clients       */
+    int        *timer_fds;             /*!< Transmit timer of every node           */
+    uint32_t    node_count;            /*!< Nodes                                  */
+    int         serial_fd;             /*!< Serial radio, -1 loopback              */
+
+    gw_frame_t *air;                   /*!< Loopback frames not delivered yet      */
+    uint32_t    air_count;             /*!< Loopback frames queued                 */
+    uint32_t    air_capacity;          /*!< Loopback frame slots                   */
+
+    gw_downlink_t downlink[GW_DOWNLINK_QUEUE];  /*!< Downlink message ring         */
+    uint8_t       downlink_head;                /*!< Oldest downlink message        */
+    uint8_t       downlink_count;               /*!< Downlink messages queued       */
+
+    gw_radio_stats_t stats;            /*!< Radio counters                         */
+
+}gw_radio_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Start the gateway server and the radio, registers the
+ *         radio file descriptors edge triggered with the event loop
+ * @param  *radio    : reference to the radio
+ * @param  *config   : radio configuration
+ * @param  *events   : gateway callbacks
+ * @param  epoll_fd  : event loop
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t gw_radio_start(gw_radio_t *radio, const gw_radio_config_t *config, gw_radio_events_t *events, int epoll_fd);
+
+
+/*******************************************************************
+ * @brief  Handle an event loop event of a radio file descriptor
+ * @param  *radio  : reference to the radio
+ * @param  fd      : ready file descriptor
+ * @retval int8_t  : not a radio descriptor: 0, handled: 1
+ *******************************************************************/
+int8_t gw_radio_handle(gw_radio_t *radio, int fd);
+
+
+/*******************************************************************
+ * @brief  Queue a downlink message for a client, sent as a CONTRL
+ *         message from the server
+ * @param  *radio          : reference to the radio
+ * @param  destination_id  : destination client id
+ * @param  *message        : downlink message
+ * @param  length          : message length
+ * @retval int8_t          : error or queue full: -1, success: 0
+ *******************************************************************/
+int8_t gw_radio_downlink(gw_radio_t *radio, uint8_t destination_id, const char *message, uint16_t length);
+
+
+/*******************************************************************
+ * @brief  Set the connection state of the IP side
+ * @param  *radio      : reference to the radio
+ * @param  connected   : IP side connected = 1, offline = 0
+ *******************************************************************/
+void gw_radio_set_connected(gw_radio_t *radio, uint8_t connected);
+
+
+/*******************************************************************
+ * @brief  Stop the radio and release the nodes
+ * @param  *radio  : reference to the radio
+ *******************************************************************/
+void gw_radio_stop(gw_radio_t *radio);
+
+
+
+#endif /* GW_RADIO_H_ */
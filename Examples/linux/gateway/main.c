@@ -0,0 +1,424 @@
+/**
+ ******************************************************************************
+ * @file    main.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network Linux gateway daemon
+ *
+ *  Info
+ *          Runs a WI_GATEWAY_SERVER server against a serial radio or loopback
+ *          clients and bridges the gateway messages to a local UDP/TCP endpoint
+ *          from one edge triggered epoll loop.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/epoll.h>
+
+#include "gw_radio.h"
+#include "gw_bridge.h"
+#include "gw_bench.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Launchpad example defaults */
+#define GW_DEFAULT_SLOT_TIME    6
+#define GW_DEFAULT_TOTAL_SLOTS  3
+#define GW_DEFAULT_NETWORK_ID   1
+#define GW_DEFAULT_BAUD_RATE    115200
+#define GW_DEFAULT_CLIENTS      4
+#define GW_DEFAULT_UDP_PORT     47000
+#define GW_DEFAULT_TCP_PORT     47001
+#define GW_DEFAULT_DURATION     10000
+#define GW_DEFAULT_WINDOW       4
+
+/* Events handled per epoll_wait call */
+#define GW_MAX_EVENTS           64
+
+
+/* Gateway process */
+typedef struct _gateway
+{
+    gw_radio_t         radio;          /*!< Server and radio                       */
+    gw_bridge_t        bridge;         /*!< Local UDP/TCP endpoint                 */
+    gw_bench_t         bench;          /*!< Loopback benchmark                     */
+    gw_radio_events_t  radio_events;   /*!< Radio callbacks                        */
+    gw_bridge_events_t bridge_events;  /*!< Bridge callbacks                       */
+    uint8_t            benchmark;      /*!< Loopback benchmark running             */
+    uint8_t            verbose;        /*!< Print forwarded messages               */
+
+}gateway_t;
+
+
+static volatile sig_atomic_t gateway_stop;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                        Gateway callbacks                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+static void gateway_on_uplink(void *context, uint8_t source_id, const char *message, uint16_t length)
+{
+    gateway_t *gateway = context;
+
+    if(gateway->verbose)
+        fprintf(stderr, "uplink   client %3u  %.*s\n", source_id, (int)length, message);
+
+    gw_bridge_uplink(&gateway->bridge, source_id, message, length);
+}
+
+
+static void gateway_on_delivered(void *context, gw_radio_t *radio, uint32_t client, uint8_t source_id,
+                                 const char *message, uint16_t length)
+{
+    gateway_t *gateway = context;
+
+    if(gateway->benchmark)
+    {
+        gw_bench_delivered(&gateway->bench, message, length);
+
+        return;
+    }
+
+    if(gateway->verbose)
+        fprintf(stderr, "downlink client %3u  %.*s\n", radio->nodes[client].state.device_slot_number, (int)length, message);
+
+    /* Loopback clients echo downlink messages to the gateway */
+    if(source_id == COMMS_SERVER_SLOTNUM && !radio->nodes[client].state.application_pending)
+        sim_node_post(&radio->nodes[client], COMMS_SERVER_SLOTNUM, message, length);
+}
+
+
+static void gateway_on_client(void *context, gw_radio_t *radio, uint32_t client)
+{
+    gateway_t *gateway = context;
+
+    (void)radio;
+
+    if(gateway->benchmark)
+        gw_bench_client(&gateway->bench, client);
+}
+
+
+static void gateway_on_downlink(void *context, uint8_t destination_id, const char *message, uint16_t length)
+{
+    gateway_t *gateway = context;
+
+    gw_radio_downlink(&gateway->radio, destination_id, message, length);
+}
+
+
+static void gateway_on_connection(void *context, uint8_t connected)
+{
+    gateway_t *gateway = context;
+
+    if(gateway->verbose)
+        fprintf(stderr, "gateway: IP side %s\n", connected ? "connected" : "offline");
+
+    gw_radio_set_connected(&gateway->radio, connected);
+}
+
+
+static void gateway_on_signal(int signal_number)
+{
+    (void)signal_number;
+
+    gateway_stop = 1;
+}
+
+
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -D, --device <path>      serial radio device, loopback clients without\n"
+            "  -b, --baud <rate>        serial baud rate             (default %d)\n"
+            "  -c, --clients <n>        loopback clients             (default %d)\n"
+            "  -t, --slot-time <ms>     device_slot_time             (default %d)\n"
+            "  -s, --slots <n>          server starting total_slots  (default %d)\n"
+            "  -n, --network-id <n>     server network id            (default %d)\n"
+            "  -u, --udp <port>         UDP port on 127.0.0.1, 0 off (default %d)\n"
+            "  -P, --udp-peer <port>    UDP port uplinks are sent to (default last sender)\n"
+            "  -T, --tcp <port>         TCP port on 127.0.0.1, 0 off (default %d)\n"
+            "  -x, --bench <udp|tcp>    loopback benchmark of the endpoint, messages per second\n"
+            "  -d, --duration <ms>      benchmark measurement period (default %d)\n"
+            "  -w, --window <n>         benchmark downlinks in flight (default %d)\n"
+            "  -v, --verbose            print forwarded messages and node debug output\n",
+            program, GW_DEFAULT_BAUD_RATE, GW_DEFAULT_CLIENTS, GW_DEFAULT_SLOT_TIME, GW_DEFAULT_TOTAL_SLOTS,
+            GW_DEFAULT_NETWORK_ID, GW_DEFAULT_UDP_PORT, GW_DEFAULT_TCP_PORT, GW_DEFAULT_DURATION, GW_DEFAULT_WINDOW);
+}
+
+
+static void print_stats(const gateway_t *gateway, FILE *output)
+{
+    fprintf(output, "  radio     uplinks %llu  downlinks %llu  downlinks dropped %llu  timer overruns %llu  serial errors %llu\n",
+            (unsigned long long)gateway->radio.stats.uplinks, (unsigned long long)gateway->radio.stats.downlinks,
+            (unsigned long long)gateway->radio.stats.downlinks_dropped,
+            (unsigned long long)gateway->radio.stats.timer_overruns, (unsigned long long)gateway->radio.stats.serial_errors);
+
+    fprintf(output, "  bridge    uplinks udp %llu tcp %llu dropped %llu  downlinks udp %llu tcp %llu  malformed %llu\n",
+            (unsigned long long)gateway->bridge.stats.uplinks_udp, (unsigned long long)gateway->bridge.stats.uplinks_tcp,
+            (unsigned long long)gateway->bridge.stats.uplinks_dropped,
+            (unsigned long long)gateway->bridge.stats.downlinks_udp, (unsigned long long)gateway->bridge.stats.downlinks_tcp,
+            (unsigned long long)gateway->bridge.stats.records_malformed);
+}
+
+
+
+int main(int argc, char **argv)
+{
+    static gateway_t   gateway;
+    gw_radio_config_t  radio_config;
+    gw_bridge_config_t bridge_config;
+    gw_bench_config_t  bench_config;
+    struct epoll_event events[GW_MAX_EVENTS];
+    struct sigaction   action;
+    int                epoll_fd;
+    int                ready;
+    int                index;
+    int                option;
+    int                exit_code = EXIT_SUCCESS;
+
+    static const struct option long_options[] =
+    {
+        {"device",     required_argument, NULL, 'D'},
+        {"baud",       required_argument, NULL, 'b'},
+        {"clients",    required_argument, NULL, 'c'},
+        {"slot-time",  required_argument, NULL, 't'},
+        {"slots",      required_argument, NULL, 's'},
+        {"network-id", required_argument, NULL, 'n'},
+        {"udp",        required_argument, NULL, 'u'},
+        {"udp-peer",   required_argument, NULL, 'P'},
+        {"tcp",        required_argument, NULL, 'T'},
+        {"bench",      required_argument, NULL, 'x'},
+        {"duration",   required_argument, NULL, 'd'},
+        {"window",     required_argument, NULL, 'w'},
+        {"verbose",    no_argument,       NULL, 'v'},
+        {"help",       no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    memset(&radio_config, 0, sizeof(radio_config));
+    memset(&bridge_config, 0, sizeof(bridge_config));
+    memset(&bench_config, 0, sizeof(bench_config));
+
+    radio_config.mode        = GW_RADIO_LOOPBACK;
+    radio_config.baud_rate   = GW_DEFAULT_BAUD_RATE;
+    radio_config.clients     = GW_DEFAULT_CLIENTS;
+    radio_config.slot_time   = GW_DEFAULT_SLOT_TIME;
+    radio_config.total_slots = GW_DEFAULT_TOTAL_SLOTS;
+    radio_config.network_id  = GW_DEFAULT_NETWORK_ID;
+
+    bridge_config.udp_port = GW_DEFAULT_UDP_PORT;
+    bridge_config.tcp_port = GW_DEFAULT_TCP_PORT;
+
+    bench_config.duration = GW_DEFAULT_DURATION;
+    bench_config.window   = GW_DEFAULT_WINDOW;
+
+    while((option = getopt_long(argc, argv, "D:b:c:t:s:n:u:P:T:x:d:w:vh", long_options, NULL)) != -1)
+    {
+        switch(option)
+        {
+        case 'D': radio_config.device       = optarg;
+                  radio_config.mode         = GW_RADIO_SERIAL;                       break;
+        case 'b': radio_config.baud_rate    = (uint32_t)strtoul(optarg, NULL, 0);   break;
+        case 'c': radio_config.clients      = (uint32_t)strtoul(optarg, NULL, 0);   break;
+        case 't': radio_config.slot_time    = (uint16_t)strtoul(optarg, NULL, 0);   break;
+        case 's': radio_config.total_slots  = (uint8_t)strtoul(optarg, NULL, 0);    break;
+        case 'n': radio_config.network_id   = (uint16_t)strtoul(optarg, NULL, 0);   break;
+        case 'u': bridge_config.udp_port    = (uint16_t)strtoul(optarg, NULL, 0);   break;
+        case 'P': bridge_config.udp_peer_port = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 'T': bridge_config.tcp_port    = (uint16_t)strtoul(optarg, NULL, 0);   break;
+        case 'd': bench_config.duration     = (uint32_t)strtoul(optarg, NULL, 0);   break;
+        case 'w': bench_config.window       = (uint8_t)strtoul(optarg, NULL, 0);    break;
+        case 'v': gateway.verbose           = 1;
+                  radio_config.verbose      = 1;                                     break;
+
+        case 'x':
+
+            if(strcmp(optarg, "udp") == 0)
+                bench_config.transport = GW_BENCH_UDP;
+            else if(strcmp(optarg, "tcp") == 0)
+                bench_config.transport = GW_BENCH_TCP;
+            else
+            {
+                print_usage(argv[0]);
+
+                return EXIT_FAILURE;
+            }
+
+            gateway.benchmark = 1;
+
+            break;
+
+        default:
+
+            print_usage(argv[0]);
+
+            return option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    /* Benchmark runs the loopback clients against one transport */
+    if(gateway.benchmark)
+    {
+        if(radio_config.mode != GW_RADIO_LOOPBACK || radio_config.clients == 0 || bench_config.window == 0 ||
+           (bench_config.transport == GW_BENCH_UDP ? bridge_config.udp_port : bridge_config.tcp_port) == 0)
+        {
+            fprintf(stderr, "gateway: the benchmark needs loopback clients, a window and the endpoint port\n");
+
+            return EXIT_FAILURE;
+        }
+
+        if(bench_config.transport == GW_BENCH_UDP)
+            bridge_config.tcp_port = 0;
+        else
+            bridge_config.udp_port = 0;
+
+        bench_config.gateway_port = bench_config.transport == GW_BENCH_UDP ? bridge_config.udp_port : bridge_config.tcp_port;
+    }
+
+    memset(&action, 0, sizeof(action));
+
+    /* No SA_RESTART, epoll_wait returns on the signal */
+    action.sa_handler = gateway_on_signal;
+
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    signal(SIGPIPE, SIG_IGN);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if(epoll_fd < 0)
+        return EXIT_FAILURE;
+
+    gateway.radio_events.context      = &gateway;
+    gateway.radio_events.on_uplink    = gateway_on_uplink;
+    gateway.radio_events.on_delivered = gateway_on_delivered;
+    gateway.radio_events.on_client    = gateway_on_client;
+
+    gateway.bridge_events.context       = &gateway;
+    gateway.bridge_events.on_downlink   = gateway_on_downlink;
+    gateway.bridge_events.on_connection = gateway_on_connection;
+
+    gateway.bench.peer_fd = -1;
+
+    /* The UDP peer port is the uplink destination of the bridge */
+    if(gateway.benchmark && gw_bench_open(&gateway.bench, &bench_config, epoll_fd) < 0)
+        exit_code = EXIT_FAILURE;
+
+    if(gateway.benchmark && bench_config.transport == GW_BENCH_UDP)
+        bridge_config.udp_peer_port = gateway.bench.peer_port;
+
+    /* Bridge first, the radio hands uplinks to it from its first step */
+    if(exit_code == EXIT_SUCCESS && gw_bridge_start(&gateway.bridge, &bridge_config, &gateway.bridge_events, epoll_fd) < 0)
+        exit_code = EXIT_FAILURE;
+
+    if(exit_code == EXIT_SUCCESS && gw_radio_start(&gateway.radio, &radio_config, &gateway.radio_events, epoll_fd) < 0)
+    {
+        gw_bridge_stop(&gateway.bridge);
+
+        exit_code = EXIT_FAILURE;
+    }
+
+    if(exit_code == EXIT_SUCCESS)
+        gw_radio_set_connected(&gateway.radio, gateway.bridge.connected);
+
+    if(exit_code == EXIT_SUCCESS && gateway.benchmark && gw_bench_start(&gateway.bench, &gateway.radio) < 0)
+        gateway_stop = 1;
+
+    while(exit_code == EXIT_SUCCESS && !gateway_stop)
+    {
+        ready = epoll_wait(epoll_fd, events, GW_MAX_EVENTS, 100);
+
+        if(ready < 0 && errno != EINTR)
+            break;
+
+        for(index = 0; index < ready; index++)
+        {
+            if(gw_radio_handle(&gateway.radio, events[index].data.fd))
+                continue;
+
+            if(gw_bridge_handle(&gateway.bridge, events[index].data.fd, events[index].events))
+                continue;
+
+            if(gateway.benchmark)
+                gw_bench_handle(&gateway.bench, events[index].data.fd);
+        }
+
+        if(gateway.benchmark && gw_bench_step(&gateway.bench))
+            break;
+    }
+
+    if(exit_code == EXIT_SUCCESS)
+    {
+        if(gateway.benchmark)
+            gw_bench_report(&gateway.bench, stdout);
+        else
+            fprintf(stdout, "gateway stopped\n");
+
+        print_stats(&gateway, stdout);
+
+        gw_radio_stop(&gateway.radio);
+        gw_bridge_stop(&gateway.bridge);
+    }
+
+    gw_bench_close(&gateway.bench);
+
+    close(epoll_fd);
+
+    return exit_code;
+}
@@ -0,0 +1,206 @@
+/**
+ ******************************************************************************
+ * @file    main.c
+ * @author  Aditya Mall,
+ * @brief   Protocol microbenchmark main file.
+ *
+ *  Info
+ *          Measures per call latency and throughput of the protocol hot paths
+ *          on the host and writes the results as JSON for comparing commits.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "mb_harness.h"
+#include "mb_cases.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define MB_DEFAULT_REPEATS      7
+#define MB_DEFAULT_MIN_TIME_US  20000
+
+
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -r, --repeats <n>        timed batches per case, median is reported (default %d, max %d)\n"
+            "  -t, --min-time <us>      minimum time of one batch (default %d)\n"
+            "  -f, --filter <text>      run cases whose group/function/variant contains text\n"
+            "  -o, --output <file>      write the JSON report to file, - for stdout\n"
+            "  -l, --list               list the cases\n",
+            program, MB_DEFAULT_REPEATS, MB_MAX_REPEATS, MB_DEFAULT_MIN_TIME_US);
+}
+
+
+
+int main(int argc, char **argv)
+{
+    mb_config_t      config;
+    mb_result_t     *results;
+    const mb_case_t *cases;
+    const char      *output_path = NULL;
+    FILE            *output      = NULL;
+    FILE            *table       = stdout;
+    uint32_t         case_count  = 0;
+    uint32_t         count       = 0;
+    uint32_t         index;
+    uint8_t          list        = 0;
+    int              option;
+    int              exit_code   = EXIT_SUCCESS;
+
+    static const struct option long_options[] =
+    {
+        {"repeats",  required_argument, NULL, 'r'},
+        {"min-time", required_argument, NULL, 't'},
+        {"filter",   required_argument, NULL, 'f'},
+        {"output",   required_argument, NULL, 'o'},
+        {"list",     no_argument,       NULL, 'l'},
+        {"help",     no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    memset(&config, 0, sizeof(config));
+
+    config.repeats     = MB_DEFAULT_REPEATS;
+    config.min_time_us = MB_DEFAULT_MIN_TIME_US;
+
+    while((option = getopt_long(argc, argv, "r:t:f:o:lh", long_options, NULL)) != -1)
+    {
+        switch(option)
+        {
+        case 'r': config.repeats     = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 't': config.min_time_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'f': config.filter      = optarg;                             break;
+        case 'o': output_path        = optarg;                             break;
+        case 'l': list               = 1;                                  break;
+
+        default:
+
+            print_usage(argv[0]);
+
+            return option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if(config.repeats == 0 || config.repeats > MB_MAX_REPEATS)
+    {
+        print_usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    cases = mb_cases(&case_count);
+
+    if(list)
+    {
+        for(index = 0; index < case_count; index++)
+            printf("%s/%s/%s\n", cases[index].group, cases[index].name, cases[index].variant);
+
+        return EXIT_SUCCESS;
+    }
+
+    results = calloc(case_count, sizeof(mb_result_t));
+
+    if(results == NULL)
+        return EXIT_FAILURE;
+
+    /* JSON on stdout moves the table to stderr */
+    if(output_path != NULL && strcmp(output_path, "-") == 0)
+        table = stderr;
+
+    mb_print_result(NULL, table);
+
+    for(index = 0; index < case_count; index++)
+    {
+        if(!mb_selected(&cases[index], config.filter))
+            continue;
+
+        if(mb_measure(&cases[index], &config, &results[count]) < 0)
+        {
+            fprintf(stderr, "microbench: %s/%s/%s setup failed\n", cases[index].group, cases[index].name,
+                    cases[index].variant);
+
+            exit_code = EXIT_FAILURE;
+
+            continue;
+        }
+
+        mb_print_result(&results[count], table);
+
+        count++;
+    }
+
+    if(output_path != NULL)
+    {
+        output = strcmp(output_path, "-") == 0 ? stdout : fopen(output_path, "w");
+
+        if(output == NULL)
+        {
+            fprintf(stderr, "microbench: cannot write %s\n", output_path);
+
+            exit_code = EXIT_FAILURE;
+        }
+        else
+        {
+            mb_write_json(results, count, &config, output);
+
+            if(output != stdout)
+                fclose(output);
+        }
+    }
+
+    free(results);
+
+    return exit_code;
+}
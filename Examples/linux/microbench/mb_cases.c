@@ -0,0 +1,1248 @@
+/**
+ ******************************************************************************
+ * @file    mb_cases.c
+ * @author  Aditya Mall,
+ * @brief   Protocol microbenchmark cases source file.
+ *
+ *  Info
+ *          Benchmark cases of the network, protocol, client table and server
+ *          state machine API calls, host build only.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "mb_cases.h"
+
+/* API headers */
+#include "comms_network.h"
+#include "comms_protocol.h"
+#include "comms_fragment.h"
+#include "comms_frame.h"
+#include "comms_codec.h"
+#include "comms_server_db.h"
+#include "comms_server_fsm.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define MB_NETWORK_ID      1
+#define MB_SLOT_TIME       6
+#define MB_TOTAL_SLOTS     3
+#define MB_CLIENT_ID       4     /*!< Client slot number of the encoded messages     */
+#define MB_DESTINATION_ID  5     /*!< Destination client of the encoded messages     */
+#define MB_FSM_CLIENTS     8     /*!< Joined clients of the server cycle             */
+#define MB_FSM_MAX_STEPS   32    /*!< State machine steps before a cycle is dropped  */
+#define MB_RECORD_LENGTH   12    /*!< Aggregated CONTRL record payload               */
+#define MB_FRAGMENT_LENGTH 48    /*!< Fragment payload, below comms_fragment_size()  */
+
+
+/* Network operations, sent frames are kept for the receive cases */
+static int8_t mb_send_message(char *message_buffer, uint16_t message_length);
+static int8_t mb_send_message_v(const net_segment_t *segments, uint8_t segment_count);
+
+static network_operations_t mb_ops =
+{
+    .send_message   = mb_send_message,
+    .send_message_v = mb_send_message_v,
+};
+
+
+/* Benchmark state, shared by the cases, every setup starts from scratch */
+static access_control_t       mb_network;
+static device_config_t        mb_server;
+static device_config_t        mb_client;
+static const uint8_t          mb_ack_records[2] = {MB_CLIENT_ID, 1};
+static device_config_t        mb_decoded;
+static protocol_handle_t      mb_handle;
+static comms_network_buffer_t mb_buffers;
+static uint8_t                mb_read_index;
+
+static char     mb_message[NET_MTU_SIZE];          /*!< Encoder output, decoder input             */
+static char     mb_output[NET_MTU_SIZE];           /*!< Decoder output                            */
+static char     mb_payload[NET_DATA_LENGTH];       /*!< Application payload                       */
+static char     mb_encoded[NET_DATA_LENGTH];       /*!< Codec encoded payload                     */
+static uint16_t mb_encoded_length;
+static uint8_t  mb_codec;
+static char     mb_sent[NET_MTU_SIZE];             /*!< Last frame sent through mb_ops            */
+static uint16_t mb_sent_length;
+static uint32_t mb_sync_frames;                    /*!< SYNC frames sent through mb_ops           */
+static char     mb_frame[NET_MTU_SIZE];            /*!< Frame fed to the receive interrupt        */
+static uint16_t mb_frame_length;
+
+static client_devices_t mb_table[CLIENT_TABLE_SIZE];
+static char             mb_macs[CLIENT_TABLE_SIZE][NET_MAC_SIZE];
+static uint8_t          mb_ids[CLIENT_TABLE_SIZE];
+static uint16_t         mb_joined;
+
+static char    mb_user_name[10] = "sens_net";
+static uint8_t mb_password[10]  = "1234";
+static char    mb_sync_payload[] = "sync";
+
+/* Sensor report text, codec cases use separated decimal integers */
+static const char mb_text[]    = "node 4 temp 21.5 hum 40 batt 3.31 rssi -67 seq 1024 up 86400 err 0 ";
+static const char mb_numbers[] = "1024@20480 1025@20500 1026@20520";
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+static int8_t mb_send_message(char *message_buffer, uint16_t message_length)
+{
+    if(message_length > NET_MTU_SIZE)
+        return -1;
+
+    memcpy(mb_sent, message_buffer, message_length);
+
+    mb_sent_length = message_length;
+
+    if(comms_frame_get_type(mb_sent) == COMMS_SYNC_MESSAGE)
+        mb_sync_frames++;
+
+    return 0;
+}
+
+
+static int8_t mb_send_message_v(const net_segment_t *segments, uint8_t segment_count)
+{
+    uint16_t length = 0;
+    uint8_t  segment;
+
+    /* Gather like a UART DMA descriptor chain */
+    for(segment = 0; segment < segment_count; segment++)
+    {
+        if(length + segments[segment].length > NET_MTU_SIZE)
+            return -1;
+
+        memcpy(mb_sent + length, segments[segment].data, segments[segment].length);
+
+        length += segments[segment].length;
+    }
+
+    mb_sent_length = length;
+
+    if(comms_frame_get_type(mb_sent) == COMMS_SYNC_MESSAGE)
+        mb_sync_frames++;
+
+    return 0;
+}
+
+
+/* Server, client and protocol handle of every case, all messages in mb_message */
+static int8_t mb_devices_init(void)
+{
+    memset(&mb_network, 0, sizeof(mb_network));
+    memset(&mb_buffers, 0, sizeof(mb_buffers));
+    memset(mb_message, 0, sizeof(mb_message));
+
+    mb_read_index = 0;
+
+    if(init_network_handle(&mb_network, &mb_ops) == NULL ||
+       init_server_device(&mb_server, "11:22:33:44:55:66", MB_NETWORK_ID, MB_SLOT_TIME, MB_TOTAL_SLOTS,
+                          mb_user_name, mb_password) == NULL ||
+       init_client_device(&mb_client, "20:20:00:00:00:04", 1, mb_user_name, mb_password) == NULL)
+    {
+        return -1;
+    }
+
+    mb_client.device_network_id  = MB_NETWORK_ID;
+    mb_client.device_slot_number = MB_CLIENT_ID;
+
+    mb_network.sync_message = (void*)mb_message;
+
+    mb_handle.joinrequest_msg  = (void*)mb_message;
+    mb_handle.joinresponse_msg = (void*)mb_message;
+    mb_handle.status_msg       = (void*)mb_message;
+    mb_handle.statusack_msg    = (void*)mb_message;
+    mb_handle.contrl_msg       = (void*)mb_message;
+
+    memcpy(mb_payload, mb_text, sizeof(mb_payload));
+
+    return 0;
+}
+
+
+/* Frame for the receive cases, sent with the integrity mode of the case */
+static int8_t mb_frame_capture(uint8_t length, uint8_t integrity_mode)
+{
+    if(length == 0 || comms_network_set_integrity(&mb_network, (net_integrity_t)integrity_mode) < 0 ||
+       comms_send(&mb_network, mb_message, length) < 0)
+    {
+        return -1;
+    }
+
+    memcpy(mb_frame, mb_sent, mb_sent_length);
+
+    mb_frame_length = mb_sent_length;
+
+    return 0;
+}
+
+
+/* Client table with percent of CLIENT_TABLE_SIZE rows joined, one slot per client */
+static int8_t mb_table_fill(uint32_t percent, uint16_t max_rows)
+{
+    table_retval_t table_values;
+    uint16_t       rows;
+
+    if(mb_devices_init() < 0 || init_server_device_table(mb_table) == NULL)
+        return -1;
+
+    rows = (uint16_t)(CLIENT_TABLE_SIZE * percent / 100);
+
+    if(rows > max_rows)
+        rows = max_rows;
+
+    for(mb_joined = 0; mb_joined < rows; mb_joined++)
+    {
+        memset(mb_macs[mb_joined], 0, NET_MAC_SIZE);
+
+        mb_macs[mb_joined][0] = 0x20;
+        mb_macs[mb_joined][1] = 0x20;
+        mb_macs[mb_joined][4] = (char)(mb_joined >> 8);
+        mb_macs[mb_joined][5] = (char)mb_joined;
+
+        table_values = update_server_device_table(mb_table, mb_macs[mb_joined], 1, &mb_server);
+
+        if(table_values.table_retval != 0)
+            return -1;
+
+        mb_ids[mb_joined] = mb_table[table_values.table_index].client_id;
+    }
+
+    return 0;
+}
+
+
+/* MAC address never in the table */
+static void mb_absent_mac(char *mac, uint64_t call)
+{
+    memset(mac, 0, NET_MAC_SIZE);
+
+    mac[0] = 0x30;
+    mac[4] = (char)0xFF;
+    mac[5] = (char)(call & 0x3F);
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Network Cases                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+static int8_t mb_setup_checksum(uint32_t argument, uint32_t *units)
+{
+    uint32_t index;
+
+    for(index = 0; index < sizeof(mb_message); index++)
+        mb_message[index] = (char)(index * 7 + 3);
+
+    *units = argument;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_checksum(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)comms_network_checksum(mb_message, 0, (uint8_t)argument);
+
+    return sink;
+}
+
+
+static int8_t mb_setup_sync_message(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    return mb_devices_init();
+}
+
+
+static uint32_t mb_run_sync_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_network_sync_message(&mb_network, MB_NETWORK_ID, MB_SLOT_TIME, mb_sync_payload, 4);
+
+    return sink;
+}
+
+
+static int8_t mb_setup_sync_data(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    if(mb_devices_init() < 0 ||
+       comms_network_sync_message(&mb_network, MB_NETWORK_ID, MB_SLOT_TIME, mb_sync_payload, 4) == 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static uint32_t mb_run_sync_data(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint32_t)get_sync_data(&mb_decoded, mb_output, mb_network) + mb_decoded.device_slot_time;
+
+    return sink;
+}
+
+
+/* Receive interrupt cases, argument is the frame integrity mode */
+static int8_t mb_setup_server_recv(uint32_t argument, uint32_t *units)
+{
+    if(mb_devices_init() < 0 ||
+       mb_frame_capture(comms_status_message(&mb_handle, mb_client, MB_DESTINATION_ID, mb_payload, 20),
+                        (uint8_t)argument) < 0)
+    {
+        return -1;
+    }
+
+    *units = mb_frame_length;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_server_recv(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+    uint16_t index;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        for(index = 0; index < mb_frame_length; index++)
+        {
+            mb_buffers.read_message[mb_read_index] = mb_frame[index];
+
+            sink += (uint8_t)comms_server_recv_it(&mb_network, &mb_buffers, &mb_read_index);
+        }
+
+        if(comms_event_peek(&mb_buffers) != NULL)
+            comms_event_pop(&mb_buffers);
+    }
+
+    return sink;
+}
+
+
+static int8_t mb_setup_client_recv(uint32_t argument, uint32_t *units)
+{
+    if(mb_devices_init() < 0 ||
+       mb_frame_capture(comms_control_message(&mb_handle, mb_server, MB_DESTINATION_ID, MB_CLIENT_ID, mb_payload, 20),
+                        (uint8_t)argument) < 0)
+    {
+        return -1;
+    }
+
+    *units = mb_frame_length;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_client_recv(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+    uint16_t index;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        for(index = 0; index < mb_frame_length; index++)
+        {
+            mb_buffers.read_message[mb_read_index] = mb_frame[index];
+
+            sink += (uint8_t)comms_client_recv_it(&mb_network, &mb_buffers, &mb_read_index);
+        }
+
+        if(comms_event_peek(&mb_buffers) != NULL)
+            comms_event_pop(&mb_buffers);
+    }
+
+    return sink;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Protocol Encoder Cases                            */
+/*                                                                            */
+/******************************************************************************/
+
+
+static int8_t mb_setup_protocol(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    return mb_devices_init();
+}
+
+
+static uint32_t mb_run_joinreq_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_joinreq_message(&mb_handle, mb_client, 1);
+
+    return sink;
+}
+
+
+static uint32_t mb_run_joinresp_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_joinresp_message(&mb_handle, mb_server, mb_client.device_mac, MB_CLIENT_ID);
+
+    return sink;
+}
+
+
+/* Argument is the payload length */
+static uint32_t mb_run_status_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_status_message(&mb_handle, mb_client, MB_DESTINATION_ID, mb_payload, (uint16_t)argument);
+
+    return sink;
+}
+
+
+static uint32_t mb_run_status_notify_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_status_notify_message(&mb_handle, mb_client, COMMS_KEEPALIVE_MESSAGE);
+
+    return sink;
+}
+
+
+static uint32_t mb_run_status_fragment_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_status_fragment_message(&mb_handle, mb_client, MB_DESTINATION_ID, (uint8_t)call, 0, 1,
+                                              mb_payload, (uint16_t)argument);
+
+    return sink;
+}
+
+
+static int8_t mb_setup_status_codec(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    if(mb_devices_init() < 0)
+        return -1;
+
+    mb_codec = comms_codec_encode(mb_numbers, sizeof(mb_numbers) - 1, mb_encoded, sizeof(mb_encoded),
+                                  COMMS_CODEC_ALL, &mb_encoded_length);
+
+    return mb_codec == COMMS_CODEC_NONE ? -1 : 0;
+}
+
+
+static uint32_t mb_run_status_codec_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_status_codec_message(&mb_handle, mb_client, MB_DESTINATION_ID, mb_codec, mb_encoded,
+                                           mb_encoded_length);
+
+    return sink;
+}
+
+
+static uint32_t mb_run_control_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_control_message(&mb_handle, mb_server, MB_CLIENT_ID, MB_DESTINATION_ID, mb_payload,
+                                      (uint16_t)argument);
+
+    return sink;
+}
+
+
+static uint32_t mb_run_control_message_v(uint32_t argument, uint64_t calls)
+{
+    net_segment_t segments[CONTRL_MAX_SEGMENTS];
+
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += comms_control_message_v(&mb_handle, mb_server, MB_CLIENT_ID, MB_DESTINATION_ID, mb_payload,
+                                        (uint16_t)argument, segments) + segments[0].length;
+
+    return sink;
+}
+
+
+/* Argument is the number of records */
+static uint8_t mb_control_aggregate(uint32_t records)
+{
+    uint8_t  length = 0;
+    uint32_t record;
+
+    length = comms_control_aggregate_init(&mb_handle, mb_server);
+
+    for(record = 0; record < records; record++)
+    {
+        length = comms_control_aggregate_add(&mb_handle, mb_server, length, NET_DATA_LENGTH,
+                                             (uint8_t)(MB_DESTINATION_ID + record),
+                                             record & 1 ? MB_DESTINATION_ID : MB_CLIENT_ID,
+                                             mb_payload, MB_RECORD_LENGTH);
+    }
+
+    return comms_control_aggregate_end(&mb_handle, length);
+}
+
+
+static uint32_t mb_run_control_aggregate(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += mb_control_aggregate(argument);
+
+    return sink;
+}
+
+
+static uint32_t mb_run_statusack_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)comms_statusack_message(&mb_handle, mb_client, mb_ack_records, 1);
+
+    return sink;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Protocol Decoder Cases                            */
+/*                                                                            */
+/******************************************************************************/
+
+
+static int8_t mb_setup_get_joinreq(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    if(mb_devices_init() < 0 || comms_joinreq_message(&mb_handle, mb_client, 1) == 0)
+        return -1;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_get_joinreq_data(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink  = 0;
+    uint8_t  slots = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)comms_get_joinreq_data(mb_output, &slots, mb_handle, mb_server, 1) + slots;
+
+    return sink;
+}
+
+
+static int8_t mb_setup_get_joinresp(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    if(mb_devices_init() < 0 || comms_joinresp_message(&mb_handle, mb_server, mb_client.device_mac, MB_CLIENT_ID) == 0)
+        return -1;
+
+    comms_set_joinresp_message_status(&mb_handle, 0);
+
+    mb_decoded = mb_client;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_get_joinresp_data(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)comms_get_joinresp_data(&mb_decoded, mb_handle) + mb_decoded.device_slot_number;
+
+    return sink;
+}
+
+
+/* Argument is the payload length */
+static int8_t mb_setup_get_status(uint32_t argument, uint32_t *units)
+{
+    (void)units;
+
+    if(mb_devices_init() < 0 || comms_status_message(&mb_handle, mb_client, MB_DESTINATION_ID, mb_payload,
+                                                     (uint16_t)argument) == 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static uint32_t mb_run_get_status_message(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink        = 0;
+    uint8_t  source      = 0;
+    uint8_t  destination = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint16_t)comms_get_status_message(mb_handle, mb_server, mb_output, &source, &destination) + destination;
+
+    return sink;
+}
+
+
+static uint32_t mb_run_get_status_payload(uint32_t argument, uint64_t calls)
+{
+    uint32_t    sink        = 0;
+    uint8_t     source      = 0;
+    uint8_t     destination = 0;
+    const char *payload     = NULL;
+    uint64_t    call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint16_t)comms_get_status_payload(mb_handle, mb_server, &payload, &source, &destination) +
+                (uint8_t)payload[0];
+
+    return sink;
+}
+
+
+static int8_t mb_setup_get_contrl(uint32_t argument, uint32_t *units)
+{
+    (void)units;
+
+    if(mb_devices_init() < 0 || comms_control_message(&mb_handle, mb_server, MB_DESTINATION_ID, MB_CLIENT_ID,
+                                                      mb_payload, (uint16_t)argument) == 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static uint32_t mb_run_get_contrl_data(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink   = 0;
+    uint8_t  source = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)comms_get_contrl_data(mb_output, &source, mb_handle, MB_NETWORK_ID, MB_CLIENT_ID) + source;
+
+    return sink;
+}
+
+
+/* Argument is the number of records */
+static int8_t mb_setup_get_record(uint32_t argument, uint32_t *units)
+{
+    (void)units;
+
+    if(mb_devices_init() < 0 || mb_control_aggregate(argument) == 0)
+        return -1;
+
+    return 0;
+}
+
+
+/* All records of the device in one call */
+static uint32_t mb_run_get_contrl_record(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink   = 0;
+    uint8_t  source = 0;
+    uint8_t  offset = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        offset = 0;
+
+        do
+        {
+            sink += (uint8_t)comms_get_contrl_record(mb_output, &source, mb_handle, MB_NETWORK_ID, MB_CLIENT_ID, &offset);
+
+        }while(offset != 0);
+    }
+
+    return sink;
+}
+
+
+/* Argument is the fragment payload length */
+static int8_t mb_setup_get_fragment(uint32_t argument, uint32_t *units)
+{
+    net_segment_t segments[CONTRL_MAX_SEGMENTS];
+    char          fragment[NET_DATA_LENGTH];
+    uint8_t       segment_count;
+
+    (void)units;
+
+    if(mb_devices_init() < 0)
+        return -1;
+
+    comms_fragment_header(fragment, 1, 0, 1);
+
+    memcpy(fragment + COMMS_FRAGMENT_HEADER_SIZE, mb_payload, argument);
+
+    segment_count = comms_control_fragment_v(&mb_handle, mb_server, MB_DESTINATION_ID, MB_CLIENT_ID, fragment,
+                                             (uint16_t)(argument + COMMS_FRAGMENT_HEADER_SIZE), segments);
+
+    /* Header and segments as they go on air */
+    if(segment_count == 0 || comms_send_v(&mb_network, mb_message, CONTRL_FRAME_HEADER_LENGTH, segments, segment_count) < 0)
+        return -1;
+
+    memcpy(mb_message, mb_sent, mb_sent_length);
+
+    return 0;
+}
+
+
+static uint32_t mb_run_get_contrl_fragment(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink   = 0;
+    uint8_t  source = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)comms_get_contrl_fragment(mb_output, &source, mb_handle, MB_NETWORK_ID, MB_CLIENT_ID) + source;
+
+    return sink;
+}
+
+
+static int8_t mb_setup_get_statusack(uint32_t argument, uint32_t *units)
+{
+    (void)argument;
+    (void)units;
+
+    if(mb_devices_init() < 0 || comms_statusack_message(&mb_handle, mb_client, mb_ack_records, 1) == 0)
+        return -1;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_get_statusack(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink   = 0;
+    uint8_t  record = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        record = 0;
+        sink  += (uint8_t)comms_get_statusack(mb_handle, MB_NETWORK_ID, MB_CLIENT_ID, &record);
+    }
+
+    return sink;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Client Table Cases                                */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Argument is the table fill in percent, one row stays free for the join */
+static int8_t mb_setup_table_join(uint32_t argument, uint32_t *units)
+{
+    (void)units;
+
+    return mb_table_fill(argument, CLIENT_TABLE_SIZE - 1);
+}
+
+
+/* Join of a new client and its release, keeps the fill level */
+static uint32_t mb_run_table_join(uint32_t argument, uint64_t calls)
+{
+    table_retval_t table_values;
+
+    char     mac[NET_MAC_SIZE];
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        mb_absent_mac(mac, call);
+
+        table_values = update_server_device_table(mb_table, mac, 1, &mb_server);
+
+        if(table_values.table_retval == 0)
+            release_client_registry(bind_server_device_table(mb_table), mb_table[table_values.table_index].client_id,
+                                    &mb_server);
+
+        sink += table_values.table_index;
+    }
+
+    return sink;
+}
+
+
+static int8_t mb_setup_table(uint32_t argument, uint32_t *units)
+{
+    (void)units;
+
+    if(mb_table_fill(argument, CLIENT_TABLE_SIZE) < 0 || mb_joined == 0)
+        return -1;
+
+    return 0;
+}
+
+
+/* Join request of a client already in the table */
+static uint32_t mb_run_table_rejoin(uint32_t argument, uint64_t calls)
+{
+    table_retval_t table_values;
+
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        table_values = update_server_device_table(mb_table, mb_macs[call % mb_joined], 1, &mb_server);
+
+        sink += table_values.table_index;
+    }
+
+    return sink;
+}
+
+
+static uint32_t mb_run_find_by_id(uint32_t argument, uint64_t calls)
+{
+    char     mac[NET_MAC_SIZE];
+    uint8_t  client_id;
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        client_id = mb_ids[call % mb_joined];
+
+        sink += (uint8_t)find_client_device(mb_table, &client_id, mac, FIND_BY_ID);
+    }
+
+    return sink;
+}
+
+
+static uint32_t mb_run_find_by_mac(uint32_t argument, uint64_t calls)
+{
+    uint8_t  client_id = 0;
+    uint32_t sink      = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+        sink += (uint8_t)find_client_device(mb_table, &client_id, mb_macs[call % mb_joined], FIND_BY_MAC) + client_id;
+
+    return sink;
+}
+
+
+static uint32_t mb_run_find_miss(uint32_t argument, uint64_t calls)
+{
+    char     mac[NET_MAC_SIZE];
+    uint8_t  client_id = 0;
+    uint32_t sink      = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        mb_absent_mac(mac, call);
+
+        sink += (uint8_t)find_client_device(mb_table, &client_id, mac, FIND_BY_MAC);
+    }
+
+    return sink;
+}
+
+
+/* Keep alive clients heard at the first frame of the wheel */
+static int8_t mb_setup_table_keep_alive(uint32_t argument, uint32_t *units)
+{
+    client_registry_t *registry;
+    uint16_t           client;
+    int16_t            row;
+
+    (void)units;
+
+    if(mb_table_fill(argument, CLIENT_TABLE_SIZE) < 0 || mb_joined == 0 ||
+       (registry = bind_server_device_table(mb_table)) == NULL)
+        return -1;
+
+    for(client = 0; client < mb_joined; client++)
+    {
+        if((row = client_registry_find_id(registry, mb_ids[client])) < 0)
+            return -1;
+
+        registry->rows[row].client_states.keep_alive = 1;
+
+        touch_client_registry(registry, mb_ids[client]);
+    }
+
+    return 0;
+}
+
+
+/* One client heard and one wheel frame per call, every client is heard within a keep alive period */
+static uint32_t mb_run_keep_alive_frame(uint32_t argument, uint64_t calls)
+{
+    client_registry_t *registry = bind_server_device_table(mb_table);
+
+    uint32_t sink = 0;
+    uint64_t call;
+
+    (void)argument;
+
+    for(call = 0; call < calls; call++)
+    {
+        touch_client_registry(registry, mb_ids[call % mb_joined]);
+
+        sink += (uint32_t)expire_client_registry(registry, &mb_server, NULL);
+    }
+
+    return sink;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                         Server State Machine Cases                         */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Server steps from one SYNC frame to the next, argument 1 relays one STATUS message */
+static uint32_t mb_server_cycle(uint32_t argument)
+{
+    uint32_t sync_frames = mb_sync_frames;
+    uint32_t steps       = 0;
+    uint16_t index;
+
+    if(argument)
+    {
+        for(index = 0; index < mb_frame_length; index++)
+        {
+            mb_buffers.read_message[mb_read_index] = mb_frame[index];
+
+            comms_server_recv_it(&mb_network, &mb_buffers, &mb_read_index);
+        }
+    }
+
+    while(mb_sync_frames == sync_frames && steps < MB_FSM_MAX_STEPS)
+    {
+        comms_start_server(&mb_network, &mb_server, &mb_buffers, mb_table, WI_LOCAL_SERVER);
+
+        steps++;
+    }
+
+    return steps;
+}
+
+
+static int8_t mb_setup_server_cycle(uint32_t argument, uint32_t *units)
+{
+    device_config_t source;
+
+    if(mb_table_fill(MB_FSM_CLIENTS * 100 / CLIENT_TABLE_SIZE, MB_FSM_CLIENTS) < 0 || mb_joined < 2)
+        return -1;
+
+    /* STATUS message between the first two clients */
+    source = mb_client;
+
+    source.device_slot_number = mb_table[0].client_id;
+
+    if(mb_frame_capture(comms_status_message(&mb_handle, source, mb_table[1].client_id, mb_payload, 20),
+                        NET_INTEGRITY_SUM8) < 0)
+    {
+        return -1;
+    }
+
+    /* State machine is single instance, run to the end of a frame, then count the steps of one frame */
+    if(mb_server_cycle(0) >= MB_FSM_MAX_STEPS)
+        return -1;
+
+    *units = mb_server_cycle(argument);
+
+    if(*units >= MB_FSM_MAX_STEPS)
+        return -1;
+
+    return 0;
+}
+
+
+static uint32_t mb_run_server_cycle(uint32_t argument, uint64_t calls)
+{
+    uint32_t sink = 0;
+    uint64_t call;
+
+    for(call = 0; call < calls; call++)
+        sink += mb_server_cycle(argument);
+
+    return sink;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Case Table                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define MB_TABLE_CASES(fill)                                                                                              \
+    {"update_server_device_table", "server_db", "join+release fill " #fill "%", "call", fill, mb_setup_table_join,        \
+     mb_run_table_join},                                                                                                  \
+    {"update_server_device_table", "server_db", "rejoin fill " #fill "%",       "call", fill, mb_setup_table,             \
+     mb_run_table_rejoin},                                                                                                \
+    {"find_client_device",         "server_db", "by id fill " #fill "%",        "call", fill, mb_setup_table,             \
+     mb_run_find_by_id},                                                                                                  \
+    {"find_client_device",         "server_db", "by mac fill " #fill "%",       "call", fill, mb_setup_table,             \
+     mb_run_find_by_mac},                                                                                                 \
+    {"find_client_device",         "server_db", "miss fill " #fill "%",         "call", fill, mb_setup_table,             \
+     mb_run_find_miss},                                                                                                   \
+    {"expire_client_registry",     "server_db", "touch+frame fill " #fill "%",  "call", fill, mb_setup_table_keep_alive,  \
+     mb_run_keep_alive_frame}
+
+
+static const mb_case_t mb_case_table[] =
+{
+    /* Network */
+    {"comms_network_checksum",        "network", "16 bytes",   "byte", 16,  mb_setup_checksum, mb_run_checksum},
+    {"comms_network_checksum",        "network", "64 bytes",   "byte", 64,  mb_setup_checksum, mb_run_checksum},
+    {"comms_network_checksum",        "network", "128 bytes",  "byte", 128, mb_setup_checksum, mb_run_checksum},
+    {"comms_server_recv_it",          "network", "STATUS sum8",  "byte", NET_INTEGRITY_SUM8,  mb_setup_server_recv, mb_run_server_recv},
+    {"comms_server_recv_it",          "network", "STATUS crc16", "byte", NET_INTEGRITY_CRC16, mb_setup_server_recv, mb_run_server_recv},
+    {"comms_server_recv_it",          "network", "STATUS crc32", "byte", NET_INTEGRITY_CRC32, mb_setup_server_recv, mb_run_server_recv},
+    {"comms_client_recv_it",          "network", "CONTRL sum8",  "byte", NET_INTEGRITY_SUM8,  mb_setup_client_recv, mb_run_client_recv},
+    {"comms_client_recv_it",          "network", "CONTRL crc16", "byte", NET_INTEGRITY_CRC16, mb_setup_client_recv, mb_run_client_recv},
+    {"comms_client_recv_it",          "network", "CONTRL crc32", "byte", NET_INTEGRITY_CRC32, mb_setup_client_recv, mb_run_client_recv},
+    {"comms_network_sync_message",    "network", "SYNC",       "call", 0,   mb_setup_sync_message, mb_run_sync_message},
+    {"get_sync_data",                 "network", "SYNC",       "call", 0,   mb_setup_sync_data,    mb_run_sync_data},
+
+    /* Protocol encoders */
+    {"comms_joinreq_message",         "protocol", "JOINREQ",          "call", 0,  mb_setup_protocol,     mb_run_joinreq_message},
+    {"comms_joinresp_message",        "protocol", "JOINRESP",         "call", 0,  mb_setup_protocol,     mb_run_joinresp_message},
+    {"comms_status_message",          "protocol", "20 B payload",     "call", 20, mb_setup_protocol,     mb_run_status_message},
+    {"comms_status_message",          "protocol", "50 B payload",     "call", 50, mb_setup_protocol,     mb_run_status_message},
+    {"comms_status_notify_message",   "protocol", "KEEPALIVE",        "call", 0,  mb_setup_protocol,     mb_run_status_notify_message},
+    {"comms_status_fragment_message", "protocol", "48 B fragment",    "call", MB_FRAGMENT_LENGTH, mb_setup_protocol, mb_run_status_fragment_message},
+    {"comms_status_codec_message",    "protocol", "encoded payload",  "call", 0,  mb_setup_status_codec, mb_run_status_codec_message},
+    {"comms_control_message",         "protocol", "20 B payload",     "call", 20, mb_setup_protocol,     mb_run_control_message},
+    {"comms_control_message",         "protocol", "50 B payload",     "call", 50, mb_setup_protocol,     mb_run_control_message},
+    {"comms_control_message_v",       "protocol", "20 B payload",     "call", 20, mb_setup_protocol,     mb_run_control_message_v},
+    {"comms_control_aggregate",       "protocol", "3 records",        "call", 3,  mb_setup_protocol,     mb_run_control_aggregate},
+    {"comms_statusack_message",       "protocol", "STATUSACK",        "call", 0,  mb_setup_protocol,     mb_run_statusack_message},
+
+    /* Protocol decoders */
+    {"comms_get_joinreq_data",        "protocol", "JOINREQ",          "call", 0,  mb_setup_get_joinreq,   mb_run_get_joinreq_data},
+    {"comms_get_joinresp_data",       "protocol", "JOINRESP",         "call", 0,  mb_setup_get_joinresp,  mb_run_get_joinresp_data},
+    {"comms_get_status_message",      "protocol", "20 B payload",     "call", 20, mb_setup_get_status,    mb_run_get_status_message},
+    {"comms_get_status_payload",      "protocol", "20 B payload",     "call", 20, mb_setup_get_status,    mb_run_get_status_payload},
+    {"comms_get_contrl_data",         "protocol", "20 B payload",     "call", 20, mb_setup_get_contrl,    mb_run_get_contrl_data},
+    {"comms_get_contrl_record",       "protocol", "2 of 3 records",   "call", 3,  mb_setup_get_record,    mb_run_get_contrl_record},
+    {"comms_get_contrl_fragment",     "protocol", "48 B fragment",    "call", MB_FRAGMENT_LENGTH, mb_setup_get_fragment, mb_run_get_contrl_fragment},
+    {"comms_get_statusack",           "protocol", "STATUSACK",        "call", 0,  mb_setup_get_statusack, mb_run_get_statusack},
+
+    /* Client table, fill levels of CLIENT_TABLE_SIZE */
+    MB_TABLE_CASES(10),
+    MB_TABLE_CASES(50),
+    MB_TABLE_CASES(90),
+
+    /* Server state machine, SYNC frame to SYNC frame */
+    {"comms_start_server",            "server_fsm", "idle frame",        "step", 0, mb_setup_server_cycle, mb_run_server_cycle},
+    {"comms_start_server",            "server_fsm", "relay one STATUS",  "step", 1, mb_setup_server_cycle, mb_run_server_cycle},
+};
+
+
+#define MB_CASE_COUNT  (sizeof(mb_case_table) / sizeof(mb_case_table[0]))
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Benchmark case table
+ * @param  *count            : number of cases
+ * @retval const mb_case_t*  : case table
+ *******************************************************************/
+const mb_case_t* mb_cases(uint32_t *count)
+{
+    *count = MB_CASE_COUNT;
+
+    return mb_case_table;
+}
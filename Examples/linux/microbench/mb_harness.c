@@ -0,0 +1,283 @@
+/**
+ ******************************************************************************
+ * @file    mb_harness.c
+ * @author  Aditya Mall,
+ * @brief   Protocol microbenchmark harness source file.
+ *
+ *  Info
+ *          Calibrated timing loops for single API calls and the JSON report,
+ *          host build only.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mb_harness.h"
+#include "network_protocol_configs.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Largest calibrated batch, bounds very cheap calls */
+#define MB_MAX_CALLS  (1ULL << 32)
+
+
+/* Result sink, keeps the compiler from dropping the measured calls */
+static volatile uint32_t mb_sink;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+static uint64_t mb_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+
+static uint64_t mb_time_batch(const mb_case_t *bench, uint64_t calls)
+{
+    uint64_t start;
+
+    start = mb_time_ns();
+
+    mb_sink += bench->run(bench->argument, calls);
+
+    return mb_time_ns() - start;
+}
+
+
+static int mb_compare_double(const void *a, const void *b)
+{
+    double left  = *(const double*)a;
+    double right = *(const double*)b;
+
+    return (left > right) - (left < right);
+}
+
+
+/* JSON string, names and variants are plain ASCII */
+static void mb_json_string(const char *text, FILE *output)
+{
+    fputc('"', output);
+
+    for(; *text; text++)
+    {
+        if(*text == '"' || *text == '\\')
+            fputc('\\', output);
+
+        fputc(*text, output);
+    }
+
+    fputc('"', output);
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Measure one case, the batch size is doubled until a batch
+ *         takes min_time_us, then repeats batches are timed
+ * @param  *bench   : benchmark case
+ * @param  *config  : harness configuration
+ * @param  *result  : case result
+ * @retval int8_t   : error: -1, success: 0
+ *******************************************************************/
+int8_t mb_measure(const mb_case_t *bench, const mb_config_t *config, mb_result_t *result)
+{
+    double   batch_ns[MB_MAX_REPEATS];
+    uint64_t calls   = 1;
+    uint64_t elapsed = 0;
+    uint32_t repeat;
+
+    if(bench == NULL || config == NULL || result == NULL || config->repeats == 0 || config->repeats > MB_MAX_REPEATS)
+        return -1;
+
+    memset(result, 0, sizeof(*result));
+
+    result->bench = bench;
+    result->units = 1;
+
+    if(bench->setup != NULL && bench->setup(bench->argument, &result->units) < 0)
+        return -1;
+
+    /* Calibrate, the last batch also warms the caches */
+    while((elapsed = mb_time_batch(bench, calls)) < (uint64_t)config->min_time_us * 1000 && calls < MB_MAX_CALLS)
+        calls *= 2;
+
+    for(repeat = 0; repeat < config->repeats; repeat++)
+        batch_ns[repeat] = (double)mb_time_batch(bench, calls) / (double)calls;
+
+    qsort(batch_ns, config->repeats, sizeof(batch_ns[0]), mb_compare_double);
+
+    result->calls       = calls;
+    result->ns_min      = batch_ns[0];
+    result->ns_median   = batch_ns[config->repeats / 2];
+    result->ns_max      = batch_ns[config->repeats - 1];
+    result->calls_per_s = result->ns_median > 0 ? 1e9 / result->ns_median : 0;
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Check a case against the filter
+ * @param  *bench   : benchmark case
+ * @param  *filter  : substring of group/name/variant, NULL for all
+ * @retval uint8_t  : skip: 0, run: 1
+ *******************************************************************/
+uint8_t mb_selected(const mb_case_t *bench, const char *filter)
+{
+    char id[128];
+
+    if(filter == NULL)
+        return 1;
+
+    snprintf(id, sizeof(id), "%s/%s/%s", bench->group, bench->name, bench->variant);
+
+    return strstr(id, filter) != NULL;
+}
+
+
+
+/*******************************************************************
+ * @brief  Print one result as a table row
+ * @param  *result  : case result, NULL prints the table header
+ * @param  *output  : output stream
+ *******************************************************************/
+void mb_print_result(const mb_result_t *result, FILE *output)
+{
+    if(result == NULL)
+    {
+        fprintf(output, "%-11s %-30s %-22s %10s %10s %10s %12s %10s\n", "group", "function", "variant",
+                "ns/call", "min", "max", "calls/s", "ns/unit");
+
+        return;
+    }
+
+    fprintf(output, "%-11s %-30s %-22s %10.1f %10.1f %10.1f %12.0f %10.2f %s\n", result->bench->group,
+            result->bench->name, result->bench->variant, result->ns_median, result->ns_min, result->ns_max,
+            result->calls_per_s, result->ns_median / result->units, result->bench->unit);
+}
+
+
+
+/*******************************************************************
+ * @brief  Write all results as JSON
+ * @param  *results  : case results
+ * @param  count     : number of results
+ * @param  *config   : harness configuration
+ * @param  *output   : output stream
+ *******************************************************************/
+void mb_write_json(const mb_result_t *results, uint32_t count, const mb_config_t *config, FILE *output)
+{
+    uint32_t index;
+
+    char id[128];
+
+    fprintf(output, "{\n");
+    fprintf(output, "  \"benchmark\": \"wi_microbench\",\n");
+    fprintf(output, "  \"config\": {\"repeats\": %u, \"min_time_us\": %u, \"net_data_length\": %d, "
+                    "\"net_mtu_size\": %d, \"compiler\": ", config->repeats, config->min_time_us,
+                    NET_DATA_LENGTH, NET_MTU_SIZE);
+
+#ifdef __VERSION__
+    mb_json_string(__VERSION__, output);
+#else
+    mb_json_string("unknown", output);
+#endif
+
+    fprintf(output, "},\n  \"results\": [\n");
+
+    for(index = 0; index < count; index++)
+    {
+        const mb_result_t *result = &results[index];
+
+        snprintf(id, sizeof(id), "%s/%s/%s", result->bench->group, result->bench->name, result->bench->variant);
+
+        fprintf(output, "    {\"id\": ");
+        mb_json_string(id, output);
+        fprintf(output, ", \"group\": ");
+        mb_json_string(result->bench->group, output);
+        fprintf(output, ", \"function\": ");
+        mb_json_string(result->bench->name, output);
+        fprintf(output, ", \"variant\": ");
+        mb_json_string(result->bench->variant, output);
+        fprintf(output, ", \"unit\": ");
+        mb_json_string(result->bench->unit, output);
+
+        fprintf(output, ", \"units_per_call\": %u, \"calls_per_batch\": %llu, \"ns_per_call\": "
+                        "{\"min\": %.3f, \"median\": %.3f, \"max\": %.3f}, \"ns_per_unit\": %.4f, "
+                        "\"calls_per_second\": %.1f, \"units_per_second\": %.1f}%s\n",
+                result->units, (unsigned long long)result->calls, result->ns_min, result->ns_median, result->ns_max,
+                result->ns_median / result->units, result->calls_per_s, result->calls_per_s * result->units,
+                index + 1 < count ? "," : "");
+    }
+
+    fprintf(output, "  ]\n}\n");
+}
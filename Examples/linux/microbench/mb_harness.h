@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ * @file    mb_harness.h
+ * @author  Aditya Mall,
+ * @brief   Protocol microbenchmark harness header file.
+ *
+ *  Info
+ *          Calibrated timing loops for single API calls and the JSON report,
+ *          host build only.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+#ifndef MB_HARNESS_H_
+#define MB_HARNESS_H_
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Timed batches per case, the median batch is reported */
+#define MB_MAX_REPEATS  31
+
+
+/* Benchmark case, the run function loops over the API call so only the call is timed */
+typedef struct _mb_case
+{
+    const char *name;                                     /*!< API function                                */
+    const char *group;                                    /*!< network, protocol, server_db or server_fsm  */
+    const char *variant;                                  /*!< Message, frame or table fill variant        */
+    const char *unit;                                     /*!< Work unit of one call, "call" or "byte"     */
+    uint32_t    argument;                                 /*!< Case argument for setup and run             */
+    int8_t    (*setup)(uint32_t argument, uint32_t *units); /*!< Prepare state, units of work per call     */
+    uint32_t  (*run)(uint32_t argument, uint64_t calls);  /*!< Run calls, returns a result sink            */
+
+}mb_case_t;
+
+
+/* Harness configuration */
+typedef struct _mb_config
+{
+    uint32_t    repeats;       /*!< Timed batches per case                */
+    uint32_t    min_time_us;   /*!< Minimum time of one batch (us)        */
+    const char *filter;        /*!< Run cases with this substring, NULL all */
+
+}mb_config_t;
+
+
+/* Result of one case */
+typedef struct _mb_result
+{
+    const mb_case_t *bench;         /*!< Measured case                        */
+    uint32_t         units;         /*!< Units of work per call               */
+    uint64_t         calls;         /*!< Calls per timed batch                */
+    double           ns_min;        /*!< Fastest batch, ns per call           */
+    double           ns_median;     /*!< Median batch, ns per call            */
+    double           ns_max;        /*!< Slowest batch, ns per call           */
+    double           calls_per_s;   /*!< Calls per second of the median batch */
+
+}mb_result_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Measure one case, the batch size is doubled until a batch
+ *         takes min_time_us, then repeats batches are timed
+ * @param  *bench   : benchmark case
+ * @param  *config  : harness configuration
+ * @param  *result  : case result
+ * @retval int8_t   : error: -1, success: 0
+ *******************************************************************/
+int8_t mb_measure(const mb_case_t *bench, const mb_config_t *config, mb_result_t *result);
+
+
+/*******************************************************************
+ * @brief  Check a case against the filter
+ * @param  *bench   : benchmark case
+ * @param  *filter  : substring of group/name/variant, NULL for all
+ * @retval uint8_t  : skip: 0, run: 1
+ *******************************************************************/
+uint8_t mb_selected(const mb_case_t *bench, const char *filter);
+
+
+/*******************************************************************
+ * @brief  Print one result as a table row
+ * @param  *result  : case result, NULL prints the table header
+ * @param  *output  : output stream
+ *******************************************************************/
+void mb_print_result(const mb_result_t *result, FILE *output);
+
+
+/*******************************************************************
+ * @brief  Write all results as JSON
+ * @param  *results  : case results
+ * @param  count     : number of results
+ * @param  *config   : harness configuration
+ * @param  *output   : output stream
+ *******************************************************************/
+void mb_write_json(const mb_result_t *results, uint32_t count, const mb_config_t *config, FILE *output);
+
+
+
+#endif /* MB_HARNESS_H_ */
@@ -0,0 +1,234 @@
+/**
+ ******************************************************************************
+ * @file    main.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network simulator main file
+ *
+ *  Info
+ *          Runs comms_server_run and comms_client_run instances against a
+ *          virtual clock and a shared virtual medium and reports throughput,
+ *          latency and slot utilization for the given configuration.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "sim_engine.h"
+#include "sim_bench.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Launchpad example defaults */
+#define SIM_DEFAULT_SLOT_TIME    6
+#define SIM_DEFAULT_TOTAL_SLOTS  3
+#define SIM_DEFAULT_CLIENTS      4
+#define SIM_DEFAULT_DURATION     60000
+#define SIM_DEFAULT_INTERVAL     500
+#define SIM_DEFAULT_BAUD_RATE    115200
+#define SIM_DEFAULT_JOIN_WINDOW  1000
+#define SIM_DEFAULT_JOIN_RETRY   8
+
+
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -t, --slot-time <ms>     device_slot_time            (default %d)\n"
+            "  -s, --slots <n>          server starting total_slots (default %d)\n"
+            "  -c, --clients <n>        number of clients           (default %d)\n"
+            "  -d, --duration <ms>      simulated time              (default %d)\n"
+            "  -i, --interval <ms>      mean message interval, 0 disables traffic (default %d)\n"
+            "  -b, --baud <rate>        radio baud rate             (default %d)\n"
+            "  -j, --join-window <ms>   clients press join within   (default %d)\n"
+            "  -r, --join-retry <n>     retry join within n frames  (default %d)\n"
+            "  -S, --seed <n>           random seed                 (default 1)\n"
+            "  -e, --integrity <mode>   frame integrity sum8, crc16 or crc32 (default sum8)\n"
+            "  -B, --batch <n>          server CONTRL messages per broadcast slot (default 1)\n"
+            "  -A, --aggregate          server packs STATUS messages into aggregated CONTRL messages\n"
+            "  -m, --message-size <n>   pad posted messages to n bytes, fragmented above a frame\n"
+            "  -z, --codec <n>          clients 1 - n send encoded STATUS payloads\n"
+            "  -a, --access-slots <n>   server grows the access slots up to n (default 1)\n"
+            "  -p, --period <frames>    clients send once every 2^n frames in shared superframe slots\n"
+            "  -L, --low-power          client radios sleep between the slots they need\n"
+            "  -q, --qos                clients send acknowledged QoS 1 STATUS messages\n"
+            "  -x, --bench <name>       run a benchmark sweep on this configuration\n"
+            "  -v, --verbose            print node debug output\n",
+            program, SIM_DEFAULT_SLOT_TIME, SIM_DEFAULT_TOTAL_SLOTS, SIM_DEFAULT_CLIENTS, SIM_DEFAULT_DURATION,
+            SIM_DEFAULT_INTERVAL, SIM_DEFAULT_BAUD_RATE, SIM_DEFAULT_JOIN_WINDOW, SIM_DEFAULT_JOIN_RETRY);
+}
+
+
+
+int main(int argc, char **argv)
+{
+    simulator_t  sim;
+    sim_config_t config;
+    int          option;
+    const char  *bench = NULL;
+
+    static const struct option long_options[] =
+    {
+        {"slot-time",   required_argument, NULL, 't'},
+        {"slots",       required_argument, NULL, 's'},
+        {"clients",     required_argument, NULL, 'c'},
+        {"duration",    required_argument, NULL, 'd'},
+        {"interval",    required_argument, NULL, 'i'},
+        {"baud",        required_argument, NULL, 'b'},
+        {"join-window", required_argument, NULL, 'j'},
+        {"join-retry",  required_argument, NULL, 'r'},
+        {"seed",        required_argument, NULL, 'S'},
+        {"integrity",   required_argument, NULL, 'e'},
+        {"batch",       required_argument, NULL, 'B'},
+        {"aggregate",   no_argument,       NULL, 'A'},
+        {"message-size", required_argument, NULL, 'm'},
+        {"codec",       required_argument, NULL, 'z'},
+        {"access-slots", required_argument, NULL, 'a'},
+        {"period",      required_argument, NULL, 'p'},
+        {"low-power",   no_argument,       NULL, 'L'},
+        {"qos",         no_argument,       NULL, 'q'},
+        {"bench",       required_argument, NULL, 'x'},
+        {"verbose",     no_argument,       NULL, 'v'},
+        {"help",        no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    memset(&config, 0, sizeof(config));
+
+    config.slot_time        = SIM_DEFAULT_SLOT_TIME;
+    config.total_slots      = SIM_DEFAULT_TOTAL_SLOTS;
+    config.clients          = SIM_DEFAULT_CLIENTS;
+    config.duration         = SIM_DEFAULT_DURATION;
+    config.message_interval = SIM_DEFAULT_INTERVAL;
+    config.baud_rate        = SIM_DEFAULT_BAUD_RATE;
+    config.join_window      = SIM_DEFAULT_JOIN_WINDOW;
+    config.join_retry       = SIM_DEFAULT_JOIN_RETRY;
+    config.seed             = 1;
+
+    while((option = getopt_long(argc, argv, "t:s:c:d:i:b:j:r:S:e:B:Am:z:a:p:Lqx:vh", long_options, NULL)) != -1)
+    {
+        switch(option)
+        {
+        case 't': config.slot_time        = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 's': config.total_slots      = (uint8_t)strtoul(optarg, NULL, 0);  break;
+        case 'c': config.clients          = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'd': config.duration         = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'i': config.message_interval = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'b': config.baud_rate        = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'j': config.join_window      = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'r': config.join_retry       = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'S': config.seed             = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'B': config.contrl_batch     = (uint8_t)strtoul(optarg, NULL, 0);  break;
+        case 'A': config.contrl_aggregate = 1;                                  break;
+        case 'm': config.message_size     = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 'z': config.codec_clients    = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'a': config.access_slots     = (uint8_t)strtoul(optarg, NULL, 0);  break;
+        case 'p': config.slot_period      = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 'L': config.sleep_mode       = 1;                                  break;
+        case 'q': config.qos              = 1;                                  break;
+        case 'x': bench                   = optarg;                             break;
+        case 'v': config.verbose          = 1;                                  break;
+
+        case 'e':
+
+            if(strcmp(optarg, "sum8") == 0)
+                config.integrity_mode = 0;
+            else if(strcmp(optarg, "crc16") == 0)
+                config.integrity_mode = 1;
+            else if(strcmp(optarg, "crc32") == 0)
+                config.integrity_mode = 2;
+            else
+            {
+                print_usage(argv[0]);
+
+                return EXIT_FAILURE;
+            }
+
+            break;
+
+        default:
+
+            print_usage(argv[0]);
+
+            return option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if(bench != NULL)
+    {
+        if(sim_bench_run(bench, &config, stdout) < 0)
+        {
+            fprintf(stderr, "simulator: unknown benchmark or invalid configuration, benchmarks:\n");
+
+            sim_bench_list(stderr);
+
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    if(sim_init(&sim, &config) < 0)
+    {
+        fprintf(stderr, "simulator: invalid configuration or failed to create nodes\n");
+
+        sim_destroy(&sim);
+
+        return EXIT_FAILURE;
+    }
+
+    if(sim_run(&sim) < 0)
+        fprintf(stderr, "simulator: simulation failed\n");
+
+    sim_report(&sim, stdout);
+
+    sim_destroy(&sim);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,317 @@
+/**
+ ******************************************************************************
+ * @file    sim_bench.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network simulator benchmark source file
+ *
+ *  Info
+ *          Benchmarks run the simulator over a sweep of configurations and
+ *          print one result row per run. The command line configuration is
+ *          the base, a benchmark only changes the swept values.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_bench.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Benchmark entry */
+typedef struct _sim_bench
+{
+    const char *name;
+    const char *description;
+    int8_t    (*run)(const sim_config_t *config, FILE *output);
+
+}sim_bench_t;
+
+
+/* Server CONTRL settings of one benchmark column */
+typedef struct _sim_bench_mode
+{
+    uint8_t contrl_batch;      /*!< CONTRL messages per broadcast slot  */
+    uint8_t contrl_aggregate;  /*!< Aggregated CONTRL messages          */
+
+}sim_bench_mode_t;
+
+
+static int8_t sim_bench_batch(const sim_config_t *config, FILE *output);
+static int8_t sim_bench_aggregate(const sim_config_t *config, FILE *output);
+static int8_t sim_bench_aloha(const sim_config_t *config, FILE *output);
+
+
+static const sim_bench_t sim_benchmarks[] =
+{
+    {"batch",     "end to end latency, one vs batched CONTRL messages per broadcast slot", sim_bench_batch},
+    {"aggregate", "delivered messages, CONTRL message per STATUS vs aggregated records",   sim_bench_aggregate},
+    {"aloha",     "join throughput S per access slot vs slotted ALOHA S = G e^-G",       sim_bench_aloha},
+};
+
+
+#define SIM_BENCH_COUNT  (sizeof(sim_benchmarks) / sizeof(sim_benchmarks[0]))
+
+
+/* Client counts of the sweeps */
+static const uint32_t sim_bench_clients[] = {2, 4, 8, 16};
+
+#define SIM_BENCH_CLIENT_COUNT  (sizeof(sim_bench_clients) / sizeof(sim_bench_clients[0]))
+
+
+/* Server settings of the batch and aggregate benchmarks */
+static const sim_bench_mode_t sim_bench_batch_modes[]     = {{1, 0}, {2, 0}, {4, 0}};
+static const sim_bench_mode_t sim_bench_aggregate_modes[] = {{1, 0}, {1, 1}, {2, 1}};
+
+
+/* Join window per client, clients press join spread over the window (ms) */
+#define SIM_BENCH_JOIN_WINDOW  1000
+
+
+/* Join windows of the aloha benchmark per client (ms), 0 presses join at once like after a power outage */
+static const uint32_t sim_bench_aloha_windows[] = {0, 100, 400, 1000};
+
+#define SIM_BENCH_ALOHA_WINDOW_COUNT  (sizeof(sim_bench_aloha_windows) / sizeof(sim_bench_aloha_windows[0]))
+
+
+/* Seeds per aloha benchmark row, a join phase has few frames */
+#define SIM_BENCH_ALOHA_SEEDS  8
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+static int8_t sim_bench_once(const sim_config_t *config, sim_summary_t *summary)
+{
+    simulator_t sim;
+    int8_t      func_retval = 0;
+
+    memset(&sim, 0, sizeof(sim));
+
+    func_retval = sim_init(&sim, config);
+
+    if(func_retval == 0)
+        func_retval = sim_run(&sim);
+
+    if(func_retval == 0)
+        sim_summarize(&sim, summary);
+
+    sim_destroy(&sim);
+
+    return func_retval;
+}
+
+
+/* Sweep client count, every client count runs once per server mode, the
+ * measurement period of the base duration starts after the join window */
+static int8_t sim_bench_sweep(const sim_config_t *config, FILE *output, const sim_bench_mode_t *modes, uint32_t mode_count)
+{
+    sim_config_t  run_config;
+    sim_summary_t summary;
+    uint32_t      client_index;
+    uint32_t      mode_index;
+
+    fprintf(output, "%8s %6s %10s %7s %10s %10s %10s %10s %10s\n", "clients", "batch", "aggregate", "joined",
+            "delivered", "msg/s", "mean ms", "p95 ms", "collided");
+
+    for(client_index = 0; client_index < SIM_BENCH_CLIENT_COUNT; client_index++)
+    {
+        for(mode_index = 0; mode_index < mode_count; mode_index++)
+        {
+            run_config = *config;
+
+            run_config.clients          = sim_bench_clients[client_index];
+            run_config.join_window      = run_config.clients * SIM_BENCH_JOIN_WINDOW;
+            run_config.duration         = run_config.join_window + config->duration;
+            run_config.contrl_batch     = modes[mode_index].contrl_batch;
+            run_config.contrl_aggregate = modes[mode_index].contrl_aggregate;
+
+            if(sim_bench_once(&run_config, &summary) < 0)
+                return -1;
+
+            fprintf(output, "%8u %6u %10s %7llu %10llu %10.2f %10.2f %10.2f %10llu\n", run_config.clients,
+                    run_config.contrl_batch, run_config.contrl_aggregate ? "on" : "off",
+                    (unsigned long long)summary.joined_clients, (unsigned long long)summary.messages_delivered,
+                    summary.delivered_rate, summary.latency_mean, summary.latency_p95,
+                    (unsigned long long)summary.collisions);
+        }
+    }
+
+    return 0;
+}
+
+
+static int8_t sim_bench_batch(const sim_config_t *config, FILE *output)
+{
+    return sim_bench_sweep(config, output, sim_bench_batch_modes,
+                           sizeof(sim_bench_batch_modes) / sizeof(sim_bench_batch_modes[0]));
+}
+
+
+static int8_t sim_bench_aggregate(const sim_config_t *config, FILE *output)
+{
+    return sim_bench_sweep(config, output, sim_bench_aggregate_modes,
+                           sizeof(sim_bench_aggregate_modes) / sizeof(sim_bench_aggregate_modes[0]));
+}
+
+
+/* Sweep client count and join window without application traffic, the
+ * access slot offered load G (JOINREQ per access slot of the frames with
+ * clients waiting to join) and throughput S (collision free JOINREQ per
+ * access slot) add up over SIM_BENCH_ALOHA_SEEDS seeds */
+static int8_t sim_bench_aloha(const sim_config_t *config, FILE *output)
+{
+    sim_config_t  run_config;
+    sim_summary_t summary;
+    uint32_t      client_index;
+    uint32_t      window_index;
+    uint32_t      seed;
+    uint64_t      frames;
+    uint64_t      slots;
+    uint64_t      requests;
+    uint64_t      received;
+    uint64_t      joined;
+    double        join_time;
+    double        offered;
+
+    fprintf(output, "%8s %10s %8s %6s %8s %7s %8s %8s %8s %10s\n", "clients", "window ms", "frames", "slots",
+            "JOINREQ", "joined", "G", "S", "G*e^-G", "join ms");
+
+    for(client_index = 0; client_index < SIM_BENCH_CLIENT_COUNT; client_index++)
+    {
+        for(window_index = 0; window_index < SIM_BENCH_ALOHA_WINDOW_COUNT; window_index++)
+        {
+            frames    = 0;
+            slots     = 0;
+            requests  = 0;
+            received  = 0;
+            joined    = 0;
+            join_time = 0;
+
+            for(seed = 0; seed < SIM_BENCH_ALOHA_SEEDS; seed++)
+            {
+                run_config = *config;
+
+                run_config.clients          = sim_bench_clients[client_index];
+                run_config.join_window      = run_config.clients * sim_bench_aloha_windows[window_index];
+                run_config.duration         = run_config.join_window + config->duration;
+                run_config.message_interval = 0;
+                run_config.seed             = config->seed + seed;
+
+                if(sim_bench_once(&run_config, &summary) < 0)
+                    return -1;
+
+                frames    += summary.join_frames;
+                slots     += summary.join_slots;
+                requests  += summary.join_requests;
+                received  += summary.join_received;
+                joined    += summary.joined_clients;
+                join_time += summary.join_time_mean * (double)summary.joined_clients;
+            }
+
+            offered = slots ? (double)requests / (double)slots : 0.0;
+
+            fprintf(output, "%8u %10u %8llu %6.2f %8llu %7llu %8.3f %8.3f %8.3f %10.2f\n", sim_bench_clients[client_index],
+                    sim_bench_clients[client_index] * sim_bench_aloha_windows[window_index], (unsigned long long)frames,
+                    frames ? (double)slots / (double)frames : 0.0, (unsigned long long)requests,
+                    (unsigned long long)joined, offered, slots ? (double)received / (double)slots : 0.0,
+                    sim_aloha_throughput(offered),
+                    joined ? join_time / (double)joined : 0.0);
+        }
+    }
+
+    return 0;
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Run a named benchmark
+ * @param  *name   : benchmark name
+ * @param  *config : base simulation configuration
+ * @param  *output : output stream
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_bench_run(const char *name, const sim_config_t *config, FILE *output)
+{
+    uint32_t index;
+
+    for(index = 0; index < SIM_BENCH_COUNT; index++)
+    {
+        if(strcmp(name, sim_benchmarks[index].name) == 0)
+            return sim_benchmarks[index].run(config, output);
+    }
+
+    return -1;
+}
+
+
+
+/*******************************************************************
+ * @brief  Print the benchmark names
+ * @param  *output : output stream
+ *******************************************************************/
+void sim_bench_list(FILE *output)
+{
+    uint32_t index;
+
+    for(index = 0; index < SIM_BENCH_COUNT; index++)
+        fprintf(output, "  %-20s %s\n", sim_benchmarks[index].name, sim_benchmarks[index].description);
+}
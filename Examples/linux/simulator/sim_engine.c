@@ -0,0 +1,1024 @@
+/**
+ ******************************************************************************
+ * @file    sim_engine.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network discrete event simulator source file
+ *
+ *  Info
+ *          Every node transmit timer, frame end and traffic event is kept in
+ *          one time ordered queue. The medium is a single shared channel, a
+ *          frame that overlaps another transmission is lost for every receiver.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim_engine.h"
+#include "comms_codec.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define SIM_SERVER_NODE        0
+#define SIM_CLIENT_BOOT_TIMER  5000   /*!< Client timer before first SYNC (us), as on the launchpad */
+#define SIM_SERVER_BOOT_TIMER  1000   /*!< Server timer before START_STATE (us)                     */
+#define SIM_BITS_PER_BYTE      10
+
+/* Radio power, UART radio module at 3.3 V */
+#define SIM_RADIO_TX_MW        110.0  /*!< Transmit power (mW)                 */
+#define SIM_RADIO_RX_MW        92.0   /*!< Receive and idle listening power    */
+#define SIM_RADIO_SLEEP_MW     0.003  /*!< Sleep power (mW)                    */
+
+
+/* Event types */
+typedef enum _sim_event_type
+{
+    SIM_EVENT_TIMER  = 1,  /*!< Node transmit timer ISR  */
+    SIM_EVENT_TX_END = 2,  /*!< Frame leaves the medium  */
+    SIM_EVENT_JOIN   = 3,  /*!< Client join button       */
+    SIM_EVENT_POST   = 4,  /*!< Client application post  */
+    SIM_EVENT_TX_START = 5 /*!< Queued frame goes on air */
+
+}sim_event_type_t;
+
+
+static const char *sim_message_names[16] =
+{
+    "?", "SYNC", "JOINREQ", "JOINRESP", "STATUS", "STATUSACK", "CONTRL", "EVNT",
+    "HIBERNATE", "UNJOIN", "KEEPALIVE", "?", "?", "?", "?", "?"
+};
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                              Private Functions                             */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* xorshift64*, deterministic for a given seed */
+static uint64_t sim_random(simulator_t *sim)
+{
+    sim->random_state ^= sim->random_state >> 12;
+    sim->random_state ^= sim->random_state << 25;
+    sim->random_state ^= sim->random_state >> 27;
+
+    return sim->random_state * 2685821657736338717ULL;
+}
+
+
+static sim_time_t sim_random_below(simulator_t *sim, sim_time_t limit)
+{
+    if(limit == 0)
+        return 0;
+
+    return sim_random(sim) % limit;
+}
+
+
+/* Exponentially distributed interval with the given mean */
+static sim_time_t sim_random_exponential(simulator_t *sim, sim_time_t mean)
+{
+    double uniform = ((double)(sim_random(sim) >> 11) + 1.0) / 9007199254740993.0;
+
+    return (sim_time_t)(-log(uniform) * (double)mean) + 1;
+}
+
+
+static sim_time_t sim_frame_time(simulator_t *sim)
+{
+    uint32_t slots = sim->nodes[SIM_SERVER_NODE].state.total_slots;
+
+    if(slots == 0)
+        slots = sim->config.total_slots;
+
+    /* More than one access slot follow the client slots */
+    if(sim->nodes[SIM_SERVER_NODE].state.access_slots > 1)
+        slots += sim->nodes[SIM_SERVER_NODE].state.access_slots;
+
+    return (sim_time_t)sim->config.slot_time * slots * 1000;
+}
+
+
+/* Clients waiting for a join response */
+static uint8_t sim_join_pending(simulator_t *sim)
+{
+    uint32_t index;
+
+    for(index = SIM_SERVER_NODE + 1; index < sim->node_count; index++)
+    {
+        if(sim->nodes[index].join_pressed && sim->nodes[index].state.network_joined == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+
+
+/*********************************************************
+ * Event queue, binary min heap on (time, sequence)
+ *********************************************************/
+
+static int sim_event_before(const sim_event_t *a, const sim_event_t *b)
+{
+    if(a->time != b->time)
+        return a->time < b->time;
+
+    return a->sequence < b->sequence;
+}
+
+
+static int8_t sim_schedule(simulator_t *sim, sim_time_t time, uint8_t type, uint32_t node, uint32_t tag)
+{
+    uint64_t    index;
+    sim_event_t event;
+
+    if(sim->event_count == sim->event_capacity)
+    {
+        uint64_t     capacity = sim->event_capacity ? sim->event_capacity * 2 : 1024;
+        sim_event_t *events   = realloc(sim->events, capacity * sizeof(sim_event_t));
+
+        if(events == NULL)
+            return -1;
+
+        sim->events         = events;
+        sim->event_capacity = capacity;
+    }
+
+    event.time     = time;
+    event.sequence = sim->sequence++;
+    event.type     = type;
+    event.node     = node;
+    event.tag      = tag;
+
+    /* Sift up */
+    index = sim->event_count++;
+
+    while(index > 0 && sim_event_before(&event, &sim->events[(index - 1) / 2]))
+    {
+        sim->events[index] = sim->events[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+
+    sim->events[index] = event;
+
+    return 0;
+}
+
+
+static int8_t sim_next_event(simulator_t *sim, sim_event_t *event)
+{
+    uint64_t    index = 0;
+    uint64_t    child;
+    sim_event_t last;
+
+    if(sim->event_count == 0)
+        return -1;
+
+    *event = sim->events[0];
+    last   = sim->events[--sim->event_count];
+
+    /* Sift down */
+    for(;;)
+    {
+        child = 2 * index + 1;
+
+        if(child >= sim->event_count)
+            break;
+
+        if(child + 1 < sim->event_count && sim_event_before(&sim->events[child + 1], &sim->events[child]))
+            child++;
+
+        if(!sim_event_before(&sim->events[child], &last))
+            break;
+
+        sim->events[index] = sim->events[child];
+        index = child;
+    }
+
+    if(sim->event_count)
+        sim->events[index] = last;
+
+    return 0;
+}
+
+
+
+/*********************************************************
+ * Statistics
+ *********************************************************/
+
+static void sim_record_latency(simulator_t *sim, sim_time_t latency)
+{
+    sim_stats_t *stats = &sim->stats;
+
+    if(stats->latency_count == stats->latency_capacity)
+    {
+        uint64_t    capacity = stats->latency_capacity ? stats->latency_capacity * 2 : 1024;
+        sim_time_t *samples  = realloc(stats->latency, capacity * sizeof(sim_time_t));
+
+        if(samples == NULL)
+            return;
+
+        stats->latency          = samples;
+        stats->latency_capacity = capacity;
+    }
+
+    stats->latency[stats->latency_count++] = latency;
+}
+
+
+static int sim_compare_time(const void *a, const void *b)
+{
+    sim_time_t x = *(const sim_time_t*)a;
+    sim_time_t y = *(const sim_time_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static double sim_percentile(const sim_stats_t *stats, double percentile)
+{
+    uint64_t rank;
+
+    if(stats->latency_count == 0)
+        return 0;
+
+    rank = (uint64_t)(percentile * (double)(stats->latency_count - 1) + 0.5);
+
+    return (double)stats->latency[rank] / 1000.0;
+}
+
+
+
+/*********************************************************
+ * Node callbacks, network_operations_t backed by events
+ *********************************************************/
+
+static void sim_tx_start(simulator_t *sim, uint32_t frame_index);
+
+
+static void sim_on_send(void *context, sim_node_t *node, const char *frame, uint16_t length)
+{
+    simulator_t *sim = context;
+    sim_frame_t *tx  = NULL;
+    uint32_t     index;
+
+    if(length == 0 || length > NET_MTU_SIZE)
+        return;
+
+    /* Find a free frame slot */
+    for(index = 0; index < sim->frame_capacity; index++)
+    {
+        if(!sim->frames[index].in_use)
+        {
+            tx = &sim->frames[index];
+            break;
+        }
+    }
+
+    if(tx == NULL)
+    {
+        uint32_t     capacity = sim->frame_capacity ? sim->frame_capacity * 2 : 16;
+        sim_frame_t *frames   = realloc(sim->frames, capacity * sizeof(sim_frame_t));
+
+        if(frames == NULL)
+            return;
+
+        memset(frames + sim->frame_capacity, 0, (capacity - sim->frame_capacity) * sizeof(sim_frame_t));
+
+        index = sim->frame_capacity;
+
+        sim->frames         = frames;
+        sim->frame_capacity = capacity;
+
+        tx = &sim->frames[index];
+    }
+
+    tx->in_use   = 1;
+    tx->collided = 0;
+    tx->sender   = node->config.index;
+    tx->length   = length;
+
+    /* The radio UART sends one frame after the other, later frames of a node wait */
+    tx->start    = sim->now > node->tx_free ? sim->now : node->tx_free;
+    tx->end      = tx->start + ((sim_time_t)length * SIM_BITS_PER_BYTE * 1000000) / sim->config.baud_rate;
+
+    node->tx_free = tx->end;
+
+    memcpy(tx->data, frame, length);
+
+    if(tx->start == sim->now)
+        sim_tx_start(sim, index);
+    else
+        sim_schedule(sim, tx->start, SIM_EVENT_TX_START, node->config.index, index);
+}
+
+
+static void sim_tx_start(simulator_t *sim, uint32_t frame_index)
+{
+    sim_frame_t *tx = &sim->frames[frame_index];
+    uint8_t      type;
+    uint32_t     other;
+
+    /* Any overlap on the shared channel destroys both frames, a frame ending now is not an overlap */
+    for(other = 0; other < sim->frame_capacity; other++)
+    {
+        if(sim->frames[other].in_use && sim->frames[other].on_air && &sim->frames[other] != tx &&
+           sim->frames[other].end > sim->now)
+        {
+            sim->frames[other].collided = 1;
+
+            tx->collided = 1;
+        }
+    }
+
+    if(sim->active_frames == 0)
+        sim->busy_since = sim->now;
+
+    tx->on_air = 1;
+
+    sim->active_frames++;
+
+    sim->nodes[tx->sender].tx_airtime += tx->end - tx->start;
+
+    type = ((uint8_t)tx->data[2] >> 4) & 0x0F;
+    sim->stats.frames_sent[type]++;
+
+    /* Access slot of a frame with clients waiting to join */
+    if(type == COMMS_SYNC_MESSAGE && tx->sender == SIM_SERVER_NODE && sim_join_pending(sim))
+    {
+        sim->stats.join_frames++;
+        sim->stats.join_slots += sim->nodes[SIM_SERVER_NODE].state.access_slots;
+    }
+
+    sim_schedule(sim, tx->end, SIM_EVENT_TX_END, tx->sender, frame_index);
+}
+
+
+static void sim_on_set_timer(void *context, sim_node_t *node, uint16_t slot_time, uint8_t slot_number)
+{
+    simulator_t *sim = context;
+
+    node->timer_period = (sim_time_t)slot_time * slot_number * 1000;
+    node->timer_generation++;
+
+    sim_schedule(sim, sim->now + node->timer_period, SIM_EVENT_TIMER, node->config.index, node->timer_generation);
+}
+
+
+static void sim_on_radio(void *context, sim_node_t *node, uint8_t awake)
+{
+    simulator_t *sim = context;
+
+    if(awake && node->radio_asleep)
+    {
+        node->radio_sleep_total += sim->now - node->radio_sleep_time;
+        node->radio_wake_time    = sim->now;
+        node->radio_asleep       = 0;
+    }
+    else if(!awake && !node->radio_asleep)
+    {
+        node->radio_sleep_time = sim->now;
+        node->radio_asleep     = 1;
+    }
+}
+
+
+/* Radio awake when the frame started, radio_sleep takes effect after the frame being received */
+static uint8_t sim_radio_heard(const sim_node_t *node, sim_time_t start)
+{
+    return node->radio_wake_time <= start && (!node->radio_asleep || node->radio_sleep_time > start);
+}
+
+
+static void sim_on_reset_timer(void *context, sim_node_t *node)
+{
+    simulator_t *sim = context;
+
+    if(node->timer_period == 0)
+        return;
+
+    node->timer_generation++;
+
+    sim_schedule(sim, sim->now + node->timer_period, SIM_EVENT_TIMER, node->config.index, node->timer_generation);
+}
+
+
+
+/*********************************************************
+ * Node state handling after every node command
+ *********************************************************/
+
+static void sim_update_node(simulator_t *sim, sim_node_t *node)
+{
+    unsigned int       sequence;
+    unsigned long long posted;
+
+    if(node->config.role != SIM_ROLE_CLIENT)
+        return;
+
+    /* First join, start application traffic */
+    if(node->state.network_joined && node->join_time == 0)
+    {
+        node->join_time = sim->now;
+
+        sim->stats.joined_clients++;
+        sim->stats.join_time_total += sim->now - node->join_request_time;
+
+        if(sim->config.message_interval)
+        {
+            sim_schedule(sim, sim->now + sim_random_exponential(sim, (sim_time_t)sim->config.message_interval * 1000),
+                         SIM_EVENT_POST, node->config.index, 0);
+        }
+    }
+
+    /* Delivered CONTRL message, payload carries the posting time */
+    if(node->state.message_ready)
+    {
+        node->state.message_ready = 0;
+        node->state.message[sizeof(node->state.message) - 1] = 0;
+
+        if(sscanf(node->state.message, "%u@%llu", &sequence, &posted) == 2 && posted <= sim->now)
+        {
+            sim->stats.messages_delivered++;
+            sim->stats.bytes_delivered += node->state.message_length;
+
+            sim_record_latency(sim, sim->now - posted);
+        }
+        else
+        {
+            sim->stats.messages_not_found++;
+        }
+    }
+}
+
+
+static void sim_tx_end(simulator_t *sim, uint32_t frame_index)
+{
+    sim_frame_t tx = sim->frames[frame_index];
+    uint32_t    index;
+    uint8_t     type;
+
+    /* Release the slot first, receivers may transmit from their ISR */
+    sim->frames[frame_index].in_use = 0;
+    sim->frames[frame_index].on_air = 0;
+    sim->active_frames--;
+
+    if(sim->active_frames == 0)
+        sim->stats.busy_time += sim->now - sim->busy_since;
+
+    type = ((uint8_t)tx.data[2] >> 4) & 0x0F;
+
+    if(tx.collided)
+    {
+        sim->stats.collisions++;
+
+        /* Receivers see the damaged frame, the last byte fails the checksum or CRC */
+        tx.data[tx.length - 1] ^= 0xFF;
+    }
+    else
+    {
+        sim->stats.frames_delivered[type]++;
+    }
+
+    for(index = 0; index < sim->node_count; index++)
+    {
+        if(index == tx.sender || !sim_radio_heard(&sim->nodes[index], tx.start))
+            continue;
+
+        sim_node_receive(&sim->nodes[index], tx.data, tx.length);
+
+        sim_update_node(sim, &sim->nodes[index]);
+    }
+}
+
+
+static void sim_timer_event(simulator_t *sim, sim_node_t *node, uint32_t generation)
+{
+    /* Timer was re-armed or reset after this event was queued */
+    if(generation != node->timer_generation)
+        return;
+
+    /* Periodic like the launchpad timer, the ISR restarts the count */
+    sim_schedule(sim, sim->now + node->timer_period, SIM_EVENT_TIMER, node->config.index, generation);
+
+    sim_node_timer_isr(node);
+
+    sim_update_node(sim, node);
+}
+
+
+static void sim_join_event(simulator_t *sim, sim_node_t *node)
+{
+    if(node->state.network_joined)
+        return;
+
+    if(node->join_pressed == 0)
+        node->join_request_time = sim->now;
+
+    node->join_pressed = 1;
+
+    sim_node_join(node);
+
+    sim_update_node(sim, node);
+
+    /* Press join again if the request was lost */
+    sim_schedule(sim, sim->now + sim_frame_time(sim) * (1 + sim_random_below(sim, sim->config.join_retry)),
+                 SIM_EVENT_JOIN, node->config.index, 0);
+}
+
+
+static void sim_post_event(simulator_t *sim, sim_node_t *node)
+{
+    char     message[COMMS_MAX_MESSAGE_LENGTH] = {0};
+    int      length;
+    uint8_t  destination_id;
+    uint32_t peer;
+
+    sim_schedule(sim, sim->now + sim_random_exponential(sim, (sim_time_t)sim->config.message_interval * 1000),
+                 SIM_EVENT_POST, node->config.index, 0);
+
+    /* Application buffer holds one message */
+    if(node->state.application_pending)
+    {
+        sim->stats.messages_backlogged++;
+        return;
+    }
+
+    /* Send to the next client, echo to self until it joins */
+    peer = node->config.index % (sim->node_count - 1) + 1;
+
+    destination_id = sim->nodes[peer].state.network_joined ? sim->nodes[peer].state.device_slot_number :
+                                                             node->state.device_slot_number;
+
+    length = snprintf(message, sizeof(message), "%u@%llu", node->message_sequence++, (unsigned long long)sim->now);
+
+    /* Pad to the configured message size, longer than a frame are sent as fragments */
+    if(sim->config.message_size > length)
+    {
+        length = sim->config.message_size < sizeof(message) ? sim->config.message_size : sizeof(message);
+
+        memset(message + strlen(message), '.', (size_t)length - strlen(message));
+    }
+
+    sim->stats.messages_posted++;
+
+    sim_node_post(node, destination_id, message, (uint16_t)length);
+
+    sim_update_node(sim, node);
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+/*******************************************************************
+ * @brief  Initialize the simulator and start all nodes
+ * @param  *sim    : reference to the simulator
+ * @param  *config : simulation configuration
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_init(simulator_t *sim, const sim_config_t *config)
+{
+    sim_node_config_t node_config;
+    uint32_t          index;
+
+    if(sim == NULL || config == NULL || config->slot_time == 0 || config->total_slots == 0 || config->baud_rate == 0)
+        return -1;
+
+    memset(sim, 0, sizeof(*sim));
+
+    sim->config       = *config;
+    sim->random_state = config->seed ? config->seed : 1;
+    sim->node_count   = config->clients + 1;
+
+    sim->nodes = calloc(sim->node_count, sizeof(sim_node_t));
+
+    if(sim->nodes == NULL)
+        return -1;
+
+    sim->handlers.context        = sim;
+    sim->handlers.on_send        = sim_on_send;
+    sim->handlers.on_set_timer   = sim_on_set_timer;
+    sim->handlers.on_reset_timer = sim_on_reset_timer;
+    sim->handlers.on_radio       = sim_on_radio;
+
+    for(index = 0; index < sim->node_count; index++)
+    {
+        memset(&node_config, 0, sizeof(node_config));
+
+        node_config.role        = index == SIM_SERVER_NODE ? SIM_ROLE_SERVER : SIM_ROLE_CLIENT;
+        node_config.index       = index;
+        node_config.network_id  = 1441;
+        node_config.slot_time   = config->slot_time;
+        node_config.total_slots = config->total_slots;
+        node_config.verbose     = config->verbose;
+
+        node_config.integrity_mode   = config->integrity_mode;
+        node_config.contrl_batch     = config->contrl_batch;
+        node_config.contrl_aggregate = config->contrl_aggregate;
+        node_config.access_slots     = config->access_slots;
+        node_config.slot_period      = config->slot_period;
+        node_config.sleep_mode       = config->sleep_mode;
+        node_config.qos              = config->qos;
+        node_config.payload_codecs   = index != SIM_SERVER_NODE && index <= config->codec_clients ? COMMS_CODEC_ALL : 0;
+
+        if(sim_node_start(&sim->nodes[index], &node_config, &sim->handlers) < 0)
+        {
+            sim->node_count = index;
+            return -1;
+        }
+
+        /* Boot timers, clients come up with a random phase */
+        if(index == SIM_SERVER_NODE)
+        {
+            sim->nodes[index].timer_period = SIM_SERVER_BOOT_TIMER;
+
+            sim_schedule(sim, SIM_SERVER_BOOT_TIMER, SIM_EVENT_TIMER, index, 0);
+        }
+        else
+        {
+            sim->nodes[index].timer_period = SIM_CLIENT_BOOT_TIMER;
+
+            sim_schedule(sim, 1 + sim_random_below(sim, SIM_CLIENT_BOOT_TIMER), SIM_EVENT_TIMER, index, 0);
+
+            sim_schedule(sim, sim_random_below(sim, (sim_time_t)config->join_window * 1000 + 1), SIM_EVENT_JOIN, index, 0);
+        }
+    }
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Run the simulation for the configured duration
+ * @param  *sim    : reference to the simulator
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_run(simulator_t *sim)
+{
+    sim_event_t event;
+    sim_time_t  end = (sim_time_t)sim->config.duration * 1000;
+
+    while(sim_next_event(sim, &event) == 0 && event.time <= end)
+    {
+        sim->now = event.time;
+
+        switch(event.type)
+        {
+
+        case SIM_EVENT_TIMER:
+
+            sim_timer_event(sim, &sim->nodes[event.node], event.tag);
+
+            break;
+
+        case SIM_EVENT_TX_START:
+
+            sim_tx_start(sim, event.tag);
+
+            break;
+
+        case SIM_EVENT_TX_END:
+
+            sim_tx_end(sim, event.tag);
+
+            break;
+
+        case SIM_EVENT_JOIN:
+
+            sim_join_event(sim, &sim->nodes[event.node]);
+
+            break;
+
+        case SIM_EVENT_POST:
+
+            sim_post_event(sim, &sim->nodes[event.node]);
+
+            break;
+
+        default:
+
+            return -1;
+        }
+    }
+
+    sim->now = end;
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Summarize the simulation results
+ * @param  *sim     : reference to the simulator
+ * @param  *summary : reference to the summary
+ *******************************************************************/
+void sim_summarize(simulator_t *sim, sim_summary_t *summary)
+{
+    sim_stats_t *stats   = &sim->stats;
+    double       seconds = (double)sim->now / 1000000.0;
+    double       mean    = 0;
+    double       energy  = 0;
+    sim_time_t   asleep  = 0;
+    sim_time_t   awake   = 0;
+    uint64_t     index;
+    sim_node_t  *node;
+
+    memset(summary, 0, sizeof(*summary));
+
+    /* Client radios listen when awake and not sending */
+    for(index = SIM_SERVER_NODE + 1; index < sim->node_count; index++)
+    {
+        node   = &sim->nodes[index];
+        asleep = node->radio_sleep_total + (node->radio_asleep ? sim->now - node->radio_sleep_time : 0);
+
+        awake  += sim->now - asleep;
+        energy += ((double)asleep * SIM_RADIO_SLEEP_MW + (double)node->tx_airtime * SIM_RADIO_TX_MW +
+                   (double)(sim->now - asleep - node->tx_airtime) * SIM_RADIO_RX_MW) / 1000000.0;
+    }
+
+    for(index = 0; index < stats->latency_count; index++)
+        mean += (double)stats->latency[index];
+
+    if(stats->latency_count)
+        mean = mean / (double)stats->latency_count / 1000.0;
+
+    qsort(stats->latency, stats->latency_count, sizeof(sim_time_t), sim_compare_time);
+
+    summary->joined_clients     = stats->joined_clients;
+    summary->messages_posted    = stats->messages_posted;
+    summary->messages_delivered = stats->messages_delivered;
+    summary->collisions         = stats->collisions;
+    summary->delivered_rate     = seconds > 0 ? (double)stats->messages_delivered / seconds : 0.0;
+    summary->latency_mean       = mean;
+    summary->latency_p50        = sim_percentile(stats, 0.50);
+    summary->latency_p95        = sim_percentile(stats, 0.95);
+    summary->latency_p99        = sim_percentile(stats, 0.99);
+    summary->latency_max        = sim_percentile(stats, 1.0);
+    summary->join_frames        = stats->join_frames;
+    summary->join_slots         = stats->join_slots;
+    summary->join_requests      = stats->frames_sent[COMMS_JOINREQ_MESSAGE];
+    summary->join_received      = stats->frames_delivered[COMMS_JOINREQ_MESSAGE];
+    summary->join_time_mean     = stats->joined_clients ?
+                                  (double)stats->join_time_total / (double)stats->joined_clients / 1000.0 : 0.0;
+    summary->radio_awake        = sim->node_count > 1 && sim->now ?
+                                  100.0 * (double)awake / (double)sim->now / (double)(sim->node_count - 1) : 0.0;
+    summary->client_energy      = sim->node_count > 1 ? energy / (double)(sim->node_count - 1) : 0.0;
+    summary->message_energy     = stats->messages_delivered ? energy / (double)stats->messages_delivered : 0.0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Slotted ALOHA throughput of an offered load, S = G e^-G
+ * @param  offered_load : transmissions per slot (G)
+ * @retval double       : successful transmissions per slot (S)
+ *******************************************************************/
+double sim_aloha_throughput(double offered_load)
+{
+    return offered_load * exp(-offered_load);
+}
+
+
+
+/*******************************************************************
+ * @brief  Print the node metrics of the last metrics_snapshot calls
+ * @param  *sim    : reference to the simulator
+ * @param  *output : output stream
+ *******************************************************************/
+static void sim_report_metrics(simulator_t *sim, FILE *output)
+{
+    const comms_metrics_t *server  = &sim->nodes[SIM_SERVER_NODE].state.metrics;
+    const comms_metrics_t *metrics;
+
+    uint64_t checksum_errors = 0;
+    uint64_t sync_missed     = 0;
+    uint64_t not_found       = 0;
+    uint64_t retransmits     = 0;
+    uint64_t qos_dropped     = 0;
+    uint32_t index;
+
+    for(index = 0; index < sim->node_count; index++)
+    {
+        if(index == SIM_SERVER_NODE)
+            continue;
+
+        metrics = &sim->nodes[index].state.metrics;
+
+        checksum_errors += metrics->checksum_errors;
+        sync_missed     += metrics->sync_missed;
+        not_found       += metrics->client_not_found;
+        retransmits     += metrics->qos_retransmits;
+        qos_dropped     += metrics->qos_dropped;
+    }
+
+    fprintf(output, "metrics (last metrics_snapshot, every %u frames)\n", COMMS_METRICS_FRAMES);
+    fprintf(output, "  checksum errors      : server %u, clients %llu\n", server->checksum_errors,
+            (unsigned long long)checksum_errors);
+    fprintf(output, "  join ACK/NACK/DUP    : %u / %u / %u\n", server->join_accepted, server->join_rejected,
+            server->join_duplicates);
+    fprintf(output, "  CLIENT_NOT_FOUND     : server %u, clients %llu\n", server->client_not_found,
+            (unsigned long long)not_found);
+    fprintf(output, "  missed SYNC          : clients %llu\n", (unsigned long long)sync_missed);
+    fprintf(output, "  keep alive expired   : server %u\n", server->clients_expired);
+
+    if(sim->config.qos)
+        fprintf(output, "  QoS 1 STATUS         : retransmitted %llu, dropped %llu, duplicates %u\n",
+                (unsigned long long)retransmits, (unsigned long long)qos_dropped, server->qos_duplicates);
+
+    if(sim->config.sleep_mode)
+        fprintf(output, "  mailbox              : held %u, dropped %u\n", server->mailbox_held, server->mailbox_dropped);
+
+    fprintf(output, "  server slot usage    :");
+
+    for(index = 0; index < COMMS_METRICS_BINS; index++)
+        fprintf(output, " %u%s:%u", index, index == COMMS_METRICS_BINS - 1 ? "+" : "", server->slot_usage[index]);
+
+    fprintf(output, "\n  server queue depth   :");
+
+    for(index = 0; index < COMMS_METRICS_BINS; index++)
+        fprintf(output, " %u%s:%u", index, index == COMMS_METRICS_BINS - 1 ? "+" : "", server->queue_depth[index]);
+
+    fprintf(output, "\n");
+}
+
+
+
+/*******************************************************************
+ * @brief  Print the simulation report
+ * @param  *sim    : reference to the simulator
+ * @param  *output : output stream
+ *******************************************************************/
+void sim_report(simulator_t *sim, FILE *output)
+{
+    sim_stats_t  *stats       = &sim->stats;
+    double        seconds     = (double)sim->now / 1000000.0;
+    double        slots       = (double)sim->now / ((double)sim->config.slot_time * 1000.0);
+    uint64_t      used        = 0;
+    uint64_t      event_drops = 0;
+    uint64_t      index;
+    sim_summary_t summary;
+
+    if(seconds <= 0)
+        return;
+
+    for(index = 0; index < 16; index++)
+        used += stats->frames_delivered[index];
+
+    for(index = 0; index < sim->node_count; index++)
+        event_drops += sim->nodes[index].state.event_drops;
+
+    sim_summarize(sim, &summary);
+
+    fprintf(output, "configuration\n");
+    fprintf(output, "  slot time            : %u ms\n", sim->config.slot_time);
+    fprintf(output, "  starting total slots : %u\n", sim->config.total_slots);
+    fprintf(output, "  clients              : %u\n", sim->config.clients);
+    fprintf(output, "  baud rate            : %u\n", sim->config.baud_rate);
+    fprintf(output, "  message interval     : %u ms\n", sim->config.message_interval);
+    if(sim->config.codec_clients)
+        fprintf(output, "  payload codecs       : %u clients\n",
+                sim->config.codec_clients < sim->config.clients ? sim->config.codec_clients : sim->config.clients);
+    if(sim->config.message_size)
+        fprintf(output, "  message size         : %u bytes\n", sim->config.message_size);
+    fprintf(output, "  frame integrity      : %s\n", sim->config.integrity_mode == 2 ? "crc32" :
+                                                    sim->config.integrity_mode == 1 ? "crc16" : "sum8");
+    fprintf(output, "  CONTRL batch         : %u%s\n", sim->config.contrl_batch > 1 ? sim->config.contrl_batch : 1,
+            sim->config.contrl_aggregate ? ", aggregated" : "");
+    if(sim->config.sleep_mode)
+        fprintf(output, "  low power clients    : radio sleeps between listen windows\n");
+    fprintf(output, "  simulated time       : %.3f s\n", seconds);
+
+    fprintf(output, "network\n");
+    fprintf(output, "  joined clients       : %llu\n", (unsigned long long)stats->joined_clients);
+    fprintf(output, "  mean join time       : %.3f ms\n",
+            stats->joined_clients ? (double)stats->join_time_total / (double)stats->joined_clients / 1000.0 : 0.0);
+    if(summary.join_slots)
+        fprintf(output, "  join access          : G %.3f, S %.3f per access slot (G*e^-G %.3f) in %llu frames, %.2f slots\n",
+                (double)summary.join_requests / (double)summary.join_slots,
+                (double)summary.join_received / (double)summary.join_slots,
+                sim_aloha_throughput((double)summary.join_requests / (double)summary.join_slots),
+                (unsigned long long)summary.join_frames, (double)summary.join_slots / (double)summary.join_frames);
+    fprintf(output, "  final total slots    : %u\n", sim->nodes[SIM_SERVER_NODE].state.total_slots);
+    fprintf(output, "  rx event drops       : %llu (server %u)\n", (unsigned long long)event_drops,
+            sim->nodes[SIM_SERVER_NODE].state.event_drops);
+
+    fprintf(output, "frames (sent / delivered)\n");
+
+    for(index = 1; index < 16; index++)
+    {
+        if(stats->frames_sent[index] == 0)
+            continue;
+
+        fprintf(output, "  %-20s : %llu / %llu\n", sim_message_names[index],
+                (unsigned long long)stats->frames_sent[index], (unsigned long long)stats->frames_delivered[index]);
+    }
+
+    fprintf(output, "  %-20s : %llu\n", "collided", (unsigned long long)stats->collisions);
+
+    fprintf(output, "throughput\n");
+    fprintf(output, "  STATUS delivered     : %.2f msg/s\n", (double)stats->frames_delivered[COMMS_STATUS_MESSAGE] / seconds);
+    fprintf(output, "  CONTRL delivered     : %.2f msg/s\n", (double)stats->frames_delivered[COMMS_CONTRL_MESSAGE] / seconds);
+    fprintf(output, "  end to end delivered : %.2f msg/s (%llu of %llu posted, %llu backlogged, %llu not found)\n",
+            summary.delivered_rate, (unsigned long long)stats->messages_delivered,
+            (unsigned long long)stats->messages_posted, (unsigned long long)stats->messages_backlogged,
+            (unsigned long long)stats->messages_not_found);
+    fprintf(output, "  payload delivered    : %.1f bytes/s\n", (double)stats->bytes_delivered / seconds);
+
+    fprintf(output, "latency (post to CONTRL delivery)\n");
+    fprintf(output, "  mean / p50 / p95 / p99 / max : %.2f / %.2f / %.2f / %.2f / %.2f ms\n", summary.latency_mean,
+            summary.latency_p50, summary.latency_p95, summary.latency_p99, summary.latency_max);
+
+    fprintf(output, "utilization\n");
+    fprintf(output, "  slot utilization     : %.2f %% (%llu delivered frames in %.0f slots)\n",
+            slots > 0 ? 100.0 * (double)used / slots : 0.0, (unsigned long long)used, slots);
+    fprintf(output, "  airtime utilization  : %.2f %%\n", 100.0 * (double)stats->busy_time / (double)sim->now);
+
+    fprintf(output, "energy (client radios, tx %.0f mW, rx %.0f mW, sleep %.3f mW)\n", SIM_RADIO_TX_MW, SIM_RADIO_RX_MW,
+            SIM_RADIO_SLEEP_MW);
+    fprintf(output, "  radio awake          : %.2f %%\n", summary.radio_awake);
+    fprintf(output, "  energy per client    : %.1f mJ\n", summary.client_energy);
+    fprintf(output, "  per delivered message: %.2f mJ\n", summary.message_energy);
+
+    sim_report_metrics(sim, output);
+}
+
+
+
+/*******************************************************************
+ * @brief  Stop all nodes and release simulator memory
+ * @param  *sim    : reference to the simulator
+ *******************************************************************/
+void sim_destroy(simulator_t *sim)
+{
+    uint32_t index;
+
+    for(index = 0; index < sim->node_count; index++)
+        sim_node_stop(&sim->nodes[index]);
+
+    free(sim->nodes);
+    free(sim->events);
+    free(sim->frames);
+    free(sim->stats.latency);
+
+    memset(sim, 0, sizeof(*sim));
+}
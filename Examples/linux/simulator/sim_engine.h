@@ -0,0 +1,255 @@
+/**
+ ******************************************************************************
+ * @file    sim_engine.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network discrete event simulator header file
+ *
+ *  Info
+ *          Virtual clock, event queue, shared radio medium and statistics
+ *          for running the server and client state machines on a host.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef SIM_ENGINE_H_
+#define SIM_ENGINE_H_
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim_node.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Virtual time in microseconds */
+typedef uint64_t sim_time_t;
+
+
+/* Simulation configuration */
+typedef struct _sim_config
+{
+    uint16_t slot_time;          /*!< Server device_slot_time (ms)                     */
+    uint8_t  total_slots;        /*!< Server starting total_slots                      */
+    uint32_t clients;            /*!< Number of client nodes                           */
+    uint32_t duration;           /*!< Simulated time (ms)                              */
+    uint32_t message_interval;   /*!< Mean application message interval per client (ms)*/
+    uint32_t baud_rate;          /*!< Radio link baud rate, 10 bits per byte           */
+    uint32_t join_window;        /*!< Clients press join within this window (ms)       */
+    uint32_t join_retry;         /*!< Retry join after up to this many frames          */
+    uint32_t seed;               /*!< Random seed                                      */
+    uint8_t  verbose;            /*!< Print node debug output                          */
+    uint8_t  integrity_mode;     /*!< Frame integrity: 0 sum8, 1 CRC-16, 2 CRC-32      */
+    uint8_t  contrl_batch;       /*!< Server CONTRL messages per broadcast slot        */
+    uint8_t  contrl_aggregate;   /*!< Server sends aggregated CONTRL messages          */
+    uint16_t message_size;       /*!< Posted messages padded to this length (bytes)    */
+    uint32_t codec_clients;      /*!< Clients 1 - n send encoded STATUS payloads       */
+    uint8_t  access_slots;       /*!< Server largest access slot count, 0 default      */
+    uint16_t slot_period;        /*!< Client reporting period (frames), 0 every frame  */
+    uint8_t  sleep_mode;         /*!< Client radios sleep between the slots they need  */
+    uint8_t  qos;                /*!< Client STATUS messages acknowledged, QoS 1       */
+
+}sim_config_t;
+
+
+/* Simulation event */
+typedef struct _sim_event
+{
+    sim_time_t time;      /*!< Event time                                  */
+    uint64_t   sequence;  /*!< Insertion order, ties are FIFO              */
+    uint8_t    type;      /*!< Event type                                  */
+    uint32_t   node;      /*!< Node index                                  */
+    uint32_t   tag;       /*!< Timer generation or frame index             */
+
+}sim_event_t;
+
+
+/* Frame on the shared medium */
+typedef struct _sim_frame
+{
+    sim_time_t start;               /*!< Transmission start                */
+    sim_time_t end;                 /*!< Transmission end                  */
+    uint32_t   sender;              /*!< Sending node index                */
+    uint16_t   length;              /*!< Frame length                      */
+    uint8_t    collided;            /*!< Overlapped another transmission   */
+    uint8_t    in_use;              /*!< Frame slot in use                 */
+    uint8_t    on_air;              /*!< Transmission started              */
+    char       data[NET_MTU_SIZE];  /*!< Frame bytes                       */
+
+}sim_frame_t;
+
+
+/* Simulation statistics */
+typedef struct _sim_stats
+{
+    uint64_t frames_sent[16];       /*!< Transmitted frames by message type     */
+    uint64_t frames_delivered[16];  /*!< Collision free frames by message type  */
+    uint64_t collisions;            /*!< Frames lost to collisions              */
+    uint64_t busy_time;             /*!< Airtime with at least one transmission */
+    uint64_t messages_posted;       /*!< Application messages posted            */
+    uint64_t messages_backlogged;   /*!< Posts skipped, previous still pending  */
+    uint64_t messages_delivered;    /*!< Messages delivered to the destination  */
+    uint64_t messages_not_found;    /*!< Server CLIENT_NOT_FOUND replies        */
+    uint64_t bytes_delivered;       /*!< Payload bytes of delivered messages    */
+    uint64_t joined_clients;        /*!< Clients that joined the network        */
+    uint64_t join_time_total;       /*!< Sum of join times (us)                 */
+    uint64_t join_frames;           /*!< Frames with clients waiting to join    */
+    uint64_t join_slots;            /*!< Access slots of these frames           */
+
+    sim_time_t *latency;            /*!< Per message latency samples (us)       */
+    uint64_t    latency_count;
+    uint64_t    latency_capacity;
+
+}sim_stats_t;
+
+
+/* Simulation summary, benchmark results */
+typedef struct _sim_summary
+{
+    uint64_t joined_clients;        /*!< Clients that joined the network        */
+    uint64_t messages_posted;       /*!< Application messages posted            */
+    uint64_t messages_delivered;    /*!< Messages delivered to the destination  */
+    uint64_t collisions;            /*!< Frames lost to collisions              */
+    double   delivered_rate;        /*!< Delivered messages per second          */
+    double   latency_mean;          /*!< Mean post to CONTRL latency (ms)       */
+    double   latency_p50;           /*!< Median latency (ms)                    */
+    double   latency_p95;           /*!< 95th percentile latency (ms)           */
+    double   latency_p99;           /*!< 99th percentile latency (ms)           */
+    double   latency_max;           /*!< Maximum latency (ms)                   */
+    uint64_t join_frames;           /*!< Frames with clients waiting to join    */
+    uint64_t join_slots;            /*!< Access slots of these frames           */
+    uint64_t join_requests;         /*!< JOINREQ messages sent                  */
+    uint64_t join_received;         /*!< Collision free JOINREQ messages        */
+    double   join_time_mean;        /*!< Mean join time (ms)                    */
+    double   radio_awake;           /*!< Client radio awake share (%)           */
+    double   client_energy;         /*!< Radio energy per client (mJ)           */
+    double   message_energy;        /*!< Client radio energy per delivered message (mJ) */
+
+}sim_summary_t;
+
+
+/* Simulator */
+typedef struct _simulator
+{
+    sim_config_t        config;
+    sim_time_t          now;
+    uint64_t            sequence;
+    uint64_t            random_state;
+
+    sim_event_t        *events;          /*!< Binary min heap of events   */
+    uint64_t            event_count;
+    uint64_t            event_capacity;
+
+    sim_frame_t        *frames;          /*!< Frames on air               */
+    uint32_t            frame_capacity;
+    uint32_t            active_frames;
+    sim_time_t          busy_since;
+
+    sim_node_t         *nodes;           /*!< Node 0 is the server        */
+    uint32_t            node_count;
+    sim_node_handlers_t handlers;
+
+    sim_stats_t         stats;
+
+}simulator_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Initialize the simulator and start all nodes
+ * @param  *sim    : reference to the simulator
+ * @param  *config : simulation configuration
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_init(simulator_t *sim, const sim_config_t *config);
+
+
+/*******************************************************************
+ * @brief  Run the simulation for the configured duration
+ * @param  *sim    : reference to the simulator
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_run(simulator_t *sim);
+
+
+/*******************************************************************
+ * @brief  Summarize the simulation results
+ * @param  *sim     : reference to the simulator
+ * @param  *summary : reference to the summary
+ *******************************************************************/
+void sim_summarize(simulator_t *sim, sim_summary_t *summary);
+
+
+/*******************************************************************
+ * @brief  Slotted ALOHA throughput of an offered load, S = G e^-G
+ * @param  offered_load : transmissions per slot (G)
+ * @retval double       : successful transmissions per slot (S)
+ *******************************************************************/
+double sim_aloha_throughput(double offered_load);
+
+
+/*******************************************************************
+ * @brief  Print the simulation report
+ * @param  *sim    : reference to the simulator
+ * @param  *output : output stream
+ *******************************************************************/
+void sim_report(simulator_t *sim, FILE *output);
+
+
+/*******************************************************************
+ * @brief  Stop all nodes and release simulator memory
+ * @param  *sim    : reference to the simulator
+ *******************************************************************/
+void sim_destroy(simulator_t *sim);
+
+
+
+#endif /* SIM_ENGINE_H_ */
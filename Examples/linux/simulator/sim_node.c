@@ -0,0 +1,497 @@
+/**
+ ******************************************************************************
+ * @file    sim_node.c
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network simulator node source file
+ *
+ *  Info
+ *          Every node owns a server or client context and is stepped in
+ *          process. The network_operations_t callbacks have no context
+ *          argument, so the node being stepped is kept in current_node.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_node.h"
+
+/* API headers */
+#include "comms_network.h"
+#include "comms_protocol.h"
+#include "comms_server_db.h"
+#include "comms_server_fsm.h"
+#include "comms_client_fsm.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+#define SIM_NETWORK_USER  "sens_net"
+#define SIM_NETWORK_PSWD  "1234"
+
+
+/* Node running inside the network_operations_t callbacks, the callbacks have no context argument */
+static sim_node_t *current_node;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                     Network operations callbacks                           */
+/*                                                                            */
+/******************************************************************************/
+
+
+static int8_t node_send_message(char *message_buffer, uint16_t message_length)
+{
+    if(current_node == NULL || message_length > NET_MTU_SIZE)
+        return -1;
+
+    current_node->handlers->on_send(current_node->handlers->context, current_node, message_buffer, message_length);
+
+    return 0;
+}
+
+
+static int8_t node_send_message_v(const net_segment_t *segments, uint8_t segment_count)
+{
+    char     frame[NET_MTU_SIZE];
+    uint16_t length = 0;
+    uint8_t  segment;
+
+    /* The medium carries whole frames, gather like a UART DMA descriptor chain would */
+    for(segment = 0; segment < segment_count; segment++)
+    {
+        if(current_node == NULL || length + segments[segment].length > NET_MTU_SIZE)
+            return -1;
+
+        memcpy(frame + length, segments[segment].data, segments[segment].length);
+
+        length += segments[segment].length;
+    }
+
+    current_node->handlers->on_send(current_node->handlers->context, current_node, frame, length);
+
+    return 0;
+}
+
+
+static int8_t node_set_tx_timer(uint16_t device_slot_time, uint8_t device_slot_number)
+{
+    /* Same contract as the hardware timer, zero slot values leave the timer untouched */
+    if(current_node == NULL || device_slot_number == 0 || device_slot_time == 0)
+        return -1;
+
+    current_node->handlers->on_set_timer(current_node->handlers->context, current_node, device_slot_time,
+                                         device_slot_number);
+
+    return 0;
+}
+
+
+static int8_t node_reset_tx_timer(void)
+{
+    if(current_node == NULL)
+        return -1;
+
+    current_node->handlers->on_reset_timer(current_node->handlers->context, current_node);
+
+    return 0;
+}
+
+
+static int8_t node_radio_sleep(void)
+{
+    if(current_node == NULL)
+        return -1;
+
+    current_node->handlers->on_radio(current_node->handlers->context, current_node, 0);
+
+    return 0;
+}
+
+
+static int8_t node_radio_wake(void)
+{
+    if(current_node == NULL)
+        return -1;
+
+    current_node->handlers->on_radio(current_node->handlers->context, current_node, 1);
+
+    return 0;
+}
+
+
+static int8_t node_metrics_snapshot(const comms_metrics_t *metrics)
+{
+    if(current_node == NULL)
+        return -1;
+
+    memcpy(&current_node->state.metrics, metrics, sizeof(comms_metrics_t));
+
+    current_node->state.snapshots++;
+
+    return 0;
+}
+
+
+static int8_t node_debug_print(char *debug_message)
+{
+    if(current_node != NULL && current_node->config.verbose)
+        fputs(debug_message, stderr);
+
+    return 0;
+}
+
+
+static network_operations_t node_ops =
+{
+    .send_message     = node_send_message,
+    .send_message_v   = node_send_message_v,
+    .set_tx_timer     = node_set_tx_timer,
+    .reset_tx_timer   = node_reset_tx_timer,
+    .metrics_snapshot = node_metrics_snapshot,
+    .radio_sleep      = node_radio_sleep,
+    .radio_wake       = node_radio_wake,
+    .net_debug_print  = node_debug_print,
+};
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                          Private Functions                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Copy the instance state to the node after every call
+ * @param  *node  : reference to the node
+ *******************************************************************/
+static void sim_node_update_state(sim_node_t *node)
+{
+    sim_node_state_t       *state = &node->state;
+    comms_server_context_t *server;
+    comms_client_context_t *client;
+    comms_metrics_t        *metrics;
+    uint8_t                 type;
+
+    if(node->config.role == SIM_ROLE_SERVER)
+        metrics = &((comms_server_context_t*)node->instance)->network.metrics;
+    else
+        metrics = &((comms_client_context_t*)node->instance)->network.metrics;
+
+    state->event_drops = 0;
+
+    for(type = 0; type < 16; type++)
+        state->event_drops += metrics->rx_dropped[type];
+
+    if(node->config.role == SIM_ROLE_SERVER)
+    {
+        server = node->instance;
+
+        state->total_slots  = server->device.total_slots;
+        state->device_count = server->device.device_count;
+        state->access_slots = server->network.access_slots;
+    }
+    else
+    {
+        client = node->instance;
+
+        state->network_joined      = client->buffers.application_flags.network_joined_state;
+        state->device_slot_number  = client->device.device_slot_number;
+        state->application_pending = client->buffers.application_flags.application_message_ready;
+
+        /* Hand the delivered network message to the engine, the application consumes it */
+        if(client->buffers.application_flags.network_message_ready)
+        {
+            state->message_ready  = 1;
+            state->source_id      = client->buffers.source_id;
+            state->message_length = client->buffers.net_message_length;
+
+            /* Message head, reassembled messages are longer than the state buffer */
+            memcpy(state->message, client->buffers.network_message_data,
+                   state->message_length < NET_DATA_LENGTH ? state->message_length : NET_DATA_LENGTH - 1);
+
+            state->message[state->message_length < NET_DATA_LENGTH ? state->message_length : NET_DATA_LENGTH - 1] = 0;
+
+            client->buffers.application_flags.network_message_ready = 0;
+        }
+    }
+}
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Functions                                    */
+/*                                                                            */
+/******************************************************************************/
+
+
+
+/*******************************************************************
+ * @brief  Start a node, creates the server or client instance
+ * @param  *node     : reference to the node
+ * @param  *config   : node configuration
+ * @param  *handlers : engine callbacks
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_start(sim_node_t *node, const sim_node_config_t *config, sim_node_handlers_t *handlers)
+{
+    int8_t  func_retval     = 0;
+    char    mac_address[18] = {0};
+    char    user_name[10]   = SIM_NETWORK_USER;
+    uint8_t password[10]    = SIM_NETWORK_PSWD;
+
+    if(node == NULL || config == NULL || handlers == NULL)
+        return -1;
+
+    memset(node, 0, sizeof(*node));
+
+    node->config   = *config;
+    node->handlers = handlers;
+
+    if(config->role == SIM_ROLE_SERVER)
+    {
+        node->instance = calloc(1, sizeof(comms_server_context_t));
+
+        if(node->instance == NULL)
+            return -1;
+
+        func_retval = comms_server_init(node->instance, &node_ops, "11:22:33:44:55:66", config->network_id,
+                                        config->slot_time, config->total_slots, user_name, password,
+                                        config->server_mode ? (comms_server_mode_t)config->server_mode : WI_LOCAL_SERVER);
+
+        if(func_retval == 0)
+            func_retval = comms_network_set_integrity(&((comms_server_context_t*)node->instance)->network,
+                                                      (net_integrity_t)config->integrity_mode);
+
+        if(func_retval == 0 && config->contrl_batch)
+            func_retval = comms_server_set_batch(node->instance, config->contrl_batch);
+
+        if(func_retval == 0)
+            func_retval = comms_server_set_aggregate(node->instance, config->contrl_aggregate);
+
+        if(func_retval == 0 && config->access_slots)
+            func_retval = comms_server_set_access_slots(node->instance, config->access_slots);
+    }
+    else
+    {
+        node->instance = calloc(1, sizeof(comms_client_context_t));
+
+        if(node->instance == NULL)
+            return -1;
+
+        snprintf(mac_address, sizeof(mac_address), "20:20:%02X:%02X:%02X:%02X",
+                 (config->index >> 24) & 0xFF, (config->index >> 16) & 0xFF,
+                 (config->index >> 8) & 0xFF, config->index & 0xFF);
+
+        func_retval = comms_client_init(node->instance, &node_ops, mac_address, 1, user_name, password);
+
+        if(func_retval == 0)
+            func_retval = comms_network_set_integrity(&((comms_client_context_t*)node->instance)->network,
+                                                      (net_integrity_t)config->integrity_mode);
+
+        if(func_retval == 0)
+            func_retval = comms_client_set_codec(node->instance, config->payload_codecs);
+
+        if(func_retval == 0)
+            func_retval = comms_client_set_period(node->instance, config->slot_period);
+
+        if(func_retval == 0)
+            func_retval = comms_client_set_sleep(node->instance, config->sleep_mode);
+
+        if(func_retval == 0)
+            func_retval = comms_client_set_qos(node->instance, config->qos);
+    }
+
+    if(func_retval < 0)
+    {
+        free(node->instance);
+        node->instance = NULL;
+    }
+
+    return func_retval;
+}
+
+
+
+/*******************************************************************
+ * @brief  Run the transmit timer ISR (state machine step) of a node
+ * @param  *node  : reference to the node
+ * @retval int8_t : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_timer_isr(sim_node_t *node)
+{
+    comms_server_context_t *server;
+
+    if(node->instance == NULL)
+        return -1;
+
+    current_node = node;
+
+    if(node->config.role == SIM_ROLE_SERVER)
+    {
+        server = node->instance;
+
+        /* Simulated server admits every join request */
+        server->buffers.application_flags.network_join_response = 1;
+
+        comms_server_run(server);
+    }
+    else
+    {
+        comms_client_run(node->instance, node->destination_id);
+
+        /* Main loop side of the deferred debug trace */
+        comms_network_trace_flush(&((comms_client_context_t*)node->instance)->network);
+    }
+
+    current_node = NULL;
+
+    sim_node_update_state(node);
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Feed a frame to the receive ISR of a node, byte by byte
+ * @param  *node   : reference to the node
+ * @param  *frame  : frame received from the medium
+ * @param  length  : frame length
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_receive(sim_node_t *node, const char *frame, uint16_t length)
+{
+    uint16_t index;
+
+    if(node->instance == NULL || length > NET_MTU_SIZE)
+        return -1;
+
+    current_node = node;
+
+    for(index = 0; index < length; index++)
+    {
+        if(node->config.role == SIM_ROLE_SERVER)
+            comms_server_recv(node->instance, frame[index]);
+        else
+            comms_client_recv(node->instance, frame[index]);
+    }
+
+    current_node = NULL;
+
+    sim_node_update_state(node);
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Press the join button of a client node
+ * @param  *node  : reference to the node
+ * @retval int8_t : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_join(sim_node_t *node)
+{
+    comms_client_context_t *client = node->instance;
+
+    if(client == NULL || node->config.role != SIM_ROLE_CLIENT)
+        return -1;
+
+    client->buffers.application_flags.network_join_request = 1;
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Post an application message on a client node
+ * @param  *node           : reference to the node
+ * @param  destination_id  : destination client id
+ * @param  *message        : application message
+ * @param  length          : message length
+ * @retval int8_t          : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_post(sim_node_t *node, uint8_t destination_id, const char *message, uint16_t length)
+{
+    comms_client_context_t *client = node->instance;
+
+    if(client == NULL || node->config.role != SIM_ROLE_CLIENT || length > COMMS_MAX_MESSAGE_LENGTH)
+        return -1;
+
+    node->destination_id = destination_id;
+
+    /* Long messages are sent from the posted buffer until the last fragment */
+    memcpy(node->post_message, message, length);
+
+    send_application_message(&client->buffers, node->post_message, length);
+
+    sim_node_update_state(node);
+
+    return 0;
+}
+
+
+
+/*******************************************************************
+ * @brief  Stop a node and release its instance
+ * @param  *node  : reference to the node
+ *******************************************************************/
+void sim_node_stop(sim_node_t *node)
+{
+    free(node->instance);
+
+    node->instance = NULL;
+}
@@ -0,0 +1,226 @@
+/**
+ ******************************************************************************
+ * @file    sim_node.h
+ * @author  Aditya Mall,
+ * @brief   (6314) wireless network simulator node header file
+ *
+ *  Info
+ *          A simulator node owns one server or client context of the API
+ *          and backs its network_operations_t callbacks with the
+ *          simulator engine handlers.
+ *
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2020 Aditya Mall, MIT License </center></h2>
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Aditya Mall
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ******************************************************************************
+ */
+
+#ifndef SIM_NODE_H_
+#define SIM_NODE_H_
+
+
+/*
+ * Standard Header and API Header files
+ */
+#include <stdint.h>
+
+#include "network_protocol_configs.h"
+
+/* comms_metrics_t */
+#include "comms_network.h"
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                  Data Structures and Defines                               */
+/*                                                                            */
+/******************************************************************************/
+
+
+/* Simulator node role */
+typedef enum _sim_node_role
+{
+    SIM_ROLE_SERVER = 1,  /*!< Runs comms_start_server */
+    SIM_ROLE_CLIENT = 2   /*!< Runs comms_start_client */
+
+}sim_node_role_t;
+
+
+/* Node configuration */
+typedef struct _sim_node_config
+{
+    sim_node_role_t role;              /*!< Server or client                        */
+    uint32_t        index;             /*!< Node index in the simulation            */
+    uint16_t        network_id;        /*!< Server network id                       */
+    uint16_t        slot_time;         /*!< Server slot time (ms)                   */
+    uint8_t         total_slots;       /*!< Server starting slots                   */
+    uint8_t         verbose;           /*!< Forward net_debug_print to stderr       */
+    uint8_t         integrity_mode;    /*!< Sent frame integrity, net_integrity_t   */
+    uint8_t         contrl_batch;      /*!< Server CONTRL messages per broadcast slot */
+    uint8_t         contrl_aggregate;  /*!< Server sends aggregated CONTRL messages   */
+    uint8_t         payload_codecs;    /*!< Client STATUS payload codecs, COMMS_CODEC_MASK */
+    uint8_t         access_slots;      /*!< Server largest access slot count, 0 default */
+    uint16_t        slot_period;       /*!< Client reporting period (frames), 0 every frame */
+    uint8_t         sleep_mode;        /*!< Client radio sleeps between the slots it needs  */
+    uint8_t         qos;               /*!< Client STATUS messages acknowledged, QoS 1      */
+    uint8_t         server_mode;       /*!< Server comms_server_mode_t, 0 local server      */
+
+}sim_node_config_t;
+
+
+/* Node state reported back after every command */
+typedef struct _sim_node_state
+{
+    uint8_t         network_joined;           /*!< Client joined state                     */
+    uint8_t         device_slot_number;       /*!< Client id / slot number                 */
+    uint8_t         total_slots;              /*!< Server total slots (frame length)       */
+    uint8_t         device_count;             /*!< Server joined device count              */
+    uint8_t         access_slots;             /*!< Server access slots of the last SYNC    */
+    uint32_t        event_drops;              /*!< Received frames dropped on a full ring  */
+    comms_metrics_t metrics;                  /*!< Metrics of the last metrics_snapshot    */
+    uint32_t        snapshots;                /*!< metrics_snapshot calls                  */
+    uint8_t         application_pending;      /*!< Application message not yet sent        */
+    uint8_t         message_ready;            /*!< Network message delivered to app        */
+    uint8_t         source_id;                /*!< Source id of the delivered message      */
+    uint16_t        message_length;           /*!< Length of the delivered message         */
+    char            message[NET_DATA_LENGTH]; /*!< Delivered message                       */
+
+}sim_node_state_t;
+
+
+struct _sim_node;
+
+/* Engine callbacks invoked for the network_operations_t of a node */
+typedef struct _sim_node_handlers
+{
+    void *context;
+
+    void (*on_send)(void *context, struct _sim_node *node, const char *frame, uint16_t length);
+    void (*on_set_timer)(void *context, struct _sim_node *node, uint16_t slot_time, uint8_t slot_number);
+    void (*on_reset_timer)(void *context, struct _sim_node *node);
+    void (*on_radio)(void *context, struct _sim_node *node, uint8_t awake);
+
+}sim_node_handlers_t;
+
+
+/* Simulator node */
+typedef struct _sim_node
+{
+    sim_node_config_t    config;      /*!< Node configuration                     */
+    sim_node_state_t     state;       /*!< Last reported node state               */
+    sim_node_handlers_t *handlers;    /*!< Engine callbacks                       */
+
+    void    *instance;                /*!< Server or client context               */
+    uint8_t  destination_id;          /*!< Client STATUS message destination      */
+
+    /* Engine owned bookkeeping */
+    uint64_t timer_period;            /*!< Transmit timer period (us)             */
+    uint32_t timer_generation;        /*!< Invalidates stale timer events         */
+    uint64_t join_request_time;       /*!< Time of first join request (us)        */
+    uint8_t  join_pressed;            /*!< Join button pressed                    */
+    uint64_t join_time;               /*!< Time of network join (us)              */
+    uint32_t message_sequence;        /*!< Application message sequence number    */
+    uint64_t tx_free;                 /*!< Radio UART idle after this time (us)   */
+    uint8_t  radio_asleep;            /*!< Radio put to sleep by radio_sleep      */
+    uint64_t radio_wake_time;         /*!< Time of the last radio wake (us)       */
+    uint64_t radio_sleep_time;        /*!< Time of the last radio sleep (us)      */
+    uint64_t radio_sleep_total;       /*!< Radio sleep time before the last wake  */
+    uint64_t tx_airtime;              /*!< Time on air of sent frames (us)        */
+    char     post_message[COMMS_MAX_MESSAGE_LENGTH]; /*!< Posted message, fragments are sent from it */
+
+}sim_node_t;
+
+
+
+
+/******************************************************************************/
+/*                                                                            */
+/*                           API Prototypes                                   */
+/*                                                                            */
+/******************************************************************************/
+
+
+/*******************************************************************
+ * @brief  Start a node, creates the server or client instance
+ * @param  *node     : reference to the node
+ * @param  *config   : node configuration
+ * @param  *handlers : engine callbacks
+ * @retval int8_t    : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_start(sim_node_t *node, const sim_node_config_t *config, sim_node_handlers_t *handlers);
+
+
+/*******************************************************************
+ * @brief  Run the transmit timer ISR (state machine step) of a node
+ * @param  *node  : reference to the node
+ * @retval int8_t : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_timer_isr(sim_node_t *node);
+
+
+/*******************************************************************
+ * @brief  Feed a frame to the receive ISR of a node, byte by byte
+ * @param  *node   : reference to the node
+ * @param  *frame  : frame received from the medium
+ * @param  length  : frame length
+ * @retval int8_t  : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_receive(sim_node_t *node, const char *frame, uint16_t length);
+
+
+/*******************************************************************
+ * @brief  Press the join button of a client node
+ * @param  *node  : reference to the node
+ * @retval int8_t : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_join(sim_node_t *node);
+
+
+/*******************************************************************
+ * @brief  Post an application message on a client node
+ * @param  *node           : reference to the node
+ * @param  destination_id  : destination client id
+ * @param  *message        : application message
+ * @param  length          : message length
+ * @retval int8_t          : error: -1, success: 0
+ *******************************************************************/
+int8_t sim_node_post(sim_node_t *node, uint8_t destination_id, const char *message, uint16_t length);
+
+
+/*******************************************************************
+ * @brief  Stop a node and release its instance
+ * @param  *node  : reference to the node
+ *******************************************************************/
+void sim_node_stop(sim_node_t *node);
+
+
+
+#endif /* SIM_NODE_H_ */
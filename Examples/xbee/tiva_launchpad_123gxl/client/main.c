@@ -95,6 +95,10 @@
 comms_network_buffer_t read_buffer;
 
 
+/* Network access handle, created once before the interrupts start */
+access_control_t *wireless_network;
+
+
 /* Initialize Console Instance */
 cl_term_t *console;
 
@@ -181,15 +185,11 @@ void uart1ISR(void)
 
     static uint8_t rx_index;
 
-    access_control_t *network;
-
-    network = create_network_handle(&net_ops);
-
     char c = UART1_DR_R & 0xFF;
 
     read_buffer.read_message[rx_index] = c;
 
-    comms_client_recv_it(network, &read_buffer, &rx_index);
+    comms_client_recv_it(wireless_network, &read_buffer, &rx_index);
 
 }
 
@@ -204,10 +204,6 @@ void wTimer5Isr(void)
     WTIMER5_TAV_R = 0;
     WTIMER5_ICR_R = TIMER_ICR_TAMCINT;
 
-    access_control_t *wireless_network;
-
-    wireless_network = create_network_handle(&net_ops);
-
     char user_name[10]   = "sens_net";
     uint8_t password[10] = "1234";
 
@@ -233,6 +229,9 @@ int main(void)
 
     init_clocks();
 
+    /* Debug prints of the state machine are recorded, printed from the main loop */
+    wireless_network = create_network_handle(&net_ops);
+
     init_board_io();
 
     init_xbee_comm();
@@ -255,6 +254,9 @@ int main(void)
 
     while(loop)
     {
+        /* Print the state machine debug output recorded since the last input */
+        comms_start_client_flush(wireless_network);
+
         /* Get input from user */
         input_length = console_get_string(console, MAX_INPUT_SIZE);
 